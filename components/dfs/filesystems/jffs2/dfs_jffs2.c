@@ -10,6 +10,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2012-1-7       prife        the first version
+ * 2026-10-19     heyuanjie    mount on nor flash of rt_mtd_t, add mkfs
 */
 #include <rtthread.h>
 #include <rtdevice.h>
@@ -21,7 +22,7 @@
 #undef mode_t
 
 #include <dfs_fs.h>
-#include <dfs_def.h>
+#include <dfs_file.h>
 
 #include "dfs_jffs2.h"
 #include "jffs2_config.h"
@@ -36,11 +37,11 @@
 struct device_part 
 {
 	struct cyg_mtab_entry * mte;
-	struct rt_mtd_nor_device *dev;
+	rt_mtd_t *dev;
 };
 static struct device_part device_partition[DEVICE_PART_MAX] = {0};
 
-static struct rt_mutex jffs2_lock;
+struct rt_mutex jffs2_lock;
 
 #define jffs2_mount   jffs2_fste.mount
 #define jffs2_umount  jffs2_fste.umount
@@ -149,6 +150,13 @@ static int dfs_jffs2_mount(struct dfs_filesystem* fs,
 	unsigned index;
 	struct cyg_mtab_entry * mte;
 	int result;
+	rt_mtd_t *mtd;
+
+	/* the nodes are written without write buffer, it works on nor flash only */
+	mtd = (rt_mtd_t *)fs->dev_id;
+	if (mtd == RT_NULL || fs->dev_id->type != RT_Device_Class_MTD ||
+		mtd->type != MTD_NORFLASH)
+		return -EINVAL;
 
 	/* find a empty entry in partition table */
 	for (index = 0; index < DEVICE_PART_MAX; index ++)
@@ -173,12 +181,13 @@ static int dfs_jffs2_mount(struct dfs_filesystem* fs,
 	 */
 	mte->data = (CYG_ADDRWORD)fs->dev_id;
 
-	device_partition[index].dev = RT_MTD_NOR_DEVICE(fs->dev_id);
+	device_partition[index].dev = mtd;
 	/* after jffs2_mount, mte->data will not be dev_id any more */
 	result = jffs2_mount(NULL, mte);
 	if (result != 0)
 	{	
 		device_partition[index].dev = NULL;
+		rt_free(mte);
 		return jffs2_result_to_dfs(result);
 	}
 	/* save this pointer */
@@ -192,7 +201,7 @@ static int _find_fs(struct cyg_mtab_entry ** mte, rt_device_t dev_id)
 	/* find device index */
 	for (index = 0; index < DEVICE_PART_MAX; index++)
 	{
-		if (device_partition[index].dev == RT_MTD_NOR_DEVICE(dev_id))
+		if (device_partition[index].dev == (rt_mtd_t *)dev_id)
 		{
 			*mte = device_partition[index].mte;
 			return 0;
@@ -209,7 +218,7 @@ static int dfs_jffs2_unmount(struct dfs_filesystem* fs)
 	/* find device index, then umount it */
 	for (index = 0; index < DEVICE_PART_MAX; index++)
 	{
-		if (device_partition[index].dev == RT_MTD_NOR_DEVICE(fs->dev_id))
+		if (device_partition[index].dev == (rt_mtd_t *)fs->dev_id)
 		{
 			result = jffs2_umount(device_partition[index].mte);
 			if (result)
@@ -217,7 +226,7 @@ static int dfs_jffs2_unmount(struct dfs_filesystem* fs)
 			rt_free(device_partition[index].mte);
 			device_partition[index].dev = NULL;	
 			device_partition[index].mte = NULL;
-			return DFS_STATUS_OK;
+			return 0;
 		}
 	}
 	return -ENOENT;
@@ -225,8 +234,33 @@ static int dfs_jffs2_unmount(struct dfs_filesystem* fs)
 
 static int dfs_jffs2_mkfs(rt_device_t dev_id)
 {
-	/* just erase all blocks on this nand partition */
-	return -ENOSYS; 
+	rt_mtd_t *mtd = (rt_mtd_t *)dev_id;
+	struct erase_info instr;
+	unsigned index;
+	uint32_t addr;
+
+	if (mtd == RT_NULL || dev_id->type != RT_Device_Class_MTD ||
+		mtd->type != MTD_NORFLASH || mtd->erasesize == 0)
+		return -EINVAL;
+
+	/* it's mounted */
+	for (index = 0; index < DEVICE_PART_MAX; index++)
+	{
+		if (device_partition[index].dev == mtd)
+			return -EBUSY;
+	}
+
+	/* just erase all blocks on this partition, an empty flash is mounted as jffs2 */
+	for (addr = 0; addr < mtd->size; addr += mtd->erasesize)
+	{
+		/* mtd_erase adds the offset of partition to instr.addr */
+		instr.addr = addr;
+		instr.len = mtd->erasesize;
+		if (mtd_erase(mtd, &instr) != 0)
+			return -EIO;
+	}
+
+	return 0;
 }
 
 static int dfs_jffs2_statfs(struct dfs_filesystem* fs, 
@@ -274,7 +308,7 @@ static int dfs_jffs2_open(struct dfs_fd* file)
 	else /* name[0] still will be '/' */
 		name ++;
 		
-	result = _find_fs(&mte, file->fs->dev_id);		
+	result = _find_fs(&mte, file->dev);		
 	if (result) 
 	{
 		rt_free(jffs2_file);
@@ -506,7 +540,7 @@ static int dfs_jffs2_getdents(struct dfs_fd* file,
 
 #if !defined (CYGPKG_FS_JFFS2_RET_DIRENT_DTYPE)
 
-	result = _find_fs(&mte, file->fs->dev_id);
+	result = _find_fs(&mte, file->dev);
 	if (result)
 		return -ENOENT;
 #endif
@@ -531,9 +565,9 @@ static int dfs_jffs2_getdents(struct dfs_fd* file,
 #if defined (CYGPKG_FS_JFFS2_RET_DIRENT_DTYPE)
 		switch(jffs2_d.d_type & JFFS2_S_IFMT) 
 		{ 
-		case JFFS2_S_IFREG: d->d_type = DFS_DT_REG; break; 		
-		case JFFS2_S_IFDIR: d->d_type = DFS_DT_DIR; break; 
-		default: d->d_type = DFS_DT_UNKNOWN; break; 
+		case JFFS2_S_IFREG: d->d_type = DT_REG; break; 		
+		case JFFS2_S_IFDIR: d->d_type = DT_DIR; break; 
+		default: d->d_type = DT_UNKNOWN; break; 
 		} 	
 #else
 		fullname = rt_malloc(FILE_PATH_MAX);
@@ -560,9 +594,9 @@ static int dfs_jffs2_getdents(struct dfs_fd* file,
 		/* convert to dfs stat structure */
 		switch(s.st_mode & JFFS2_S_IFMT)
 		{
-		case JFFS2_S_IFREG: d->d_type = DFS_DT_REG; break;
-		case JFFS2_S_IFDIR: d->d_type = DFS_DT_DIR; break;
-		default: d->d_type = DFS_DT_UNKNOWN; break;
+		case JFFS2_S_IFREG: d->d_type = DT_REG; break;
+		case JFFS2_S_IFDIR: d->d_type = DT_DIR; break;
+		default: d->d_type = DT_UNKNOWN; break;
 		}
 #endif
 		/* write the rest fields of struct dirent* dirp  */
@@ -670,16 +704,16 @@ static int dfs_jffs2_stat(struct dfs_filesystem* fs, const char *path, struct st
 	switch(s.st_mode & JFFS2_S_IFMT) 
 	{ 
 	case JFFS2_S_IFREG: 
-		st->st_mode = DFS_S_IFREG | DFS_S_IRUSR | DFS_S_IRGRP | DFS_S_IROTH |
-		DFS_S_IWUSR | DFS_S_IWGRP | DFS_S_IWOTH;
+		st->st_mode = S_IFREG | S_IRUSR | S_IRGRP | S_IROTH |
+		S_IWUSR | S_IWGRP | S_IWOTH;
 		break;
 
 	case JFFS2_S_IFDIR:
-		st->st_mode = DFS_S_IFDIR | DFS_S_IXUSR | DFS_S_IXGRP | DFS_S_IXOTH;
+		st->st_mode = S_IFDIR | S_IXUSR | S_IXGRP | S_IXOTH;
 		break;		
 
 	default: 
-		st->st_mode = DFS_DT_UNKNOWN; //fixme
+		st->st_mode = DT_UNKNOWN; //fixme
 		break; 
 	} 	
 
@@ -36,13 +36,16 @@
 #define CONFIG_JFFS2_FS_DEBUG 		0  /* 1 or 2 */
 
 /* jffs2 gc thread section */
-//#define CYGOPT_FS_JFFS2_GCTHREAD
+#define CYGOPT_FS_JFFS2_GCTHREAD /* erase and collect garbage in a thread */
 #define CYGNUM_JFFS2_GC_THREAD_PRIORITY  (RT_THREAD_PRIORITY_MAX-2) /* GC thread's priority */
 #define CYGNUM_JFFS2_GS_THREAD_TICKS  20  /* event timeout ticks */
 #define CYGNUM_JFFS2_GC_THREAD_TICKS  20  /* GC thread's running ticks */
 
 //#define CONFIG_JFFS2_FS_WRITEBUFFER /* should not be enabled */
 
+/* write a summary node at the end of every block, to scan the block quickly on mount */
+#define CONFIG_JFFS2_SUMMARY
+
 /* zlib section*/
 //#define CONFIG_JFFS2_ZLIB
 //#define CONFIG_JFFS2_RTIME
@@ -313,7 +313,7 @@ static void jffs2_calc_trigger_levels(struct jffs2_sb_info *c)
 
 int jffs2_do_mount_fs(struct jffs2_sb_info *c)
 {
-	int i;
+	int i, ret;
 
 	c->free_size = c->flash_size;
 	c->nr_blocks = c->flash_size / c->sector_size;
@@ -351,8 +351,15 @@ int jffs2_do_mount_fs(struct jffs2_sb_info *c)
 	INIT_LIST_HEAD(&c->bad_used_list);
 	c->highest_ino = 1;
 
+	ret = jffs2_sum_init(c);
+	if (ret) {
+		kfree(c->blocks);
+		return ret;
+	}
+
 	if (jffs2_build_filesystem(c)) {
 		D1(printk(KERN_DEBUG "build_fs failed\n"));
+		jffs2_sum_exit(c);
 		jffs2_free_ino_caches(c);
 		jffs2_free_raw_node_refs(c);
 #ifndef __ECOS
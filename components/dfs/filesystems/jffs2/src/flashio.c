@@ -21,11 +21,10 @@ int jffs2_flash_read(struct jffs2_sb_info * c, uint32_t offset,
 		size_t * return_size,
 		unsigned char *buffer)
 {
-	uint32_t len;
+	size_t len;
 	struct super_block *sb = OFNI_BS_2SFFJ(c);
 
-	len = rt_mtd_nor_read(RT_MTD_NOR_DEVICE(sb->s_dev), offset, buffer, size);
-	if (len != size)
+	if (mtd_read((rt_mtd_t *)sb->s_dev, offset, size, &len, buffer) < 0 || len != size)
 		return -EIO;
 
 	* return_size = len;
@@ -36,11 +35,10 @@ int jffs2_flash_write(struct jffs2_sb_info * c,
 		uint32_t offset, const size_t size,
 		size_t * return_size, unsigned char *buffer)
 {
-	uint32_t len;
+	size_t len;
 	struct super_block *sb = OFNI_BS_2SFFJ(c);
 
-	len = rt_mtd_nor_write(RT_MTD_NOR_DEVICE(sb->s_dev), offset, buffer, size);
-	if (len != size)
+	if (mtd_write((rt_mtd_t *)sb->s_dev, offset, size, &len, buffer) < 0 || len != size)
 		return -EIO;
 
 	* return_size = len;
@@ -50,11 +48,12 @@ int jffs2_flash_write(struct jffs2_sb_info * c,
 int jffs2_flash_erase(struct jffs2_sb_info * c,
 		struct jffs2_eraseblock * jeb)
 {
-	rt_err_t result;
+	struct erase_info instr;
 	struct super_block *sb = OFNI_BS_2SFFJ(c);
 
-	result = rt_mtd_nor_erase_block(RT_MTD_NOR_DEVICE(sb->s_dev), jeb->offset, c->sector_size);
-	if (result != RT_EOK)
+	instr.addr = jeb->offset;
+	instr.len = c->sector_size;
+	if (mtd_erase((rt_mtd_t *)sb->s_dev, &instr) != 0)
 		return -EIO;
 
 	return ENOERR;
@@ -66,6 +65,7 @@ int jffs2_flash_direct_writev(struct jffs2_sb_info *c,
 {
 	unsigned long i;
 	size_t totlen = 0, thislen;
+	loff_t ofs = to;
 	int ret = 0;
 
 	for (i = 0; i < count; i++)
@@ -147,5 +147,14 @@ int jffs2_flash_direct_writev(struct jffs2_sb_info *c,
 writev_out:
 	if (retlen) *retlen = totlen;
 
+	if (jffs2_sum_active(c) && !ret)
+	{
+		// only a node written completely goes to the summary
+		for (i = 0, thislen = 0; i < count; i++)
+			thislen += vecs[i].iov_len;
+		if (thislen == totlen)
+			jffs2_sum_add_kvec(c, vecs, count, (uint32_t)ofs);
+	}
+
 	return ret;
 }
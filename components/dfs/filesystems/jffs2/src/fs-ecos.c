@@ -449,18 +449,18 @@ static int jffs2_read_super(struct super_block *sb)
 {
 	Cyg_ErrNo err;
 	struct jffs2_sb_info *c;
-	struct rt_mtd_nor_device *device;
+	rt_mtd_t *device;
 	
 	c = JFFS2_SB_INFO(sb);
-	device = RT_MTD_NOR_DEVICE(sb->s_dev);
+	device = (rt_mtd_t *)sb->s_dev;
 
 	/* initialize mutex lock */
 	init_MUTEX(&c->alloc_sem);
 	init_MUTEX(&c->erase_free_sem);
 
 	/* sector size is the erase block size */
-	c->sector_size = device->block_size;
-	c->flash_size  = (device->block_end - device->block_start) * device->block_size;
+	c->sector_size = device->erasesize;
+	c->flash_size  = device->size;
 	c->cleanmarker_size = sizeof(struct jffs2_unknown_node);
 
 	err = jffs2_do_mount_fs(c);
@@ -477,6 +477,7 @@ static int jffs2_read_super(struct super_block *sb)
 	return 0;
 
 out_nodes:
+	jffs2_sum_exit(c);
 	jffs2_free_ino_caches(c);
 	jffs2_free_raw_node_refs(c);
 	rt_free(c->blocks);
@@ -591,6 +592,12 @@ static int jffs2_umount(cyg_mtab_entry * mte)
 
 	// Only really umount if this is the only mount
 	if (jffs2_sb->s_mount_count == 1) {
+#ifdef CYGOPT_FS_JFFS2_GCTHREAD
+		// The GC thread reads inodes into the cache, stop it
+		// before the cache is evicted. It's started again if
+		// the file system is still in use.
+		jffs2_stop_garbage_collect_thread(c);
+#endif
 		icache_evict(root, NULL);
 		if (root->i_cache_next != NULL)	{
 			struct _inode *inode = root;
@@ -600,6 +607,9 @@ static int jffs2_umount(cyg_mtab_entry * mte)
 				       inode->i_ino, inode->i_count);
 				inode = inode->i_cache_next;
 			}
+#ifdef CYGOPT_FS_JFFS2_GCTHREAD
+			jffs2_start_garbage_collect_thread(c);
+#endif
 			// root icount was set to 1 on mount
 			return EBUSY;
                 }
@@ -623,11 +633,11 @@ static int jffs2_umount(cyg_mtab_entry * mte)
 		if (root->i_count != 1) {
 			printf("Ino #1 has use count %d\n",
 			       root->i_count);
-			return EBUSY;
-		}
 #ifdef CYGOPT_FS_JFFS2_GCTHREAD
-		jffs2_stop_garbage_collect_thread(c);
+			jffs2_start_garbage_collect_thread(c);
 #endif
+			return EBUSY;
+		}
 		jffs2_iput(root);	// Time to free the root inode
 
 		// free directory entries
@@ -641,6 +651,7 @@ static int jffs2_umount(cyg_mtab_entry * mte)
 		//root_i = NULL;
 
 		// Clean up the super block and root inode
+		jffs2_sum_exit(c);
 		jffs2_free_ino_caches(c);
 		jffs2_free_raw_node_refs(c);
 		rt_free(c->blocks);
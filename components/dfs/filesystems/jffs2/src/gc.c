@@ -596,6 +596,14 @@ static int jffs2_garbage_collect_pristine(struct jffs2_sb_info *c,
 
 	ret = jffs2_flash_write(c, phys_ofs, rawlen, &retlen, (unsigned char *)node);
 
+	if (!ret && retlen == rawlen && jffs2_sum_active(c)) {
+		struct iovec vec;
+
+		vec.iov_base = (void *)node;
+		vec.iov_len = rawlen;
+		jffs2_sum_add_kvec(c, &vec, 1, phys_ofs);
+	}
+
 	if (ret || (retlen != rawlen)) {
 		printk(KERN_NOTICE "Write of %d bytes at 0x%08x failed. returned %d, retlen %zd\n",
                        rawlen, phys_ofs, ret, retlen);
@@ -69,6 +69,8 @@ jffs2_stop_garbage_collect_thread(struct jffs2_sb_info *c)
      D1(printk("jffs2_stop_garbage_collect_thread\n"));
      /* Stop the thread and wait for it if necessary */
 
+     sb->s_gc_thread_started = 0;
+
      cyg_flag_setbits(&sb->s_gc_thread_flags,GC_THREAD_FLAG_STOP);
 
      D1(printk("jffs2_stop_garbage_collect_thread wait\n"));
@@ -127,126 +129,142 @@ jffs2_garbage_collect_thread(unsigned long data)
 }
 #endif 
 
-rt_uint32_t cyg_current_time(void)
-{
-	return 0;
-}
-
 static void
-jffs2_garbage_collect_thread(unsigned long data);
+jffs2_garbage_collect_thread(void *parameter);
 
 void jffs2_garbage_collect_trigger(struct jffs2_sb_info *c)
 {
      struct super_block *sb=OFNI_BS_2SFFJ(c);
 
+     /* the blocks are erased by jffs2_mount before the thread starts */
+     if (!sb->s_gc_thread_started)
+          return;
+
      /* Wake up the thread */
      D1(printk("jffs2_garbage_collect_trigger\n"));
 
      rt_event_send(&sb->s_gc_thread_flags,GC_THREAD_FLAG_TRIG);
 }
 
-static struct rt_thread gc_thread;
 void
 jffs2_start_garbage_collect_thread(struct jffs2_sb_info *c)
 {
      struct super_block *sb=OFNI_BS_2SFFJ(c);
-     cyg_mtab_entry *mte;
-     int result;
-	
+     rt_err_t result;
+
      RT_ASSERT(c);
-     //RT_ASSERT(!sb->s_gc_thread_handle);
-	 
-     mte=(cyg_dir *) sb->s_root;
-     RT_ASSERT(mte);
-	 
-     rt_event_init(&sb->s_gc_thread_flags, "gc_event", RT_IPC_FLAG_FIFO);	 
-     rt_mutex_init(&sb->s_lock, "gc_mutex", RT_IPC_FLAG_FIFO);
-//     rt_mutex_init(&mte->fs->syncmode, "fs_lock", RT_IPC_FLAG_FIFO);
-	 
+
+     rt_event_init(&sb->s_gc_thread_flags, "jffs2gc", RT_IPC_FLAG_FIFO);
+     rt_mutex_init(&sb->s_lock, "jffs2gc", RT_IPC_FLAG_FIFO);
+     sb->s_gc_thread_started = 1;
+
      D1(printk("jffs2_start_garbage_collect_thread\n"));
      /* Start the thread. Doesn't matter if it fails -- it's only an
       * optimisation anyway */
-     result =  rt_thread_init(&sb->s_gc_thread, 
-	                   "jffs2_gc_thread",
-                       jffs2_garbage_collect_thread,
-                       (void *)c,
-                       (void*)sb->s_gc_thread_stack,
-                       sizeof(sb->s_gc_thread_stack),
-					   CYGNUM_JFFS2_GC_THREAD_PRIORITY,
-					   CYGNUM_JFFS2_GC_THREAD_TICKS
-					   );
-	 if (result != RT_EOK) {
-		 rt_thread_startup(&sb->s_gc_thread);
-		 /* how to deal with the following filed? */
-		 /* sb->s_gc_thread_handle; */
-	 }
+     result = rt_thread_init(&sb->s_gc_thread,
+                             "jffs2gc",
+                             jffs2_garbage_collect_thread,
+                             (void *)c,
+                             (void *)sb->s_gc_thread_stack,
+                             sizeof(sb->s_gc_thread_stack),
+                             CYGNUM_JFFS2_GC_THREAD_PRIORITY,
+                             CYGNUM_JFFS2_GC_THREAD_TICKS);
+     if (result == RT_EOK)
+          rt_thread_startup(&sb->s_gc_thread);
+     else
+          rt_event_send(&sb->s_gc_thread_flags, GC_THREAD_FLAG_HAS_EXIT);
 }
 
 void
 jffs2_stop_garbage_collect_thread(struct jffs2_sb_info *c)
 {
      struct super_block *sb=OFNI_BS_2SFFJ(c);
-     cyg_mtab_entry *mte;
-	 rt_uint32_t  e;
-	 
-     //RT_ASSERT(sb->s_gc_thread_handle);
+     rt_uint32_t e;
 
      D1(printk("jffs2_stop_garbage_collect_thread\n"));
      /* Stop the thread and wait for it if necessary */
 
+     sb->s_gc_thread_started = 0;
+
      rt_event_send(&sb->s_gc_thread_flags,GC_THREAD_FLAG_STOP);
 
      D1(printk("jffs2_stop_garbage_collect_thread wait\n"));
-	 
+
      rt_event_recv(&sb->s_gc_thread_flags,
                    GC_THREAD_FLAG_HAS_EXIT,
                    RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR,
-				   RT_WAITING_FOREVER,  &e);
+                   RT_WAITING_FOREVER, &e);
 
      // Kill and free the resources ...  this is safe due to the flag
      // from the thread.
      rt_thread_detach(&sb->s_gc_thread);
-     rt_sem_detach(&sb->s_lock);
+     rt_mutex_detach(&sb->s_lock);
      rt_event_detach(&sb->s_gc_thread_flags);
 }
 
+/* the work left for the thread: blocks to be erased, or too few free blocks */
+static int jffs2_gc_thread_has_work(struct jffs2_sb_info *c)
+{
+     if (jffs2_is_readonly(c))
+          return 0;
+
+     return !list_empty(&c->erase_pending_list) ||
+            !list_empty(&c->erase_complete_list) ||
+            jffs2_thread_should_wake(c);
+}
 
 static void
-jffs2_garbage_collect_thread(unsigned long data)
+jffs2_garbage_collect_thread(void *parameter)
 {
-     struct jffs2_sb_info *c=(struct jffs2_sb_info *)data;
+     struct jffs2_sb_info *c=(struct jffs2_sb_info *)parameter;
      struct super_block *sb=OFNI_BS_2SFFJ(c);
-     cyg_mtab_entry *mte;
-     rt_uint32_t flag = 0;
-	 
+     rt_uint32_t flag;
+     int ret;
+
      D1(printk("jffs2_garbage_collect_thread START\n"));
 
      while(1) {
+          flag = 0;
           rt_event_recv(&sb->s_gc_thread_flags,
                         GC_THREAD_FLAG_TRIG | GC_THREAD_FLAG_STOP,
                         RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR,
-				        cyg_current_time() + CYGNUM_JFFS2_GS_THREAD_TICKS,  
-						&flag);
+                        CYGNUM_JFFS2_GS_THREAD_TICKS,
+                        &flag);
 
           if (flag & GC_THREAD_FLAG_STOP)
                break;
 
           D1(printk("jffs2: GC THREAD GC BEGIN\n"));
 
-          mte=(cyg_dir *) sb->s_root;
-          RT_ASSERT(mte != NULL);
-//          rt_mutex_take(&mte->fs->syncmode, RT_WAITING_FOREVER);
-
-          if (jffs2_garbage_collect_pass(c) == -ENOSPC) {
-               printf("No space for garbage collection. "
-                      "Aborting JFFS2 GC thread\n");
-               break;
+          /* the file system is serialized by jffs2_lock of dfs_jffs2.c, the
+           * lock is given up between the passes to let the writers in */
+          rt_mutex_take(&jffs2_lock, RT_WAITING_FOREVER);
+          while (jffs2_gc_thread_has_work(c)) {
+               if (!list_empty(&c->erase_pending_list) ||
+                   !list_empty(&c->erase_complete_list)) {
+                    jffs2_erase_pending_blocks(c, 1);
+               } else if ((ret = jffs2_garbage_collect_pass(c)) != 0) {
+                    if (ret == -ENOSPC)
+                         printf("No space for garbage collection. "
+                                "Stop JFFS2 GC until next trigger\n");
+                    break;
+               }
+
+               rt_mutex_release(&jffs2_lock);
+               rt_thread_yield();
+
+               /* stop is checked before the lock is taken again */
+               if (rt_event_recv(&sb->s_gc_thread_flags, GC_THREAD_FLAG_STOP,
+                                 RT_EVENT_FLAG_OR, 0, &flag) == RT_EOK)
+                    goto out;
+               rt_mutex_take(&jffs2_lock, RT_WAITING_FOREVER);
           }
-//          rt_mutex_release(&mte->fs->syncmode);
+          rt_mutex_release(&jffs2_lock);
           D1(printk("jffs2: GC THREAD GC END\n"));
      }
 
+out:
      D1(printk("jffs2_garbage_collect_thread EXIT\n"));
-     rt_event_send(&sb->s_gc_thread_flags,GC_THREAD_FLAG_HAS_EXIT);	 
+     rt_event_send(&sb->s_gc_thread_flags,GC_THREAD_FLAG_HAS_EXIT);
 }
 #endif
@@ -162,8 +162,29 @@ int jffs2_reserve_space_gc(struct jffs2_sb_info *c, uint32_t minsize, uint32_t *
 static int jffs2_do_reserve_space(struct jffs2_sb_info *c,  uint32_t minsize, uint32_t *ofs, uint32_t *len)
 {
 	struct jffs2_eraseblock *jeb = c->nextblock;
+	uint32_t reserved_size;		/* for the summary at the end of the block */
 	
  restart:
+	reserved_size = 0;
+
+	if (jeb && jffs2_sum_active(c)) {
+		reserved_size = jffs2_sum_reserved_size(c);
+
+		if (minsize + reserved_size > jeb->free_size) {
+			/* No room for this node and the summary. Write out the
+			   summary and close the block, unless the block is still
+			   empty, for a node that never fits with a summary */
+			if (jeb->free_size == c->sector_size - c->cleanmarker_size) {
+				jffs2_sum_disable_collecting(c);
+			} else {
+				D1(printk(KERN_DEBUG "jffs2_do_reserve_space: Writing summary for block at 0x%08x\n", jeb->offset));
+				jffs2_sum_write_sumnode(c);
+			}
+			jeb = c->nextblock;
+			goto restart;
+		}
+	}
+
 	if (jeb && minsize > jeb->free_size) {
 		/* Skip the end of this block and file it as having some dirty space */
 		/* If there's a pending write to it, flush now */
@@ -257,16 +278,19 @@ static int jffs2_do_reserve_space(struct jffs2_sb_info *c,  uint32_t minsize, ui
 		list_del(next);
 		c->nextblock = jeb = list_entry(next, struct jffs2_eraseblock, list);
 		c->nr_free_blocks--;
+		jffs2_sum_reset_collected(c);
 
 		if (jeb->free_size != c->sector_size - c->cleanmarker_size) {
 			printk(KERN_WARNING "Eep. Block 0x%08x taken from free_list had free_size of 0x%08x!!\n", jeb->offset, jeb->free_size);
 			goto restart;
 		}
+		if (jffs2_sum_active(c))
+			goto restart;	/* reserve the room for summary */
 	}
 	/* OK, jeb (==c->nextblock) is now pointing at a block which definitely has
 	   enough space */
 	*ofs = jeb->offset + (c->sector_size - jeb->free_size);
-	*len = jeb->free_size;
+	*len = jeb->free_size - reserved_size;
 
 	if (c->cleanmarker_size && jeb->used_size == c->cleanmarker_size &&
 	    !jeb->first_node->next_in_ino) {
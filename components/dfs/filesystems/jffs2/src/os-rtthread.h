@@ -165,6 +165,7 @@ struct super_block {
 	struct rt_mutex s_lock;             // Lock the inode cache
 	struct rt_event s_gc_thread_flags;  // Communication with the gcthread
 	//void (*s_gc_thread_handle)(void *parameter);
+	int s_gc_thread_started;            // the trigger is ignored before start
 	struct rt_thread s_gc_thread;
 //#if (CYGNUM_JFFS2_GC_THREAD_STACK_SIZE >= CYGNUM_HAL_STACK_SIZE_MINIMUM)
 //    char s_gc_thread_stack[CYGNUM_JFFS2_GC_THREAD_STACK_SIZE];
@@ -187,6 +188,8 @@ struct super_block {
 void jffs2_garbage_collect_trigger(struct jffs2_sb_info *c);
 void jffs2_start_garbage_collect_thread(struct jffs2_sb_info *c);
 void jffs2_stop_garbage_collect_thread(struct jffs2_sb_info *c);
+/* dfs_jffs2.c, taken by the gc thread as well as the file operations */
+extern struct rt_mutex jffs2_lock;
 #else
 static inline void jffs2_garbage_collect_trigger(struct jffs2_sb_info *c)
 {
@@ -231,7 +234,10 @@ int jffs2_rename (struct _inode *old_dir_i, struct _inode *d_inode, const unsign
 
 /* erase.c */
 static inline void jffs2_erase_pending_trigger(struct jffs2_sb_info *c)
-{ }
+{
+	/* the blocks are erased by the gc thread in the background */
+	jffs2_garbage_collect_trigger(c);
+}
 
 #ifndef CONFIG_JFFS2_FS_WRITEBUFFER
 #define SECTOR_ADDR(x) ( ((unsigned long)(x) & ~(c->sector_size-1)) )
@@ -465,7 +465,16 @@ static int jffs2_get_inode_nodes(struct jffs2_sb_info *c, struct jffs2_inode_inf
 			JFFS2_ERROR("error %d reading node at 0x%08x in get_inode_nodes()\n", err, ref_offset(ref));
 			goto free_out;
 		}
-			
+
+		if (!(je16_to_cpu(node.u.nodetype) & JFFS2_NODE_ACCURATE)) {
+			/* Obsoleted on the flash, but listed by the eraseblock
+			   summary which was written before */
+			JFFS2_DBG_READINODE("node at %08x is obsolete on flash\n", ref_offset(ref));
+			jffs2_mark_node_obsolete(c, ref);
+			spin_lock(&c->erase_completion_lock);
+			continue;
+		}
+
 		switch (je16_to_cpu(node.u.nodetype)) {
 			
 		case JFFS2_NODETYPE_DIRENT:
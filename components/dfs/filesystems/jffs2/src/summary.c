@@ -0,0 +1,540 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ * 2026-10-19     heyuanjie    use the layout of Linux
+ */
+
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/crc32.h>
+#include <linux/compiler.h>
+#include "nodelist.h"
+
+#ifdef CONFIG_JFFS2_SUMMARY
+
+#define DIRTY_SPACE(x) do { uint32_t _x = (x); \
+		c->free_size -= _x; c->dirty_size += _x; \
+		jeb->free_size -= _x ; jeb->dirty_size += _x; \
+		}while(0)
+#define USED_SPACE(x) do { uint32_t _x = (x); \
+		c->free_size -= _x; c->used_size += _x; \
+		jeb->free_size -= _x ; jeb->used_size += _x; \
+		}while(0)
+#define UNCHECKED_SPACE(x) do { uint32_t _x = (x); \
+		c->free_size -= _x; c->unchecked_size += _x; \
+		jeb->free_size -= _x ; jeb->unchecked_size += _x; \
+		}while(0)
+
+#define SUM_ENTRIES(s)	((s)->buf + sizeof(struct jffs2_raw_summary))
+
+int jffs2_sum_init(struct jffs2_sb_info *c)
+{
+	struct jffs2_summary *s;
+
+	s = kmalloc(sizeof(struct jffs2_summary), GFP_KERNEL);
+	if (!s)
+		return -ENOMEM;
+	memset(s, 0, sizeof(struct jffs2_summary));
+
+	/* the entries never take more than a block */
+	s->buf = kmalloc(c->sector_size, GFP_KERNEL);
+	if (!s->buf) {
+		kfree(s);
+		return -ENOMEM;
+	}
+
+	/* The nextblock left by the scan has nodes which are not collected.
+	   Collecting starts with the first block taken from free_list. */
+	s->disabled = 1;
+	c->summary = s;
+
+	return 0;
+}
+
+void jffs2_sum_exit(struct jffs2_sb_info *c)
+{
+	if (c->summary) {
+		kfree(c->summary->buf);
+		kfree(c->summary);
+		c->summary = NULL;
+	}
+}
+
+void jffs2_sum_reset_collected(struct jffs2_sb_info *c)
+{
+	if (c->summary) {
+		c->summary->sum_num = 0;
+		c->summary->sum_size = 0;
+		c->summary->disabled = 0;
+	}
+}
+
+void jffs2_sum_disable_collecting(struct jffs2_sb_info *c)
+{
+	if (c->summary)
+		c->summary->disabled = 1;
+}
+
+/* The room kept at the end of nextblock: the summary collected, the entry
+   of the node being reserved for, the summary header and the marker */
+uint32_t jffs2_sum_reserved_size(struct jffs2_sb_info *c)
+{
+	return PAD(c->summary->sum_size + JFFS2_SUMMARY_MAX_ENTRY + JFFS2_SUMMARY_FRAME_SIZE);
+}
+
+/* Copy the bytes at ofs of the data described by vecs */
+static int jffs2_sum_copy_vecs(const struct iovec *vecs, unsigned long count,
+			       uint32_t ofs, void *buf, uint32_t len)
+{
+	unsigned char *p = buf;
+	unsigned long i;
+	uint32_t n;
+
+	for (i = 0; i < count && len; i++) {
+		if (ofs >= vecs[i].iov_len) {
+			ofs -= vecs[i].iov_len;
+			continue;
+		}
+		n = min_t(uint32_t, vecs[i].iov_len - ofs, len);
+		memcpy(p, (unsigned char *)vecs[i].iov_base + ofs, n);
+		p += n;
+		len -= n;
+		ofs = 0;
+	}
+
+	return len ? -EINVAL : 0;
+}
+
+/**
+ *	jffs2_sum_add_kvec - collect a node written to nextblock
+ *	@c: superblock info
+ *	@vecs: the data of the node
+ *	@count: number of vecs
+ *	@ofs: flash offset of the node
+ *
+ *	A node which can't be described by the summary disables it for the
+ *	block, then the block is scanned fully at mount.
+ */
+int jffs2_sum_add_kvec(struct jffs2_sb_info *c, const struct iovec *vecs,
+		       unsigned long count, uint32_t ofs)
+{
+	struct jffs2_summary *s = c->summary;
+	struct jffs2_eraseblock *jeb = c->nextblock;
+	union jffs2_node_union node;
+	union jffs2_sum_flash *entry;
+	uint32_t size, end;
+
+	if (!jffs2_sum_active(c))
+		return 0;
+
+	/* The cleanmarker of a block just erased isn't in nextblock */
+	if (!jeb || ofs < jeb->offset || ofs >= jeb->offset + c->sector_size)
+		return 0;
+
+	if (jffs2_sum_copy_vecs(vecs, count, 0, &node, sizeof(struct jffs2_unknown_node)))
+		goto nosum;
+
+	switch (je16_to_cpu(node.u.nodetype)) {
+	case JFFS2_NODETYPE_INODE:
+		if (jffs2_sum_copy_vecs(vecs, count, 0, &node, sizeof(struct jffs2_raw_inode)))
+			goto nosum;
+		size = JFFS2_SUMMARY_INODE_SIZE;
+		break;
+
+	case JFFS2_NODETYPE_DIRENT:
+		if (jffs2_sum_copy_vecs(vecs, count, 0, &node, sizeof(struct jffs2_raw_dirent)))
+			goto nosum;
+		size = JFFS2_SUMMARY_DIRENT_SIZE(node.d.nsize);
+		break;
+
+	case JFFS2_NODETYPE_CLEANMARKER:
+	case JFFS2_NODETYPE_PADDING:
+		/* The scanner takes the space out of the entries as dirty */
+		return 0;
+
+	default:
+		goto nosum;
+	}
+
+	/* The summary must still fit behind this node */
+	end = ofs - jeb->offset + PAD(je32_to_cpu(node.u.totlen));
+	if (end + JFFS2_SUMMARY_FRAME_SIZE + s->sum_size + size > c->sector_size)
+		goto nosum;
+
+	entry = (union jffs2_sum_flash *)(SUM_ENTRIES(s) + s->sum_size);
+	if (je16_to_cpu(node.u.nodetype) == JFFS2_NODETYPE_INODE) {
+		entry->i.nodetype = node.i.nodetype;
+		entry->i.inode = node.i.ino;
+		entry->i.version = node.i.version;
+		entry->i.offset = cpu_to_je32(ofs - jeb->offset);
+		entry->i.totlen = node.i.totlen;
+	} else {
+		memset(entry, 0, size);
+		entry->d.nodetype = node.d.nodetype;
+		entry->d.nsize = node.d.nsize;
+		entry->d.type = node.d.type;
+		entry->d.totlen = node.d.totlen;
+		entry->d.offset = cpu_to_je32(ofs - jeb->offset);
+		entry->d.pino = node.d.pino;
+		entry->d.version = node.d.version;
+		entry->d.ino = node.d.ino;
+		if (jffs2_sum_copy_vecs(vecs, count, sizeof(struct jffs2_raw_dirent),
+					entry->d.name, node.d.nsize))
+			goto nosum;
+	}
+
+	s->sum_num++;
+	s->sum_size += size;
+
+	return 0;
+
+ nosum:
+	D1(printk(KERN_DEBUG "jffs2_sum_add_kvec(): Node at 0x%08x can't be collected, no summary for block at 0x%08x\n",
+		  ofs, jeb->offset));
+	s->disabled = 1;
+	return 0;
+}
+
+/**
+ *	jffs2_sum_write_sumnode - write the summary and fill up nextblock
+ *	@c: superblock info
+ *
+ *	Called with alloc_sem and erase_completion_lock held. The summary
+ *	node takes all of the free space, so the block is closed whether it's
+ *	written or not.
+ */
+int jffs2_sum_write_sumnode(struct jffs2_sb_info *c)
+{
+	struct jffs2_summary *s = c->summary;
+	struct jffs2_eraseblock *jeb = c->nextblock;
+	struct jffs2_raw_summary *sum = (struct jffs2_raw_summary *)s->buf;
+	struct jffs2_sum_marker *marker;
+	struct jffs2_raw_node_ref *raw;
+	uint32_t ofs, len, datalen;
+	size_t retlen;
+	int ret;
+
+	/* Done with this block, written or not */
+	s->disabled = 1;
+
+	ofs = jeb->offset + c->sector_size - jeb->free_size;
+	len = jeb->free_size;
+	datalen = sizeof(struct jffs2_raw_summary) + s->sum_size;
+	if (datalen + sizeof(struct jffs2_sum_marker) > len)
+		return 0;
+
+	raw = jffs2_alloc_raw_node_ref();
+	if (!raw)
+		return -ENOMEM;
+
+	/* The node takes the rest of block: the entries, the padding of
+	   0xff and the marker, which are all in sum_crc */
+	memset(s->buf + datalen, 0xff, len - datalen);
+	marker = (struct jffs2_sum_marker *)(s->buf + len - sizeof(struct jffs2_sum_marker));
+	marker->offset = cpu_to_je32(ofs - jeb->offset);
+	marker->magic = cpu_to_je32(JFFS2_SUM_MAGIC);
+
+	sum->magic = cpu_to_je16(JFFS2_MAGIC_BITMASK);
+	sum->nodetype = cpu_to_je16(JFFS2_NODETYPE_SUMMARY);
+	sum->totlen = cpu_to_je32(len);
+	sum->hdr_crc = cpu_to_je32(crc32(0, sum, sizeof(struct jffs2_unknown_node) - 4));
+	sum->sum_num = cpu_to_je32(s->sum_num);
+	sum->cln_mkr = cpu_to_je32(c->cleanmarker_size);
+	sum->padded = cpu_to_je32(0);
+	sum->sum_crc = cpu_to_je32(crc32(0, SUM_ENTRIES(s), len - sizeof(struct jffs2_raw_summary)));
+	sum->node_crc = cpu_to_je32(crc32(0, sum, sizeof(struct jffs2_raw_summary) - 8));
+
+	spin_unlock(&c->erase_completion_lock);
+
+	/* The padding is left erased. The marker goes last, so a summary
+	   broken by power loss is never used */
+	ret = jffs2_flash_write(c, ofs, datalen, &retlen, s->buf);
+	if (!ret && retlen != datalen)
+		ret = -EIO;
+	if (!ret) {
+		ret = jffs2_flash_write(c, ofs + len - sizeof(struct jffs2_sum_marker),
+					sizeof(struct jffs2_sum_marker), &retlen,
+					(unsigned char *)marker);
+		if (!ret && retlen != sizeof(struct jffs2_sum_marker))
+			ret = -EIO;
+	}
+	if (ret)
+		printk(KERN_NOTICE "Write of summary at 0x%08x failed: %d\n", ofs, ret);
+
+	/* Anything written in a failed summary is dirty */
+	raw->flash_offset = ofs | (ret ? REF_OBSOLETE : REF_NORMAL);
+	raw->__totlen = len;
+	raw->next_phys = NULL;
+	raw->next_in_ino = NULL;
+	jffs2_add_physical_node_ref(c, raw);
+
+	spin_lock(&c->erase_completion_lock);
+
+	D1(printk(KERN_DEBUG "jffs2_sum_write_sumnode(): %d entries for block at 0x%08x\n",
+		  s->sum_num, jeb->offset));
+	return ret;
+}
+
+/* Size of the entry, or 0 if it's broken */
+static uint32_t jffs2_sum_entry_size(const union jffs2_sum_flash *entry, uint32_t left)
+{
+	uint32_t size;
+
+	if (left < sizeof(jint16_t))
+		return 0;
+
+	switch (je16_to_cpu(entry->i.nodetype)) {
+	case JFFS2_NODETYPE_INODE:
+		size = JFFS2_SUMMARY_INODE_SIZE;
+		break;
+
+	case JFFS2_NODETYPE_DIRENT:
+		if (left < sizeof(struct jffs2_sum_dirent_flash))
+			return 0;
+		size = JFFS2_SUMMARY_DIRENT_SIZE(entry->d.nsize);
+		break;
+
+	default:
+		return 0;
+	}
+
+	return size <= left ? size : 0;
+}
+
+/* Check the entries before anything is built from them, so that the
+   block can still be scanned fully. They are in front of the marker */
+static int jffs2_sum_check_entries(struct jffs2_raw_summary *sum, uint32_t sumofs,
+				   uint32_t left)
+{
+	unsigned char *p = (unsigned char *)sum->sum;
+	uint32_t num = 0, prev = 0;
+	uint32_t size, ofs, totlen;
+	union jffs2_sum_flash *entry;
+
+	while (num < je32_to_cpu(sum->sum_num)) {
+		entry = (union jffs2_sum_flash *)p;
+		size = jffs2_sum_entry_size(entry, left);
+		if (!size)
+			return -EINVAL;
+
+		/* offset and totlen are at the same place for both */
+		if (je16_to_cpu(entry->i.nodetype) == JFFS2_NODETYPE_INODE) {
+			ofs = je32_to_cpu(entry->i.offset);
+			totlen = je32_to_cpu(entry->i.totlen);
+		} else {
+			ofs = je32_to_cpu(entry->d.offset);
+			totlen = je32_to_cpu(entry->d.totlen);
+		}
+		if ((ofs & 3) || ofs < prev || !totlen || ofs + PAD(totlen) > sumofs)
+			return -EINVAL;
+
+		prev = ofs + PAD(totlen);
+		p += size;
+		left -= size;
+		num++;
+	}
+
+	return 0;
+}
+
+static void jffs2_sum_link_node_ref(struct jffs2_eraseblock *jeb, struct jffs2_raw_node_ref *raw)
+{
+	if (!jeb->first_node)
+		jeb->first_node = raw;
+	if (jeb->last_node)
+		jeb->last_node->next_phys = raw;
+	jeb->last_node = raw;
+}
+
+/* Build the node refs and dirents as jffs2_scan_eraseblock() does */
+static int jffs2_sum_process_entries(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
+				     struct jffs2_raw_summary *sum, uint32_t sumofs,
+				     uint32_t *pseudo_random)
+{
+	unsigned char *p = (unsigned char *)sum->sum;
+	uint32_t num = je32_to_cpu(sum->sum_num);
+	uint32_t prev = 0;
+	uint32_t size, ofs, totlen;
+	union jffs2_sum_flash *entry;
+	struct jffs2_raw_node_ref *raw;
+	struct jffs2_inode_cache *ic;
+	struct jffs2_full_dirent *fd;
+
+	/* The cleanmarker is in the dirty space in front of the first node,
+	   for it's obsoleted by the first node written to the block */
+	while (num--) {
+		entry = (union jffs2_sum_flash *)p;
+		size = jffs2_sum_entry_size(entry, ~0U);
+
+		raw = jffs2_alloc_raw_node_ref();
+		if (!raw)
+			return -ENOMEM;
+
+		if (je16_to_cpu(entry->i.nodetype) == JFFS2_NODETYPE_INODE) {
+			ofs = je32_to_cpu(entry->i.offset);
+			totlen = PAD(je32_to_cpu(entry->i.totlen));
+
+			ic = jffs2_scan_make_ino_cache(c, je32_to_cpu(entry->i.inode));
+			if (!ic) {
+				jffs2_free_raw_node_ref(raw);
+				return -ENOMEM;
+			}
+			if (ofs > prev)
+				DIRTY_SPACE(ofs - prev);
+
+			raw->flash_offset = (jeb->offset + ofs) | REF_UNCHECKED;
+			raw->__totlen = totlen;
+			raw->next_phys = NULL;
+			raw->next_in_ino = ic->nodes;
+			ic->nodes = raw;
+			jffs2_sum_link_node_ref(jeb, raw);
+
+			*pseudo_random += je32_to_cpu(entry->i.version);
+			UNCHECKED_SPACE(totlen);
+		} else {
+			ofs = je32_to_cpu(entry->d.offset);
+			totlen = PAD(je32_to_cpu(entry->d.totlen));
+
+			fd = jffs2_alloc_full_dirent(entry->d.nsize + 1);
+			if (!fd) {
+				jffs2_free_raw_node_ref(raw);
+				return -ENOMEM;
+			}
+			memcpy(&fd->name, entry->d.name, entry->d.nsize);
+			fd->name[entry->d.nsize] = 0;
+
+			ic = jffs2_scan_make_ino_cache(c, je32_to_cpu(entry->d.pino));
+			if (!ic) {
+				jffs2_free_full_dirent(fd);
+				jffs2_free_raw_node_ref(raw);
+				return -ENOMEM;
+			}
+			if (ofs > prev)
+				DIRTY_SPACE(ofs - prev);
+
+			/* The summary crc stands for the node crc checked by
+			   the scan, so the dirent is pristine as well */
+			raw->flash_offset = (jeb->offset + ofs) | REF_PRISTINE;
+			raw->__totlen = totlen;
+			raw->next_phys = NULL;
+			raw->next_in_ino = ic->nodes;
+			ic->nodes = raw;
+			jffs2_sum_link_node_ref(jeb, raw);
+
+			fd->raw = raw;
+			fd->next = NULL;
+			fd->version = je32_to_cpu(entry->d.version);
+			fd->ino = je32_to_cpu(entry->d.ino);
+			fd->nhash = full_name_hash(fd->name, entry->d.nsize);
+			fd->type = entry->d.type;
+			jffs2_add_fd_to_list(c, fd, &ic->scan_dents);
+
+			*pseudo_random += fd->version;
+			USED_SPACE(totlen);
+		}
+
+		prev = ofs + totlen;
+		p += size;
+	}
+
+	/* Obsolete nodes behind the last one */
+	if (sumofs > prev)
+		DIRTY_SPACE(sumofs - prev);
+
+	return 0;
+}
+
+/**
+ *	jffs2_sum_scan_sumnode - scan a block by its summary
+ *	@c: superblock info
+ *	@jeb: the block
+ *	@pseudo_random: seed for jffs2_rotate_lists()
+ *
+ *	Returns the block state, or -EAGAIN if the block has no valid summary
+ *	and has to be scanned fully, or other error if the mount fails.
+ */
+int jffs2_sum_scan_sumnode(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
+			   uint32_t *pseudo_random)
+{
+	struct jffs2_summary *s = c->summary;
+	struct jffs2_raw_summary *sum = (struct jffs2_raw_summary *)s->buf;
+	struct jffs2_sum_marker marker;
+	struct jffs2_raw_node_ref *raw;
+	uint32_t sumofs, datalen, crc;
+	size_t retlen;
+	int ret;
+
+	ret = jffs2_flash_read(c, jeb->offset + c->sector_size - sizeof(marker),
+			       sizeof(marker), &retlen, (unsigned char *)&marker);
+	if (ret || retlen != sizeof(marker) || je32_to_cpu(marker.magic) != JFFS2_SUM_MAGIC)
+		return -EAGAIN;
+
+	sumofs = je32_to_cpu(marker.offset);
+	if ((sumofs & 3) || sumofs + JFFS2_SUMMARY_FRAME_SIZE > c->sector_size)
+		return -EAGAIN;
+
+	ret = jffs2_flash_read(c, jeb->offset + sumofs, sizeof(struct jffs2_raw_summary),
+			       &retlen, (unsigned char *)sum);
+	if (ret || retlen != sizeof(struct jffs2_raw_summary))
+		return -EAGAIN;
+
+	crc = crc32(0, sum, sizeof(struct jffs2_unknown_node) - 4);
+	if (je16_to_cpu(sum->magic) != JFFS2_MAGIC_BITMASK ||
+	    je16_to_cpu(sum->nodetype) != JFFS2_NODETYPE_SUMMARY ||
+	    je32_to_cpu(sum->hdr_crc) != crc ||
+	    je32_to_cpu(sum->totlen) != c->sector_size - sumofs) {
+		D1(printk(KERN_DEBUG "Summary of block at 0x%08x is not valid, or obsoleted by GC\n", jeb->offset));
+		return -EAGAIN;
+	}
+
+	crc = crc32(0, sum, sizeof(struct jffs2_raw_summary) - 8);
+	if (je32_to_cpu(sum->node_crc) != crc) {
+		printk(KERN_NOTICE "jffs2_sum_scan_sumnode(): Summary node at 0x%08x is broken\n", jeb->offset + sumofs);
+		return -EAGAIN;
+	}
+
+	/* A cleanmarker of another size is checked by the full scan */
+	if (je32_to_cpu(sum->cln_mkr) && je32_to_cpu(sum->cln_mkr) != c->cleanmarker_size)
+		return -EAGAIN;
+
+	/* The rest of block, the marker read above is the end of it */
+	datalen = c->sector_size - sumofs - sizeof(struct jffs2_raw_summary);
+	ret = jffs2_flash_read(c, jeb->offset + sumofs + sizeof(struct jffs2_raw_summary),
+			       datalen, &retlen, (unsigned char *)sum->sum);
+	if (ret || retlen != datalen)
+		return -EAGAIN;
+
+	crc = crc32(0, sum->sum, datalen);
+	if (je32_to_cpu(sum->sum_crc) != crc ||
+	    jffs2_sum_check_entries(sum, sumofs, datalen - sizeof(marker))) {
+		printk(KERN_NOTICE "jffs2_sum_scan_sumnode(): Entries of summary at 0x%08x are broken\n", jeb->offset + sumofs);
+		return -EAGAIN;
+	}
+
+	D1(printk(KERN_DEBUG "jffs2_sum_scan_sumnode(): %d entries for block at 0x%08x\n",
+		  je32_to_cpu(sum->sum_num), jeb->offset));
+
+	ret = jffs2_sum_process_entries(c, jeb, sum, sumofs, pseudo_random);
+	if (ret)
+		return ret;
+
+	/* The summary node itself, to the end of the block */
+	raw = jffs2_alloc_raw_node_ref();
+	if (!raw)
+		return -ENOMEM;
+	raw->flash_offset = (jeb->offset + sumofs) | REF_NORMAL;
+	raw->__totlen = c->sector_size - sumofs;
+	raw->next_phys = NULL;
+	raw->next_in_ino = NULL;
+	jffs2_sum_link_node_ref(jeb, raw);
+	USED_SPACE(c->sector_size - sumofs);
+
+	return jffs2_scan_classify_jeb(c, jeb);
+}
+
+#endif
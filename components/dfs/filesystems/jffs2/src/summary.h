@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ * 2026-10-19     heyuanjie    use the layout of Linux
+ */
+
+/*
+ * Eraseblock summary, after the CONFIG_JFFS2_SUMMARY of Linux.
+ *
+ * The nodes written to the current block are collected in memory. When the
+ * block is full, a summary node with an entry for every node is written
+ * behind the last node, and a marker pointing to the summary node takes the
+ * last 8 bytes of the block. The scanner reads the marker and the summary
+ * node instead of all nodes of the block.
+ *
+ * The layout of summary node, entries and marker is the one of Linux, so
+ * the summaries of images made by sumtool are used as well. The entries are
+ * packed, and there is no entry of xattr for it's not supported.
+ */
+
+#ifndef __JFFS2_SUMMARY_H__
+#define __JFFS2_SUMMARY_H__
+
+#define JFFS2_NODETYPE_SUMMARY	(JFFS2_FEATURE_RWCOMPAT_DELETE | JFFS2_NODE_ACCURATE | 6)
+#define JFFS2_SUM_MAGIC		0x02851885
+
+struct jffs2_sum_inode_flash
+{
+	jint16_t nodetype;	/* == JFFS2_NODETYPE_INODE */
+	jint32_t inode;
+	jint32_t version;
+	jint32_t offset;	/* of the node in the block */
+	jint32_t totlen;
+} __attribute__((packed));
+
+struct jffs2_sum_dirent_flash
+{
+	jint16_t nodetype;	/* == JFFS2_NODETYPE_DIRENT */
+	jint32_t totlen;
+	jint32_t offset;	/* of the node in the block */
+	jint32_t pino;
+	jint32_t version;
+	jint32_t ino;
+	uint8_t nsize;
+	uint8_t type;
+	uint8_t name[0];
+} __attribute__((packed));
+
+union jffs2_sum_flash
+{
+	struct jffs2_sum_inode_flash i;
+	struct jffs2_sum_dirent_flash d;
+};
+
+struct jffs2_raw_summary
+{
+	jint16_t magic;
+	jint16_t nodetype;	/* == JFFS2_NODETYPE_SUMMARY */
+	jint32_t totlen;	/* to the end of the block */
+	jint32_t hdr_crc;
+	jint32_t sum_num;	/* number of entries */
+	jint32_t cln_mkr;	/* size of cleanmarker, 0 for none */
+	jint32_t padded;	/* bytes of padding nodes */
+	jint32_t sum_crc;	/* crc of the rest of block, marker included */
+	jint32_t node_crc;	/* crc of the header before sum_crc */
+	jint32_t sum[0];
+} __attribute__((packed));
+
+/* the last 8 bytes of a block with summary */
+struct jffs2_sum_marker
+{
+	jint32_t offset;	/* of the summary node in the block */
+	jint32_t magic;		/* == JFFS2_SUM_MAGIC */
+};
+
+#define JFFS2_SUMMARY_INODE_SIZE	(sizeof(struct jffs2_sum_inode_flash))
+#define JFFS2_SUMMARY_DIRENT_SIZE(x)	(sizeof(struct jffs2_sum_dirent_flash) + (x))
+#define JFFS2_SUMMARY_FRAME_SIZE	(sizeof(struct jffs2_raw_summary) + sizeof(struct jffs2_sum_marker))
+/* room for the entry of the node being reserved for */
+#define JFFS2_SUMMARY_MAX_ENTRY		JFFS2_SUMMARY_DIRENT_SIZE(JFFS2_MAX_NAME_LEN)
+
+/* the summary being collected for c->nextblock */
+struct jffs2_summary
+{
+	uint32_t sum_num;
+	uint32_t sum_size;	/* bytes of entries */
+	int disabled;		/* no summary is written for this block */
+	unsigned char *buf;	/* the summary node, also used by the scanner */
+};
+
+#ifdef CONFIG_JFFS2_SUMMARY
+
+#define jffs2_sum_active(c)	((c)->summary && !(c)->summary->disabled)
+
+int jffs2_sum_init(struct jffs2_sb_info *c);
+void jffs2_sum_exit(struct jffs2_sb_info *c);
+void jffs2_sum_reset_collected(struct jffs2_sb_info *c);
+void jffs2_sum_disable_collecting(struct jffs2_sb_info *c);
+uint32_t jffs2_sum_reserved_size(struct jffs2_sb_info *c);
+int jffs2_sum_add_kvec(struct jffs2_sb_info *c, const struct iovec *vecs,
+		       unsigned long count, uint32_t ofs);
+int jffs2_sum_write_sumnode(struct jffs2_sb_info *c);
+int jffs2_sum_scan_sumnode(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
+			   uint32_t *pseudo_random);
+
+#else
+
+#define jffs2_sum_active(c)			(0)
+#define jffs2_sum_init(c)			(0)
+#define jffs2_sum_exit(c)			do { } while (0)
+#define jffs2_sum_reset_collected(c)		do { } while (0)
+#define jffs2_sum_disable_collecting(c)		do { } while (0)
+#define jffs2_sum_reserved_size(c)		(0)
+#define jffs2_sum_add_kvec(c, v, n, o)		((void)0)
+#define jffs2_sum_write_sumnode(c)		(0)
+#define jffs2_sum_scan_sumnode(c, j, p)		(-EAGAIN)
+
+#endif
+
+#endif
@@ -19,8 +19,15 @@
  *
  * Change Logs:
  * Date           Author       Notes
+ * 2026-10-19     heyuanjie    add page cache with read-ahead, write-behind
+ *                             with UNSTABLE write and COMMIT, and handle and
+ *                             attribute cache
+ * 2026-10-19     heyuanjie    lock each file instead of the file system,
+ *                             only the rpc client is shared
+ * 2026-10-19     heyuanjie    keep the UNSTABLE range of page until COMMIT,
+ *                             and read a page to the end of file by eof
  */
- 
+
 #include <stdio.h>
 #include <rtthread.h>
 #include <dfs_fs.h>
@@ -34,17 +41,95 @@
 #define NAME_MAX    64
 #define DFS_NFS_MAX_MTU  1024
 
+/* one READ or WRITE call moves one cache page */
+#define DFS_NFS_PAGE_SIZE       DFS_NFS_MAX_MTU
+
+/* pages cached for each opened file */
+#ifndef DFS_NFS_CACHE_PAGES
+#define DFS_NFS_CACHE_PAGES     8
+#endif
+
+/* pages read ahead of a sequential reader */
+#ifndef DFS_NFS_READAHEAD
+#define DFS_NFS_READAHEAD       4
+#endif
+
+/* written pages are committed in one batch once there are so many */
+#define DFS_NFS_COMMIT_PAGES    (DFS_NFS_CACHE_PAGES / 2)
+
+/* cached handles and attributes are trusted for this long, in millisecond */
+#ifndef DFS_NFS_ATTR_TIMEOUT
+#define DFS_NFS_ATTR_TIMEOUT    3000
+#endif
+
+/* entries of handle and attribute cache */
+#ifndef DFS_NFS_DENTRY_NUM
+#define DFS_NFS_DENTRY_NUM      32
+#endif
+
 #ifdef _WIN32
 #define strtok_r strtok_s
 #endif
 
+/* file handle with its own storage, so no allocation is needed */
+struct nfs_handle
+{
+    nfs_fh3 fh;
+    char data[NFS3_FHSIZE];
+};
+
+/* cache page state */
+#define PAGE_EMPTY      0   /* no data */
+#define PAGE_READING    1   /* READ is in flight */
+#define PAGE_CLEAN      2   /* same data as server */
+#define PAGE_DIRTY      3   /* modified, not sent yet */
+#define PAGE_WRITING    4   /* WRITE is in flight */
+#define PAGE_UNSTABLE   5   /* written, waiting for COMMIT */
+
+/* page has data written UNSTABLE, it may be DIRTY or WRITING again */
+#define PAGE_HAS_UNSTABLE(page) ((page)->unstable_end > (page)->unstable_start)
+
+struct nfs_page
+{
+    rt_uint8_t state;
+    rt_uint8_t loaded;      /* page was read from server, [0, length) is valid */
+    rt_uint8_t inflight;    /* call is in flight */
+    struct rpc_call call;
+
+    size_t offset;          /* file offset of page */
+    size_t length;
+    size_t dirty_start;
+    size_t dirty_end;
+    size_t unstable_start;  /* range written UNSTABLE and not committed */
+    size_t unstable_end;
+
+    rt_uint32_t used;       /* LRU stamp */
+    writeverf3 verf;        /* write verifier of unstable range, checked by COMMIT */
+
+    union
+    {
+        READ3res read;
+        WRITE3res write;
+    } res;
+
+    char *buf;
+};
+
 struct nfs_file
 {
-    nfs_fh3 handle;     /* handle */
+    struct rt_mutex lock;       /* the offset and the page cache */
+    struct nfs_handle handle;   /* handle */
     size_t offset;      /* current offset */
 
     size_t size;        /* total size */
-    bool_t eof;         /* end of file */
+    int error;          /* error of write-behind */
+    rt_bool_t written;  /* attributes on server are changed */
+
+    size_t ra_offset;   /* where a sequential read goes on */
+    rt_uint32_t clock;  /* LRU clock of pages */
+
+    char *pool;         /* buffers of pages */
+    struct nfs_page page[DFS_NFS_CACHE_PAGES];
 };
 
 struct nfs_dir
@@ -57,6 +142,18 @@ struct nfs_dir
     READDIR3res res;
 };
 
+/* handle and attributes of a path */
+struct nfs_dentry
+{
+    rt_uint32_t hash;   /* 0 for a free entry */
+    char *path;
+    rt_tick_t tick;     /* when the entry was filled */
+
+    struct nfs_handle handle;
+    bool_t attr_valid;
+    fattr3 attr;
+};
+
 #define HOST_LENGTH         32
 #define EXPORT_PATH_LENGTH  32
 struct nfs_filesystem
@@ -66,6 +163,9 @@ struct nfs_filesystem
     CLIENT *nfs_client;
     CLIENT *mount_client;
 
+    struct rt_mutex lock;           /* the handle and attribute cache */
+    struct nfs_dentry *dentry;
+
     char host[HOST_LENGTH];
     char export[EXPORT_PATH_LENGTH];
 };
@@ -107,7 +207,7 @@ static int nfs_parse_host_export(const char *host_export,
     /* copy export path */
     for (index = host_len; index < host_len + export_len; index ++)
     {
-        if (host_export[index] == 0) 
+        if (host_export[index] == 0)
         {
             export[index - host_len] = '\0';
 
@@ -134,209 +234,292 @@ static void copy_handle(nfs_fh3 *dest, const nfs_fh3 *source)
     memcpy(dest->data.data_val, source->data.data_val, dest->data.data_len);
 }
 
-static nfs_fh3 *get_handle(struct nfs_filesystem *nfs, const char *name)
+static void set_handle(struct nfs_handle *dest, const nfs_fh3 *source)
 {
-    nfs_fh3 *handle = RT_NULL;
-    char *file;
-    char *path;
-    char *init;
+    dest->fh.data.data_len = source->data.data_len;
+    if (dest->fh.data.data_len > NFS3_FHSIZE)
+        dest->fh.data.data_len = NFS3_FHSIZE;
+    dest->fh.data.data_val = dest->data;
 
-    init = path = rt_malloc(strlen(name)+1);
-    if (init == RT_NULL)
-        return RT_NULL;
+    memcpy(dest->data, source->data.data_val, dest->fh.data.data_len);
+}
 
-    memcpy(init, name, strlen(name)+1);
+static rt_uint32_t nfs_hash(const char *path, size_t length)
+{
+    rt_uint32_t hash = 5381;
 
-    handle = rt_malloc(sizeof(nfs_fh3));
-    if (handle == RT_NULL)
-    {
-        rt_free(init);
+    while (length --)
+        hash = ((hash << 5) + hash) + (rt_uint8_t)*path ++;
 
+    /* 0 is kept for a free entry */
+    return hash ? hash : 1;
+}
+
+/* the entry of path, nfs->lock must be held */
+static struct nfs_dentry *nfs_dentry_find(struct nfs_filesystem *nfs,
+                                          const char *path, size_t length)
+{
+    struct nfs_dentry *dentry;
+    rt_uint32_t hash;
+
+    hash = nfs_hash(path, length);
+    dentry = &nfs->dentry[hash % DFS_NFS_DENTRY_NUM];
+
+    if (dentry->hash != hash || strncmp(dentry->path, path, length) != 0 ||
+        dentry->path[length] != '\0')
         return RT_NULL;
-    }
 
-    if (path[0] == '/')
-    {
-        path ++;
-        copy_handle(handle, &nfs->root_handle);
-    }
-    else
+    /* expired, the server may have changed it */
+    if (rt_tick_get() - dentry->tick >= rt_tick_from_millisecond(DFS_NFS_ATTR_TIMEOUT))
     {
-        copy_handle(handle, &nfs->current_handle);
+        dentry->hash = 0;
+
+        return RT_NULL;
     }
 
-    while ((file = strtok_r(RT_NULL, "/", &path)) != RT_NULL)
-    {
-        LOOKUP3args args;
-        LOOKUP3res res;
-        memset(&res, 0, sizeof(res));
-        copy_handle(&args.what.dir, handle);
-        xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
-        args.what.name = file;
+    return dentry;
+}
 
-        if (nfsproc3_lookup_3(args, &res, nfs->nfs_client) != RPC_SUCCESS)
-        {
-            rt_kprintf("Lookup failed\n");
-            rt_free(init);
-            rt_free(handle);
-            xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&args.what.dir);
+/*
+ * get the cached handle of path, and its attributes when attr is not
+ * RT_NULL. Return -1 when path is not cached, 1 when the attributes are
+ * got too, otherwise 0.
+ */
+static int nfs_dentry_get(struct nfs_filesystem *nfs, const char *path, size_t length,
+                          struct nfs_handle *handle, fattr3 *attr)
+{
+    struct nfs_dentry *dentry;
+    int ret = -1;
 
-            return RT_NULL;
-        }
-        else if (res.status != NFS3_OK)
-        {
-            rt_kprintf("Lookup failed: %d\n", res.status);
-            rt_free(init);
-            rt_free(handle);
-            xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&args.what.dir);
-            xdr_free((xdrproc_t)xdr_LOOKUP3res, (char *)&res);
+    rt_mutex_take(&nfs->lock, RT_WAITING_FOREVER);
+    dentry = nfs_dentry_find(nfs, path, length);
+    if (dentry != RT_NULL)
+    {
+        set_handle(handle, &dentry->handle.fh);
+        ret = 0;
 
-            return RT_NULL;
+        if (attr != RT_NULL && dentry->attr_valid)
+        {
+            *attr = dentry->attr;
+            ret = 1;
         }
-        copy_handle(handle, &res.LOOKUP3res_u.resok.object);
-        xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&args.what.dir);
-        xdr_free((xdrproc_t)xdr_LOOKUP3res, (char *)&res);
     }
+    rt_mutex_release(&nfs->lock);
 
-    rt_free(init);
-
-    return handle;
+    return ret;
 }
 
-static nfs_fh3 *get_dir_handle(struct nfs_filesystem *nfs, const char *name)
+static void nfs_dentry_insert(struct nfs_filesystem *nfs,
+                              const char *path, size_t length,
+                              const nfs_fh3 *handle, const fattr3 *attr)
 {
-    nfs_fh3 *handle = RT_NULL;
-    char *file;
-    char *path;
-    char *init;
+    struct nfs_dentry *dentry;
+    rt_uint32_t hash;
 
-    init = path = rt_malloc(strlen(name)+1);
-    if (init == RT_NULL)
-        return RT_NULL;
-    memcpy(init, name, strlen(name)+1);
+    hash = nfs_hash(path, length);
 
-    handle = rt_malloc(sizeof(nfs_fh3));
-    if (handle == RT_NULL)
+    rt_mutex_take(&nfs->lock, RT_WAITING_FOREVER);
+    dentry = &nfs->dentry[hash % DFS_NFS_DENTRY_NUM];
+
+    /* keep the attributes got by another call for the same path */
+    if (attr == RT_NULL && dentry->hash == hash &&
+        strncmp(dentry->path, path, length) == 0 && dentry->path[length] == '\0')
     {
-        rt_free(init);
+        rt_mutex_release(&nfs->lock);
 
-        return RT_NULL;
+        return;
     }
 
-    if (path[0] == '/')
-    {
-        path ++;
-        copy_handle(handle, &nfs->root_handle);
-    }
-    else
-    {
-        copy_handle(handle, &nfs->current_handle);
-    }
+    if (dentry->path != RT_NULL)
+        rt_free(dentry->path);
 
-    while ((file = strtok_r(RT_NULL, "/", &path)) != RT_NULL && path[0] != 0)
+    dentry->hash = 0;
+    dentry->path = rt_malloc(length + 1);
+    if (dentry->path != RT_NULL)
     {
-        LOOKUP3args args;
-        LOOKUP3res res;
-        memset(&res, 0, sizeof(res));
-        copy_handle(&args.what.dir, handle);
-        xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
-        args.what.name = file;
-
-        if (nfsproc3_lookup_3(args, &res, nfs->nfs_client) != RPC_SUCCESS)
-        {
-            rt_kprintf("Lookup failed\n");
-            rt_free(init);
-            rt_free(handle);
-            xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&args.what.dir);
-
-            return RT_NULL;
-        }
-        else if (res.status != NFS3_OK)
+        memcpy(dentry->path, path, length);
+        dentry->path[length] = '\0';
+        dentry->hash = hash;
+        dentry->tick = rt_tick_get();
+        set_handle(&dentry->handle, handle);
+
+        dentry->attr_valid = FALSE;
+        if (attr != RT_NULL)
         {
-            rt_kprintf("Lookup failed: %d\n", res.status);
-            rt_free(init);
-            rt_free(handle);
-            xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&args.what.dir);
-            xdr_free((xdrproc_t)xdr_LOOKUP3res, (char *)&res);
-
-            return RT_NULL;
+            dentry->attr = *attr;
+            dentry->attr_valid = TRUE;
         }
-        copy_handle(handle, &res.LOOKUP3res_u.resok.object);
-        xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&args.what.dir);
-        xdr_free((xdrproc_t)xdr_LOOKUP3res, (char *)&res);
     }
+    rt_mutex_release(&nfs->lock);
+}
 
-    rt_free(init);
+/* drop the cached path and all of paths under it */
+static void nfs_dentry_invalidate(struct nfs_filesystem *nfs, const char *path)
+{
+    struct nfs_dentry *dentry;
+    size_t length;
+    int index;
 
-    return handle;
+    length = strlen(path);
+
+    rt_mutex_take(&nfs->lock, RT_WAITING_FOREVER);
+    for (index = 0; index < DFS_NFS_DENTRY_NUM; index ++)
+    {
+        dentry = &nfs->dentry[index];
+        if (dentry->hash == 0)
+            continue;
+
+        if (strncmp(dentry->path, path, length) == 0 &&
+            (dentry->path[length] == '\0' || dentry->path[length] == '/'))
+            dentry->hash = 0;
+    }
+    rt_mutex_release(&nfs->lock);
 }
 
-static size_t nfs_get_filesize(struct nfs_filesystem *nfs, nfs_fh3 *handle)
+static int nfs_getattr(struct nfs_filesystem *nfs, struct nfs_handle *handle, fattr3 *attr)
 {
     GETATTR3args args;
     GETATTR3res res;
-    fattr3 *info;
-    size_t size;
-
-    args.object = *handle;
 
+    args.object = handle->fh;
     memset(&res, '\0', sizeof(res));
 
-    if ((nfsproc3_getattr_3(args, &res, nfs->nfs_client)!=RPC_SUCCESS) ||
+    if (nfsproc3_getattr_3(args, &res, nfs->nfs_client) != RPC_SUCCESS ||
         res.status != NFS3_OK)
     {
         rt_kprintf("GetAttr failed: %d\n", res.status);
 
-        return 0;
+        return -1;
     }
 
-    info = &res.GETATTR3res_u.resok.obj_attributes;
-    size = info->size;
+    *attr = res.GETATTR3res_u.resok.obj_attributes;
     xdr_free((xdrproc_t)xdr_GETATTR3res, (char *)&res);
-    
-    return size;
+
+    return 0;
 }
 
-rt_bool_t nfs_is_directory(struct nfs_filesystem *nfs, const char *name)
+/*
+ * get handle of the first length characters of name, and its attributes
+ * when attr is not RT_NULL. Every directory on the way is cached, so only
+ * the part of path not seen recently costs LOOKUP calls.
+ */
+static int get_handle(struct nfs_filesystem *nfs, const char *name, size_t length,
+                      struct nfs_handle *handle, fattr3 *attr)
 {
-    GETATTR3args args;
-    GETATTR3res res;
-    fattr3 *info;
-    nfs_fh3 *handle;
-    rt_bool_t result;
+    char file[NAME_MAX];
+    size_t pos, start;
+    int cached;
 
-    result = RT_FALSE;
-    handle = get_handle(nfs, name);
-    if (handle == RT_NULL)
-        return RT_FALSE;
+    /* strip trailing '/' */
+    while (length > 1 && name[length - 1] == '/')
+        length --;
 
-    args.object = *handle;
+    cached = nfs_dentry_get(nfs, name, length, handle, attr);
+    if (cached < 0)
+    {
+        if (name[0] == '/')
+            set_handle(handle, &nfs->root_handle);
+        else
+            set_handle(handle, &nfs->current_handle);
 
-    memset(&res, '\0', sizeof(res));
+        pos = 0;
+        while (pos < length)
+        {
+            LOOKUP3args args;
+            LOOKUP3res res;
+            post_op_attr *obj_attr;
+
+            /* get next component */
+            while (pos < length && name[pos] == '/')
+                pos ++;
+            start = pos;
+            while (pos < length && name[pos] != '/')
+                pos ++;
+            if (pos == start)
+                break;
+
+            if (nfs_dentry_get(nfs, name, pos, handle, RT_NULL) >= 0)
+                continue;
+
+            if (pos - start >= NAME_MAX)
+                return -1;
+            memcpy(file, &name[start], pos - start);
+            file[pos - start] = '\0';
+
+            memset(&res, 0, sizeof(res));
+            args.what.dir = handle->fh;
+            args.what.name = file;
 
-    if (nfsproc3_getattr_3(args, &res, nfs->nfs_client) != RPC_SUCCESS)
+            if (nfsproc3_lookup_3(args, &res, nfs->nfs_client) != RPC_SUCCESS)
+            {
+                rt_kprintf("Lookup failed\n");
+
+                return -1;
+            }
+            else if (res.status != NFS3_OK)
+            {
+                xdr_free((xdrproc_t)xdr_LOOKUP3res, (char *)&res);
+
+                return -1;
+            }
+
+            set_handle(handle, &res.LOOKUP3res_u.resok.object);
+            obj_attr = &res.LOOKUP3res_u.resok.obj_attributes;
+            nfs_dentry_insert(nfs, name, pos, &handle->fh,
+                              obj_attr->attributes_follow ? &obj_attr->post_op_attr_u.attributes : RT_NULL);
+
+            /* the attributes of the last component come with LOOKUP */
+            if (pos >= length && attr != RT_NULL && obj_attr->attributes_follow)
+            {
+                *attr = obj_attr->post_op_attr_u.attributes;
+                cached = 1;
+            }
+            xdr_free((xdrproc_t)xdr_LOOKUP3res, (char *)&res);
+        }
+    }
+
+    if (attr == RT_NULL || cached == 1)
+        return 0;
+
+    if (nfs_getattr(nfs, handle, attr) < 0)
+        return -1;
+    nfs_dentry_insert(nfs, name, length, &handle->fh, attr);
+
+    return 0;
+}
+
+/* get handle of the directory which name is in */
+static int get_dir_handle(struct nfs_filesystem *nfs, const char *name,
+                          struct nfs_handle *handle)
+{
+    const char *ptr;
+
+    ptr = strrchr(name, '/');
+    if (ptr == RT_NULL)
     {
-        rt_kprintf("GetAttr failed\n");
+        set_handle(handle, &nfs->current_handle);
 
-        return RT_FALSE;
+        return 0;
     }
-    else if (res.status != NFS3_OK)
+    if (ptr == name)
     {
-        rt_kprintf("Getattr failed: %d\n", res.status);
+        set_handle(handle, &nfs->root_handle);
 
-        return RT_FALSE;
+        return 0;
     }
 
-    info=&res.GETATTR3res_u.resok.obj_attributes;
+    return get_handle(nfs, name, ptr - name, handle, RT_NULL);
+}
+
+rt_bool_t nfs_is_directory(struct nfs_filesystem *nfs, const char *name)
+{
+    struct nfs_handle handle;
+    fattr3 info;
 
-    if (info->type == NFS3DIR)
-        result = RT_TRUE;
+    if (get_handle(nfs, name, strlen(name), &handle, &info) < 0)
+        return RT_FALSE;
 
-    xdr_free((xdrproc_t)xdr_GETATTR3res, (char *)&res);
-    xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
-    rt_free(handle);
-    
-    return result;
+    return info.type == NFS3DIR ? RT_TRUE : RT_FALSE;
 }
 
 int nfs_create(struct nfs_filesystem *nfs, const char *name, mode_t mode)
@@ -344,19 +527,18 @@ int nfs_create(struct nfs_filesystem *nfs, const char *name, mode_t mode)
     CREATE3args args;
     CREATE3res res;
     int ret = 0;
-    nfs_fh3 *handle;
+    struct nfs_handle handle;
 
     if (nfs->nfs_client == RT_NULL)
     {
         return -1;
     }
 
-    handle = get_dir_handle(nfs, name);
-    if (handle == RT_NULL)
+    if (get_dir_handle(nfs, name, &handle) < 0)
     {
         return -1;
     }
-    args.where.dir = *handle;
+    args.where.dir = handle.fh;
     args.where.name = strrchr(name, '/') + 1;
     if (args.where.name == RT_NULL)
     {
@@ -385,8 +567,7 @@ int nfs_create(struct nfs_filesystem *nfs, const char *name, mode_t mode)
         ret = -1;
     }
     xdr_free((xdrproc_t)xdr_CREATE3res, (char *)&res);
-    xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
-    rt_free(handle);
+    nfs_dentry_invalidate(nfs, name);
 
     return ret;
 }
@@ -396,16 +577,15 @@ int nfs_mkdir(struct nfs_filesystem *nfs, const char *name, mode_t mode)
     MKDIR3args args;
     MKDIR3res res;
     int ret = 0;
-    nfs_fh3 *handle;
+    struct nfs_handle handle;
 
     if (nfs->nfs_client == RT_NULL)
         return -1;
 
-    handle = get_dir_handle(nfs, name);
-    if (handle == RT_NULL)
+    if (get_dir_handle(nfs, name, &handle) < 0)
         return -1;
 
-    args.where.dir = *handle;
+    args.where.dir = handle.fh;
     args.where.name = strrchr(name, '/') + 1;
     if (args.where.name == RT_NULL)
     {
@@ -433,9 +613,8 @@ int nfs_mkdir(struct nfs_filesystem *nfs, const char *name, mode_t mode)
         ret = -1;
     }
     xdr_free((xdrproc_t)xdr_MKDIR3res, (char *)&res);
-    xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
-    rt_free(handle);
-    
+    nfs_dentry_invalidate(nfs, name);
+
     return ret;
 }
 
@@ -446,6 +625,8 @@ int nfs_mount(struct dfs_filesystem *fs, unsigned long rwflag, const void *data)
     struct nfs_filesystem *nfs;
 
     nfs = (struct nfs_filesystem *)rt_malloc(sizeof(struct nfs_filesystem));
+    if (nfs == RT_NULL)
+        return -1;
     memset(nfs, 0, sizeof(struct nfs_filesystem));
 
     if (nfs_parse_host_export((const char *)data, nfs->host, HOST_LENGTH,
@@ -455,6 +636,14 @@ int nfs_mount(struct dfs_filesystem *fs, unsigned long rwflag, const void *data)
         goto __return;
     }
 
+    nfs->dentry = rt_malloc(sizeof(struct nfs_dentry) * DFS_NFS_DENTRY_NUM);
+    if (nfs->dentry == RT_NULL)
+    {
+        rt_kprintf("nfs: no memory\n");
+        goto __return;
+    }
+    memset(nfs->dentry, 0, sizeof(struct nfs_dentry) * DFS_NFS_DENTRY_NUM);
+
     nfs->mount_client=clnt_create((char *)nfs->host, MOUNT_PROGRAM, MOUNT_V3, "udp");
     if (nfs->mount_client == RT_NULL)
     {
@@ -483,6 +672,7 @@ int nfs_mount(struct dfs_filesystem *fs, unsigned long rwflag, const void *data)
     copy_handle(&nfs->current_handle, &nfs->root_handle);
 
     nfs->nfs_client->cl_auth = authnone_create();
+    rt_mutex_init(&nfs->lock, "nfs", RT_IPC_FLAG_FIFO);
     fs->data = nfs;
 
     return 0;
@@ -502,6 +692,10 @@ __return:
             }
             clnt_destroy(nfs->nfs_client);
         }
+        if (nfs->dentry != RT_NULL)
+        {
+            rt_free(nfs->dentry);
+        }
         rt_free(nfs);
     }
 
@@ -511,12 +705,13 @@ __return:
 int nfs_unmount(struct dfs_filesystem *fs)
 {
     struct nfs_filesystem *nfs;
+    int index;
 
     RT_ASSERT(fs != RT_NULL);
     RT_ASSERT(fs->data != RT_NULL);
     nfs = (struct nfs_filesystem *)fs->data;
 
-    if (nfs->mount_client != RT_NULL && 
+    if (nfs->mount_client != RT_NULL &&
         mountproc3_umnt_3((char *)nfs->export, RT_NULL, nfs->mount_client) != RPC_SUCCESS)
     {
         rt_kprintf("umount failed\n");
@@ -548,6 +743,16 @@ int nfs_unmount(struct dfs_filesystem *fs)
         nfs->mount_client = RT_NULL;
     }
 
+    for (index = 0; index < DFS_NFS_DENTRY_NUM; index ++)
+    {
+        if (nfs->dentry[index].path != RT_NULL)
+            rt_free(nfs->dentry[index].path);
+    }
+    rt_free(nfs->dentry);
+    xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&nfs->root_handle);
+    xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&nfs->current_handle);
+    rt_mutex_detach(&nfs->lock);
+
     rt_free(nfs);
     fs->data = RT_NULL;
 
@@ -559,13 +764,394 @@ int nfs_ioctl(struct dfs_fd *file, int cmd, void *args)
     return -ENOSYS;
 }
 
+/*
+ * page cache
+ *
+ * Each opened file caches DFS_NFS_CACHE_PAGES pages. READ and WRITE calls
+ * of pages are kept in flight on the rpc client: a sequential reader has
+ * the following pages read ahead, and a page filled by writer is sent as an
+ * UNSTABLE write at once. Written pages are committed in batch, and they
+ * are written again when the write verifier shows that server has lost
+ * them.
+ *
+ * The pages belong to the file and are protected by the lock of file, so
+ * the files are read and written in parallel. Only the rpc client is
+ * shared, and the reply of a call may be decoded by another thread.
+ */
+
+static int nfs_page_start(struct nfs_filesystem *nfs, nfs_file *fd, struct nfs_page *page,
+                          stable_how stable);
+static int nfs_page_start_write(struct nfs_filesystem *nfs, nfs_file *fd, struct nfs_page *page,
+                                stable_how stable);
+
+/* wait the call in flight of page */
+static int nfs_page_complete(struct nfs_filesystem *nfs, nfs_file *fd, struct nfs_page *page)
+{
+    enum clnt_stat status;
+
+    status = clntudp_call_wait(nfs->nfs_client, &page->call);
+    page->inflight = FALSE;
+
+    if (page->state == PAGE_READING)
+    {
+        if (status != RPC_SUCCESS || page->res.read.status != NFS3_OK)
+        {
+            rt_kprintf("Read failed: %d\n", page->res.read.status);
+            page->state = PAGE_EMPTY;
+
+            return -EIO;
+        }
+
+        page->length += page->res.read.READ3res_u.resok.count;
+
+        /* a short reply is not the end of file, read the rest of page */
+        if (!page->res.read.READ3res_u.resok.eof && page->res.read.READ3res_u.resok.count &&
+            page->length < DFS_NFS_PAGE_SIZE)
+        {
+            if (nfs_page_start(nfs, fd, page, UNSTABLE) < 0)
+            {
+                page->state = PAGE_EMPTY;
+
+                return -EIO;
+            }
+
+            return nfs_page_complete(nfs, fd, page);
+        }
+
+        page->loaded = TRUE;
+        page->state = PAGE_CLEAN;
+    }
+    else if (page->state == PAGE_WRITING)
+    {
+        if (status != RPC_SUCCESS || page->res.write.status != NFS3_OK ||
+            page->res.write.WRITE3res_u.resok.count != page->dirty_end - page->dirty_start)
+        {
+            rt_kprintf("Write failed: %d\n", page->res.write.status);
+            page->state = PAGE_DIRTY;
+            fd->error = -EIO;
+
+            return -EIO;
+        }
+
+        if (page->res.write.WRITE3res_u.resok.committed == UNSTABLE)
+        {
+            /* the ranges of page are contiguous, see nfs_write */
+            if (PAGE_HAS_UNSTABLE(page))
+            {
+                if (page->unstable_start < page->dirty_start) page->dirty_start = page->unstable_start;
+                if (page->unstable_end > page->dirty_end) page->dirty_end = page->unstable_end;
+                page->unstable_start = page->unstable_end = 0;
+
+                /* server has restarted after the earlier write, write all again in stable */
+                if (memcmp(page->verf, page->res.write.WRITE3res_u.resok.verf, NFS3_WRITEVERFSIZE) != 0)
+                {
+                    if (nfs_page_start_write(nfs, fd, page, FILE_SYNC) < 0)
+                    {
+                        fd->error = -EIO;
+
+                        return -EIO;
+                    }
+
+                    return nfs_page_complete(nfs, fd, page);
+                }
+            }
+
+            memcpy(page->verf, page->res.write.WRITE3res_u.resok.verf, NFS3_WRITEVERFSIZE);
+            page->unstable_start = page->dirty_start;
+            page->unstable_end = page->dirty_end;
+            page->state = PAGE_UNSTABLE;
+        }
+        else if (PAGE_HAS_UNSTABLE(page))
+        {
+            /* the earlier unstable range still waits for COMMIT */
+            page->state = PAGE_UNSTABLE;
+        }
+        else
+        {
+            /* only the loaded part of a written page is known */
+            page->state = page->loaded ? PAGE_CLEAN : PAGE_EMPTY;
+        }
+    }
+
+    return 0;
+}
+
+static int nfs_page_start(struct nfs_filesystem *nfs, nfs_file *fd, struct nfs_page *page,
+                          stable_how stable)
+{
+    enum clnt_stat status;
+
+    if (page->state == PAGE_READING)
+    {
+        READ3args args;
+
+        /* read the page from where the last reply ends */
+        args.file = fd->handle.fh;
+        args.offset = page->offset + page->length;
+        args.count = DFS_NFS_PAGE_SIZE - page->length;
+
+        /* data is decoded into page buffer directly */
+        memset(&page->res.read, 0, sizeof(page->res.read));
+        page->res.read.READ3res_u.resok.data.data_val = page->buf + page->length;
+
+        status = clntudp_call_start(nfs->nfs_client, &page->call, NFSPROC3_READ,
+                                    (xdrproc_t) xdr_READ3args, (char *) &args,
+                                    (xdrproc_t) xdr_READ3res, (char *) &page->res.read);
+    }
+    else
+    {
+        WRITE3args args;
+
+        args.file = fd->handle.fh;
+        args.offset = page->offset + page->dirty_start;
+        args.count = page->dirty_end - page->dirty_start;
+        args.stable = stable;
+        args.data.data_val = page->buf + page->dirty_start;
+        args.data.data_len = args.count;
+
+        memset(&page->res.write, 0, sizeof(page->res.write));
+        status = clntudp_call_start(nfs->nfs_client, &page->call, NFSPROC3_WRITE,
+                                    (xdrproc_t) xdr_WRITE3args, (char *) &args,
+                                    (xdrproc_t) xdr_WRITE3res, (char *) &page->res.write);
+    }
+
+    if (status != RPC_SUCCESS)
+        return -EIO;
+
+    page->inflight = TRUE;
+
+    return 0;
+}
+
+static int nfs_page_start_read(struct nfs_filesystem *nfs, nfs_file *fd, struct nfs_page *page)
+{
+    page->state = PAGE_READING;
+    if (nfs_page_start(nfs, fd, page, UNSTABLE) < 0)
+    {
+        page->state = PAGE_EMPTY;
+
+        return -EIO;
+    }
+
+    return 0;
+}
+
+static int nfs_page_start_write(struct nfs_filesystem *nfs, nfs_file *fd, struct nfs_page *page,
+                                stable_how stable)
+{
+    page->state = PAGE_WRITING;
+    if (nfs_page_start(nfs, fd, page, stable) < 0)
+    {
+        page->state = PAGE_DIRTY;
+
+        return -EIO;
+    }
+
+    return 0;
+}
+
+/* commit unstable pages, the pages lost by server are written again */
+static int nfs_file_commit(struct nfs_filesystem *nfs, nfs_file *fd)
+{
+    COMMIT3args args;
+    COMMIT3res res;
+    struct nfs_page *page;
+    int index, ret = 0;
+
+    args.file = fd->handle.fh;
+    args.offset = 0;
+    args.count = 0;     /* to the end of file */
+
+    memset(&res, 0, sizeof(res));
+    if (nfsproc3_commit_3(args, &res, nfs->nfs_client) != RPC_SUCCESS ||
+        res.status != NFS3_OK)
+    {
+        rt_kprintf("Commit failed: %d\n", res.status);
+
+        return -EIO;
+    }
+
+    for (index = 0; index < DFS_NFS_CACHE_PAGES; index ++)
+    {
+        page = &fd->page[index];
+        if (!PAGE_HAS_UNSTABLE(page) || page->inflight)
+            continue;
+
+        if (memcmp(page->verf, res.COMMIT3res_u.resok.verf, NFS3_WRITEVERFSIZE) == 0)
+        {
+            page->unstable_start = page->unstable_end = 0;
+            if (page->state == PAGE_UNSTABLE)
+                page->state = PAGE_CLEAN;
+        }
+        else if (page->state == PAGE_DIRTY)
+        {
+            /* server has restarted, the unstable range is sent with dirty one */
+            if (page->unstable_start < page->dirty_start) page->dirty_start = page->unstable_start;
+            if (page->unstable_end > page->dirty_end) page->dirty_end = page->unstable_end;
+            page->unstable_start = page->unstable_end = 0;
+        }
+        else
+        {
+            /* server has restarted, write the unstable range again in stable */
+            page->dirty_start = page->unstable_start;
+            page->dirty_end = page->unstable_end;
+            page->unstable_start = page->unstable_end = 0;
+            if (nfs_page_start_write(nfs, fd, page, FILE_SYNC) < 0 ||
+                nfs_page_complete(nfs, fd, page) < 0)
+                ret = -EIO;
+        }
+
+        /* only the loaded part of a written page is known */
+        if (page->state == PAGE_CLEAN && !page->loaded)
+            page->state = PAGE_EMPTY;
+    }
+
+    return ret;
+}
+
+/* write all of dirty pages and commit them */
+static int nfs_file_sync(struct nfs_filesystem *nfs, nfs_file *fd)
+{
+    struct nfs_page *page;
+    int index, unstable = 0;
+    int ret;
+
+    for (index = 0; index < DFS_NFS_CACHE_PAGES; index ++)
+    {
+        page = &fd->page[index];
+        if (page->state == PAGE_DIRTY)
+            nfs_page_start_write(nfs, fd, page, UNSTABLE);
+    }
+
+    for (index = 0; index < DFS_NFS_CACHE_PAGES; index ++)
+    {
+        page = &fd->page[index];
+        if (page->inflight)
+            nfs_page_complete(nfs, fd, page);
+
+        if (PAGE_HAS_UNSTABLE(page))
+            unstable ++;
+    }
+
+    if (unstable && nfs_file_commit(nfs, fd) < 0)
+        fd->error = -EIO;
+
+    ret = fd->error;
+    fd->error = 0;
+
+    return ret;
+}
+
+static struct nfs_page *nfs_page_find(nfs_file *fd, size_t offset)
+{
+    int index;
+
+    for (index = 0; index < DFS_NFS_CACHE_PAGES; index ++)
+    {
+        if (fd->page[index].state != PAGE_EMPTY && fd->page[index].offset == offset)
+            return &fd->page[index];
+    }
+
+    return RT_NULL;
+}
+
+/*
+ * get a page to cache data at offset. An empty or clean page is reused
+ * first; when all of pages hold data not on server, they are synchronized
+ * if sync is true, otherwise RT_NULL is returned.
+ */
+static struct nfs_page *nfs_page_alloc(struct nfs_filesystem *nfs, nfs_file *fd,
+                                       size_t offset, rt_bool_t sync)
+{
+    struct nfs_page *page, *victim;
+    int index;
+
+    while (1)
+    {
+        victim = RT_NULL;
+        for (index = 0; index < DFS_NFS_CACHE_PAGES; index ++)
+        {
+            page = &fd->page[index];
+            if (page->state == PAGE_EMPTY)
+            {
+                victim = page;
+                break;
+            }
+
+            if (page->state == PAGE_CLEAN &&
+                (victim == RT_NULL || (rt_int32_t)(page->used - victim->used) < 0))
+                victim = page;
+        }
+
+        if (victim != RT_NULL)
+            break;
+
+        if (sync == RT_FALSE || nfs_file_sync(nfs, fd) < 0)
+            return RT_NULL;
+    }
+
+    victim->state = PAGE_EMPTY;
+    victim->loaded = FALSE;
+    victim->offset = offset;
+    victim->length = 0;
+    victim->dirty_start = victim->dirty_end = 0;
+    victim->unstable_start = victim->unstable_end = 0;
+    victim->used = fd->clock ++;
+
+    return victim;
+}
+
+static int nfs_file_cache_init(nfs_file *fd)
+{
+    int index;
+
+    if (fd->pool != RT_NULL)
+        return 0;
+
+    fd->pool = rt_malloc(DFS_NFS_PAGE_SIZE * DFS_NFS_CACHE_PAGES);
+    if (fd->pool == RT_NULL)
+        return -ENOMEM;
+
+    for (index = 0; index < DFS_NFS_CACHE_PAGES; index ++)
+    {
+        fd->page[index].state = PAGE_EMPTY;
+        fd->page[index].inflight = FALSE;
+        fd->page[index].buf = fd->pool + index * DFS_NFS_PAGE_SIZE;
+    }
+
+    return 0;
+}
+
+/* start reading the pages after offset when they are not cached yet */
+static void nfs_readahead(struct nfs_filesystem *nfs, nfs_file *fd, size_t offset)
+{
+    struct nfs_page *page;
+    int index;
+
+    for (index = 0; index < DFS_NFS_READAHEAD; index ++, offset += DFS_NFS_PAGE_SIZE)
+    {
+        if (offset >= fd->size)
+            break;
+
+        if (nfs_page_find(fd, offset) != RT_NULL)
+            continue;
+
+        /* read ahead never pushes out data not on server */
+        page = nfs_page_alloc(nfs, fd, offset, RT_FALSE);
+        if (page == RT_NULL || nfs_page_start_read(nfs, fd, page) < 0)
+            break;
+    }
+}
+
 int nfs_read(struct dfs_fd *file, void *buf, rt_size_t count)
 {
-    READ3args args;
-    READ3res res;
-    ssize_t bytes, total=0;
     nfs_file *fd;
     struct nfs_filesystem *nfs;
+    struct nfs_page *page;
+    size_t page_offset, length;
+    rt_bool_t sequential;
+    ssize_t total = 0;
+    int ret;
 
     if (file->type == FT_DIRECTORY)
         return -EISDIR;
@@ -579,60 +1165,94 @@ int nfs_read(struct dfs_fd *file, void *buf, rt_size_t count)
     if (nfs->nfs_client == RT_NULL)
         return -1;
 
-    /* end of file */
-    if (fd->eof == TRUE)
-        return 0;
+    rt_mutex_take(&fd->lock, RT_WAITING_FOREVER);
+    if (nfs_file_cache_init(fd) < 0)
+    {
+        rt_mutex_release(&fd->lock);
 
-    args.file = fd->handle;
-    do {
-        args.offset = fd->offset;
-        args.count = count > DFS_NFS_MAX_MTU ? DFS_NFS_MAX_MTU : count;
-        count -= args.count;
+        return -ENOMEM;
+    }
 
-        memset(&res, 0, sizeof(res));
-        if (nfsproc3_read_3(args, &res, nfs->nfs_client) != RPC_SUCCESS)
+    sequential = (fd->offset == fd->ra_offset) ? RT_TRUE : RT_FALSE;
+    while (count > 0)
+    {
+        page_offset = fd->offset - (fd->offset % DFS_NFS_PAGE_SIZE);
+
+        page = nfs_page_find(fd, page_offset);
+        if (page != RT_NULL && page->state == PAGE_WRITING)
+            nfs_page_complete(nfs, fd, page);
+
+        /* a partially written page does not know the rest, get it from server */
+        if (page != RT_NULL && page->state != PAGE_READING && !page->loaded)
         {
-            rt_kprintf("Read failed\n");
-            total = 0;
-            break;
+            if (nfs_file_sync(nfs, fd) < 0)
+            {
+                total = total ? total : -EIO;
+                break;
+            }
+            page = nfs_page_find(fd, page_offset);
         }
-        else if (res.status != NFS3_OK)
+
+        if (page == RT_NULL)
         {
-            rt_kprintf("Read failed: %d\n", res.status);
-            total = 0;
-            break;
+            page = nfs_page_alloc(nfs, fd, page_offset, RT_TRUE);
+            if (page == RT_NULL || nfs_page_start_read(nfs, fd, page) < 0)
+            {
+                total = total ? total : -EIO;
+                break;
+            }
         }
-        else
+        page->used = fd->clock ++;
+
+        /* keep the following pages in flight while waiting this one */
+        if (sequential)
+            nfs_readahead(nfs, fd, page_offset + DFS_NFS_PAGE_SIZE);
+
+        if (page->state == PAGE_READING)
         {
-            bytes = res.READ3res_u.resok.count;
-            total += bytes;
-            fd->offset += bytes;
-            /* update current position */
-            file->pos = fd->offset;
-            memcpy(buf, res.READ3res_u.resok.data.data_val, bytes);
-            buf = (void *)((char *)buf + args.count);
-            if (res.READ3res_u.resok.eof)
+            ret = nfs_page_complete(nfs, fd, page);
+            if (ret < 0)
             {
-                /* something should probably be here */
-                fd->eof = TRUE;
+                total = total ? total : ret;
                 break;
             }
         }
-        xdr_free((xdrproc_t)xdr_READ3res, (char *)&res);
-    } while(count > 0);
 
-    xdr_free((xdrproc_t)xdr_READ3res, (char *)&res);
+        /* end of file */
+        if (page->length <= fd->offset - page_offset)
+            break;
+
+        length = page->length - (fd->offset - page_offset);
+        if (length > count)
+            length = count;
+
+        memcpy(buf, page->buf + (fd->offset - page_offset), length);
+        buf = (void *)((char *)buf + length);
+        fd->offset += length;
+        total += length;
+        count -= length;
+
+        /* a page is read to the end of file, so a short one is the end */
+        if (page->length < DFS_NFS_PAGE_SIZE)
+            break;
+    }
+
+    fd->ra_offset = fd->offset;
+    /* update current position */
+    file->pos = fd->offset;
+    rt_mutex_release(&fd->lock);
 
     return total;
 }
 
 int nfs_write(struct dfs_fd *file, const void *buf, rt_size_t count)
 {
-    WRITE3args args;
-    WRITE3res res;
-    ssize_t bytes, total=0;
     nfs_file *fd;
     struct nfs_filesystem *nfs;
+    struct nfs_page *page;
+    size_t page_offset, start, length;
+    ssize_t total = 0;
+    int index, unstable;
 
     if (file->type == FT_DIRECTORY)
         return -EISDIR;
@@ -646,50 +1266,133 @@ int nfs_write(struct dfs_fd *file, const void *buf, rt_size_t count)
     if (nfs->nfs_client == RT_NULL)
         return -1;
 
-    args.file = fd->handle;
-    args.stable = FILE_SYNC;
+    rt_mutex_take(&fd->lock, RT_WAITING_FOREVER);
+    if (nfs_file_cache_init(fd) < 0)
+    {
+        rt_mutex_release(&fd->lock);
 
-    do {
-        args.offset = fd->offset;
+        return -ENOMEM;
+    }
 
-        memset(&res, 0, sizeof(res));
-        args.data.data_val=(void *)buf;
-        args.count = count > DFS_NFS_MAX_MTU ? DFS_NFS_MAX_MTU : count;
-        args.data.data_len = args.count;
-        count -= args.count;
-        buf = (const void *)((char *)buf + args.count);
+    while (count > 0)
+    {
+        page_offset = fd->offset - (fd->offset % DFS_NFS_PAGE_SIZE);
+        start = fd->offset - page_offset;
+        length = DFS_NFS_PAGE_SIZE - start;
+        if (length > count)
+            length = count;
+
+        page = nfs_page_find(fd, page_offset);
+        if (page != RT_NULL && page->inflight)
+            nfs_page_complete(nfs, fd, page);
+
+        /* only one dirty range is kept in a page, send the old one */
+        if (page != RT_NULL && page->state == PAGE_DIRTY &&
+            (start > page->dirty_end || start + length < page->dirty_start))
+        {
+            if (nfs_page_start_write(nfs, fd, page, UNSTABLE) < 0 ||
+                nfs_page_complete(nfs, fd, page) < 0)
+            {
+                total = total ? total : -EIO;
+                break;
+            }
+        }
 
-        if (nfsproc3_write_3(args, &res, nfs->nfs_client) != RPC_SUCCESS)
+        /*
+         * the unstable range must be contiguous with the dirty one, so a
+         * page is rewritten in one range when server has lost it
+         */
+        if (page != RT_NULL && PAGE_HAS_UNSTABLE(page) &&
+            (start > page->unstable_end || start + length < page->unstable_start))
         {
-            rt_kprintf("Write failed\n");
-            total = 0;
-            break;
+            if (nfs_file_sync(nfs, fd) < 0)
+            {
+                total = total ? total : -EIO;
+                break;
+            }
         }
-        else if (res.status != NFS3_OK)
+
+        if (page == RT_NULL || page->state == PAGE_EMPTY)
         {
-            rt_kprintf("Write failed: %d\n", res.status);
-            total = 0;
-            break;
+            page = nfs_page_alloc(nfs, fd, page_offset, RT_TRUE);
+            if (page == RT_NULL)
+            {
+                total = total ? total : -EIO;
+                break;
+            }
+        }
+        page->used = fd->clock ++;
+
+        /* fill the hole after end of file with zero */
+        if (page->loaded && page->length < start)
+            memset(page->buf + page->length, 0, start - page->length);
+        memcpy(page->buf + start, buf, length);
+        if (page->state == PAGE_DIRTY)
+        {
+            if (start < page->dirty_start) page->dirty_start = start;
+            if (start + length > page->dirty_end) page->dirty_end = start + length;
         }
         else
         {
-            bytes = res.WRITE3res_u.resok.count;
-            fd->offset += bytes;
-            total += bytes;
-            /* update current position */
-            file->pos = fd->offset;
-            /* update file size */
-			if (fd->size < fd->offset) fd->size = fd->offset;
-			file->size = fd->size;
+            page->dirty_start = start;
+            page->dirty_end = start + length;
         }
-        xdr_free((xdrproc_t)xdr_WRITE3res, (char *)&res);
-    } while (count > 0);
+        if (page->loaded && page->length < start + length)
+            page->length = start + length;
+        page->state = PAGE_DIRTY;
+
+        /* write behind the page once it is filled to the end */
+        if (page->dirty_end == DFS_NFS_PAGE_SIZE)
+            nfs_page_start_write(nfs, fd, page, UNSTABLE);
+
+        buf = (const void *)((const char *)buf + length);
+        fd->offset += length;
+        total += length;
+        count -= length;
+        fd->written = RT_TRUE;
+
+        /* update file size */
+        if (fd->size < fd->offset) fd->size = fd->offset;
+    }
+
+    /* commit in batch */
+    for (index = 0, unstable = 0; index < DFS_NFS_CACHE_PAGES; index ++)
+    {
+        if (PAGE_HAS_UNSTABLE(&fd->page[index]) || fd->page[index].state == PAGE_WRITING)
+            unstable ++;
+    }
+    if (unstable >= DFS_NFS_COMMIT_PAGES)
+        nfs_file_sync(nfs, fd);
 
-    xdr_free((xdrproc_t)xdr_WRITE3res, (char *)&res);
+    /* update current position */
+    file->pos = fd->offset;
+    file->size = fd->size;
+    rt_mutex_release(&fd->lock);
 
     return total;
 }
 
+int nfs_flush(struct dfs_fd *file)
+{
+    nfs_file *fd;
+    struct nfs_filesystem *nfs;
+    int ret;
+
+    if (file->type != FT_REGULAR)
+        return 0;
+
+    fd = (nfs_file *)(file->data);
+    nfs = (struct nfs_filesystem *)file->fs->data;
+    if (fd->pool == RT_NULL)
+        return 0;
+
+    rt_mutex_take(&fd->lock, RT_WAITING_FOREVER);
+    ret = nfs_file_sync(nfs, fd);
+    rt_mutex_release(&fd->lock);
+
+    return ret;
+}
+
 int nfs_lseek(struct dfs_fd *file, rt_off_t offset)
 {
     nfs_file *fd;
@@ -700,18 +1403,26 @@ int nfs_lseek(struct dfs_fd *file, rt_off_t offset)
     fd = (nfs_file *)(file->data);
     RT_ASSERT(fd != RT_NULL);
 
-    if (offset <= fd->size)
+    rt_mutex_take(&fd->lock, RT_WAITING_FOREVER);
+    if (offset > fd->size)
     {
-        fd->offset = offset;
+        rt_mutex_release(&fd->lock);
 
-        return offset;
+        return -EIO;
     }
+    fd->offset = offset;
+    rt_mutex_release(&fd->lock);
 
-    return -EIO;
+    return offset;
 }
 
 int nfs_close(struct dfs_fd *file)
 {
+    struct nfs_filesystem *nfs;
+    int ret = 0;
+
+    nfs = (struct nfs_filesystem *)file->fs->data;
+
     if (file->type == FT_DIRECTORY)
     {
         struct nfs_dir *dir;
@@ -727,12 +1438,22 @@ int nfs_close(struct dfs_fd *file)
 
         fd = (struct nfs_file *)file->data;
 
-        xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&fd->handle);
+        if (fd->pool != RT_NULL)
+        {
+            ret = nfs_file_sync(nfs, fd);
+            rt_free(fd->pool);
+        }
+
+        /* the file is changed by ourself, drop the attributes */
+        if (fd->written)
+            nfs_dentry_invalidate(nfs, file->path);
+
+        rt_mutex_detach(&fd->lock);
         rt_free(fd);
     }
 
     file->data = RT_NULL;
-    return 0;
+    return ret;
 }
 
 int nfs_open(struct dfs_fd *file)
@@ -746,7 +1467,7 @@ int nfs_open(struct dfs_fd *file)
     if (file->flags & O_DIRECTORY)
     {
         nfs_dir *dir;
-    
+
         if (file->flags & O_CREAT)
         {
             if (nfs_mkdir(nfs, file->path, 0755) < 0)
@@ -761,22 +1482,26 @@ int nfs_open(struct dfs_fd *file)
     else
     {
         nfs_file *fp;
-        nfs_fh3 *handle;
+        fattr3 info;
+
+        /* open file (get file handle ) */
+        fp = rt_malloc(sizeof(nfs_file));
+        if (fp == RT_NULL)
+            return -ENOMEM;
+        memset(fp, 0, sizeof(nfs_file));
 
         /* create file */
         if (file->flags & O_CREAT)
         {
             if (nfs_create(nfs, file->path, 0664) < 0)
+            {
+                rt_free(fp);
+
                 return -EAGAIN;
+            }
         }
 
-        /* open file (get file handle ) */
-        fp = rt_malloc(sizeof(nfs_file));
-        if (fp == RT_NULL)
-            return -ENOMEM;
-
-        handle = get_handle(nfs, file->path);
-        if (handle == RT_NULL)
+        if (get_handle(nfs, file->path, strlen(file->path), &fp->handle, &info) < 0)
         {
             rt_free(fp);
 
@@ -784,18 +1509,15 @@ int nfs_open(struct dfs_fd *file)
         }
 
         /* get size of file */
-        fp->size = nfs_get_filesize(nfs, handle);
+        fp->size = info.size;
         fp->offset = 0;
-        fp->eof = FALSE;
-
-        copy_handle(&fp->handle, handle);
-        xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
-        rt_free(handle);
+        rt_mutex_init(&fp->lock, "nfsf", RT_IPC_FLAG_FIFO);
 
         if (file->flags & O_APPEND)
         {
             fp->offset = fp->size;
         }
+        fp->ra_offset = fp->offset;
 
         /* set private file */
         file->data = fp;
@@ -807,53 +1529,31 @@ int nfs_open(struct dfs_fd *file)
 
 int nfs_stat(struct dfs_filesystem *fs, const char *path, struct stat *st)
 {
-    GETATTR3args args;
-    GETATTR3res res;
-    fattr3 *info;
-    nfs_fh3 *handle;
+    fattr3 info;
+    struct nfs_handle handle;
     struct nfs_filesystem *nfs;
+    int ret;
 
     RT_ASSERT(fs != RT_NULL);
     RT_ASSERT(fs->data != RT_NULL);
     nfs = (struct nfs_filesystem *)fs->data;
 
-    handle = get_handle(nfs, path);
-    if (handle == RT_NULL)
-        return -1;
-
-    args.object = *handle;
-
-    memset(&res, '\0', sizeof(res));
-
-    if (nfsproc3_getattr_3(args, &res, nfs->nfs_client) != RPC_SUCCESS)
-    {
-        rt_kprintf("GetAttr failed\n");
+    ret = get_handle(nfs, path, strlen(path), &handle, &info);
+    if (ret < 0)
         return -1;
-    }
-    else if (res.status != NFS3_OK)
-    {
-        rt_kprintf("Getattr failed: %d\n", res.status);
-        return -1;
-    }
-
-    info = &res.GETATTR3res_u.resok.obj_attributes;
 
     st->st_dev = 0;
 
     st->st_mode = DFS_S_IFREG | DFS_S_IRUSR | DFS_S_IRGRP | DFS_S_IROTH |
     DFS_S_IWUSR | DFS_S_IWGRP | DFS_S_IWOTH;
-    if (info->type == NFS3DIR)
+    if (info.type == NFS3DIR)
     {
         st->st_mode &= ~DFS_S_IFREG;
         st->st_mode |= DFS_S_IFDIR | DFS_S_IXUSR | DFS_S_IXGRP | DFS_S_IXOTH;
     }
 
-    st->st_size  = info->size;
-    st->st_mtime = info->mtime.seconds;
-
-    xdr_free((xdrproc_t)xdr_GETATTR3res, (char *)&res);
-    xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
-    rt_free(handle);
+    st->st_size  = info.size;
+    st->st_mtime = info.mtime.seconds;
 
     return 0;
 }
@@ -861,7 +1561,7 @@ int nfs_stat(struct dfs_filesystem *fs, const char *path, struct stat *st)
 nfs_dir *nfs_opendir(struct nfs_filesystem *nfs, const char *path)
 {
     nfs_dir *dir;
-    nfs_fh3 *handle;
+    struct nfs_handle handle;
 
     dir = rt_malloc(sizeof(nfs_dir));
     if (dir == RT_NULL)
@@ -869,17 +1569,14 @@ nfs_dir *nfs_opendir(struct nfs_filesystem *nfs, const char *path)
         return RT_NULL;
     }
 
-    handle = get_handle(nfs, path);
-    if (handle == RT_NULL)
+    if (get_handle(nfs, path, strlen(path), &handle, RT_NULL) < 0)
     {
         rt_free(dir);
 
         return RT_NULL;
     }
 
-    copy_handle(&dir->handle, handle);
-    xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
-    rt_free(handle);
+    copy_handle(&dir->handle, &handle.fh);
 
     dir->cookie = 0;
     memset(&dir->cookieverf, '\0', sizeof(cookieverf3));
@@ -890,10 +1587,9 @@ nfs_dir *nfs_opendir(struct nfs_filesystem *nfs, const char *path)
     return dir;
 }
 
-char *nfs_readdir(struct nfs_filesystem *nfs, nfs_dir *dir)
+/* get the next entry of dir into name, which has NAME_MAX bytes */
+char *nfs_readdir(struct nfs_filesystem *nfs, nfs_dir *dir, char *name)
 {
-    static char name[NAME_MAX];
-
     if (nfs->nfs_client == RT_NULL || dir == RT_NULL)
         return RT_NULL;
 
@@ -937,27 +1633,27 @@ char *nfs_readdir(struct nfs_filesystem *nfs, nfs_dir *dir)
     return name;
 }
 
+
 int nfs_unlink(struct dfs_filesystem *fs, const char *path)
 {
     int ret = 0;
     struct nfs_filesystem *nfs;
+    struct nfs_handle handle;
 
     RT_ASSERT(fs != RT_NULL);
     RT_ASSERT(fs->data != RT_NULL);
     nfs = (struct nfs_filesystem *)fs->data;
 
+    if (get_dir_handle(nfs, path, &handle) < 0)
+        return -1;
+
     if (nfs_is_directory(nfs, path) == RT_FALSE)
     {
         /* remove file */
         REMOVE3args args;
         REMOVE3res res;
-        nfs_fh3 *handle;
-
-        handle = get_dir_handle(nfs, path);
-        if (handle == RT_NULL)
-            return -1;
 
-        args.object.dir = *handle;
+        args.object.dir = handle.fh;
         args.object.name = strrchr(path, '/') + 1;
         if (args.object.name == RT_NULL)
         {
@@ -977,21 +1673,14 @@ int nfs_unlink(struct dfs_filesystem *fs, const char *path)
             ret = -1;
         }
         xdr_free((xdrproc_t)xdr_REMOVE3res, (char *)&res);
-        xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
-        rt_free(handle);
     }
     else
     {
         /* remove directory */
         RMDIR3args args;
         RMDIR3res res;
-        nfs_fh3 *handle;
 
-        handle = get_dir_handle(nfs, path);
-        if (handle == RT_NULL)
-            return -1;
-
-        args.object.dir = *handle;
+        args.object.dir = handle.fh;
         args.object.name = strrchr(path, '/') + 1;
         if (args.object.name == RT_NULL)
         {
@@ -1012,9 +1701,8 @@ int nfs_unlink(struct dfs_filesystem *fs, const char *path)
         }
 
         xdr_free((xdrproc_t)xdr_RMDIR3res, (char *)&res);
-        xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
-        rt_free(handle);    
     }
+    nfs_dentry_invalidate(nfs, path);
 
     return ret;
 }
@@ -1023,8 +1711,8 @@ int nfs_rename(struct dfs_filesystem *fs, const char *src, const char *dest)
 {
     RENAME3args args;
     RENAME3res res;
-    nfs_fh3 *sHandle;
-    nfs_fh3 *dHandle;
+    struct nfs_handle sHandle;
+    struct nfs_handle dHandle;
     int ret = 0;
     struct nfs_filesystem *nfs;
 
@@ -1035,23 +1723,23 @@ int nfs_rename(struct dfs_filesystem *fs, const char *src, const char *dest)
     if (nfs->nfs_client == RT_NULL)
         return -1;
 
-    sHandle = get_dir_handle(nfs, src);
-    if (sHandle == RT_NULL)
-        return -1;
-
-    dHandle = get_dir_handle(nfs, dest);
-    if (dHandle == RT_NULL)
+    if (get_dir_handle(nfs, src, &sHandle) < 0 ||
+        get_dir_handle(nfs, dest, &dHandle) < 0)
         return -1;
 
-    args.from.dir = *sHandle;
-    args.from.name = strrchr(src, '/') + 1;
+    args.from.dir = sHandle.fh;
+    args.from.name = strrchr(src, '/');
     if (args.from.name == RT_NULL)
         args.from.name = (char *)src;
+    else
+        args.from.name ++;
 
-    args.to.dir = *dHandle;
-    args.to.name = strrchr(src, '/') + 1;
+    args.to.dir = dHandle.fh;
+    args.to.name = strrchr(dest, '/');
     if (args.to.name == RT_NULL)
         args.to.name = (char *)dest;
+    else
+        args.to.name ++;
 
     memset(&res, '\0', sizeof(res));
 
@@ -1066,9 +1754,9 @@ int nfs_rename(struct dfs_filesystem *fs, const char *src, const char *dest)
         ret = -1;
     }
 
-    xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)sHandle);
-    xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)dHandle);
     xdr_free((xdrproc_t)xdr_RENAME3res, (char *)&res);
+    nfs_dentry_invalidate(nfs, src);
+    nfs_dentry_invalidate(nfs, dest);
 
     return ret;
 }
@@ -1079,7 +1767,7 @@ int nfs_getdents(struct dfs_fd *file, struct dirent *dirp, rt_uint32_t count)
     rt_uint32_t index;
     struct dirent *d;
     struct nfs_filesystem *nfs;
-    char *name;
+    char name[NAME_MAX];
 
     dir = (nfs_dir *)(file->data);
     RT_ASSERT(dir != RT_NULL);
@@ -1097,8 +1785,7 @@ int nfs_getdents(struct dfs_fd *file, struct dirent *dirp, rt_uint32_t count)
     {
         d = dirp + index;
 
-        name = nfs_readdir(nfs, dir);
-        if (name == RT_NULL)
+        if (nfs_readdir(nfs, dir, name) == RT_NULL)
             break;
 
         d->d_type = DFS_DT_REG;
@@ -1122,7 +1809,7 @@ static const struct dfs_file_ops _nfs_fops =
     nfs_ioctl,
     nfs_read,
     nfs_write,
-    RT_NULL, /* flush */
+    nfs_flush,
     nfs_lseek,
     nfs_getdents,
 };
@@ -0,0 +1,394 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ */
+
+/*
+ * Loopback test of the nfs client.
+ *
+ * An export is mounted, e.g. one of the host by the simulator of the posix
+ * port through lwIP, and the data read back is checked in each case:
+ * - a file written and read sequentially, by write-behind, COMMIT and
+ *   read-ahead;
+ * - writes at random offsets across the pages, read back by another
+ *   descriptor after fsync and after reopen;
+ * - files written and read by several threads at the same time, which go
+ *   in parallel with the lock of each file, compared with one thread;
+ * - readdir, rename, stat and unlink through the handle cache.
+ */
+
+#include <rtthread.h>
+#include <dfs_posix.h>
+#include <dfs_fs.h>
+#include <finsh.h>
+#include <stdlib.h>
+
+#if defined(RT_USING_FINSH) && defined(DFS_NFS_USING_TEST)
+
+#define NFS_TEST_PATH       "/nfs_test"
+#define NFS_TEST_SIZE       (64 * 1024)
+#define NFS_TEST_IO_SIZE    1500        /* not aligned to the pages */
+#define NFS_TEST_WRITES     64          /* random writes */
+#define NFS_TEST_THREADS    4
+
+struct nfs_test_worker
+{
+    int index;
+    int result;
+    rt_sem_t done;
+};
+
+static rt_uint8_t nfs_test_byte(rt_uint32_t seed, rt_uint32_t offset)
+{
+    return (rt_uint8_t)((offset * 31 + seed * 17) ^ (offset >> 8));
+}
+
+static void nfs_test_fill(rt_uint8_t *buf, rt_uint32_t seed, rt_uint32_t offset, rt_uint32_t length)
+{
+    while (length --)
+        *buf ++ = nfs_test_byte(seed, offset ++);
+}
+
+static void nfs_test_file(char *path, int index)
+{
+    rt_snprintf(path, 64, "%s/nfs_test_%d.dat", NFS_TEST_PATH, index);
+}
+
+/* write size bytes of the pattern of seed to a new file */
+static int nfs_test_write(const char *path, rt_uint32_t seed, rt_uint32_t size)
+{
+    rt_uint8_t *buf;
+    rt_uint32_t offset, length;
+    int fd, ret = 0;
+
+    buf = rt_malloc(NFS_TEST_IO_SIZE);
+    if (buf == RT_NULL)
+        return -1;
+
+    unlink(path);
+    fd = open(path, O_WRONLY | O_CREAT, 0);
+    if (fd < 0)
+    {
+        rt_free(buf);
+        return -1;
+    }
+
+    for (offset = 0; offset < size; offset += length)
+    {
+        length = size - offset;
+        if (length > NFS_TEST_IO_SIZE)
+            length = NFS_TEST_IO_SIZE;
+
+        nfs_test_fill(buf, seed, offset, length);
+        if (write(fd, buf, length) != length)
+        {
+            ret = -1;
+            break;
+        }
+    }
+
+    /* the errors of write-behind are reported by close */
+    if (close(fd) != 0)
+        ret = -1;
+    rt_free(buf);
+
+    return ret;
+}
+
+/* read the file from fd and compare it with expect, or the pattern of seed */
+static int nfs_test_check(int fd, const rt_uint8_t *expect, rt_uint32_t seed, rt_uint32_t size)
+{
+    rt_uint8_t *buf, *ref;
+    rt_uint32_t offset = 0;
+    int length, ret = 0;
+
+    buf = rt_malloc(NFS_TEST_IO_SIZE * 2);
+    if (buf == RT_NULL)
+        return -1;
+    ref = buf + NFS_TEST_IO_SIZE;
+
+    lseek(fd, 0, SEEK_SET);
+    while (1)
+    {
+        length = read(fd, buf, NFS_TEST_IO_SIZE);
+        if (length <= 0)
+            break;
+
+        if (expect != RT_NULL)
+            rt_memcpy(ref, expect + offset, length);
+        else
+            nfs_test_fill(ref, seed, offset, length);
+
+        if (offset + length > size || rt_memcmp(buf, ref, length) != 0)
+        {
+            rt_kprintf("mismatch at %u\n", offset);
+            ret = -1;
+            break;
+        }
+        offset += length;
+    }
+
+    if (ret == 0 && (length < 0 || offset != size))
+    {
+        rt_kprintf("read %u of %u bytes\n", offset, size);
+        ret = -1;
+    }
+    rt_free(buf);
+
+    return ret;
+}
+
+static int nfs_test_verify(const char *path, rt_uint32_t seed, rt_uint32_t size)
+{
+    int fd, ret;
+
+    fd = open(path, O_RDONLY, 0);
+    if (fd < 0)
+        return -1;
+
+    ret = nfs_test_check(fd, RT_NULL, seed, size);
+    close(fd);
+
+    return ret;
+}
+
+static int nfs_test_sequential(void)
+{
+    char path[64];
+
+    nfs_test_file(path, 0);
+    if (nfs_test_write(path, 0, NFS_TEST_SIZE) != 0)
+        return -1;
+
+    return nfs_test_verify(path, 0, NFS_TEST_SIZE);
+}
+
+static int nfs_test_random(void)
+{
+    rt_uint8_t *shadow;
+    rt_uint32_t seed = 1, offset, length;
+    char path[64];
+    int fd, fd2 = -1, i, ret = -1;
+
+    shadow = rt_malloc(NFS_TEST_SIZE);
+    if (shadow == RT_NULL)
+        return -1;
+
+    nfs_test_file(path, 0);
+    nfs_test_fill(shadow, 0, 0, NFS_TEST_SIZE);
+    fd = open(path, O_RDWR, 0);
+    if (fd < 0)
+        goto __exit;
+
+    for (i = 0; i < NFS_TEST_WRITES; i ++)
+    {
+        seed = seed * 1103515245 + 12345;
+        offset = (seed >> 8) % NFS_TEST_SIZE;
+        length = (seed >> 20) % NFS_TEST_IO_SIZE + 1;
+        if (length > NFS_TEST_SIZE - offset)
+            length = NFS_TEST_SIZE - offset;
+
+        /* the shadow holds the pattern of i for the written range */
+        nfs_test_fill(shadow + offset, i + 2, offset, length);
+        if (lseek(fd, offset, SEEK_SET) != offset ||
+            write(fd, shadow + offset, length) != length)
+            goto __exit;
+    }
+
+    /* another descriptor has its own cache, it sees the data once synced */
+    if (fsync(fd) != 0)
+        goto __exit;
+    fd2 = open(path, O_RDONLY, 0);
+    if (fd2 < 0 || nfs_test_check(fd2, shadow, 0, NFS_TEST_SIZE) != 0)
+        goto __exit;
+
+    /* and the writer reads its own cache */
+    if (nfs_test_check(fd, shadow, 0, NFS_TEST_SIZE) != 0)
+        goto __exit;
+
+    if (close(fd) != 0)
+    {
+        fd = -1;
+        goto __exit;
+    }
+    fd = open(path, O_RDONLY, 0);
+    if (fd < 0 || nfs_test_check(fd, shadow, 0, NFS_TEST_SIZE) != 0)
+        goto __exit;
+
+    ret = 0;
+
+__exit:
+    if (fd2 >= 0)
+        close(fd2);
+    if (fd >= 0)
+        close(fd);
+    rt_free(shadow);
+
+    return ret;
+}
+
+static void nfs_test_worker_entry(void *parameter)
+{
+    struct nfs_test_worker *worker = (struct nfs_test_worker *)parameter;
+    char path[64];
+
+    nfs_test_file(path, worker->index);
+    worker->result = nfs_test_write(path, worker->index, NFS_TEST_SIZE);
+    if (worker->result == 0)
+        worker->result = nfs_test_verify(path, worker->index, NFS_TEST_SIZE);
+
+    rt_sem_release(worker->done);
+}
+
+/* write and read a file in each of threads at the same time, return ms */
+static int nfs_test_threads(int threads)
+{
+    struct nfs_test_worker worker[NFS_TEST_THREADS];
+    rt_thread_t tid;
+    rt_sem_t done;
+    rt_tick_t tick;
+    int i, started = 0, ret = 0;
+
+    done = rt_sem_create("nfstest", 0, RT_IPC_FLAG_FIFO);
+    if (done == RT_NULL)
+        return -1;
+
+    tick = rt_tick_get();
+    for (i = 0; i < threads; i ++)
+    {
+        worker[i].index = i + 1;
+        worker[i].result = -1;
+        worker[i].done = done;
+
+        tid = rt_thread_create("nfstest", nfs_test_worker_entry, &worker[i],
+                               2048, RT_THREAD_PRIORITY_MAX / 2, 10);
+        if (tid == RT_NULL)
+            break;
+        rt_thread_startup(tid);
+        started ++;
+    }
+
+    for (i = 0; i < started; i ++)
+        rt_sem_take(done, RT_WAITING_FOREVER);
+    tick = rt_tick_get() - tick;
+    rt_sem_delete(done);
+
+    if (started < threads)
+        return -1;
+    for (i = 0; i < threads; i ++)
+    {
+        if (worker[i].result != 0)
+            ret = -1;
+    }
+
+    return ret == 0 ? (int)(tick * 1000 / RT_TICK_PER_SECOND) : -1;
+}
+
+static int nfs_test_parallel(void)
+{
+    int one, all;
+
+    one = nfs_test_threads(1);
+    if (one < 0)
+        return -1;
+    all = nfs_test_threads(NFS_TEST_THREADS);
+    if (all < 0)
+        return -1;
+
+    rt_kprintf("1 thread %d ms, %d threads %d ms, ", one, NFS_TEST_THREADS, all);
+
+    return 0;
+}
+
+static int nfs_test_metadata(void)
+{
+    char path[64], dest[64];
+    struct dirent *entry;
+    struct stat st;
+    DIR *dir;
+    int found = 0;
+
+    nfs_test_file(path, 0);
+    dir = opendir(NFS_TEST_PATH);
+    if (dir == RT_NULL)
+        return -1;
+    while ((entry = readdir(dir)) != RT_NULL)
+    {
+        if (rt_strcmp(entry->d_name, "nfs_test_0.dat") == 0)
+            found = 1;
+    }
+    closedir(dir);
+    if (!found)
+        return -1;
+
+    rt_snprintf(dest, sizeof(dest), "%s/nfs_test_renamed.dat", NFS_TEST_PATH);
+    unlink(dest);
+    if (rename(path, dest) != 0)
+        return -1;
+
+    /* the cached handle and attributes of the old path are gone */
+    if (stat(path, &st) == 0)
+        return -1;
+    if (stat(dest, &st) != 0 || st.st_size != NFS_TEST_SIZE)
+        return -1;
+
+    if (unlink(dest) != 0 || stat(dest, &st) == 0)
+        return -1;
+
+    return 0;
+}
+
+static void nfs_test_run(const char *name, int (*test)(void), int *failed)
+{
+    rt_kprintf("%-12s ", name);
+    if (test() == 0)
+    {
+        rt_kprintf("PASS\n");
+    }
+    else
+    {
+        rt_kprintf("FAIL\n");
+        (*failed) ++;
+    }
+}
+
+static int nfs_test(int argc, char **argv)
+{
+    const char *export = RT_NFS_HOST_EXPORT;
+    char path[64];
+    int i, failed = 0;
+
+    if (argc > 1)
+        export = argv[1];
+
+    mkdir(NFS_TEST_PATH, 0);
+    if (dfs_mount(RT_NULL, NFS_TEST_PATH, "nfs", 0, export) != 0)
+    {
+        rt_kprintf("mount %s failed\n", export);
+        return -1;
+    }
+
+    nfs_test_run("sequential", nfs_test_sequential, &failed);
+    nfs_test_run("random", nfs_test_random, &failed);
+    nfs_test_run("parallel", nfs_test_parallel, &failed);
+    nfs_test_run("metadata", nfs_test_metadata, &failed);
+
+    for (i = 1; i <= NFS_TEST_THREADS; i ++)
+    {
+        nfs_test_file(path, i);
+        unlink(path);
+    }
+    dfs_unmount(NFS_TEST_PATH);
+
+    rt_kprintf("%d failed\n", failed);
+
+    return failed ? -1 : 0;
+}
+MSH_CMD_EXPORT(nfs_test, loopback test of nfs client: nfs_test [host:/export]);
+
+#endif
@@ -309,6 +309,36 @@ extern CLIENT *clntudp_bufcreate (struct sockaddr_in *__raddr,
 				  struct timeval __wait_resend, int *__sockp,
 				  unsigned int __sendsz, unsigned int __recvsz);
 
+/*
+ * Calls in flight on a UDP client, which may be shared by threads.
+ * struct rpc_call is owned by the caller until the call is waited.
+ * enum clnt_stat
+ * clntudp_call_start(rh, call, proc, xargs, argsp, xres, resp)
+ *	sends the call, waiting a free slot when too many calls are in flight.
+ *	A call failed to start is done with the error.
+ * enum clnt_stat
+ * clntudp_call_wait(rh, call)
+ *	waits the reply of call, the results are decoded into resp.
+ */
+struct rpc_call
+{
+	struct rpc_call *next;
+	uint32_t xid;
+	bool_t done;
+	enum clnt_stat status;
+	int retries;
+	xdrproc_t xresults;
+	char* resultsp;
+	char *buf;				/* encoded call message */
+	int len;
+};
+
+extern enum clnt_stat clntudp_call_start (CLIENT *__rh, struct rpc_call *__call,
+			       unsigned long __proc,
+			       xdrproc_t __xargs, char* __argsp,
+			       xdrproc_t __xres, char* __resp);
+extern enum clnt_stat clntudp_call_wait (CLIENT *__rh, struct rpc_call *__call);
+
 extern int callrpc (const char *__host, const unsigned long __prognum,
 		    const unsigned long __versnum, const unsigned long __procnum,
 		    const xdrproc_t __inproc, const char *__in,
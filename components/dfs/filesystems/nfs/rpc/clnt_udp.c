@@ -38,6 +38,7 @@ static char sccsid[] = "@(#)clnt_udp.c 1.39 87/08/11 Copyr 1984 Sun Micro";
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <rpc/rpc.h>
 #include <rtthread.h>
 
@@ -68,11 +69,27 @@ static struct clnt_ops udp_ops =
 	clntudp_control
 };
 
+/*
+ * Calls kept in flight at the same time on one client handle. A call keeps
+ * its encoded message until the reply comes for retransmission.
+ */
+#ifndef RPC_MAX_INFLIGHT
+#define RPC_MAX_INFLIGHT	8
+#endif
+#define RPC_MAX_RETRIES		3
+
 /*
  * Private data kept per client handle
+ *
+ * The handle may be shared by threads: a reply is decoded by whichever
+ * thread receives it, into the results of the call it belongs to.
  */
 struct cu_data
 {
+	struct rpc_call *cu_pending;	/* calls waiting their replies */
+	int cu_inflight;
+	struct rt_mutex cu_lock;		/* pending calls and out buffer */
+	struct rt_mutex cu_recv_lock;	/* socket receive and in buffer */
 	int cu_sock;
 	bool_t cu_closeit;
 	struct sockaddr_in cu_raddr;
@@ -131,6 +148,8 @@ CLIENT *clntudp_bufcreate(struct sockaddr_in *raddr,
 		rt_kprintf("clntudp_create: out of memory\n");
 		goto fooy;
 	}
+	cu->cu_pending = NULL;
+	cu->cu_inflight = 0;
 	cu->cu_outbuf = &cu->cu_inbuf[recvsz];
 
 	if (raddr->sin_port == 0) {
@@ -182,6 +201,8 @@ CLIENT *clntudp_bufcreate(struct sockaddr_in *raddr,
 		cu->cu_closeit = FALSE;
 	}
 	cu->cu_sock = *sockp;
+	rt_mutex_init(&cu->cu_lock, "rpc", RT_IPC_FLAG_FIFO);
+	rt_mutex_init(&cu->cu_recv_lock, "rpcrx", RT_IPC_FLAG_FIFO);
 	cl->cl_auth = authnone_create();
 	return (cl);
 
@@ -202,62 +223,79 @@ CLIENT *clntudp_create(struct sockaddr_in *raddr,
 							  UDPMSGSIZE, UDPMSGSIZE));
 }
 
-static enum clnt_stat clntudp_call(CLIENT *cl, unsigned long proc, 
-	xdrproc_t xargs, char* argsp, 
-	xdrproc_t xresults, char* resultsp, 
-	struct timeval utimeout)
+/* the call is over, by its reply or by timeout. cu_lock must be held */
+static void clntudp_finish(struct cu_data *cu, struct rpc_call *call)
 {
-	register struct cu_data *cu = (struct cu_data *) cl->cl_private;
-	register XDR *xdrs;
-	register int outlen;
-	register int inlen;
-	socklen_t fromlen;
+	rt_free(call->buf);
+	call->buf = NULL;
+	cu->cu_inflight --;
+}
 
-	struct sockaddr_in from;
+/* decode a reply into the results of the call it belongs to */
+static void clntudp_reply(CLIENT *cl, struct rpc_call *call, int inlen)
+{
+	register struct cu_data *cu = (struct cu_data *) cl->cl_private;
 	struct rpc_msg reply_msg;
+	struct rpc_err error;
 	XDR reply_xdrs;
-	bool_t ok;
-	int nrefreshes = 2;			/* number of times to refresh cred */
 
-call_again:
-	xdrs = &(cu->cu_outxdrs);
-	xdrs->x_op = XDR_ENCODE;
-	XDR_SETPOS(xdrs, cu->cu_xdrpos);
+	reply_msg.acpted_rply.ar_verf = _null_auth;
+	reply_msg.acpted_rply.ar_results.where = call->resultsp;
+	reply_msg.acpted_rply.ar_results.proc = call->xresults;
 
 	/*
-	 * the transaction is the first thing in the out buffer
+	 * now decode and validate the response
 	 */
-	(*(unsigned long *) (cu->cu_outbuf))++;
-
-	if ((!XDR_PUTLONG(xdrs, (long *) &proc)) ||
-			(!AUTH_MARSHALL(cl->cl_auth, xdrs)) || (!(*xargs) (xdrs, argsp)))
-    {
-        cu->cu_error.re_status = RPC_CANTENCODEARGS;
-		return RPC_CANTENCODEARGS;
-    }
-	outlen = (int) XDR_GETPOS(xdrs);
+	xdrmem_create(&reply_xdrs, cu->cu_inbuf, (unsigned int) inlen, XDR_DECODE);
+	if (xdr_replymsg(&reply_xdrs, &reply_msg))
+	{
+		_seterr_reply(&reply_msg, &error);
+		if (error.re_status == RPC_SUCCESS)
+		{
+			if (!AUTH_VALIDATE(cl->cl_auth,
+							   &reply_msg.acpted_rply.ar_verf))
+			{
+				error.re_status = RPC_AUTHERROR;
+			}
+			if (reply_msg.acpted_rply.ar_verf.oa_base != NULL)
+			{
+				extern bool_t xdr_opaque_auth(XDR *xdrs, struct opaque_auth *ap);
 
-send_again:
-	if (sendto(cu->cu_sock, cu->cu_outbuf, outlen, 0,
-			   (struct sockaddr *) &(cu->cu_raddr), cu->cu_rlen)
-			!= outlen)
+				reply_xdrs.x_op = XDR_FREE;
+				(void) xdr_opaque_auth(&reply_xdrs, &(reply_msg.acpted_rply.ar_verf));
+			}
+		}
+		call->status = (enum clnt_stat) error.re_status;
+	}
+	else
 	{
-		cu->cu_error.re_errno = errno;
-        cu->cu_error.re_status = RPC_CANTSEND;
-        
-		return RPC_CANTSEND;
+		call->status = RPC_CANTDECODERES;
 	}
+}
 
-	/*
-	 * sub-optimal code appears here because we have
-	 * some clock time to spare while the packets are in flight.
-	 * (We assume that this is actually only executed once.)
-	 */
-	reply_msg.acpted_rply.ar_verf = _null_auth;
-	reply_msg.acpted_rply.ar_results.where = resultsp;
-	reply_msg.acpted_rply.ar_results.proc = xresults;
+/*
+ * receive one reply and decode it into the results of the call it belongs
+ * to, or send the pending calls again on timeout. A stale reply is dropped.
+ *
+ * return TRUE without receiving when call is done already, or when call is
+ * NULL and a call can be started.
+ */
+static bool_t clntudp_recv(CLIENT *cl, struct rpc_call *call)
+{
+	register struct cu_data *cu = (struct cu_data *) cl->cl_private;
+	struct rpc_call **pp, *c = NULL;
+	struct sockaddr_in from;
+	socklen_t fromlen;
+	int inlen;
+
+	rt_mutex_take(&cu->cu_recv_lock, RT_WAITING_FOREVER);
+	if ((call != NULL && call->done) ||
+		(call == NULL && cu->cu_inflight < RPC_MAX_INFLIGHT))
+	{
+		rt_mutex_release(&cu->cu_recv_lock);
+		return TRUE;
+	}
 
-	/* do recv */
 	do
 	{
 		fromlen = sizeof(struct sockaddr);
@@ -265,64 +303,183 @@ send_again:
 		inlen = recvfrom(cu->cu_sock, cu->cu_inbuf,
 						 (int) cu->cu_recvsz, 0,
 						 (struct sockaddr *) &from, &fromlen);
-	}while (inlen < 0 && errno == EINTR);
+	} while (inlen < 0 && errno == EINTR);
 
+	rt_mutex_take(&cu->cu_lock, RT_WAITING_FOREVER);
 	if (inlen < 4)
 	{
-		rt_kprintf("recv error, len %d\n", inlen);
-		cu->cu_error.re_errno = errno;
-		cu->cu_error.re_status = RPC_CANTRECV;
-		
-		return RPC_CANTRECV;
+		/* a request or its reply is lost, send all of pending again */
+		pp = &cu->cu_pending;
+		while ((c = *pp) != NULL)
+		{
+			if (c->retries ++ < RPC_MAX_RETRIES)
+			{
+				sendto(cu->cu_sock, c->buf, c->len, 0,
+					   (struct sockaddr *) &(cu->cu_raddr), cu->cu_rlen);
+				pp = &c->next;
+				continue;
+			}
+
+			rt_kprintf("recv error, len %d\n", inlen);
+			cu->cu_error.re_errno = errno;
+			*pp = c->next;
+			clntudp_finish(cu, c);
+			c->status = RPC_CANTRECV;
+			c->done = TRUE;
+		}
+	}
+	else
+	{
+		/* see which call the reply transaction id belongs to */
+		for (pp = &cu->cu_pending; (c = *pp) != NULL; pp = &c->next)
+		{
+			if (c->xid == *((uint32_t *) (cu->cu_inbuf)))
+			{
+				*pp = c->next;
+				clntudp_finish(cu, c);
+				break;
+			}
+		}
 	}
+	rt_mutex_release(&cu->cu_lock);
 
-	/* see if reply transaction id matches sent id */
-	if (*((uint32_t *) (cu->cu_inbuf)) != *((uint32_t *) (cu->cu_outbuf)))
-		goto send_again;
+	/* the owner checks done with the receive lock, which is still held */
+	if (c != NULL)
+	{
+		clntudp_reply(cl, c, inlen);
+		c->done = TRUE;
+	}
+	rt_mutex_release(&cu->cu_recv_lock);
 
-	/* we now assume we have the proper reply */
+	return FALSE;
+}
+
+/*
+ * encode a call and send it, the message is kept by the call for
+ * retransmission. When RPC_MAX_INFLIGHT calls are in flight, replies are
+ * received until one of them is over.
+ */
+static enum clnt_stat clntudp_send(CLIENT *cl, struct rpc_call *call,
+	unsigned long proc, xdrproc_t xargs, char* argsp,
+	xdrproc_t xresults, char* resultsp)
+{
+	register struct cu_data *cu = (struct cu_data *) cl->cl_private;
+	register XDR *xdrs;
+	int outlen;
+
+	call->done = TRUE;
+	call->buf = NULL;
+
+	rt_mutex_take(&cu->cu_lock, RT_WAITING_FOREVER);
+	while (cu->cu_inflight >= RPC_MAX_INFLIGHT)
+	{
+		rt_mutex_release(&cu->cu_lock);
+		clntudp_recv(cl, NULL);
+		rt_mutex_take(&cu->cu_lock, RT_WAITING_FOREVER);
+	}
+
+	xdrs = &(cu->cu_outxdrs);
+	xdrs->x_op = XDR_ENCODE;
+	XDR_SETPOS(xdrs, cu->cu_xdrpos);
 
 	/*
-	 * now decode and validate the response
+	 * the transaction is the first thing in the out buffer,
+	 * and 0 is never used
 	 */
-	xdrmem_create(&reply_xdrs, cu->cu_inbuf, (unsigned int) inlen, XDR_DECODE);
-	ok = xdr_replymsg(&reply_xdrs, &reply_msg);
-	/* XDR_DESTROY(&reply_xdrs);  save a few cycles on noop destroy */
-	if (ok)
+	(*(uint32_t *) (cu->cu_outbuf))++;
+	if (*(uint32_t *) (cu->cu_outbuf) == 0)
+		(*(uint32_t *) (cu->cu_outbuf))++;
+
+	if ((!XDR_PUTLONG(xdrs, (long *) &proc)) ||
+			(!AUTH_MARSHALL(cl->cl_auth, xdrs)) || (!(*xargs) (xdrs, argsp)))
 	{
-		_seterr_reply(&reply_msg, &(cu->cu_error));
-		if (cu->cu_error.re_status == RPC_SUCCESS)
-		{
-			if (!AUTH_VALIDATE(cl->cl_auth,
-							   &reply_msg.acpted_rply.ar_verf))
-			{
-				cu->cu_error.re_status = RPC_AUTHERROR;
-				cu->cu_error.re_why = AUTH_INVALIDRESP;
-			}
-			if (reply_msg.acpted_rply.ar_verf.oa_base != NULL)
-			{
-				extern bool_t xdr_opaque_auth(XDR *xdrs, struct opaque_auth *ap);
-				
-				xdrs->x_op = XDR_FREE;
-				(void) xdr_opaque_auth(xdrs, &(reply_msg.acpted_rply.ar_verf));
-			}
-		} /* end successful completion */
-		else
-		{
-			/* maybe our credentials need to be refreshed ... */
-			if (nrefreshes > 0 && AUTH_REFRESH(cl->cl_auth))
-			{
-				nrefreshes--;
-				goto call_again;
-			}
-		} /* end of unsuccessful completion */
-	} /* end of valid reply message */
-	else
+		call->status = RPC_CANTENCODEARGS;
+		goto __exit;
+	}
+	outlen = (int) XDR_GETPOS(xdrs);
+
+	call->buf = rt_malloc(outlen);
+	if (call->buf == NULL)
 	{
-		cu->cu_error.re_status = RPC_CANTDECODERES;
+		call->status = RPC_SYSTEMERROR;
+		goto __exit;
 	}
+	memcpy(call->buf, cu->cu_outbuf, outlen);
 
-	return (enum clnt_stat)(cu->cu_error.re_status);
+	if (sendto(cu->cu_sock, call->buf, outlen, 0,
+			   (struct sockaddr *) &(cu->cu_raddr), cu->cu_rlen)
+			!= outlen)
+	{
+		rt_free(call->buf);
+		call->buf = NULL;
+		cu->cu_error.re_errno = errno;
+		call->status = RPC_CANTSEND;
+		goto __exit;
+	}
+
+	/* the reply can't be looked up before the call is pending, cu_lock is held */
+	call->xid = *(uint32_t *) (call->buf);
+	call->len = outlen;
+	call->retries = 0;
+	call->xresults = xresults;
+	call->resultsp = resultsp;
+	call->status = RPC_SUCCESS;
+	call->done = FALSE;
+	call->next = cu->cu_pending;
+	cu->cu_pending = call;
+	cu->cu_inflight ++;
+
+__exit:
+	cu->cu_error.re_status = call->status;
+	rt_mutex_release(&cu->cu_lock);
+
+	return call->status;
+}
+
+/*
+ * start a call without waiting its reply, the results are decoded into
+ * resultsp by clntudp_call_wait of this or of another call. The call is
+ * owned by the caller until it's done.
+ */
+enum clnt_stat clntudp_call_start(CLIENT *cl, struct rpc_call *call,
+	unsigned long proc, xdrproc_t xargs, char* argsp,
+	xdrproc_t xresults, char* resultsp)
+{
+	return clntudp_send(cl, call, proc, xargs, argsp, xresults, resultsp);
+}
+
+/* wait the reply of a call started by clntudp_call_start */
+enum clnt_stat clntudp_call_wait(CLIENT *cl, struct rpc_call *call)
+{
+	while (clntudp_recv(cl, call) == FALSE);
+
+	return call->status;
+}
+
+static enum clnt_stat clntudp_call(CLIENT *cl, unsigned long proc,
+	xdrproc_t xargs, char* argsp,
+	xdrproc_t xresults, char* resultsp,
+	struct timeval utimeout)
+{
+	struct rpc_call call;
+	enum clnt_stat status;
+	int nrefreshes = 2;			/* number of times to refresh cred */
+
+call_again:
+	status = clntudp_send(cl, &call, proc, xargs, argsp, xresults, resultsp);
+	if (status == RPC_SUCCESS)
+		status = clntudp_call_wait(cl, &call);
+	if (status == RPC_AUTHERROR)
+	{
+		/* maybe our credentials need to be refreshed ... */
+		if (nrefreshes > 0 && AUTH_REFRESH(cl->cl_auth))
+		{
+			nrefreshes--;
+			goto call_again;
+		}
+	}
+
+	return status;
 }
 
 static void clntudp_geterr(CLIENT *cl, struct rpc_err *errp)
@@ -334,11 +491,11 @@ static void clntudp_geterr(CLIENT *cl, struct rpc_err *errp)
 
 static bool_t clntudp_freeres(CLIENT *cl, xdrproc_t xdr_res, char* res_ptr)
 {
-	register struct cu_data *cu = (struct cu_data *) cl->cl_private;
-	register XDR *xdrs = &(cu->cu_outxdrs);
+	XDR xdrs;
 
-	xdrs->x_op = XDR_FREE;
-	return ((*xdr_res) (xdrs, res_ptr));
+	/* not the out stream, it may be encoding a call of another thread */
+	xdrs.x_op = XDR_FREE;
+	return ((*xdr_res) (&xdrs, res_ptr));
 }
 
 static void clntudp_abort()
@@ -384,6 +541,12 @@ static bool_t clntudp_control(CLIENT *cl, int request, char *info)
 static void clntudp_destroy(CLIENT *cl)
 {
 	register struct cu_data *cu = (struct cu_data *) cl->cl_private;
+	struct rpc_call *call;
+
+	for (call = cu->cu_pending; call != NULL; call = call->next)
+		rt_free(call->buf);
+	rt_mutex_detach(&cu->cu_lock);
+	rt_mutex_detach(&cu->cu_recv_lock);
 
 	if (cu->cu_closeit)
 	{
@@ -22,6 +22,7 @@
  * 2011-10-22     prife        the first version
  * 2012-03-28     prife        use mtd device interface
  * 2012-04-05     prife        update uffs with official repo and use uffs_UnMount/Mount
+ * 2026-10-19     heyuanjie    use rt_mtd_t and size the caches from the free heap
  */
 
 #include <rtthread.h>
@@ -35,6 +36,8 @@
 #include "uffs/uffs_mtb.h"
 #include "uffs/uffs_mem.h"
 #include "uffs/uffs_utils.h"
+#include "uffs/uffs_buf.h"
+#include "uffs/uffs_blockinfo.h"
 
 /*
  * RT-Thread DFS Interface for uffs
@@ -45,7 +48,8 @@
 
 struct _nand_dev
 {
-	struct rt_mtd_nand_device * dev;
+	rt_mtd_t * dev;
+	struct uffs_mtd umtd;
 	struct uffs_StorageAttrSt storage;
 	uffs_Device uffs_dev;
 	uffs_MountTable mount_table;
@@ -124,15 +128,14 @@ static int init_uffs_fs(
 	struct _nand_dev * nand_part)
 {
     uffs_MountTable * mtb;
-    struct rt_mtd_nand_device * nand;
     struct uffs_StorageAttrSt * flash_storage;
 
     mtb = &nand_part->mount_table;
-    nand = nand_part->dev;
     flash_storage = &nand_part->storage;
 
 	/* setup nand storage attributes */
-	uffs_setup_storage(flash_storage, nand);
+	if (uffs_setup_storage(flash_storage, &nand_part->umtd) != RT_EOK)
+		return -1;
 
 	/* register mount table */
 	if(mtb->dev)
@@ -152,6 +155,60 @@ static int init_uffs_fs(
 	return uffs_Mount(nand_part->mount_path) == U_SUCC ? 0 : -1;
 }
 
+#define clamp(v, lo, hi)  ((v) < (lo) ? (lo) : (v) > (hi) ? (hi) : (v))
+
+/*
+ * size the page buffers and the block info cache from the free heap, or by
+ * the defaults of uffs_config.h when the heap gives no usage (memheap as
+ * heap), the sizes given by the mount data are kept.
+ */
+static void uffs_setup_config(uffs_Device *dev, rt_mtd_t *mtd, const uffs_Config *cfg)
+{
+	int blocks, pages;
+#if defined(RT_USING_HEAP) && !defined(RT_USING_MEMHEAP_AS_HEAP)
+	rt_uint32_t total, used, max_used;
+	int budget;
+#endif
+
+	blocks = mtd->size / mtd->erasesize;
+	pages = mtd->erasesize / mtd->writesize;
+
+#if defined(RT_USING_HEAP) && !defined(RT_USING_MEMHEAP_AS_HEAP)
+	rt_memory_info(&total, &used, &max_used);
+	budget = (total - used) / 100 * RT_UFFS_CACHE_PERCENT;
+
+	dev->cfg.page_buffers = budget / 2 / (sizeof(uffs_Buf) + mtd->writesize);
+	dev->cfg.bc_caches = budget / 2 / (sizeof(uffs_BlockInfo) + sizeof(uffs_PageSpare) * pages);
+#else
+	dev->cfg.page_buffers = MAX_PAGE_BUFFERS;
+	dev->cfg.bc_caches = MAX_CACHED_BLOCK_INFO;
+#endif
+
+	dev->cfg.page_buffers = clamp(dev->cfg.page_buffers, CLONE_BUFFERS_THRESHOLD + 3,
+	                              pages + CLONE_BUFFERS_THRESHOLD + 1);
+	/* a whole block of dirty pages is written without a clone */
+	dev->cfg.dirty_pages = dev->cfg.page_buffers - CLONE_BUFFERS_THRESHOLD - 1;
+	if (dev->cfg.dirty_pages > pages)
+		dev->cfg.dirty_pages = pages;
+	dev->cfg.dirty_groups = MAX_DIRTY_BUF_GROUPS;
+
+	dev->cfg.bc_caches = clamp(dev->cfg.bc_caches, 5, blocks);
+
+	if (cfg != RT_NULL)
+	{
+		if (cfg->page_buffers)
+			dev->cfg.page_buffers = cfg->page_buffers;
+		if (cfg->dirty_pages)
+			dev->cfg.dirty_pages = cfg->dirty_pages;
+		if (cfg->dirty_groups)
+			dev->cfg.dirty_groups = cfg->dirty_groups;
+		if (cfg->bc_caches)
+			dev->cfg.bc_caches = cfg->bc_caches;
+		if (cfg->reserved_free_blocks)
+			dev->cfg.reserved_free_blocks = cfg->reserved_free_blocks;
+	}
+}
+
 static int dfs_uffs_mount(
 	struct dfs_filesystem* fs,
     unsigned long rwflag,
@@ -159,10 +216,14 @@ static int dfs_uffs_mount(
 {
 	rt_base_t index;
 	uffs_MountTable * mount_part;
-	struct rt_mtd_nand_device * dev;
+	rt_mtd_t * dev;
 	
 	RT_ASSERT(rt_strlen(fs->path) < (UFFS_MOUNT_PATH_MAX-1));
-	dev = RT_MTD_NAND_DEVICE(fs->dev_id);
+	if (fs->dev_id->type != RT_Device_Class_MTD)
+		return -ENODEV;
+	dev = (rt_mtd_t *)fs->dev_id;
+	if (dev->type != MTD_NANDFLASH || dev->writesize > UFFS_MAX_PAGE_SIZE)
+		return -EINVAL;
 
 	/*1. find a empty entry in partition table */
 	for (index = 0; index < UFFS_DEVICE_MAX ; index ++)
@@ -185,12 +246,17 @@ static int dfs_uffs_mount(
 	mount_part->mount	= nand_part[index].mount_path;
 	mount_part->dev = &(nand_part[index].uffs_dev);
 	rt_memset(mount_part->dev, 0, sizeof(uffs_Device));//in order to make uffs happy.
-	mount_part->dev->_private = dev;   /* save dev_id into uffs */
-	mount_part->start_block = dev->block_start;
-	mount_part->end_block = dev->block_end;
+	rt_memset(&nand_part[index].umtd, 0, sizeof(struct uffs_mtd));
+	nand_part[index].umtd.mtd = dev;
+	nand_part[index].umtd.ra_max = RT_UFFS_READ_AHEAD_PAGES;
+	mount_part->dev->_private = &nand_part[index].umtd;   /* save mtd into uffs */
+	mount_part->start_block = 0;
+	mount_part->end_block = dev->size / dev->erasesize - 1;
+	uffs_setup_config(mount_part->dev, dev, (const uffs_Config *)data);
 	/*3. mount uffs */
 	if (init_uffs_fs(&nand_part[index]) < 0)
 	{
+		nand_part[index].dev = RT_NULL;
 		return uffs_result_to_dfs(uffs_get_error());
 	}
 	return 0;
@@ -204,7 +270,7 @@ static int dfs_uffs_unmount(struct dfs_filesystem* fs)
 	/* find the device index and then unmount it */
 	for (index = 0; index < UFFS_DEVICE_MAX; index++)
 	{
-		if (nand_part[index].dev == RT_MTD_NAND_DEVICE(fs->dev_id))
+		if (nand_part[index].dev == (rt_mtd_t *)fs->dev_id)
 		{
 			nand_part[index].dev = RT_NULL;
 			result = uffs_UnMount(nand_part[index].mount_path);
@@ -222,12 +288,13 @@ static int dfs_uffs_mkfs(rt_device_t dev_id)
 {
 	rt_base_t index;
 	rt_uint32_t block;
-	struct rt_mtd_nand_device * mtd;
+	rt_mtd_t * mtd;
+	struct erase_info instr;
 
 	/*1. find the device index */
 	for (index = 0; index < UFFS_DEVICE_MAX; index++)
 	{
-		if (nand_part[index].dev == (struct rt_mtd_nand_device *)dev_id)
+		if (nand_part[index].dev == (rt_mtd_t *)dev_id)
 			break;
 	}
 
@@ -242,14 +309,17 @@ static int dfs_uffs_mkfs(rt_device_t dev_id)
 	mtd = nand_part[index].dev;
 
 	/*3. erase all blocks on the partition */
-	block = mtd->block_start;
-	for (; block <= mtd->block_end; block++)
+	for (block = 0; block < mtd->size / mtd->erasesize; block++)
 	{
-		rt_mtd_nand_erase_block(mtd, block);
-		if (rt_mtd_nand_check_block(mtd, block) != RT_EOK)
+		if (mtd_block_isbad(mtd, block * mtd->erasesize))
+			continue;
+
+		instr.addr = block * mtd->erasesize;
+		instr.len = mtd->erasesize;
+		if (mtd_erase(mtd, &instr) != 0)
 		{
 			rt_kprintf("found bad block %d\n", block);
-			rt_mtd_nand_mark_badblock(mtd, block);
+			mtd_block_markbad(mtd, block * mtd->erasesize);
 		}
 	}
 
@@ -265,7 +335,7 @@ static int dfs_uffs_statfs(struct dfs_filesystem* fs,
                     struct statfs *buf)
 {
 	rt_base_t index;
-	struct rt_mtd_nand_device * mtd = RT_MTD_NAND_DEVICE(fs->dev_id);
+	rt_mtd_t * mtd = (rt_mtd_t *)fs->dev_id;
 
 	RT_ASSERT(mtd != RT_NULL);
 
@@ -278,10 +348,9 @@ static int dfs_uffs_statfs(struct dfs_filesystem* fs,
 	if (index == UFFS_DEVICE_MAX)
 		return -ENOENT;
 	
-	buf->f_bsize = mtd->page_size;
-	buf->f_blocks = mtd->pages_per_block*
-	                (mtd->block_end - mtd->block_start + 1);
-	buf->f_bfree = uffs_GetDeviceFree(&nand_part[index].uffs_dev) / mtd->page_size;
+	buf->f_bsize = mtd->writesize;
+	buf->f_blocks = mtd->size / mtd->writesize;
+	buf->f_bfree = uffs_GetDeviceFree(&nand_part[index].uffs_dev) / mtd->writesize;
 	
 	return 0;
 }
@@ -605,7 +674,6 @@ static int dfs_uffs_stat(struct dfs_filesystem* fs, const char *path, struct sta
 {
 	int result;
 	struct uffs_stat s;
-	struct rt_mtd_nand_device * mtd;
 
 	result = uffs_stat(path, &s);
 	if (result < 0)
@@ -618,8 +686,6 @@ static int dfs_uffs_stat(struct dfs_filesystem* fs, const char *path, struct sta
 	st->st_size = s.st_size;
 	st->st_mtime = s.st_mtime;
 
-	mtd = RT_MTD_NAND_DEVICE(fs->dev_id);
-
 	return 0;
 }
 
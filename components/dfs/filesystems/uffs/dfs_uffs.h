@@ -20,6 +20,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2012-03-30     prife        the first version
+ * 2026-10-19     heyuanjie    use rt_mtd_t, read ahead and caches sized from heap
  */
 
 #ifndef DFS_UFFS_H_
@@ -33,8 +34,16 @@
 /* #define RT_CONFIG_UFFS_ECC_MODE  UFFS_ECC_SOFT */
 /* #define RT_CONFIG_UFFS_ECC_MODE  UFFS_ECC_NONE */
 
-/* enable this ,you need provide a mark_badblock/check_block funciton */
-/* #define RT_UFFS_USE_CHECK_MARK_FUNCITON */
+/* the pages of a sequential read loaded in one mtd request, 1 to disable */
+#ifndef RT_UFFS_READ_AHEAD_PAGES
+#define RT_UFFS_READ_AHEAD_PAGES    4
+#endif
+
+/* the percent of free heap for the page buffers and block info cache,
+ * the defaults of uffs_config.h are used with RT_USING_MEMHEAP_AS_HEAP */
+#ifndef RT_UFFS_CACHE_PERCENT
+#define RT_UFFS_CACHE_PERCENT       10
+#endif
 
 #if RT_CONFIG_UFFS_ECC_MODE == UFFS_ECC_SOFT      /* let uffs do soft ecc */
 #define RT_CONFIG_UFFS_LAYOUT    UFFS_LAYOUT_UFFS /* UFFS_LAYOUT_FLASH */
@@ -72,11 +81,28 @@
 #warning "when use UFFS_ECC_SOFT, it is recommended to use UFFS_LAYOUT_UFFS"
 #endif
 
+struct uffs_mtd
+{
+    rt_mtd_t *mtd;
+    int oob_len;            /* free oob bytes of a page */
+    int bitflips;           /* bitflips to retire a block */
+
+    /* the pages read ahead */
+    rt_uint8_t *ra_data;
+    rt_uint8_t *ra_oob;
+    int ra_max;
+    int ra_block;
+    int ra_page;
+    int ra_count;
+    int last_block;
+    int last_page;
+};
+
 extern const uffs_FlashOps nand_ops;
 
-extern void uffs_setup_storage(
+extern int uffs_setup_storage(
     struct uffs_StorageAttrSt *attr,
-    struct rt_mtd_nand_device * nand);
+    struct uffs_mtd *um);
 
 extern int dfs_uffs_init(void);
 #endif /* DFS_UFFS_H_ */
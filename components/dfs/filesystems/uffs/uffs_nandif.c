@@ -1,48 +1,177 @@
 /*
  * RT-Thread Device Interface for uffs
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    use rt_mtd_t with tags in free oob and read ahead
+ */
+
+/*
+ * The ecc of page data is done by the mtd nand layer, uffs keeps its tags
+ * (and its own ecc for UFFS_ECC_SOFT) in the free oob of MTD_OPS_AUTO_OOB.
+ * The bad blocks are kept by mtd too.
+ *
+ * The sequential reads of page data are read ahead in one mtd request, so
+ * the nand driver can load the next page while a page is transferred.
  */
 
 #include <rtthread.h>
 #include <rtdevice.h>
 #include "dfs_uffs.h"
 
+#define UMTD(dev)       ((struct uffs_mtd *)(dev)->_private)
+#define PAGE_OFS(dev, block, page) \
+    (((loff_t)(block) * (dev)->attr->pages_per_block + (page)) * (dev)->attr->page_data_size)
+
+/* the tag store and the seal byte, for UFFS_ECC_HW_AUTO */
+#define TAG_SIZE        (sizeof(uffs_TagStore) + 1)
+
+#define min(a, b)       ((a) < (b) ? (a) : (b))
+
 static int nand_init_flash(uffs_Device *dev)
 {
+    struct uffs_mtd *um = UMTD(dev);
+
+    um->ra_block = -1;
+    um->ra_count = 0;
+    um->last_block = -1;
+    if (um->ra_max > 1)
+    {
+        um->ra_data = rt_malloc(um->ra_max * (dev->attr->page_data_size + um->oob_len));
+        if (um->ra_data == RT_NULL)
+            um->ra_max = 1;
+        else
+            um->ra_oob = um->ra_data + um->ra_max * dev->attr->page_data_size;
+    }
+
     return UFFS_FLASH_NO_ERR;
 }
 
 static int nand_release_flash(uffs_Device *dev)
 {
+    struct uffs_mtd *um = UMTD(dev);
+
+    rt_free(um->ra_data);
+    um->ra_data = RT_NULL;
+    um->ra_count = 0;
+
     return UFFS_FLASH_NO_ERR;
 }
+
 static int nand_erase_block(uffs_Device *dev, unsigned block)
 {
-    int res;
+    struct uffs_mtd *um = UMTD(dev);
+    struct erase_info instr;
+
+    if ((int)block == um->ra_block)
+        um->ra_count = 0;
 
-    res = rt_mtd_nand_erase_block(RT_MTD_NAND_DEVICE(dev->_private), block);
+    instr.addr = block * um->mtd->erasesize;
+    instr.len = um->mtd->erasesize;
 
-    return res == RT_EOK ? UFFS_FLASH_NO_ERR : UFFS_FLASH_IO_ERR;
+    return mtd_erase(um->mtd, &instr) == 0 ? UFFS_FLASH_NO_ERR : UFFS_FLASH_BAD_BLK;
 }
 
-#if defined(RT_UFFS_USE_CHECK_MARK_FUNCITON)
 static int nand_check_block(uffs_Device *dev, unsigned block)
 {
-    int res;
-
-    res = rt_mtd_nand_check_block(RT_MTD_NAND_DEVICE(dev->_private), block);
+    struct uffs_mtd *um = UMTD(dev);
 
-    return res == RT_EOK ? UFFS_FLASH_NO_ERR : UFFS_FLASH_BAD_BLK;
+    return mtd_block_isbad(um->mtd, block * um->mtd->erasesize) ? 1 : 0;
 }
 
 static int nand_mark_badblock(uffs_Device *dev, unsigned block)
 {
-    int res;
+    struct uffs_mtd *um = UMTD(dev);
 
-    res = rt_mtd_nand_mark_badblock(RT_MTD_NAND_DEVICE(dev->_private), block);
+    return mtd_block_markbad(um->mtd, block * um->mtd->erasesize) == 0 ? 0 : -1;
+}
 
-    return res == RT_EOK ? UFFS_FLASH_NO_ERR : UFFS_FLASH_IO_ERR;
+/* a few bitflips are usual, the block is retired by uffs for more */
+static int nand_result(struct uffs_mtd *um, int ret)
+{
+    if (ret == -EBADMSG)
+        return UFFS_FLASH_ECC_FAIL;
+    if (ret < 0)
+        return UFFS_FLASH_IO_ERR;
+
+    return ret >= um->bitflips ? UFFS_FLASH_ECC_OK : UFFS_FLASH_NO_ERR;
+}
+
+/* read the data and/or free oob of a page, from the pages read ahead if it's there */
+static int nand_read(uffs_Device *dev, u32 block, u32 page, u8 *data, u8 *oob, int oob_len)
+{
+    struct uffs_mtd *um = UMTD(dev);
+    struct mtd_oob_ops ops;
+    int n, ret;
+
+    if (data != RT_NULL)
+    {
+        /* the next pages of a sequential read are read together */
+        if (um->ra_max > 1 && (int)block == um->last_block && (int)page == um->last_page + 1 &&
+            !((int)block == um->ra_block && (int)page >= um->ra_page && (int)page < um->ra_page + um->ra_count))
+        {
+            n = min(um->ra_max, dev->attr->pages_per_block - (int)page);
+
+            rt_memset(&ops, 0, sizeof(ops));
+            ops.mode = MTD_OPS_AUTO_OOB;
+            ops.len = n * dev->attr->page_data_size;
+            ops.datbuf = um->ra_data;
+            ops.ooblen = n * um->oob_len;
+            ops.oobbuf = um->ra_oob;
+
+            um->ra_count = 0;
+            ret = mtd_read_oob(um->mtd, PAGE_OFS(dev, block, page), &ops);
+            /* else the errors and bitflips are found by page */
+            if (n > 1 && nand_result(um, ret) == UFFS_FLASH_NO_ERR)
+            {
+                um->ra_block = block;
+                um->ra_page = page;
+                um->ra_count = n;
+            }
+        }
+        um->last_block = block;
+        um->last_page = page;
+    }
+
+    if ((int)block == um->ra_block && (int)page >= um->ra_page && (int)page < um->ra_page + um->ra_count)
+    {
+        n = page - um->ra_page;
+        if (data != RT_NULL)
+            rt_memcpy(data, um->ra_data + n * dev->attr->page_data_size, dev->attr->page_data_size);
+        if (oob != RT_NULL)
+            rt_memcpy(oob, um->ra_oob + n * um->oob_len, oob_len);
+
+        return UFFS_FLASH_NO_ERR;
+    }
+
+    rt_memset(&ops, 0, sizeof(ops));
+    ops.mode = MTD_OPS_AUTO_OOB;
+    ops.len = data ? dev->attr->page_data_size : 0;
+    ops.datbuf = data;
+    ops.ooblen = oob ? oob_len : 0;
+    ops.oobbuf = oob;
+
+    return nand_result(um, mtd_read_oob(um->mtd, PAGE_OFS(dev, block, page), &ops));
+}
+
+static int nand_write(uffs_Device *dev, u32 block, u32 page, const u8 *data, const u8 *oob, int oob_len)
+{
+    struct uffs_mtd *um = UMTD(dev);
+    struct mtd_oob_ops ops;
+
+    if ((int)block == um->ra_block)
+        um->ra_count = 0;
+
+    rt_memset(&ops, 0, sizeof(ops));
+    ops.mode = MTD_OPS_AUTO_OOB;
+    ops.len = data ? dev->attr->page_data_size : 0;
+    ops.datbuf = (uint8_t *)data;
+    ops.ooblen = oob ? oob_len : 0;
+    ops.oobbuf = (uint8_t *)oob;
+
+    return mtd_write_oob(um->mtd, PAGE_OFS(dev, block, page), &ops) == 0 ?
+           UFFS_FLASH_NO_ERR : UFFS_FLASH_IO_ERR;
 }
-#endif
 
 #if (RT_CONFIG_UFFS_ECC_MODE == UFFS_ECC_NONE) || (RT_CONFIG_UFFS_ECC_MODE == UFFS_ECC_SOFT)
 static int nand_read_page(uffs_Device *dev,
@@ -54,34 +183,15 @@ static int nand_read_page(uffs_Device *dev,
                           rt_uint8_t  *spare,
                           int          spare_len)
 {
-    int res;
-
-    page = block * dev->attr->pages_per_block + page;
     if (data == NULL && spare == NULL)
     {
-#if defined(RT_UFFS_USE_CHECK_MARK_FUNCITON)
-        RT_ASSERT(0); //should not be here
-#else
         /* check block status: bad or good */
-        rt_uint8_t spare[UFFS_MAX_SPARE_SIZE];
-
-        rt_memset(spare, 0, UFFS_MAX_SPARE_SIZE);
-
-        rt_mtd_nand_read(RT_MTD_NAND_DEVICE(dev->_private),
-                         page, RT_NULL, 0,
-                         spare, dev->attr->spare_size);//dev->mem.spare_data_size
-
-        res = spare[dev->attr->block_status_offs] == 0xFF ?
-                               UFFS_FLASH_NO_ERR : UFFS_FLASH_BAD_BLK;
-
-        return res;
-#endif
+        return nand_check_block(dev, block) ? UFFS_FLASH_BAD_BLK : UFFS_FLASH_NO_ERR;
     }
 
-    rt_mtd_nand_read(RT_MTD_NAND_DEVICE(dev->_private),
-                     page, data, data_len, spare, spare_len);
+    RT_ASSERT(data == NULL || data_len == dev->attr->page_data_size);
 
-    return UFFS_FLASH_NO_ERR;
+    return nand_read(dev, block, page, data, spare, spare_len);
 }
 
 static int nand_write_page(uffs_Device *dev,
@@ -92,40 +202,15 @@ static int nand_write_page(uffs_Device *dev,
                            const u8    *spare,
                            int          spare_len)
 {
-    int res;
-
-    RT_ASSERT(UFFS_MAX_SPARE_SIZE >= dev->attr->spare_size);
-
-    page = block * dev->attr->pages_per_block + page;
-
     if (data == NULL && spare == NULL)
     {
-#if defined(RT_UFFS_USE_CHECK_MARK_FUNCITON)
-        RT_ASSERT(0); //should not be here
-#else
         /* mark bad block  */
-        rt_uint8_t spare[UFFS_MAX_SPARE_SIZE];
-
-        rt_memset(spare, 0xFF, UFFS_MAX_SPARE_SIZE);
-        spare[dev->attr->block_status_offs] =  0x00;
-
-        res = rt_mtd_nand_write(RT_MTD_NAND_DEVICE(dev->_private),
-                                page, RT_NULL, 0,
-                                spare, dev->attr->spare_size);//dev->mem.spare_data_size
-        if (res != RT_EOK)
-            goto __error;
-#endif
+        return nand_mark_badblock(dev, block) == 0 ? UFFS_FLASH_NO_ERR : UFFS_FLASH_IO_ERR;
     }
 
-    res = rt_mtd_nand_write(RT_MTD_NAND_DEVICE(dev->_private),
-                           page,  data, data_len, spare, spare_len);
-    if (res != RT_EOK)
-        goto __error;
+    RT_ASSERT(data == NULL || data_len == dev->attr->page_data_size);
 
-    return UFFS_FLASH_NO_ERR;
-
-__error:
-    return UFFS_FLASH_IO_ERR;
+    return nand_write(dev, block, page, data, spare, spare_len);
 }
 
 const uffs_FlashOps nand_ops =
@@ -136,31 +221,11 @@ const uffs_FlashOps nand_ops =
     NULL,               /* ReadPageWithLayout */
     nand_write_page,    /* WritePage() */
     NULL,               /* WirtePageWithLayout */
-#if defined(RT_UFFS_USE_CHECK_MARK_FUNCITON)
-    nand_check_block,
-    nand_mark_badblock,
-#else
-    NULL,               /* IsBadBlock(), let UFFS take care of it. */
-    NULL,               /* MarkBadBlock(), let UFFS take care of it. */
-#endif
+    nand_check_block,   /* IsBadBlock() */
+    nand_mark_badblock, /* MarkBadBlock() */
     nand_erase_block,   /* EraseBlock() */
 };
 
-void uffs_setup_storage(struct uffs_StorageAttrSt *attr,
-                        struct rt_mtd_nand_device *nand)
-{
-    rt_memset(attr, 0, sizeof(struct uffs_StorageAttrSt));
-
-//  attr->total_blocks = nand->end_block - nand->start_block + 1;/* no use */
-    attr->page_data_size = nand->page_size;                /* page data size */
-    attr->pages_per_block = nand->pages_per_block;         /* pages per block */
-    attr->spare_size = nand->oob_size;                     /* page spare size */
-    attr->ecc_opt = RT_CONFIG_UFFS_ECC_MODE;               /* ecc option */
-    attr->ecc_size = 0;                                    /* ecc size is 0 , the uffs will calculate the ecc size*/
-    attr->block_status_offs = attr->ecc_size;              /* indicate block bad or good, offset in spare */
-    attr->layout_opt = RT_CONFIG_UFFS_LAYOUT;              /* let UFFS do the spare layout */
-}
-
 #elif  RT_CONFIG_UFFS_ECC_MODE == UFFS_ECC_HW_AUTO
 static int WritePageWithLayout(uffs_Device         *dev,
                                u32                  block,
@@ -170,33 +235,13 @@ static int WritePageWithLayout(uffs_Device         *dev,
                                const u8            *ecc,  //NULL
                                const uffs_TagStore *ts)
 {
-    int res;
-    int spare_len;
-    rt_uint8_t spare[UFFS_MAX_SPARE_SIZE];
-
-    RT_ASSERT(UFFS_MAX_SPARE_SIZE >= dev->attr->spare_size);
-
-    page = block * dev->attr->pages_per_block + page;
-    spare_len = dev->mem.spare_data_size;
+    rt_uint8_t tag[TAG_SIZE];
 
     if (data == NULL && ts == NULL)
     {
-#if defined(RT_UFFS_USE_CHECK_MARK_FUNCITON)
-        RT_ASSERT(0); //should not be here
-#else
         /* mark bad block  */
-        rt_memset(spare, 0xFF, UFFS_MAX_SPARE_SIZE);
-        spare[dev->attr->block_status_offs] =  0x00;
-
-        res = rt_mtd_nand_write(RT_MTD_NAND_DEVICE(dev->_private),
-                                page, RT_NULL, 0,
-                                spare, dev->attr->spare_size);//dev->mem.spare_data_size
-        if (res != RT_EOK)
-            goto __error;
-
         dev->st.io_write++;
-        return UFFS_FLASH_NO_ERR;
-#endif
+        return nand_mark_badblock(dev, block) == 0 ? UFFS_FLASH_NO_ERR : UFFS_FLASH_IO_ERR;
     }
 
     if (data != NULL && data_len != 0)
@@ -209,20 +254,15 @@ static int WritePageWithLayout(uffs_Device         *dev,
 
     if (ts != RT_NULL)
     {
-        uffs_FlashMakeSpare(dev, ts, RT_NULL, (u8 *)spare);
+        /* sealed by the same program */
+        rt_memcpy(tag, ts, sizeof(uffs_TagStore));
+        tag[TAG_SIZE - 1] = 0x00;
+
         dev->st.spare_write_count++;
-        dev->st.io_write += spare_len;
+        dev->st.io_write += TAG_SIZE;
     }
 
-    res = rt_mtd_nand_write(RT_MTD_NAND_DEVICE(dev->_private),
-                            page, data, data_len, spare, spare_len);
-    if (res != RT_EOK)
-        goto __error;
-
-    return UFFS_FLASH_NO_ERR;
-
-__error:
-    return UFFS_FLASH_IO_ERR;
+    return nand_write(dev, block, page, data, ts ? tag : RT_NULL, TAG_SIZE);
 }
 
 static URET ReadPageWithLayout(uffs_Device   *dev,
@@ -234,61 +274,34 @@ static URET ReadPageWithLayout(uffs_Device   *dev,
                                uffs_TagStore *ts,
                                u8            *ecc_store)        //NULL
 {
-    int res = UFFS_FLASH_NO_ERR;
-    int spare_len;
-    rt_uint8_t spare[UFFS_MAX_SPARE_SIZE];
-
-    RT_ASSERT(UFFS_MAX_SPARE_SIZE >= dev->attr->spare_size);
-
-    page = block * dev->attr->pages_per_block + page;
-    spare_len = dev->mem.spare_data_size;
+    rt_uint8_t tag[TAG_SIZE];
+    int res;
 
     if (data == RT_NULL && ts == RT_NULL)
     {
-#if defined(RT_UFFS_USE_CHECK_MARK_FUNCITON)
-        RT_ASSERT(0); //should not be here
-#else
         /* check block good or bad */
-
-        rt_mtd_nand_read(RT_MTD_NAND_DEVICE(dev->_private),
-                         page, RT_NULL, 0,
-                         spare, dev->attr->spare_size);//dev->mem.spare_data_size
-
         dev->st.io_read++;
-
-        res = spare[dev->attr->block_status_offs] == 0xFF ?
-                               UFFS_FLASH_NO_ERR : UFFS_FLASH_BAD_BLK;
-        return res;
-#endif
+        return nand_check_block(dev, block) ? UFFS_FLASH_BAD_BLK : UFFS_FLASH_NO_ERR;
     }
 
     if (data != RT_NULL)
     {
+        RT_ASSERT(data_len == dev->attr->page_data_size);
+
         dev->st.io_read += data_len;
         dev->st.page_read_count++;
     }
 
-    res = rt_mtd_nand_read(RT_MTD_NAND_DEVICE(dev->_private),
-                           page, data, data_len, spare, spare_len);
-    if (res == 0)
-        res = UFFS_FLASH_NO_ERR;
-    else if (res == -1)
-    {
-        //TODO ecc correct, add code to use hardware do ecc correct
-        res = UFFS_FLASH_ECC_OK;
-    }
-    else
-        res = UFFS_FLASH_ECC_FAIL;
+    res = nand_read(dev, block, page, data, ts ? tag : RT_NULL, TAG_SIZE);
 
     if (ts != RT_NULL)
     {
-        // unload ts and ecc from spare, you can modify it if you like
-        uffs_FlashUnloadSpare(dev, (const u8 *)spare, ts, RT_NULL);
+        rt_memcpy(ts, tag, sizeof(uffs_TagStore));
 
-        if ((spare[spare_len - 1] == 0xFF) && (res == UFFS_FLASH_NO_ERR))
+        if ((tag[TAG_SIZE - 1] == 0xFF) && (res == UFFS_FLASH_NO_ERR))
             res = UFFS_FLASH_NOT_SEALED;
 
-        dev->st.io_read += spare_len;
+        dev->st.io_read += TAG_SIZE;
         dev->st.spare_read_count++;
     }
 
@@ -303,57 +316,38 @@ const uffs_FlashOps nand_ops =
     ReadPageWithLayout, /* ReadPageWithLayout */
     NULL,               /* WritePage() */
     WritePageWithLayout,/* WirtePageWithLayout */
-
-#if defined(RT_UFFS_USE_CHECK_MARK_FUNCITON)
-    nand_check_block,
-    nand_mark_badblock,
-#else
-    NULL,               /* IsBadBlock(), let UFFS take care of it. */
-    NULL,               /* MarkBadBlock(), let UFFS take care of it. */
-#endif
+    nand_check_block,   /* IsBadBlock() */
+    nand_mark_badblock, /* MarkBadBlock() */
     nand_erase_block,   /* EraseBlock() */
 };
+#endif
 
-static rt_uint8_t hw_flash_data_layout[UFFS_SPARE_LAYOUT_SIZE] =
+int uffs_setup_storage(struct uffs_StorageAttrSt *attr,
+                       struct uffs_mtd *um)
 {
-    0x05, 0x08, 0xFF, 0x00
-};
+    rt_mtd_t *mtd = um->mtd;
+    rt_nand_t *chip = (rt_nand_t *)mtd->priv;
 
-static rt_uint8_t hw_flash_ecc_layout[UFFS_SPARE_LAYOUT_SIZE] =
-{
-    0x00, 0x04, 0xFF, 0x00
-};
+    if (mtd->type != MTD_NANDFLASH || mtd->writesize > UFFS_MAX_PAGE_SIZE ||
+        chip->freelayout->length > UFFS_MAX_SPARE_SIZE ||
+        (RT_CONFIG_UFFS_ECC_MODE == UFFS_ECC_HW_AUTO && chip->freelayout->length < TAG_SIZE))
+        return -RT_EINVAL;
 
-void uffs_setup_storage(struct uffs_StorageAttrSt *attr,
-                        struct rt_mtd_nand_device *nand)
-{
     rt_memset(attr, 0, sizeof(struct uffs_StorageAttrSt));
 
-//  attr->total_blocks = nand->end_block - nand->start_block + 1;/* no use */
-    attr->page_data_size = nand->page_size;                /* page data size */
-    attr->pages_per_block = nand->pages_per_block;         /* pages per block */
-    attr->spare_size = nand->oob_size;                     /* page spare size */
+    attr->total_blocks = mtd->size / mtd->erasesize;
+    attr->page_data_size = mtd->writesize;                 /* page data size */
+    attr->pages_per_block = mtd->erasesize / mtd->writesize; /* pages per block */
+    attr->spare_size = chip->freelayout->length;           /* uffs uses the free oob only */
     attr->ecc_opt = RT_CONFIG_UFFS_ECC_MODE;               /* ecc option */
-    attr->ecc_size = nand->oob_size-nand->oob_free;        /* ecc size */
-    attr->block_status_offs = attr->ecc_size;              /* indicate block bad or good, offset in spare */
+    attr->ecc_size = 0;                                    /* ecc size is 0 , the uffs will calculate the ecc size*/
+    attr->block_status_offs = 0;                           /* not used, the bad blocks are kept by mtd */
     attr->layout_opt = RT_CONFIG_UFFS_LAYOUT;              /* let UFFS do the spare layout */
 
-    /* calculate the ecc layout array */
-    hw_flash_data_layout[0] = attr->ecc_size + 1; /* ecc size + 1byte block status */
-    hw_flash_data_layout[1] = 0x08;
-    hw_flash_data_layout[2] = 0xFF;
-    hw_flash_data_layout[3] = 0x00;
+    um->oob_len = attr->spare_size;
+    um->bitflips = chip->ecc.strength * 3 / 4;
+    if (um->bitflips == 0)
+        um->bitflips = 1;
 
-    hw_flash_ecc_layout[0] = 0;
-    hw_flash_ecc_layout[1] = attr->ecc_size;
-    hw_flash_ecc_layout[2] = 0xFF;
-    hw_flash_ecc_layout[3] = 0x00;
-
-    /* initialize  _uffs_data_layout and _uffs_ecc_layout */
-    rt_memcpy(attr->_uffs_data_layout, hw_flash_data_layout, UFFS_SPARE_LAYOUT_SIZE);
-    rt_memcpy(attr->_uffs_ecc_layout, hw_flash_ecc_layout, UFFS_SPARE_LAYOUT_SIZE);
-
-    attr->data_layout = attr->_uffs_data_layout;
-    attr->ecc_layout = attr->_uffs_ecc_layout;
+    return RT_EOK;
 }
-#endif
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ */
+
+#ifndef __AIO_H__
+#define __AIO_H__
+
+#include <rtthread.h>
+#include <sys/types.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LIO_READ        0
+#define LIO_WRITE       1
+#define LIO_NOP         2
+
+#define LIO_WAIT        0
+#define LIO_NOWAIT      1
+
+struct aio_lio;
+
+struct aiocb
+{
+    int             aio_fildes;
+    off_t           aio_offset;
+    volatile void  *aio_buf;
+    size_t          aio_nbytes;
+    int             aio_reqprio;        /* not supported, ignored */
+    struct sigevent aio_sigevent;
+    int             aio_lio_opcode;
+
+    /* private */
+    rt_list_t       __list;
+    int             __op;
+    struct aio_lio *__lio;
+    rt_thread_t     __owner;
+    int             __error;
+    ssize_t         __return;
+};
+
+int aio_read(struct aiocb *aiocbp);
+int aio_write(struct aiocb *aiocbp);
+int aio_error(const struct aiocb *aiocbp);
+ssize_t aio_return(struct aiocb *aiocbp);
+int aio_suspend(const struct aiocb *const list[], int nent, const struct timespec *timeout);
+int lio_listio(int mode, struct aiocb *const list[], int nent, struct sigevent *sig);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
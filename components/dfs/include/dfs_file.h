@@ -20,6 +20,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2005-01-26     Bernard      The first version.
+ * 2026-10-19     heyuanjie    add pos_lock and dfs_file_pread/pwrite
  */
 
 #ifndef __DFS_FILE_H__
@@ -66,6 +67,7 @@ struct dfs_fd
 #endif
 
     void *data;                  /* Specific file system data */
+    struct rt_mutex pos_lock;    /* Position of a seekable file */
 };
 
 int dfs_file_open(struct dfs_fd *fd, const char *path, int flags);
@@ -77,6 +79,8 @@ int dfs_file_unlink(const char *path);
 int dfs_file_write(struct dfs_fd *fd, const void *buf, size_t len);
 int dfs_file_flush(struct dfs_fd *fd);
 int dfs_file_lseek(struct dfs_fd *fd, off_t offset);
+int dfs_file_pread(struct dfs_fd *fd, void *buf, size_t len, off_t offset);
+int dfs_file_pwrite(struct dfs_fd *fd, const void *buf, size_t len, off_t offset);
 
 int dfs_file_stat(const char *path, struct stat *buf);
 int dfs_file_rename(const char *oldpath, const char *newpath);
@@ -20,6 +20,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2005-02-22     Bernard      The first version.
+ * 2026-10-19     heyuanjie    init the pos_lock of fd
  */
 
 #include <dfs.h>
@@ -133,6 +134,7 @@ int fd_new(int minfd)
     d = fdt->fds[idx];
     d->ref_count = 1;
     d->magic = DFS_FD_MAGIC;
+    rt_mutex_init(&d->pos_lock, "fdpos", RT_IPC_FLAG_FIFO);
 
 __result:
     dfs_unlock();
@@ -189,6 +191,7 @@ void fd_put(struct dfs_fd *fd)
     /* clear this fd entry */
     if (fd->ref_count == 0)
     {
+        rt_mutex_detach(&fd->pos_lock);
         memset(fd, 0, sizeof(struct dfs_fd));
     }
     dfs_unlock();
@@ -22,6 +22,7 @@
  * 2005-02-22     Bernard      The first version.
  * 2011-12-08     Bernard      Merges rename patch from iamcacy.
  * 2015-05-27     Bernard      Fix the fd clear issue.
+ * 2026-10-19     heyuanjie    add dfs_file_pread/pwrite under the pos_lock
  */
 
 #include <dfs.h>
@@ -31,6 +32,12 @@
 #include <sys/stat.h>
 #include <dirent.h>
 
+/*
+ * The position of a file which can seek is kept under the pos_lock of fd.
+ * The others (devices, sockets) may block in read, so they are not locked.
+ */
+#define DFS_FD_SEEKABLE(fd)     ((fd)->fops->lseek != NULL)
+
 /**
  * @addtogroup FileApi
  */
@@ -278,8 +285,12 @@ int dfs_file_read(struct dfs_fd *fd, void *buf, size_t len)
     if (fd->fops->read == NULL)
         return -ENOSYS;
 
+    if (DFS_FD_SEEKABLE(fd))
+        rt_mutex_take(&fd->pos_lock, RT_WAITING_FOREVER);
     if ((result = fd->fops->read(fd, buf, len)) < 0)
         fd->flags |= DFS_F_EOF;
+    if (DFS_FD_SEEKABLE(fd))
+        rt_mutex_release(&fd->pos_lock);
 
     return result;
 }
@@ -295,13 +306,22 @@ int dfs_file_read(struct dfs_fd *fd, void *buf, size_t len)
  */
 int dfs_file_write(struct dfs_fd *fd, const void *buf, size_t len)
 {
+    int result;
+
     if (fd == NULL)
         return -EINVAL;
 
     if (fd->fops->write == NULL)
         return -ENOSYS;
 
-    return fd->fops->write(fd, buf, len);
+    if (!DFS_FD_SEEKABLE(fd))
+        return fd->fops->write(fd, buf, len);
+
+    rt_mutex_take(&fd->pos_lock, RT_WAITING_FOREVER);
+    result = fd->fops->write(fd, buf, len);
+    rt_mutex_release(&fd->pos_lock);
+
+    return result;
 }
 
 /**
@@ -337,7 +357,10 @@ int dfs_file_dupfd(int fd, int minfd)
     nfile = fd_get(fdret);
 	if (nfile)
 	{
+	    /* the mutex is an object in the list, it's not copied */
+	    rt_mutex_detach(&nfile->pos_lock);
 	    *nfile = *ofile;
+	    rt_mutex_init(&nfile->pos_lock, "fdpos", RT_IPC_FLAG_FIFO);
 		if (nfile->dev)
 		{
 		    nfile->dev->ref_count ++;
@@ -449,11 +472,100 @@ int dfs_file_lseek(struct dfs_fd *fd, off_t offset)
     if (fd->fops->lseek == NULL)
         return -ENOSYS;
 
+    rt_mutex_take(&fd->pos_lock, RT_WAITING_FOREVER);
     result = fd->fops->lseek(fd, offset);
 
     /* update current position */
     if (result >= 0)
         fd->pos = result;
+    rt_mutex_release(&fd->pos_lock);
+
+    return result;
+}
+
+/**
+ * this function will read data at the offset of a file, the current position
+ * of file is not changed.
+ *
+ * @param fd the file descriptor.
+ * @param buf the buffer to save the read data.
+ * @param len the length of data buffer to be read.
+ * @param offset the offset in file.
+ *
+ * @return the actual read data bytes or a negative error code, -ESPIPE if
+ * the file can't seek.
+ */
+int dfs_file_pread(struct dfs_fd *fd, void *buf, size_t len, off_t offset)
+{
+    int result;
+    off_t pos;
+
+    if (fd == NULL)
+        return -EINVAL;
+
+    if (!DFS_FD_SEEKABLE(fd))
+        return -ESPIPE;
+
+    rt_mutex_take(&fd->pos_lock, RT_WAITING_FOREVER);
+    /* closed while it's held */
+    if (fd->path == NULL)
+    {
+        rt_mutex_release(&fd->pos_lock);
+
+        return -EBADF;
+    }
+
+    pos = fd->pos;
+    result = dfs_file_lseek(fd, offset);
+    if (result >= 0)
+    {
+        result = dfs_file_read(fd, buf, len);
+        dfs_file_lseek(fd, pos);
+    }
+    rt_mutex_release(&fd->pos_lock);
+
+    return result;
+}
+
+/**
+ * this function will write data at the offset of a file, the current
+ * position of file is not changed.
+ *
+ * @param fd the file descriptor.
+ * @param buf the data buffer to be written.
+ * @param len the data buffer length.
+ * @param offset the offset in file.
+ *
+ * @return the actual written data bytes or a negative error code, -ESPIPE
+ * if the file can't seek.
+ */
+int dfs_file_pwrite(struct dfs_fd *fd, const void *buf, size_t len, off_t offset)
+{
+    int result;
+    off_t pos;
+
+    if (fd == NULL)
+        return -EINVAL;
+
+    if (!DFS_FD_SEEKABLE(fd))
+        return -ESPIPE;
+
+    rt_mutex_take(&fd->pos_lock, RT_WAITING_FOREVER);
+    if (fd->path == NULL)
+    {
+        rt_mutex_release(&fd->pos_lock);
+
+        return -EBADF;
+    }
+
+    pos = fd->pos;
+    result = dfs_file_lseek(fd, offset);
+    if (result >= 0)
+    {
+        result = dfs_file_write(fd, buf, len);
+        dfs_file_lseek(fd, pos);
+    }
+    rt_mutex_release(&fd->pos_lock);
 
     return result;
 }
@@ -20,6 +20,9 @@
  * Change Logs:
  * Date           Author       Notes
  * 2009-05-27     Yi.qiu       The first version
+ * 2026-10-19     heyuanjie    add aio_read/aio_write/lio_listio
+ * 2026-10-19     heyuanjie    check the owner of aio is alive before signal
+ * 2026-10-19     heyuanjie    a closed fd can't be got while aio holds it
  */
 
 #include <dfs.h>
@@ -100,7 +103,22 @@ int close(int fd)
         return -1;
     }
 
+    /* after the reads and writes in progress, e.g. of aio */
+    if (d->fops->lseek != NULL)
+        rt_mutex_take(&d->pos_lock, RT_WAITING_FOREVER);
     result = dfs_file_close(d);
+    if (result == 0)
+    {
+        /*
+         * the fd can't be got any more, only the references taken before
+         * (e.g. by aio) keep the entry until they are put
+         */
+        dfs_lock();
+        d->magic = 0;
+        dfs_unlock();
+    }
+    if (d->fops->lseek != NULL)
+        rt_mutex_release(&d->pos_lock);
     fd_put(d);
 
     if (result < 0)
@@ -341,6 +359,10 @@ off_t lseek(int fd, off_t offset, int whence)
         return -1;
     }
 
+    /* the current position is not moved by aio between */
+    if (d->fops->lseek != NULL)
+        rt_mutex_take(&d->pos_lock, RT_WAITING_FOREVER);
+
     switch (whence)
     {
     case SEEK_SET:
@@ -355,20 +377,15 @@ off_t lseek(int fd, off_t offset, int whence)
         break;
 
     default:
-        fd_put(d);
-        rt_set_errno(-EINVAL);
-
-        return -1;
+        result = -EINVAL;
+        goto __exit;
     }
 
-    if (offset < 0)
-    {
-        fd_put(d);
-        rt_set_errno(-EINVAL);
+    result = (offset < 0) ? -EINVAL : dfs_file_lseek(d, offset);
 
-        return -1;
-    }
-    result = dfs_file_lseek(d, offset);
+__exit:
+    if (d->fops->lseek != NULL)
+        rt_mutex_release(&d->pos_lock);
     if (result < 0)
     {
         fd_put(d);
@@ -907,4 +924,648 @@ off_t lseek(int fd, off_t offset, int whence)
 
 #endif
 
+#ifdef RT_USING_POSIX_AIO
+#include <rthw.h>
+#include <aio.h>
+
+#ifndef POSIX_AIO_THREAD_NUM
+#define POSIX_AIO_THREAD_NUM        2
+#endif
+
+#ifndef POSIX_AIO_THREAD_STACK_SIZE
+#define POSIX_AIO_THREAD_STACK_SIZE 2048
+#endif
+
+#ifndef POSIX_AIO_THREAD_PRIO
+#define POSIX_AIO_THREAD_PRIO       (RT_THREAD_PRIORITY_MAX / 2)
+#endif
+
+/* the contiguous requests of a file merged to one read or write */
+#ifndef POSIX_AIO_MERGE_SIZE
+#define POSIX_AIO_MERGE_SIZE        4096
+#endif
+
+/*
+ * The requests of a file are served in the order of submission by the
+ * worker of the file. The requests at the head of it on the following
+ * offsets in the same direction are served together: merged to one
+ * read or write if they are small, or one after another.
+ *
+ * A file holds a reference of its dfs_fd from the first request to the last
+ * one, the requests are served by positional reads and writes under the
+ * pos_lock of it, the file position of application is not changed.
+ */
+struct aio_file
+{
+    struct dfs_fd *d;
+    int worker;
+    rt_list_t reqs;
+    rt_list_t node;
+    struct rt_work work;
+};
+
+/* the requests of a lio_listio */
+struct aio_lio
+{
+    int pending;
+    struct sigevent sigev;
+    rt_thread_t owner;
+    struct rt_semaphore *sem;       /* for LIO_WAIT */
+};
+
+struct aio_waiter
+{
+    rt_list_t node;
+    struct rt_semaphore sem;
+};
+
+static struct rt_workqueue *_aio_workers[POSIX_AIO_THREAD_NUM];
+static rt_list_t _aio_files = RT_LIST_OBJECT_INIT(_aio_files);
+static rt_list_t _aio_waiters = RT_LIST_OBJECT_INIT(_aio_waiters);
+static struct rt_mutex _aio_lock;
+
+static int aio_sigev_valid(const struct sigevent *sigev)
+{
+    if (sigev->sigev_notify == SIGEV_NONE)
+        return 1;
+    if (sigev->sigev_notify == SIGEV_THREAD)
+        return sigev->sigev_notify_function != RT_NULL;
+#ifdef RT_USING_SIGNALS
+    if (sigev->sigev_notify == SIGEV_SIGNAL)
+        return (sigev->sigev_signo > 0) && (sigev->sigev_signo < RT_SIG_MAX);
+#endif
+
+    return 0;
+}
+
+#ifdef RT_USING_SIGNALS
+/*
+ * The submitter may have exited before the request is done, so it is looked
+ * up among the threads alive. The caller locks the scheduler, so that it
+ * can not exit meanwhile.
+ */
+static rt_bool_t aio_owner_alive(rt_thread_t owner)
+{
+    struct rt_object_information *information;
+    struct rt_list_node *node;
+    rt_bool_t alive = RT_FALSE;
+    rt_base_t level;
+
+    if (owner == RT_NULL)
+        return RT_FALSE;
+
+    information = rt_object_get_information(RT_Object_Class_Thread);
+    RT_ASSERT(information != RT_NULL);
+
+    level = rt_hw_interrupt_disable();
+    for (node = information->object_list.next;
+         node != &(information->object_list);
+         node = node->next)
+    {
+        if ((rt_thread_t)rt_list_entry(node, struct rt_object, list) == owner)
+        {
+            alive = (owner->stat & RT_THREAD_STAT_MASK) != RT_THREAD_CLOSE;
+            break;
+        }
+    }
+    rt_hw_interrupt_enable(level);
+
+    return alive;
+}
+#endif
+
+static void aio_notify(const struct sigevent *sigev, rt_thread_t owner)
+{
+    if (sigev->sigev_notify == SIGEV_THREAD)
+    {
+        sigev->sigev_notify_function(sigev->sigev_value);
+    }
+#ifdef RT_USING_SIGNALS
+    else if (sigev->sigev_notify == SIGEV_SIGNAL)
+    {
+        rt_siginfo_t si;
+
+        si.si_signo = sigev->sigev_signo;
+        si.si_code  = SI_ASYNCIO;
+        si.si_value = sigev->sigev_value;
+
+        /* the owner can not exit while the scheduler is locked */
+        rt_enter_critical();
+        if (aio_owner_alive(owner))
+            rt_thread_sigqueue(owner, &si);
+        rt_exit_critical();
+    }
+#endif
+}
+
+static void aio_complete(struct aiocb *cb, ssize_t result)
+{
+    struct aio_lio *lio = cb->__lio;
+    struct aio_waiter *waiter;
+    struct sigevent sigev;
+    rt_thread_t owner;
+    int lio_done = 0;
+
+    /* the aiocb may be reused once its error is set */
+    sigev = cb->aio_sigevent;
+    owner = cb->__owner;
+
+    rt_mutex_take(&_aio_lock, RT_WAITING_FOREVER);
+    cb->__return = (result < 0) ? -1 : result;
+    cb->__error = (result < 0) ? -result : 0;
+    if (lio != RT_NULL && --lio->pending == 0)
+        lio_done = 1;
+    rt_list_for_each_entry(waiter, &_aio_waiters, node)
+        rt_sem_release(&(waiter->sem));
+    rt_mutex_release(&_aio_lock);
+
+    aio_notify(&sigev, owner);
+    if (lio_done)
+    {
+        if (lio->sem != RT_NULL)
+        {
+            rt_sem_release(lio->sem);
+        }
+        else
+        {
+            aio_notify(&(lio->sigev), lio->owner);
+            rt_free(lio);
+        }
+    }
+}
+
+static int aio_rw(struct dfs_fd *d, int op, void *buf, size_t len, off_t offset)
+{
+    if (op == LIO_READ)
+        return dfs_file_pread(d, buf, len, offset);
+
+    return dfs_file_pwrite(d, buf, len, offset);
+}
+
+/* serve the requests on the following offsets of a file */
+static void aio_run(struct dfs_fd *d, rt_list_t *batch)
+{
+    struct aiocb *first, *cb, *next;
+    rt_uint8_t *buf = RT_NULL;
+    size_t total = 0, offset;
+    ssize_t result;
+    int count = 0, ret;
+
+    first = rt_list_first_entry(batch, struct aiocb, __list);
+    rt_list_for_each_entry(cb, batch, __list)
+    {
+        total += cb->aio_nbytes;
+        count ++;
+    }
+
+    if (count > 1 && total <= POSIX_AIO_MERGE_SIZE)
+        buf = rt_malloc(total);
+
+    if (buf != RT_NULL)
+    {
+        if (first->__op == LIO_WRITE)
+        {
+            offset = 0;
+            rt_list_for_each_entry(cb, batch, __list)
+            {
+                rt_memcpy(buf + offset, (void *)cb->aio_buf, cb->aio_nbytes);
+                offset += cb->aio_nbytes;
+            }
+        }
+
+        ret = aio_rw(d, first->__op, buf, total, first->aio_offset);
+
+        offset = 0;
+        rt_list_for_each_entry_safe(cb, next, batch, __list)
+        {
+            if (ret < 0)
+                result = ret;
+            else if ((size_t)ret <= offset)
+                result = 0;
+            else
+                result = ((size_t)ret - offset < cb->aio_nbytes) ? (size_t)ret - offset : cb->aio_nbytes;
+
+            if (first->__op == LIO_READ && result > 0)
+                rt_memcpy((void *)cb->aio_buf, buf + offset, result);
+            offset += cb->aio_nbytes;
+
+            rt_list_remove(&(cb->__list));
+            aio_complete(cb, result);
+        }
+
+        rt_free(buf);
+    }
+    else
+    {
+        rt_list_for_each_entry_safe(cb, next, batch, __list)
+        {
+            ret = aio_rw(d, cb->__op, (void *)cb->aio_buf, cb->aio_nbytes, cb->aio_offset);
+
+            rt_list_remove(&(cb->__list));
+            aio_complete(cb, ret);
+        }
+    }
+}
+
+static void aio_work(struct rt_work *work, void *work_data)
+{
+    struct aio_file *file = (struct aio_file *)work_data;
+    struct aiocb *first, *cb;
+    rt_list_t batch;
+    off_t end;
+
+    rt_list_init(&batch);
+
+    rt_mutex_take(&_aio_lock, RT_WAITING_FOREVER);
+    first = rt_list_first_entry(&(file->reqs), struct aiocb, __list);
+    end = first->aio_offset;
+    while (!rt_list_isempty(&(file->reqs)))
+    {
+        cb = rt_list_first_entry(&(file->reqs), struct aiocb, __list);
+        if (cb->__op != first->__op || cb->aio_offset != end)
+            break;
+
+        rt_list_remove(&(cb->__list));
+        rt_list_insert_before(&batch, &(cb->__list));
+        end += cb->aio_nbytes;
+    }
+    rt_mutex_release(&_aio_lock);
+
+    aio_run(file->d, &batch);
+
+    /* the other files of this worker go first */
+    rt_mutex_take(&_aio_lock, RT_WAITING_FOREVER);
+    if (rt_list_isempty(&(file->reqs)))
+    {
+        rt_list_remove(&(file->node));
+        fd_put(file->d);
+        rt_free(file);
+    }
+    else
+    {
+        rt_workqueue_dowork(_aio_workers[file->worker], &(file->work));
+    }
+    rt_mutex_release(&_aio_lock);
+}
+
+/* queue a request to its file, the _aio_lock is taken */
+static int aio_submit(struct aiocb *cb, int op, struct aio_lio *lio)
+{
+    struct aio_file *file;
+    struct dfs_fd *d;
+
+    if (cb->aio_offset < 0 || !aio_sigev_valid(&(cb->aio_sigevent)))
+        return -EINVAL;
+
+    /* the file is kept by the reference, even if the fd is closed */
+    d = fd_get(cb->aio_fildes);
+    if (d == RT_NULL)
+        return -EBADF;
+
+    rt_list_for_each_entry(file, &_aio_files, node)
+    {
+        if (file->d == d)
+        {
+            fd_put(d);
+            goto __queue;
+        }
+    }
+
+    file = (struct aio_file *)rt_malloc(sizeof(struct aio_file));
+    if (file == RT_NULL)
+    {
+        fd_put(d);
+        return -EAGAIN;
+    }
+    file->d = d;
+    file->worker = cb->aio_fildes % POSIX_AIO_THREAD_NUM;
+    rt_list_init(&(file->reqs));
+    rt_list_insert_before(&_aio_files, &(file->node));
+    rt_work_init(&(file->work), aio_work, file);
+    rt_workqueue_dowork(_aio_workers[file->worker], &(file->work));
+
+__queue:
+    cb->__op = op;
+    cb->__lio = lio;
+    cb->__owner = rt_thread_self();
+    cb->__error = EINPROGRESS;
+    cb->__return = 0;
+    rt_list_insert_before(&(file->reqs), &(cb->__list));
+
+    return 0;
+}
+
+static int aio_queue(struct aiocb *aiocbp, int op)
+{
+    int result;
+
+    if (aiocbp == RT_NULL)
+    {
+        rt_set_errno(-EINVAL);
+
+        return -1;
+    }
+
+    rt_mutex_take(&_aio_lock, RT_WAITING_FOREVER);
+    result = aio_submit(aiocbp, op, RT_NULL);
+    rt_mutex_release(&_aio_lock);
+
+    if (result < 0)
+    {
+        rt_set_errno(result);
+
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * this function is a POSIX compliant version, which will queue a read of
+ * aio_nbytes at aio_offset of the file. The file position is not changed.
+ *
+ * @param aiocbp the control block, which must be kept until it's done.
+ *
+ * @return 0 on queued, -1 on failed.
+ */
+int aio_read(struct aiocb *aiocbp)
+{
+    return aio_queue(aiocbp, LIO_READ);
+}
+RTM_EXPORT(aio_read);
+
+/**
+ * this function is a POSIX compliant version, which will queue a write of
+ * aio_nbytes at aio_offset of the file. The file position is not changed.
+ *
+ * @param aiocbp the control block, which must be kept until it's done.
+ *
+ * @return 0 on queued, -1 on failed.
+ */
+int aio_write(struct aiocb *aiocbp)
+{
+    return aio_queue(aiocbp, LIO_WRITE);
+}
+RTM_EXPORT(aio_write);
+
+/**
+ * this function is a POSIX compliant version, which will return the error
+ * status of an asynchronous request.
+ *
+ * @param aiocbp the control block.
+ *
+ * @return EINPROGRESS if it's not done, 0 on successful, or the error number.
+ */
+int aio_error(const struct aiocb *aiocbp)
+{
+    if (aiocbp == RT_NULL)
+    {
+        rt_set_errno(-EINVAL);
+
+        return -1;
+    }
+
+    return aiocbp->__error;
+}
+RTM_EXPORT(aio_error);
+
+/**
+ * this function is a POSIX compliant version, which will return the result
+ * of a done asynchronous request.
+ *
+ * @param aiocbp the control block.
+ *
+ * @return the bytes read or written, -1 on failed.
+ */
+ssize_t aio_return(struct aiocb *aiocbp)
+{
+    if (aiocbp == RT_NULL || aiocbp->__error == EINPROGRESS)
+    {
+        rt_set_errno(-EINVAL);
+
+        return -1;
+    }
+
+    if (aiocbp->__error != 0)
+        rt_set_errno(-aiocbp->__error);
+
+    return aiocbp->__return;
+}
+RTM_EXPORT(aio_return);
+
+/**
+ * this function is a POSIX compliant version, which will wait until one of
+ * the requests is done.
+ *
+ * @param list the control blocks, RT_NULL ones are ignored.
+ * @param nent the number of control blocks.
+ * @param timeout the time to wait, RT_NULL for forever.
+ *
+ * @return 0 on one is done, -1 on timeout.
+ */
+int aio_suspend(const struct aiocb *const list[], int nent, const struct timespec *timeout)
+{
+    struct aio_waiter waiter;
+    rt_int32_t ticks = RT_WAITING_FOREVER;
+    rt_tick_t deadline = 0;
+    rt_err_t result = RT_EOK;
+    int index;
+
+    if (list == RT_NULL || nent < 0)
+    {
+        rt_set_errno(-EINVAL);
+
+        return -1;
+    }
+
+    if (timeout != RT_NULL)
+    {
+        ticks = timeout->tv_sec * RT_TICK_PER_SECOND +
+                (rt_int64_t)timeout->tv_nsec * RT_TICK_PER_SECOND / 1000000000;
+        deadline = rt_tick_get() + ticks;
+    }
+
+    rt_sem_init(&(waiter.sem), "aio", 0, RT_IPC_FLAG_FIFO);
+
+    rt_mutex_take(&_aio_lock, RT_WAITING_FOREVER);
+    rt_list_insert_before(&_aio_waiters, &(waiter.node));
+    while (1)
+    {
+        for (index = 0; index < nent; index ++)
+        {
+            if (list[index] != RT_NULL && list[index]->__error != EINPROGRESS)
+                break;
+        }
+        if (index < nent)
+        {
+            /* it may be done just as the wait times out */
+            result = RT_EOK;
+            break;
+        }
+
+        if (timeout != RT_NULL)
+        {
+            ticks = (rt_int32_t)(deadline - rt_tick_get());
+            if (ticks <= 0)
+            {
+                result = -RT_ETIMEOUT;
+                break;
+            }
+        }
+
+        /* the list is checked again after the wait, even if it timed out */
+        rt_mutex_release(&_aio_lock);
+        rt_sem_take(&(waiter.sem), ticks);
+        rt_mutex_take(&_aio_lock, RT_WAITING_FOREVER);
+    }
+    rt_list_remove(&(waiter.node));
+    rt_mutex_release(&_aio_lock);
+
+    rt_sem_detach(&(waiter.sem));
+
+    if (result != RT_EOK)
+    {
+        rt_set_errno(-EAGAIN);
+
+        return -1;
+    }
+
+    return 0;
+}
+RTM_EXPORT(aio_suspend);
+
+/**
+ * this function is a POSIX compliant version, which will queue a list of
+ * requests. The requests are queued together, so the ones on following
+ * offsets of a file are served together.
+ *
+ * @param mode LIO_WAIT to wait until all are done, or LIO_NOWAIT.
+ * @param list the control blocks, RT_NULL ones are ignored.
+ * @param nent the number of control blocks.
+ * @param sig the notification when all are done, for LIO_NOWAIT.
+ *
+ * @return 0 on successful, -1 on failed.
+ */
+int lio_listio(int mode, struct aiocb *const list[], int nent, struct sigevent *sig)
+{
+    struct aio_lio *lio = RT_NULL, lio_wait;
+    struct rt_semaphore sem;
+    struct aiocb *cb;
+    int index, result, error = 0, done;
+
+    if ((mode != LIO_WAIT && mode != LIO_NOWAIT) || list == RT_NULL || nent < 0)
+    {
+        rt_set_errno(-EINVAL);
+
+        return -1;
+    }
+
+    if (mode == LIO_WAIT)
+    {
+        lio = &lio_wait;
+        rt_sem_init(&sem, "lio", 0, RT_IPC_FLAG_FIFO);
+        lio->sem = &sem;
+    }
+    else if (sig != RT_NULL && sig->sigev_notify != SIGEV_NONE)
+    {
+        if (!aio_sigev_valid(sig))
+        {
+            rt_set_errno(-EINVAL);
+
+            return -1;
+        }
+
+        lio = (struct aio_lio *)rt_malloc(sizeof(struct aio_lio));
+        if (lio == RT_NULL)
+        {
+            rt_set_errno(-EAGAIN);
+
+            return -1;
+        }
+        lio->sigev = *sig;
+        lio->owner = rt_thread_self();
+        lio->sem = RT_NULL;
+    }
+
+    /* held until all are queued */
+    if (lio != RT_NULL)
+        lio->pending = 1;
+
+    rt_mutex_take(&_aio_lock, RT_WAITING_FOREVER);
+    for (index = 0; index < nent; index ++)
+    {
+        cb = list[index];
+        if (cb == RT_NULL || cb->aio_lio_opcode == LIO_NOP)
+            continue;
+
+        if (cb->aio_lio_opcode != LIO_READ && cb->aio_lio_opcode != LIO_WRITE)
+            result = -EINVAL;
+        else
+            result = aio_submit(cb, cb->aio_lio_opcode, lio);
+
+        if (result < 0)
+        {
+            cb->__error = -result;
+            cb->__return = -1;
+            error = EIO;
+        }
+        else if (lio != RT_NULL)
+        {
+            lio->pending ++;
+        }
+    }
+    done = (lio != RT_NULL && --lio->pending == 0);
+    rt_mutex_release(&_aio_lock);
+
+    if (mode == LIO_WAIT)
+    {
+        if (!done)
+            rt_sem_take(&sem, RT_WAITING_FOREVER);
+        rt_sem_detach(&sem);
+
+        for (index = 0; index < nent; index ++)
+        {
+            cb = list[index];
+            if (cb != RT_NULL && cb->aio_lio_opcode != LIO_NOP && cb->__error != 0)
+                error = EIO;
+        }
+    }
+    else if (done)
+    {
+        aio_notify(&(lio->sigev), lio->owner);
+        rt_free(lio);
+    }
+
+    if (error)
+    {
+        rt_set_errno(-error);
+
+        return -1;
+    }
+
+    return 0;
+}
+RTM_EXPORT(lio_listio);
+
+int aio_system_init(void)
+{
+    char name[RT_NAME_MAX];
+    int index;
+
+    rt_mutex_init(&_aio_lock, "aio", RT_IPC_FLAG_FIFO);
+
+    for (index = 0; index < POSIX_AIO_THREAD_NUM; index ++)
+    {
+        rt_snprintf(name, sizeof(name), "aio%d", index);
+        _aio_workers[index] = rt_workqueue_create(name, POSIX_AIO_THREAD_STACK_SIZE,
+                                                  POSIX_AIO_THREAD_PRIO);
+        if (_aio_workers[index] == RT_NULL)
+            return -1;
+    }
+
+    return 0;
+}
+INIT_COMPONENT_EXPORT(aio_system_init);
+#endif /* RT_USING_POSIX_AIO */
+
 /* @} */
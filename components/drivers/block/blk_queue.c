@@ -0,0 +1,567 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ */
+
+/*
+ * Request queue of block device.
+ *
+ * A queue is a block device on another one, the reads and writes of it are
+ * submitted to the queue and served by the thread of queue, so the requests
+ * of several threads are merged and the submitter of rt_blk_submit() can go
+ * on while its request is served.
+ *
+ * - The requests are served by the elevator (C-LOOK) in the order of sector,
+ *   unless one waits past its deadline, then the one expired first is served.
+ * - The pending requests of the same direction on the following sectors are
+ *   merged to one transfer of RT_BLK_MAX_SECTORS sectors at most. They are
+ *   copied through a bounce buffer if their buffers are not contiguous.
+ * - A request never passes an earlier one on the same sectors when either
+ *   of them writes.
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+
+#define BLK_EVENT_SUBMIT    0x01
+#define BLK_EVENT_IDLE      0x02
+
+struct rt_blk_queue
+{
+    struct rt_device parent;
+    rt_device_t dev;                /* the device queued */
+    struct rt_device_blk_geometry geometry;
+
+    struct rt_mutex lock;
+    struct rt_event event;
+    rt_thread_t tid;
+
+    rt_list_t sorted;               /* the pending requests by sector */
+    rt_list_t fifo;                 /* the pending requests by submission */
+    rt_off_t head;                  /* the sector after the last transfer */
+
+    rt_uint8_t *bounce;             /* RT_BLK_MAX_SECTORS sectors, or RT_NULL */
+    struct rt_blk_request *batch[RT_BLK_MAX_SECTORS];
+
+    struct rt_blk_stats stats;
+    rt_list_t node;
+};
+
+static rt_list_t _blk_queues = RT_LIST_OBJECT_INIT(_blk_queues);
+
+rt_inline int blk_overlap(struct rt_blk_request *a, struct rt_blk_request *b)
+{
+    return a->sector < b->sector + (rt_off_t)b->count &&
+           b->sector < a->sector + (rt_off_t)a->count;
+}
+
+/* an earlier pending request which must be served before req */
+static struct rt_blk_request *blk_conflict(struct rt_blk_queue *q, struct rt_blk_request *req)
+{
+    struct rt_blk_request *r;
+
+    rt_list_for_each_entry(r, &q->fifo, fifo)
+    {
+        if (r == req)
+            break;
+        if ((r->op == RT_BLK_WRITE || req->op == RT_BLK_WRITE) && blk_overlap(r, req))
+            return r;
+    }
+
+    return RT_NULL;
+}
+
+static struct rt_blk_request *blk_pick(struct rt_blk_queue *q)
+{
+    struct rt_blk_request *r, *req = RT_NULL;
+    rt_tick_t now = rt_tick_get();
+
+    rt_list_for_each_entry(r, &q->fifo, fifo)
+    {
+        if ((rt_int32_t)(now - r->deadline) >= 0 &&
+            (req == RT_NULL || (rt_int32_t)(r->deadline - req->deadline) < 0))
+            req = r;
+    }
+
+    if (req != RT_NULL)
+    {
+        q->stats.expired++;
+    }
+    else
+    {
+        /* the next one after the head, or back to the lowest */
+        rt_list_for_each_entry(r, &q->sorted, list)
+        {
+            if (r->sector >= q->head)
+            {
+                req = r;
+                break;
+            }
+        }
+        if (req == RT_NULL)
+            req = rt_list_entry(q->sorted.next, struct rt_blk_request, list);
+    }
+
+    while ((r = blk_conflict(q, req)) != RT_NULL)
+        req = r;
+
+    return req;
+}
+
+/* take the next requests to transfer to q->batch, return the number of them */
+static int blk_next(struct rt_blk_queue *q)
+{
+    struct rt_blk_request *req, *r;
+    rt_uint8_t *end;
+    rt_size_t sectors;
+    rt_list_t *next;
+    int n = 0;
+
+    rt_mutex_take(&q->lock, RT_WAITING_FOREVER);
+    if (rt_list_isempty(&q->sorted))
+        goto out;
+
+    req = blk_pick(q);
+    next = req->list.next;
+    rt_list_remove(&req->list);
+    rt_list_remove(&req->fifo);
+    q->batch[n++] = req;
+    sectors = req->count;
+    end = (rt_uint8_t *)req->buffer + req->count * q->geometry.bytes_per_sector;
+
+    while (next != &q->sorted && n < RT_BLK_MAX_SECTORS)
+    {
+        r = rt_list_entry(next, struct rt_blk_request, list);
+        if (r->op != req->op || r->sector != req->sector + (rt_off_t)sectors ||
+            sectors + r->count > RT_BLK_MAX_SECTORS)
+            break;
+        /* without bounce buffer, only the contiguous buffers are merged */
+        if (q->bounce == RT_NULL && (rt_uint8_t *)r->buffer != end)
+            break;
+        if (blk_conflict(q, r) != RT_NULL)
+            break;
+
+        next = r->list.next;
+        rt_list_remove(&r->list);
+        rt_list_remove(&r->fifo);
+        q->batch[n++] = r;
+        sectors += r->count;
+        end = (rt_uint8_t *)r->buffer + r->count * q->geometry.bytes_per_sector;
+        q->stats.merges++;
+    }
+
+    q->head = req->sector + sectors;
+    q->stats.transfers++;
+
+out:
+    rt_mutex_release(&q->lock);
+
+    return n;
+}
+
+static void blk_complete(struct rt_blk_queue *q, struct rt_blk_request *req, rt_err_t result)
+{
+    rt_tick_t ticks = rt_tick_get() - req->start;
+    int slot = 0;
+
+    while (slot < RT_BLK_LATENCY_SLOTS - 1 && (ticks >> slot))
+        slot++;
+
+    req->result = result;
+    if (req->done != RT_NULL)
+        req->done(req);
+    else
+        rt_completion_done(&req->completion);
+
+    /*
+     * the request may be gone now. The queue is idle once it's done, and
+     * under the lock, as submit clears the idle event when depth goes 0->1.
+     */
+    rt_mutex_take(&q->lock, RT_WAITING_FOREVER);
+    q->stats.latency[slot]++;
+    if (result < 0)
+        q->stats.errors++;
+    if (--q->stats.depth == 0)
+        rt_event_send(&q->event, BLK_EVENT_IDLE);
+    rt_mutex_release(&q->lock);
+}
+
+static rt_size_t blk_transfer(struct rt_blk_queue *q, rt_uint8_t op, rt_off_t sector, void *buffer, rt_size_t count)
+{
+    if (op == RT_BLK_READ)
+        return rt_device_read(q->dev, sector, buffer, count);
+
+    return rt_device_write(q->dev, sector, buffer, count);
+}
+
+static void blk_dispatch(struct rt_blk_queue *q, int n)
+{
+    struct rt_blk_request *req = q->batch[0], *r;
+    rt_uint32_t bps = q->geometry.bytes_per_sector;
+    rt_size_t sectors, ret;
+    rt_uint8_t *buf;
+    int i;
+
+    buf = req->buffer;
+    sectors = req->count;
+    for (i = 1; i < n; i ++)
+    {
+        r = q->batch[i];
+        if ((rt_uint8_t *)r->buffer != (rt_uint8_t *)req->buffer + sectors * bps)
+            buf = q->bounce;
+        sectors += r->count;
+    }
+
+    if (buf == q->bounce && req->op == RT_BLK_WRITE)
+    {
+        for (i = 0; i < n; i ++)
+        {
+            r = q->batch[i];
+            rt_memcpy(buf + (r->sector - req->sector) * bps, r->buffer, r->count * bps);
+        }
+    }
+
+    ret = blk_transfer(q, req->op, req->sector, buf, sectors);
+    if (ret == sectors)
+    {
+        for (i = 0; i < n; i ++)
+        {
+            r = q->batch[i];
+            if (buf == q->bounce && req->op == RT_BLK_READ)
+                rt_memcpy(r->buffer, buf + (r->sector - req->sector) * bps, r->count * bps);
+            blk_complete(q, r, r->count);
+        }
+    }
+    else if (n == 1)
+    {
+        blk_complete(q, req, ret ? (rt_err_t)ret : -RT_EIO);
+    }
+    else
+    {
+        /* find out the failed ones */
+        for (i = 0; i < n; i ++)
+        {
+            r = q->batch[i];
+            ret = blk_transfer(q, r->op, r->sector, r->buffer, r->count);
+            blk_complete(q, r, ret ? (rt_err_t)ret : -RT_EIO);
+        }
+    }
+}
+
+static void blk_thread_entry(void *parameter)
+{
+    struct rt_blk_queue *q = (struct rt_blk_queue *)parameter;
+    rt_uint32_t set;
+    int n;
+
+    while (1)
+    {
+        rt_event_recv(&q->event, BLK_EVENT_SUBMIT, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR,
+                      RT_WAITING_FOREVER, &set);
+
+        while ((n = blk_next(q)) > 0)
+            blk_dispatch(q, n);
+    }
+}
+
+/**
+ * This function will submit a request to the queue. The done function of
+ * request is called by the thread of queue when it's served, or the
+ * completion of request is done if the done function is RT_NULL.
+ *
+ * @param q the queue
+ * @param req the request, which must be kept until it's done
+ *
+ * @return RT_EOK on submitted, -RT_EINVAL on the sectors out of device
+ */
+rt_err_t rt_blk_submit(struct rt_blk_queue *q, struct rt_blk_request *req)
+{
+    struct rt_blk_request *r;
+    rt_list_t *node;
+    rt_uint32_t set;
+
+    RT_ASSERT(q != RT_NULL);
+    RT_ASSERT(req != RT_NULL);
+
+    if (req->count == 0 || req->sector < 0 ||
+        req->sector + req->count > q->geometry.sector_count)
+        return -RT_EINVAL;
+
+    req->result = 0;
+    req->start = rt_tick_get();
+    req->deadline = req->start + rt_tick_from_millisecond(req->op == RT_BLK_READ ?
+                                 RT_BLK_READ_DEADLINE_MS : RT_BLK_WRITE_DEADLINE_MS);
+    if (req->done == RT_NULL)
+        rt_completion_init(&req->completion);
+
+    rt_mutex_take(&q->lock, RT_WAITING_FOREVER);
+
+    /* after the requests of the same sector */
+    for (node = q->sorted.next; node != &q->sorted; node = node->next)
+    {
+        r = rt_list_entry(node, struct rt_blk_request, list);
+        if (r->sector > req->sector)
+            break;
+    }
+    rt_list_insert_before(node, &req->list);
+    rt_list_insert_before(&q->fifo, &req->fifo);
+
+    if (req->op == RT_BLK_READ)
+    {
+        q->stats.reads++;
+        q->stats.read_sectors += req->count;
+    }
+    else
+    {
+        q->stats.writes++;
+        q->stats.write_sectors += req->count;
+    }
+    if (q->stats.depth++ == 0)
+        rt_event_recv(&q->event, BLK_EVENT_IDLE, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, 0, &set);
+    if (q->stats.depth > q->stats.max_depth)
+        q->stats.max_depth = q->stats.depth;
+    rt_event_send(&q->event, BLK_EVENT_SUBMIT);
+
+    rt_mutex_release(&q->lock);
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_blk_submit);
+
+/**
+ * This function will wait until all requests of the queue are served.
+ *
+ * @param q the queue
+ * @param timeout the ticks to wait
+ *
+ * @return RT_EOK, or -RT_ETIMEOUT
+ */
+rt_err_t rt_blk_flush(struct rt_blk_queue *q, rt_int32_t timeout)
+{
+    rt_uint32_t set;
+
+    return rt_event_recv(&q->event, BLK_EVENT_IDLE, RT_EVENT_FLAG_OR, timeout, &set);
+}
+RTM_EXPORT(rt_blk_flush);
+
+void rt_blk_stats_get(struct rt_blk_queue *q, struct rt_blk_stats *stats)
+{
+    rt_mutex_take(&q->lock, RT_WAITING_FOREVER);
+    rt_memcpy(stats, &q->stats, sizeof(struct rt_blk_stats));
+    rt_mutex_release(&q->lock);
+}
+RTM_EXPORT(rt_blk_stats_get);
+
+static rt_size_t blk_queue_rw(struct rt_blk_queue *q, rt_uint8_t op, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    struct rt_blk_request req;
+    rt_err_t ret;
+
+    rt_memset(&req, 0, sizeof(req));
+    req.op = op;
+    req.sector = pos;
+    req.count = size;
+    req.buffer = buffer;
+
+    ret = rt_blk_submit(q, &req);
+    if (ret == RT_EOK)
+    {
+        rt_completion_wait(&req.completion, RT_WAITING_FOREVER);
+        ret = req.result;
+    }
+    if (ret < 0)
+    {
+        rt_set_errno(ret);
+        return 0;
+    }
+
+    return ret;
+}
+
+static rt_size_t blk_queue_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    return blk_queue_rw((struct rt_blk_queue *)dev, RT_BLK_READ, pos, buffer, size);
+}
+
+static rt_size_t blk_queue_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    return blk_queue_rw((struct rt_blk_queue *)dev, RT_BLK_WRITE, pos, (void *)buffer, size);
+}
+
+static rt_err_t blk_queue_control(rt_device_t dev, int cmd, void *args)
+{
+    struct rt_blk_queue *q = (struct rt_blk_queue *)dev;
+
+    switch (cmd)
+    {
+    case RT_DEVICE_CTRL_BLK_GETGEOME:
+        if (args == RT_NULL)
+            return -RT_ERROR;
+        rt_memcpy(args, &q->geometry, sizeof(struct rt_device_blk_geometry));
+        return RT_EOK;
+
+    case RT_DEVICE_CTRL_BLK_SYNC:
+    case RT_DEVICE_CTRL_BLK_ERASE:
+        /* after the writes queued */
+        rt_blk_flush(q, RT_WAITING_FOREVER);
+        break;
+
+    default:
+        break;
+    }
+
+    return rt_device_control(q->dev, cmd, args);
+}
+
+static const struct rt_device_ops _blk_queue_ops =
+{
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    blk_queue_read,
+    blk_queue_write,
+    blk_queue_control,
+};
+
+/**
+ * This function will create a request queue on a block device. The queue
+ * is registered as a block device too, for the file systems.
+ *
+ * @param name the device name of queue
+ * @param dev_name the block device queued
+ *
+ * @return the queue, or RT_NULL on failure
+ */
+struct rt_blk_queue *rt_blk_queue_create(const char *name, const char *dev_name)
+{
+    struct rt_blk_queue *q;
+    rt_device_t dev;
+
+    dev = rt_device_find(dev_name);
+    if (dev == RT_NULL || dev->type != RT_Device_Class_Block)
+        return RT_NULL;
+
+    q = rt_malloc(sizeof(struct rt_blk_queue));
+    if (q == RT_NULL)
+        return RT_NULL;
+    rt_memset(q, 0, sizeof(struct rt_blk_queue));
+    q->dev = dev;
+
+    if (rt_device_open(dev, RT_DEVICE_OFLAG_RDWR) != RT_EOK)
+    {
+        rt_free(q);
+        return RT_NULL;
+    }
+    if (rt_device_control(dev, RT_DEVICE_CTRL_BLK_GETGEOME, &q->geometry) != RT_EOK ||
+        q->geometry.bytes_per_sector == 0)
+        goto out;
+
+    /* only the requests on contiguous buffers are merged without it */
+    q->bounce = rt_malloc(RT_BLK_MAX_SECTORS * q->geometry.bytes_per_sector);
+
+    rt_list_init(&q->sorted);
+    rt_list_init(&q->fifo);
+    rt_mutex_init(&q->lock, name, RT_IPC_FLAG_FIFO);
+    rt_event_init(&q->event, name, RT_IPC_FLAG_FIFO);
+    rt_event_send(&q->event, BLK_EVENT_IDLE);
+
+    q->tid = rt_thread_create(name, blk_thread_entry, q, RT_BLK_THREAD_STACK, RT_BLK_THREAD_PRIORITY, 10);
+    if (q->tid == RT_NULL)
+        goto out_ipc;
+
+    q->parent.type = RT_Device_Class_Block;
+    q->parent.dops = &_blk_queue_ops;
+    if (rt_device_register(&q->parent, name, RT_DEVICE_FLAG_RDWR) != RT_EOK)
+    {
+        rt_thread_delete(q->tid);
+        goto out_ipc;
+    }
+
+    rt_enter_critical();
+    rt_list_insert_before(&_blk_queues, &q->node);
+    rt_exit_critical();
+
+    rt_thread_startup(q->tid);
+
+    return q;
+
+out_ipc:
+    rt_event_detach(&q->event);
+    rt_mutex_detach(&q->lock);
+out:
+    rt_device_close(dev);
+    rt_free(q->bounce);
+    rt_free(q);
+
+    return RT_NULL;
+}
+RTM_EXPORT(rt_blk_queue_create);
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+static int blk_queue(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        rt_kprintf("blk_queue <name> <device>\n");
+        return -1;
+    }
+
+    if (rt_blk_queue_create(argv[1], argv[2]) == RT_NULL)
+    {
+        rt_kprintf("create queue on %s failed\n", argv[2]);
+        return -1;
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(blk_queue, create request queue on block device);
+
+static int blk_stat(int argc, char **argv)
+{
+    struct rt_blk_queue *q;
+    struct rt_blk_stats st;
+    rt_list_t *node;
+    int i;
+
+    /*
+     * the list is changed in critical by rt_blk_queue_create. A queue is
+     * never removed, so only the step to next one is done in critical,
+     * and the statistics are got and printed out of it.
+     */
+    rt_enter_critical();
+    node = _blk_queues.next;
+    rt_exit_critical();
+
+    while (node != &_blk_queues)
+    {
+        q = rt_list_entry(node, struct rt_blk_queue, node);
+        rt_blk_stats_get(q, &st);
+
+        rt_kprintf("%-8.*s on %.*s\n", RT_NAME_MAX, q->parent.parent.name,
+                   RT_NAME_MAX, q->dev->parent.name);
+        rt_kprintf("  read  %d requests, %d sectors\n", st.reads, st.read_sectors);
+        rt_kprintf("  write %d requests, %d sectors\n", st.writes, st.write_sectors);
+        rt_kprintf("  transfers %d, merges %d, expired %d, errors %d\n",
+                   st.transfers, st.merges, st.expired, st.errors);
+        rt_kprintf("  depth %d, max %d\n", st.depth, st.max_depth);
+        rt_kprintf("  latency(ticks)");
+        for (i = 0; i < RT_BLK_LATENCY_SLOTS - 1; i ++)
+            rt_kprintf(" <%d:%d", 1 << i, st.latency[i]);
+        rt_kprintf(" more:%d\n", st.latency[i]);
+
+        rt_enter_critical();
+        node = node->next;
+        rt_exit_critical();
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(blk_stat, show statistics of block request queues);
+#endif
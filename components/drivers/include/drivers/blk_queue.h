@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ */
+
+#ifndef __BLK_QUEUE_H__
+#define __BLK_QUEUE_H__
+
+#include <rtthread.h>
+#include "device.h"
+#include "ipc/completion.h"
+
+#ifndef RT_BLK_MAX_SECTORS
+#define RT_BLK_MAX_SECTORS          64      /* sectors of the requests merged into one transfer */
+#endif
+#ifndef RT_BLK_READ_DEADLINE_MS
+#define RT_BLK_READ_DEADLINE_MS     50      /* a read waits no longer than this for the elevator */
+#endif
+#ifndef RT_BLK_WRITE_DEADLINE_MS
+#define RT_BLK_WRITE_DEADLINE_MS    500
+#endif
+#ifndef RT_BLK_THREAD_STACK
+#define RT_BLK_THREAD_STACK         1024
+#endif
+#ifndef RT_BLK_THREAD_PRIORITY
+#define RT_BLK_THREAD_PRIORITY      (RT_THREAD_PRIORITY_MAX / 3)
+#endif
+
+#define RT_BLK_LATENCY_SLOTS        12      /* slot i counts the latency below 2^i ticks */
+
+#define RT_BLK_READ                 0
+#define RT_BLK_WRITE                1
+
+struct rt_blk_request
+{
+    rt_uint8_t op;                          /* RT_BLK_READ or RT_BLK_WRITE */
+    rt_off_t sector;
+    rt_size_t count;                        /* sectors */
+    void *buffer;
+
+    /*
+     * called by the queue thread when it's done, or the completion is done
+     * if it's RT_NULL. The result is the sectors transferred, or a negative
+     * error.
+     */
+    void (*done)(struct rt_blk_request *req);
+    void *user_data;
+    rt_err_t result;
+    struct rt_completion completion;
+
+    /* private */
+    rt_list_t list;                         /* sorted by sector */
+    rt_list_t fifo;                         /* in the order of submission */
+    rt_tick_t start;
+    rt_tick_t deadline;
+};
+
+struct rt_blk_stats
+{
+    rt_uint32_t reads;                      /* requests */
+    rt_uint32_t writes;
+    rt_uint32_t read_sectors;
+    rt_uint32_t write_sectors;
+    rt_uint32_t transfers;                  /* requests to the device */
+    rt_uint32_t merges;                     /* requests merged to another */
+    rt_uint32_t expired;                    /* requests served for the deadline */
+    rt_uint32_t errors;
+    rt_uint16_t depth;                      /* requests queued and in flight */
+    rt_uint16_t max_depth;
+    rt_uint32_t latency[RT_BLK_LATENCY_SLOTS];
+};
+
+struct rt_blk_queue;
+
+struct rt_blk_queue *rt_blk_queue_create(const char *name, const char *dev_name);
+rt_err_t rt_blk_submit(struct rt_blk_queue *q, struct rt_blk_request *req);
+rt_err_t rt_blk_flush(struct rt_blk_queue *q, rt_int32_t timeout);
+void rt_blk_stats_get(struct rt_blk_queue *q, struct rt_blk_stats *stats);
+
+#endif
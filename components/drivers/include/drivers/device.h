@@ -107,6 +107,11 @@ rt_err_t rt_device_register(rt_device_t dev,
                             const char *name,
                             rt_uint16_t flags);
 rt_device_t rt_device_find(const char *name)	;						
+rt_err_t rt_device_open(rt_device_t dev, rt_uint16_t oflag);
+rt_err_t rt_device_close(rt_device_t dev);
+rt_size_t rt_device_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size);
+rt_size_t rt_device_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size);
+rt_err_t rt_device_control(rt_device_t dev, int cmd, void *arg);
 
 
 #endif
@@ -5,6 +5,7 @@
 #include "device.h"
 
 #define MTD_NANDFLASH    1
+#define MTD_NORFLASH     2
 
 
 #define MTD_FAIL_ADDR_UNKNOWN    -1
@@ -29,6 +30,8 @@ struct mtd_info
     uint8_t type;
 
 	uint32_t size;
+    uint32_t erasesize;     /* bytes of an erase block */
+    uint32_t writesize;     /* bytes of a page, 1 for nor */
 
 	const struct mtd_ops *ops;
 
@@ -60,10 +63,10 @@ struct erase_info
 struct mtd_oob_ops 
 {
 	uint8_t	    mode;
-	uint8_t		ooblen;
-	uint8_t		oobretlen;
 	uint8_t	    ooboffs;
 
+	size_t		ooblen;         /* of all pages, for the pages of datbuf */
+	size_t		oobretlen;
 	size_t		len;
 	size_t		retlen;
 	uint8_t		*datbuf;
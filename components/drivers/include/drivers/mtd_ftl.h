@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ */
+
+#ifndef __MTD_FTL_H__
+#define __MTD_FTL_H__
+
+#include "mtd.h"
+
+#ifndef MTD_FTL_MAP_CACHE
+#define MTD_FTL_MAP_CACHE       4       /* map pages cached in RAM */
+#endif
+#ifndef MTD_FTL_OP_PERCENT
+#define MTD_FTL_OP_PERCENT      5       /* blocks kept for bad blocks and garbage collection */
+#endif
+#ifndef MTD_FTL_RESERVED_BLOCKS
+#define MTD_FTL_RESERVED_BLOCKS 4       /* free blocks kept for garbage collection */
+#endif
+#ifndef MTD_FTL_WL_THRESHOLD
+#define MTD_FTL_WL_THRESHOLD    256     /* difference of erase counts to move cold data */
+#endif
+#ifndef MTD_FTL_CKPT_INTERVAL
+#define MTD_FTL_CKPT_INTERVAL   16      /* blocks written between checkpoints */
+#endif
+
+int rt_mtd_ftl_format(const char *mtd_name);
+int rt_mtd_ftl_init(const char *name, const char *mtd_name);
+
+#endif
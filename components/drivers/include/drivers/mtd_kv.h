@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ */
+
+#ifndef __MTD_KV_H__
+#define __MTD_KV_H__
+
+#include "mtd.h"
+
+#ifndef MTD_KV_MAX_KEYS
+#define MTD_KV_MAX_KEYS         64      /* keys in the index */
+#endif
+#ifndef MTD_KV_KEY_MAX
+#define MTD_KV_KEY_MAX          32      /* bytes of a key */
+#endif
+#ifndef MTD_KV_VALUE_MAX
+#define MTD_KV_VALUE_MAX        256     /* bytes of a value */
+#endif
+#ifndef MTD_KV_CKPT_RECORDS
+#define MTD_KV_CKPT_RECORDS     128     /* records written between checkpoints */
+#endif
+#ifndef MTD_KV_GC_BLOCKS
+#define MTD_KV_GC_BLOCKS        2       /* free blocks kept by the compaction thread */
+#endif
+#ifndef MTD_KV_WL_THRESHOLD
+#define MTD_KV_WL_THRESHOLD     64      /* difference of erase counts to move cold records */
+#endif
+#ifndef MTD_KV_FLUSH_MS
+#define MTD_KV_FLUSH_MS         1000    /* records buffered for a nand page at most */
+#endif
+#ifndef MTD_KV_THREAD_STACK
+#define MTD_KV_THREAD_STACK     1024
+#endif
+#ifndef MTD_KV_THREAD_PRIORITY
+#define MTD_KV_THREAD_PRIORITY  (RT_THREAD_PRIORITY_MAX - 2)
+#endif
+
+struct mtd_kv;
+
+struct mtd_kv *kv_mount(const char *mtd_name);
+int kv_get(struct mtd_kv *kv, const char *key, void *value, size_t size);
+int kv_set(struct mtd_kv *kv, const char *key, const void *value, size_t len);
+int kv_del(struct mtd_kv *kv, const char *key);
+int kv_sync(struct mtd_kv *kv);
+int kv_foreach(struct mtd_kv *kv, int (*func)(struct mtd_kv *kv, const char *key, size_t len, void *arg),
+               void *arg);
+
+#endif
@@ -10,6 +10,20 @@
 #define NAND_STATUS_READY   0x40
 #define NAND_STATUS_WP          0x80
 
+/* the options of chip */
+#define NAND_BBT_USE_FLASH  0x01    /* keep the bad block table in flash */
+
+/*
+ * The bad blocks are scanned at init into a table in RAM. With
+ * NAND_BBT_USE_FLASH, the table is kept in the last blocks of device,
+ * which are reserved and reported as bad. The main and mirror tables are
+ * found by the pattern and version in the free oob of first page, which
+ * needs 8 bytes of free oob.
+ */
+#ifndef NAND_BBT_BLOCKS
+#define NAND_BBT_BLOCKS     4
+#endif
+
 typedef enum
 {
     NAND_PAGE_RD,
@@ -18,12 +32,14 @@ typedef enum
     NAND_ECC_READ,
     NAND_ECC_WRITE,
     NAND_BLK_ERASE,
+    NAND_BLK_ERASE_MP,          /* queue a block of multi-plane erase, started by NAND_BLK_ERASE */
 } nand_cmd_t;
 
 typedef enum 
 {
     NAND_ECC_NONE,
     NAND_ECC_HW,
+    NAND_ECC_SOFT_BCH,
 } nand_eccmode_t;
 
 /**
@@ -55,6 +71,7 @@ struct nand_ecc
     uint8_t mode;
     uint8_t bytes;                /* bytes per ecc step */
     uint16_t stepsize;
+    uint8_t strength;             /* bits corrected per ecc step, for BCH */
 
     /* driver must set the two interface if HWECC */
     int (*calculate)(struct nand_chip *chip, const uint8_t *dat, uint8_t *ecc_code);
@@ -64,6 +81,7 @@ struct nand_ecc
     int (*read_page)(struct nand_chip *chip, uint8_t *buf, int oob_required, int page);
     int (*write_page)(struct nand_chip *chip, const uint8_t *buf, int oob_required, int page);
 	const struct nand_oob_region *layout;
+    void *priv;
 };
 
 struct nand_chip
@@ -80,8 +98,17 @@ struct nand_chip
     struct nand_buffers buffers;
     uint8_t *oob_poi;
     const struct nand_oob_region *freelayout;
+    struct nand_oob_region oob_layout[3];  /* free, end and ecc, for soft ecc */
     uint32_t size;
     uint8_t nchip;
+    uint32_t options;               /* NAND_BBT_USE_FLASH */
+
+    uint32_t blocks;                /* number of blocks in all chips */
+    uint8_t *bbt;                   /* bad block bitmap, 1 for bad */
+    uint32_t bbt_version;
+    int bbt_block[2];               /* the block of main and mirror table, -1 for none */
+
+    uint8_t planes;                 /* blocks erased together, 0 or 1 for single plane */
 };
 typedef struct nand_chip rt_nand_t;
 
@@ -90,8 +117,47 @@ struct nand_ops
     int (*cmdfunc)(rt_nand_t *nand, int cmd, int page, int offset);
     int (*read_buf)(rt_nand_t *nand, uint8_t *buf, int len);
     int (*write_buf)(rt_nand_t *nand, const  uint8_t *buf, int len);
+
+    /*
+     * Optional, cache read and cache program of sequential pages.
+     * read_page_cached gets the page ready for read_buf like NAND_PAGE_RD,
+     * and starts loading the next page (-1 for none) into cache register,
+     * the page is loaded first if it's not the next one of last call.
+     * write_page_cached is called instead of NAND_PAGE_WR1, it returns when
+     * the page is moved to cache register, and the last one returns when
+     * all pages are programmed. NAND_STATUS_FAIL_N1 is for previous page.
+     */
+    int (*read_page_cached)(rt_nand_t *nand, int page, int next);
+    int (*write_page_cached)(rt_nand_t *nand, int page, int last);
 };
 
 int rt_mtd_nand_init(rt_nand_t *nand, int blks_pc, int nchip);
 
+/* software BCH ecc engine */
+struct nand_bch
+{
+    uint8_t m;                      /* the field is GF(2^m) */
+    uint8_t t;                      /* bits corrected per step */
+    uint16_t n;                     /* 2^m - 1 */
+    uint16_t len;                   /* bytes of data per step */
+    uint16_t ecc_bits;
+    uint8_t ecc_bytes;
+    uint8_t ecc_words;
+
+    uint16_t *a_pow;                /* a_pow[i] is alpha^i */
+    uint16_t *a_log;                /* a_log[alpha^i] is i */
+    uint32_t *mod8_tab;             /* the remainder of every byte */
+    uint8_t *ecc_mask;              /* the ecc of an erased step is all 0xff */
+
+    uint32_t *ecc_buf;
+    uint16_t *syn;
+    uint16_t *elp;
+};
+
+struct nand_bch *nand_bch_init(int stepsize, int t);
+void nand_bch_free(struct nand_bch *bch);
+void nand_bch_calculate(struct nand_bch *bch, const uint8_t *dat, uint8_t *ecc);
+int nand_bch_correct(struct nand_bch *bch, uint8_t *dat,
+                     const uint8_t *read_ecc, const uint8_t *calc_ecc);
+
 #endif
@@ -45,6 +45,11 @@ rt_err_t rt_data_queue_pop(struct rt_data_queue *queue,
                            const void          **data_ptr,
                            rt_size_t            *size,
                            rt_int32_t            timeout);
+rt_err_t rt_data_queue_pop_batch(struct rt_data_queue *queue,
+                                 const void          **data_ptr,
+                                 rt_size_t            *size,
+                                 rt_size_t            *count,
+                                 rt_int32_t            timeout);
 rt_err_t rt_data_queue_peak(struct rt_data_queue *queue,
                             const void          **data_ptr,
                             rt_size_t            *size);
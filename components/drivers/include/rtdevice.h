@@ -48,10 +48,26 @@ extern "C" {
 #include "drivers/spi.h"
 #endif /* RT_USING_SPI */
 
+#ifdef RT_USING_MTD_NOR
+#include "drivers/mtd.h"
+#endif /* RT_USING_MTD_NOR */
+
 #ifdef RT_USING_MTD_NAND
 #include "drivers/nand.h"
 #endif /* RT_USING_MTD_NAND */
 
+#ifdef RT_USING_MTD_FTL
+#include "drivers/mtd_ftl.h"
+#endif /* RT_USING_MTD_FTL */
+
+#ifdef RT_USING_MTD_KV
+#include "drivers/mtd_kv.h"
+#endif /* RT_USING_MTD_KV */
+
+#ifdef RT_USING_BLK_QUEUE
+#include "drivers/blk_queue.h"
+#endif /* RT_USING_BLK_QUEUE */
+
 #ifdef RT_USING_USB_DEVICE
 #include "drivers/usb_device.h"
 #endif /* RT_USING_USB_DEVICE */
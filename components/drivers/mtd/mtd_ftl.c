@@ -0,0 +1,1550 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ */
+
+/*
+ * Flash translation layer, a block device of 512 bytes sectors on a nand
+ * mtd device, for the file systems of disk such as elm FAT.
+ *
+ * - The sectors are mapped by page. Every page is written to the current
+ *   block of log, with a tag in the free oob: the type, the logical page,
+ *   the sequence number of write and the erase count of block.
+ * - The mapping table is kept in map pages, which are written to the log
+ *   too. A few map pages are cached in RAM, and the directory of them is
+ *   kept in RAM.
+ * - A write of part of a page is merged in the page buffer, and written to
+ *   a new page when another page is written or on sync. No block is erased
+ *   for it.
+ * - The block with fewest valid pages is collected when the free blocks are
+ *   few. The free block with lowest erase count is taken for the log, and
+ *   the block with lowest erase count is collected when the counts differ
+ *   too much, to move the cold data out of it.
+ * - A checkpoint with the directory and the erase counts is written to one
+ *   of two checkpoint blocks every MTD_FTL_CKPT_INTERVAL blocks. On mount,
+ *   the pages written after it are found by the sequence number and
+ *   replayed, so a write is safe once it's done.
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+
+#define FTL_SECTOR_SIZE     512
+#define FTL_NONE            0xFFFFFFFF
+
+#define FTL_TAG_DATA        0x01
+#define FTL_TAG_MAP         0x02
+#define FTL_TAG_CKPT        0x03
+
+/* the result of reading a tag */
+#define FTL_PAGE_GOOD       0
+#define FTL_PAGE_ERASED     1
+#define FTL_PAGE_BROKEN     2
+
+#define FTL_BLK_FREE        0
+#define FTL_BLK_LOG         1
+#define FTL_BLK_CKPT        2
+#define FTL_BLK_BAD         3
+
+#define FTL_BLK_ERASED      0x01    /* erased since mount */
+#define FTL_BLK_RETIRE      0x02    /* a program failed, marked bad when collected */
+
+#define FTL_CKPT_MAGIC      0x4C544631
+#define FTL_WL_INTERVAL     32      /* erases between the checks of wear leveling */
+
+#define min(a, b)           ((a) < (b) ? (a) : (b))
+
+struct ftl_tag
+{
+    uint32_t seq;
+    uint32_t lpn;                   /* logical page, map page or page of checkpoint */
+    uint32_t ec;                    /* erase count of the block */
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t crc;
+};
+
+struct ftl_ckpt_header
+{
+    uint32_t magic;
+    uint32_t size;                  /* bytes of checkpoint */
+    uint32_t seq;                   /* the pages written later are replayed */
+    uint32_t blocks;
+    uint32_t lpages;
+    uint32_t active;                /* the block of log */
+    uint32_t crc;                   /* of the checkpoint with crc as 0 */
+    uint32_t reserved;
+    /* followed by the directory of map pages and the erase counts */
+};
+#define FTL_CKPT_HDR_WORDS  (sizeof(struct ftl_ckpt_header) / 4)
+
+struct ftl_block
+{
+    uint32_t ec;
+    uint16_t valid;                 /* pages */
+    uint8_t state;
+    uint8_t flags;
+};
+
+struct ftl_map_cache
+{
+    uint32_t index;                 /* FTL_NONE for empty */
+    uint32_t stamp;
+    uint32_t dirty;
+    uint32_t *map;
+};
+
+struct mtd_ftl
+{
+    struct rt_device parent;
+    rt_mtd_t *mtd;
+    struct rt_mutex lock;
+
+    uint32_t page_size;
+    uint32_t pages_pb;
+    uint32_t blocks;
+    uint32_t sectors_pp;
+    uint32_t sectors;
+    uint32_t lpages;
+    uint32_t entries_pp;            /* entries of a map page */
+    uint32_t map_pages;
+    uint32_t ckpt_pages;
+
+    struct ftl_block *blk;
+    uint32_t *dir;                  /* the page of every map page */
+    struct ftl_map_cache cache[MTD_FTL_MAP_CACHE];
+    uint32_t stamp;
+
+    uint32_t seq;
+    uint32_t nr_free;
+    int active;                     /* block of log, -1 for none */
+    uint32_t active_page;
+
+    int ckpt_blk[2];
+    int ckpt_cur;
+    uint32_t ckpt_page;             /* next page in current checkpoint block */
+    uint32_t blocks_since_ckpt;
+    uint32_t erases_since_wl;
+    uint8_t ckpt_due;
+    uint8_t trimmed;                /* unmapped since last checkpoint */
+
+    uint32_t *gc_lpn;               /* the data pages of the block being collected */
+
+    uint32_t buf_lpn;               /* the page in buffer, FTL_NONE for none */
+    uint32_t buf_dirty;
+    uint8_t *buf;
+    uint8_t *tmp;
+};
+
+#define BLK(c, ppn)     ((ppn) / (c)->pages_pb)
+#define PPN(c, b, p)    ((uint32_t)(b) * (c)->pages_pb + (p))
+#define OFS(c, ppn)     ((loff_t)(ppn) * (c)->page_size)
+
+static uint32_t ftl_crc32(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    int i;
+
+    crc = ~crc;
+    while (len --)
+    {
+        crc ^= *buf ++;
+        for (i = 0; i < 8; i ++)
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+
+    return ~crc;
+}
+
+static void ftl_make_tag(struct mtd_ftl *c, struct ftl_tag *tag, uint8_t type,
+                         uint32_t lpn, uint32_t seq, int block)
+{
+    tag->seq = seq;
+    tag->lpn = lpn;
+    tag->ec = c->blk[block].ec;
+    tag->type = type;
+    tag->reserved = 0xFF;
+    tag->crc = (uint16_t)ftl_crc32(0, (const uint8_t *)tag, offsetof(struct ftl_tag, crc));
+}
+
+static int ftl_check_tag(const struct ftl_tag *tag)
+{
+    const uint8_t *p = (const uint8_t *)tag;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(struct ftl_tag); i ++)
+    {
+        if (p[i] != 0xFF)
+            break;
+    }
+    if (i == sizeof(struct ftl_tag))
+        return FTL_PAGE_ERASED;
+
+    if (tag->crc != (uint16_t)ftl_crc32(0, p, offsetof(struct ftl_tag, crc)))
+        return FTL_PAGE_BROKEN;
+
+    return FTL_PAGE_GOOD;
+}
+
+static int ftl_read_tag(struct mtd_ftl *c, uint32_t ppn, struct ftl_tag *tag)
+{
+    struct mtd_oob_ops ops;
+    int ret;
+
+    rt_memset(&ops, 0, sizeof(ops));
+    ops.mode = MTD_OPS_AUTO_OOB;
+    ops.ooblen = sizeof(struct ftl_tag);
+    ops.oobbuf = (uint8_t *)tag;
+
+    ret = mtd_read_oob(c->mtd, OFS(c, ppn), &ops);
+    if (ret < 0)
+        return ret;
+
+    return ftl_check_tag(tag);
+}
+
+/* read a page with the tag, -EIO if the data can't be corrected */
+static int ftl_read_page(struct mtd_ftl *c, uint32_t ppn, uint8_t *buf, struct ftl_tag *tag)
+{
+    struct mtd_oob_ops ops;
+    int ret;
+
+    rt_memset(&ops, 0, sizeof(ops));
+    ops.mode = MTD_OPS_AUTO_OOB;
+    ops.len = c->page_size;
+    ops.datbuf = buf;
+    ops.ooblen = sizeof(struct ftl_tag);
+    ops.oobbuf = (uint8_t *)tag;
+
+    ret = mtd_read_oob(c->mtd, OFS(c, ppn), &ops);
+    if (ret == -EBADMSG)
+        return -EIO;
+    if (ret < 0)
+        return ret;
+
+    return ftl_check_tag(tag);
+}
+
+static int ftl_prog_page(struct mtd_ftl *c, uint32_t ppn, const uint8_t *buf, struct ftl_tag *tag)
+{
+    struct mtd_oob_ops ops;
+
+    rt_memset(&ops, 0, sizeof(ops));
+    ops.mode = MTD_OPS_AUTO_OOB;
+    ops.len = c->page_size;
+    ops.datbuf = (uint8_t *)buf;
+    ops.ooblen = sizeof(struct ftl_tag);
+    ops.oobbuf = (uint8_t *)tag;
+
+    return mtd_write_oob(c->mtd, OFS(c, ppn), &ops);
+}
+
+static int ftl_erase_block(struct mtd_ftl *c, int block)
+{
+    struct erase_info instr;
+
+    instr.addr = block * c->mtd->erasesize;
+    instr.len = c->mtd->erasesize;
+    if (mtd_erase(c->mtd, &instr) != 0)
+    {
+        /* instr.addr has the offset of partition added by mtd_erase */
+        mtd_block_markbad(c->mtd, (loff_t)block * c->mtd->erasesize);
+        c->blk[block].state = FTL_BLK_BAD;
+        c->blk[block].flags = 0;
+        return -EIO;
+    }
+
+    c->blk[block].ec ++;
+    c->blk[block].valid = 0;
+    c->blk[block].flags = FTL_BLK_ERASED;
+
+    return 0;
+}
+
+/*
+ * Take the free block with lowest erase count for log, for dynamic wear
+ * leveling. The checkpoints are erased seldom, they rest the most worn one.
+ */
+static int ftl_take_free(struct mtd_ftl *c, uint8_t state)
+{
+    int b, best;
+
+    while (1)
+    {
+        best = -1;
+        for (b = 0; b < (int)c->blocks; b ++)
+        {
+            if (c->blk[b].state == FTL_BLK_FREE &&
+                (best < 0 || (state == FTL_BLK_CKPT ? c->blk[b].ec > c->blk[best].ec :
+                                                      c->blk[b].ec < c->blk[best].ec)))
+                best = b;
+        }
+        if (best < 0)
+            return -ENOSPC;
+
+        c->nr_free --;
+        /* the free blocks found on mount may be erased partly */
+        if (!(c->blk[best].flags & FTL_BLK_ERASED) && ftl_erase_block(c, best) != 0)
+            continue;
+
+        c->blk[best].state = state;
+        c->blk[best].flags = 0;
+        c->blk[best].valid = 0;
+
+        return best;
+    }
+}
+
+static int ftl_next_page(struct mtd_ftl *c, uint32_t *ppn)
+{
+    int b;
+
+    if (c->active < 0 || c->active_page == c->pages_pb)
+    {
+        b = ftl_take_free(c, FTL_BLK_LOG);
+        if (b < 0)
+            return b;
+
+        c->active = b;
+        c->active_page = 0;
+        if (++ c->blocks_since_ckpt >= MTD_FTL_CKPT_INTERVAL)
+            c->ckpt_due = 1;
+    }
+    *ppn = PPN(c, c->active, c->active_page ++);
+
+    return 0;
+}
+
+/* write a page to the log, it's counted as valid in the block */
+static int ftl_write_page(struct mtd_ftl *c, const uint8_t *buf, uint8_t type,
+                          uint32_t lpn, uint32_t *ppn)
+{
+    struct ftl_tag tag;
+    int ret;
+
+    while (1)
+    {
+        ret = ftl_next_page(c, ppn);
+        if (ret)
+            return ret;
+
+        ftl_make_tag(c, &tag, type, lpn, ++ c->seq, c->active);
+        if (ftl_prog_page(c, *ppn, buf, &tag) == 0)
+            break;
+
+        /* write it to another block, this one is retired when collected */
+        c->blk[c->active].flags |= FTL_BLK_RETIRE;
+        c->active = -1;
+    }
+    c->blk[BLK(c, *ppn)].valid ++;
+
+    return 0;
+}
+
+static void ftl_invalidate(struct mtd_ftl *c, uint32_t ppn)
+{
+    if (ppn != FTL_NONE && c->blk[BLK(c, ppn)].valid)
+        c->blk[BLK(c, ppn)].valid --;
+}
+
+static int ftl_map_write(struct mtd_ftl *c, uint32_t index, const uint8_t *buf)
+{
+    uint32_t ppn;
+    int ret;
+
+    ret = ftl_write_page(c, buf, FTL_TAG_MAP, index, &ppn);
+    if (ret)
+        return ret;
+
+    ftl_invalidate(c, c->dir[index]);
+    c->dir[index] = ppn;
+
+    return 0;
+}
+
+static int ftl_map_flush(struct mtd_ftl *c, struct ftl_map_cache *m)
+{
+    int ret;
+
+    ret = ftl_map_write(c, m->index, (const uint8_t *)m->map);
+    if (ret == 0)
+        m->dirty = 0;
+
+    return ret;
+}
+
+/* get a map page in cache, the least recently used one is replaced */
+static int ftl_map_load(struct mtd_ftl *c, uint32_t index, struct ftl_map_cache **cache)
+{
+    struct ftl_map_cache *m, *victim = RT_NULL;
+    struct ftl_tag tag;
+    int i, ret;
+
+    for (i = 0; i < MTD_FTL_MAP_CACHE; i ++)
+    {
+        m = &c->cache[i];
+        if (m->index == index)
+            goto out;
+
+        if (victim == RT_NULL || (victim->index != FTL_NONE &&
+            (m->index == FTL_NONE || m->stamp < victim->stamp)))
+            victim = m;
+    }
+
+    m = victim;
+    if (m->index != FTL_NONE && m->dirty)
+    {
+        ret = ftl_map_flush(c, m);
+        if (ret)
+            return ret;
+    }
+    m->index = FTL_NONE;
+
+    if (c->dir[index] == FTL_NONE)
+    {
+        rt_memset(m->map, 0xFF, c->page_size);
+    }
+    else
+    {
+        ret = ftl_read_page(c, c->dir[index], (uint8_t *)m->map, &tag);
+        if (ret < 0)
+            return ret;
+        if (ret != FTL_PAGE_GOOD || tag.type != FTL_TAG_MAP || tag.lpn != index)
+            return -EIO;
+    }
+    m->index = index;
+    m->dirty = 0;
+
+out:
+    m->stamp = ++ c->stamp;
+    *cache = m;
+
+    return 0;
+}
+
+/* move a map page out of the block being collected, the cached one is newer */
+static int ftl_map_move(struct mtd_ftl *c, uint32_t index, const uint8_t *buf)
+{
+    int i;
+
+    for (i = 0; i < MTD_FTL_MAP_CACHE; i ++)
+    {
+        if (c->cache[i].index == index)
+            return ftl_map_flush(c, &c->cache[i]);
+    }
+
+    return ftl_map_write(c, index, buf);
+}
+
+static int ftl_map_get(struct mtd_ftl *c, uint32_t lpn, uint32_t *ppn)
+{
+    struct ftl_map_cache *m;
+    int ret;
+
+    ret = ftl_map_load(c, lpn / c->entries_pp, &m);
+    if (ret)
+        return ret;
+
+    *ppn = m->map[lpn % c->entries_pp];
+
+    return 0;
+}
+
+/* map the logical page to a page, the old page is invalid */
+static int ftl_map_set(struct mtd_ftl *c, uint32_t lpn, uint32_t ppn)
+{
+    struct ftl_map_cache *m;
+    uint32_t old;
+    int ret;
+
+    ret = ftl_map_load(c, lpn / c->entries_pp, &m);
+    if (ret)
+        return ret;
+
+    old = m->map[lpn % c->entries_pp];
+    m->map[lpn % c->entries_pp] = ppn;
+    m->dirty = 1;
+    ftl_invalidate(c, old);
+
+    return 0;
+}
+
+/* the word of checkpoint: the header, the directory and the erase counts */
+static void ftl_ckpt_fill(struct mtd_ftl *c, const struct ftl_ckpt_header *h,
+                          uint32_t page, uint32_t *buf)
+{
+    uint32_t i, w, n = c->page_size / 4;
+
+    for (i = 0; i < n; i ++)
+    {
+        w = page * n + i;
+        if (w < FTL_CKPT_HDR_WORDS)
+            buf[i] = ((const uint32_t *)h)[w];
+        else if ((w -= FTL_CKPT_HDR_WORDS) < c->map_pages)
+            buf[i] = c->dir[w];
+        else if ((w -= c->map_pages) < c->blocks)
+            buf[i] = c->blk[w].ec;
+        else
+            buf[i] = 0xFFFFFFFF;
+    }
+}
+
+/* continue the checkpoints in another block, the one of older checkpoints is freed */
+static int ftl_ckpt_switch(struct mtd_ftl *c)
+{
+    int next = !c->ckpt_cur;
+    int b = c->ckpt_blk[next];
+
+    if (b >= 0 && ftl_erase_block(c, b) == 0)
+    {
+        c->blk[b].state = FTL_BLK_FREE;
+        c->nr_free ++;
+    }
+
+    b = ftl_take_free(c, FTL_BLK_CKPT);
+    if (b < 0)
+        return b;
+
+    c->ckpt_blk[next] = b;
+    c->ckpt_cur = next;
+    c->ckpt_page = 0;
+
+    return 0;
+}
+
+static int ftl_checkpoint(struct mtd_ftl *c)
+{
+    struct ftl_ckpt_header h;
+    struct ftl_tag tag;
+    uint32_t k, len, crc;
+    int i, b, ret, retry;
+
+    /* the directory is written with the map pages on flash */
+    for (i = 0; i < MTD_FTL_MAP_CACHE; i ++)
+    {
+        if (c->cache[i].index != FTL_NONE && c->cache[i].dirty)
+        {
+            ret = ftl_map_flush(c, &c->cache[i]);
+            if (ret)
+                return ret;
+        }
+    }
+
+    h.magic = FTL_CKPT_MAGIC;
+    h.size = (FTL_CKPT_HDR_WORDS + c->map_pages + c->blocks) * 4;
+    h.seq = ++ c->seq;
+    h.blocks = c->blocks;
+    h.lpages = c->lpages;
+    h.active = (uint32_t)c->active;
+    h.crc = 0;
+    h.reserved = 0xFFFFFFFF;
+    for (k = 0, crc = 0; k < c->ckpt_pages; k ++)
+    {
+        ftl_ckpt_fill(c, &h, k, (uint32_t *)c->tmp);
+        len = min(c->page_size, h.size - k * c->page_size);
+        crc = ftl_crc32(crc, c->tmp, len);
+    }
+    h.crc = crc;
+
+    ret = -EIO;
+    for (retry = 0; retry < 2 && ret; retry ++)
+    {
+        if (c->ckpt_blk[c->ckpt_cur] < 0 || c->ckpt_page + c->ckpt_pages > c->pages_pb)
+        {
+            ret = ftl_ckpt_switch(c);
+            if (ret)
+                return ret;
+        }
+
+        b = c->ckpt_blk[c->ckpt_cur];
+        for (k = 0; k < c->ckpt_pages; k ++)
+        {
+            ftl_ckpt_fill(c, &h, k, (uint32_t *)c->tmp);
+            ftl_make_tag(c, &tag, FTL_TAG_CKPT, k, h.seq, b);
+            ret = ftl_prog_page(c, PPN(c, b, c->ckpt_page + k), c->tmp, &tag);
+            if (ret)
+                break;
+        }
+
+        /* a failed one is written again in the other block */
+        c->ckpt_page = ret ? c->pages_pb : c->ckpt_page + c->ckpt_pages;
+    }
+    if (ret)
+        return ret;
+
+    c->blocks_since_ckpt = 0;
+    c->ckpt_due = 0;
+    c->trimmed = 0;
+
+    return 0;
+}
+
+static uint32_t ftl_ec_spread(struct mtd_ftl *c)
+{
+    uint32_t b, lo = FTL_NONE, hi = 0;
+
+    for (b = 0; b < c->blocks; b ++)
+    {
+        if (c->blk[b].state == FTL_BLK_BAD)
+            continue;
+        if (c->blk[b].ec > hi)
+            hi = c->blk[b].ec;
+        if (c->blk[b].state == FTL_BLK_LOG && c->blk[b].ec < lo)
+            lo = c->blk[b].ec;
+    }
+
+    return lo == FTL_NONE ? 0 : hi - lo;
+}
+
+/* move the data page if it's still mapped */
+static int ftl_gc_move(struct mtd_ftl *c, uint32_t ppn, uint32_t lpn)
+{
+    struct ftl_tag tag;
+    uint32_t cur, to;
+    int ret;
+
+    ret = ftl_map_get(c, lpn, &cur);
+    if (ret || cur != ppn)
+        return ret;
+
+    ret = ftl_read_page(c, ppn, c->tmp, &tag);
+    if (ret == -EIO)
+    {
+        /* the data is lost, but it's moved to collect the block */
+        rt_kprintf("ftl: uncorrectable page %d\n", ppn);
+        ret = 0;
+    }
+    if (ret < 0)
+        return ret;
+
+    ret = ftl_write_page(c, c->tmp, FTL_TAG_DATA, lpn, &to);
+    if (ret == 0)
+        ret = ftl_map_set(c, lpn, to);
+
+    return ret;
+}
+
+/*
+ * Collect the block with fewest valid pages, or the one with lowest erase
+ * count for static wear leveling. The valid pages are moved to the log.
+ */
+static int ftl_gc(struct mtd_ftl *c, int wear_leveling)
+{
+    struct ftl_tag tag;
+    uint32_t p, q, ppn, index;
+    int b, victim = -1, ret;
+
+    for (b = 0; b < (int)c->blocks; b ++)
+    {
+        if (c->blk[b].state != FTL_BLK_LOG || b == c->active)
+            continue;
+
+        if (victim < 0 ||
+            (wear_leveling ? c->blk[b].ec < c->blk[victim].ec :
+             (c->blk[b].valid < c->blk[victim].valid ||
+              (c->blk[b].valid == c->blk[victim].valid && c->blk[b].ec < c->blk[victim].ec))))
+            victim = b;
+    }
+    if (victim < 0 || (!wear_leveling && c->blk[victim].valid >= c->pages_pb))
+        return -ENOSPC;
+
+    /*
+     * The tags are read first and the data pages are moved by map page, the
+     * map cache would be thrashed by moving them in the order of the block.
+     */
+    rt_memset(c->gc_lpn, 0xFF, c->pages_pb * sizeof(uint32_t));
+    for (p = 0; p < c->pages_pb; p ++)
+    {
+        ppn = PPN(c, victim, p);
+        ret = ftl_read_tag(c, ppn, &tag);
+        if (ret < 0)
+            return ret;
+        if (ret == FTL_PAGE_ERASED)
+            break;
+        if (ret == FTL_PAGE_BROKEN)
+            continue;
+
+        if (tag.type == FTL_TAG_DATA && tag.lpn < c->lpages)
+        {
+            c->gc_lpn[p] = tag.lpn;
+        }
+        else if (tag.type == FTL_TAG_MAP && tag.lpn < c->map_pages && c->dir[tag.lpn] == ppn)
+        {
+            ret = ftl_read_page(c, ppn, c->tmp, &tag);
+            if (ret >= 0)
+                ret = ftl_map_move(c, tag.lpn, c->tmp);
+            if (ret)
+                return ret;
+        }
+    }
+
+    for (p = 0; p < c->pages_pb && c->blk[victim].valid; p ++)
+    {
+        if (c->gc_lpn[p] == FTL_NONE)
+            continue;
+
+        index = c->gc_lpn[p] / c->entries_pp;
+        for (q = p; q < c->pages_pb; q ++)
+        {
+            if (c->gc_lpn[q] == FTL_NONE || c->gc_lpn[q] / c->entries_pp != index)
+                continue;
+
+            ret = ftl_gc_move(c, PPN(c, victim, q), c->gc_lpn[q]);
+            if (ret)
+                return ret;
+            c->gc_lpn[q] = FTL_NONE;
+        }
+    }
+
+    /* the pages unmapped by trim are still mapped in the last checkpoint */
+    if (c->trimmed)
+    {
+        ret = ftl_checkpoint(c);
+        if (ret)
+            return ret;
+    }
+
+    if (c->blk[victim].flags & FTL_BLK_RETIRE)
+    {
+        mtd_block_markbad(c->mtd, OFS(c, PPN(c, victim, 0)));
+        c->blk[victim].state = FTL_BLK_BAD;
+    }
+    else if (ftl_erase_block(c, victim) == 0)
+    {
+        c->blk[victim].state = FTL_BLK_FREE;
+        c->nr_free ++;
+        c->erases_since_wl ++;
+    }
+
+    return 0;
+}
+
+/* keep the free blocks for log before a page is written */
+static int ftl_reserve(struct mtd_ftl *c)
+{
+    int ret;
+
+    while (c->nr_free < MTD_FTL_RESERVED_BLOCKS)
+    {
+        ret = ftl_gc(c, 0);
+        if (ret)
+            return ret;
+    }
+
+    if (c->erases_since_wl >= FTL_WL_INTERVAL)
+    {
+        c->erases_since_wl = 0;
+        if (ftl_ec_spread(c) > MTD_FTL_WL_THRESHOLD)
+            return ftl_gc(c, 1);
+    }
+
+    return 0;
+}
+
+static int ftl_write_lpage(struct mtd_ftl *c, uint32_t lpn, const uint8_t *buf)
+{
+    uint32_t ppn;
+    int ret;
+
+    ret = ftl_reserve(c);
+    if (ret == 0)
+        ret = ftl_write_page(c, buf, FTL_TAG_DATA, lpn, &ppn);
+    if (ret == 0)
+        ret = ftl_map_set(c, lpn, ppn);
+
+    return ret;
+}
+
+static int ftl_read_lpage(struct mtd_ftl *c, uint32_t lpn, uint8_t *buf)
+{
+    struct ftl_tag tag;
+    uint32_t ppn;
+    int ret;
+
+    if (lpn == c->buf_lpn)
+    {
+        rt_memcpy(buf, c->buf, c->page_size);
+        return 0;
+    }
+
+    ret = ftl_map_get(c, lpn, &ppn);
+    if (ret)
+        return ret;
+
+    if (ppn != FTL_NONE)
+    {
+        ret = ftl_read_page(c, ppn, buf, &tag);
+        if (ret < 0)
+            return ret;
+        if (ret == FTL_PAGE_GOOD && tag.type == FTL_TAG_DATA && tag.lpn == lpn)
+            return 0;
+    }
+
+    /* never written or trimmed */
+    rt_memset(buf, 0, c->page_size);
+
+    return 0;
+}
+
+static int ftl_buf_flush(struct mtd_ftl *c)
+{
+    int ret;
+
+    if (c->buf_lpn == FTL_NONE || !c->buf_dirty)
+        return 0;
+
+    ret = ftl_write_lpage(c, c->buf_lpn, c->buf);
+    if (ret == 0)
+        c->buf_dirty = 0;
+
+    return ret;
+}
+
+static int ftl_buf_load(struct mtd_ftl *c, uint32_t lpn)
+{
+    int ret;
+
+    if (c->buf_lpn == lpn)
+        return 0;
+
+    ret = ftl_buf_flush(c);
+    if (ret)
+        return ret;
+
+    c->buf_lpn = FTL_NONE;
+    ret = ftl_read_lpage(c, lpn, c->buf);
+    if (ret)
+        return ret;
+    c->buf_lpn = lpn;
+
+    return 0;
+}
+
+/* unmap the whole pages in the sectors */
+static int ftl_trim(struct mtd_ftl *c, uint32_t begin, uint32_t end)
+{
+    uint32_t lpn, ppn;
+    int ret;
+
+    if (end >= c->sectors)
+        end = c->sectors - 1;
+
+    for (lpn = (begin + c->sectors_pp - 1) / c->sectors_pp;
+         begin <= end && lpn < (end + 1) / c->sectors_pp; lpn ++)
+    {
+        if (lpn == c->buf_lpn)
+            c->buf_lpn = FTL_NONE;
+
+        ret = ftl_map_get(c, lpn, &ppn);
+        if (ret == 0 && ppn != FTL_NONE)
+        {
+            ret = ftl_map_set(c, lpn, FTL_NONE);
+            c->trimmed = 1;
+        }
+        if (ret)
+            return ret;
+    }
+
+    return 0;
+}
+
+/* check the checkpoint at the page, 0 if it's good */
+static int ftl_ckpt_check(struct mtd_ftl *c, uint32_t ppn, struct ftl_ckpt_header *h)
+{
+    struct ftl_tag tag;
+    uint32_t k, len, crc = 0;
+
+    for (k = 0; k < c->ckpt_pages; k ++)
+    {
+        if (ftl_read_page(c, ppn + k, c->tmp, &tag) != FTL_PAGE_GOOD)
+            return -1;
+
+        if (k == 0)
+        {
+            rt_memcpy(h, c->tmp, sizeof(struct ftl_ckpt_header));
+            if (h->magic != FTL_CKPT_MAGIC || h->blocks != c->blocks || h->lpages != c->lpages ||
+                h->size != (FTL_CKPT_HDR_WORDS + c->map_pages + c->blocks) * 4)
+                return -1;
+            ((struct ftl_ckpt_header *)c->tmp)->crc = 0;
+        }
+
+        len = min(c->page_size, h->size - k * c->page_size);
+        crc = ftl_crc32(crc, c->tmp, len);
+    }
+
+    return (crc == h->crc) ? 0 : -1;
+}
+
+/* find the last good checkpoint in a block */
+static void ftl_ckpt_scan(struct mtd_ftl *c, int b, struct ftl_ckpt_header *h, uint32_t *ppn)
+{
+    struct ftl_ckpt_header found;
+    struct ftl_tag tag;
+    uint32_t p, start = FTL_NONE;
+
+    *ppn = FTL_NONE;
+    for (p = 0; p < c->pages_pb; p ++)
+    {
+        if (ftl_read_tag(c, PPN(c, b, p), &tag) != FTL_PAGE_GOOD || tag.type != FTL_TAG_CKPT)
+            break;
+
+        if (tag.lpn == 0)
+            start = p;
+        else if (start == FTL_NONE || tag.lpn != p - start)
+            start = FTL_NONE;
+
+        if (start != FTL_NONE && tag.lpn + 1 == c->ckpt_pages &&
+            ftl_ckpt_check(c, PPN(c, b, start), &found) == 0)
+        {
+            *h = found;
+            *ppn = PPN(c, b, start);
+        }
+    }
+}
+
+static int ftl_ckpt_load(struct mtd_ftl *c, uint32_t ppn)
+{
+    struct ftl_tag tag;
+    uint32_t k, i, w, n = c->page_size / 4;
+    uint32_t *buf = (uint32_t *)c->tmp;
+
+    for (k = 0; k < c->ckpt_pages; k ++)
+    {
+        if (ftl_read_page(c, ppn + k, c->tmp, &tag) != FTL_PAGE_GOOD)
+            return -EIO;
+
+        for (i = 0; i < n; i ++)
+        {
+            w = k * n + i;
+            if (w < FTL_CKPT_HDR_WORDS)
+                continue;
+            else if ((w -= FTL_CKPT_HDR_WORDS) < c->map_pages)
+                c->dir[w] = buf[i];
+            else if ((w -= c->map_pages) < c->blocks && buf[i] > c->blk[w].ec)
+                c->blk[w].ec = buf[i];
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Replay the pages of a block written after the checkpoint. The map pages
+ * are replayed first, then the data pages written after the last version
+ * of their map page.
+ */
+static int ftl_replay_block(struct mtd_ftl *c, int b, uint32_t after, uint32_t *map_seq, int data)
+{
+    struct ftl_tag tag;
+    uint32_t p, ppn;
+    int ret;
+
+    for (p = 0; p < c->pages_pb; p ++)
+    {
+        ppn = PPN(c, b, p);
+        /* the pages behind a torn one are not written */
+        if (ftl_read_tag(c, ppn, &tag) != FTL_PAGE_GOOD)
+            break;
+
+        if (tag.seq > c->seq)
+            c->seq = tag.seq;
+        if (tag.seq <= after)
+            continue;
+
+        if (!data && tag.type == FTL_TAG_MAP && tag.lpn < c->map_pages)
+        {
+            c->dir[tag.lpn] = ppn;
+            map_seq[tag.lpn] = tag.seq;
+        }
+        else if (data && tag.type == FTL_TAG_DATA && tag.lpn < c->lpages &&
+                 tag.seq > map_seq[tag.lpn / c->entries_pp])
+        {
+            ret = ftl_map_set(c, tag.lpn, ppn);
+            if (ret)
+                return ret;
+        }
+    }
+
+    return 0;
+}
+
+static int ftl_count_valid(struct mtd_ftl *c)
+{
+    struct ftl_map_cache *m;
+    uint32_t i, j, ppn;
+    int ret;
+
+    for (i = 0; i < c->blocks; i ++)
+        c->blk[i].valid = 0;
+
+    for (i = 0; i < c->map_pages; i ++)
+    {
+        if (c->dir[i] == FTL_NONE)
+            continue;
+        c->blk[BLK(c, c->dir[i])].valid ++;
+
+        ret = ftl_map_load(c, i, &m);
+        if (ret)
+            return ret;
+        for (j = 0; j < c->entries_pp; j ++)
+        {
+            ppn = m->map[j];
+            if (ppn < c->blocks * c->pages_pb)
+                c->blk[BLK(c, ppn)].valid ++;
+        }
+    }
+
+    return 0;
+}
+
+static int ftl_format(struct mtd_ftl *c)
+{
+    uint32_t b;
+    int i;
+
+    c->nr_free = 0;
+    for (b = 0; b < c->blocks; b ++)
+    {
+        if (c->blk[b].state == FTL_BLK_BAD || ftl_erase_block(c, b) != 0)
+            continue;
+
+        c->blk[b].state = FTL_BLK_FREE;
+        c->nr_free ++;
+    }
+
+    rt_memset(c->dir, 0xFF, c->map_pages * sizeof(uint32_t));
+    for (i = 0; i < MTD_FTL_MAP_CACHE; i ++)
+        c->cache[i].index = FTL_NONE;
+    c->active = -1;
+    c->ckpt_blk[0] = c->ckpt_blk[1] = -1;
+    c->ckpt_cur = 0;
+
+    return ftl_checkpoint(c);
+}
+
+static int ftl_mount(struct mtd_ftl *c)
+{
+    struct ftl_ckpt_header h, last;
+    struct ftl_tag tag;
+    uint32_t *seq0, *order, *map_seq = RT_NULL;
+    uint32_t i, j, n, ppn, last_ppn = FTL_NONE;
+    int b, ret;
+
+    seq0 = rt_malloc(c->blocks * sizeof(uint32_t) * 2);
+    if (seq0 == RT_NULL)
+        return -ENOMEM;
+    order = seq0 + c->blocks;
+
+    /* the state of block by its first page */
+    for (b = 0; b < (int)c->blocks; b ++)
+    {
+        c->blk[b].ec = 0;
+        c->blk[b].valid = 0;
+        c->blk[b].flags = 0;
+        seq0[b] = 0;
+
+        if (mtd_block_isbad(c->mtd, OFS(c, PPN(c, b, 0))))
+        {
+            c->blk[b].state = FTL_BLK_BAD;
+            continue;
+        }
+
+        ret = ftl_read_tag(c, PPN(c, b, 0), &tag);
+        if (ret == FTL_PAGE_ERASED)
+        {
+            c->blk[b].state = FTL_BLK_FREE;
+            continue;
+        }
+
+        c->blk[b].state = FTL_BLK_LOG;
+        if (ret == FTL_PAGE_GOOD)
+        {
+            c->blk[b].ec = tag.ec;
+            seq0[b] = tag.seq;
+            if (tag.type == FTL_TAG_CKPT)
+                c->blk[b].state = FTL_BLK_CKPT;
+        }
+    }
+
+    c->ckpt_blk[0] = c->ckpt_blk[1] = -1;
+    c->ckpt_cur = 0;
+    for (b = 0; b < (int)c->blocks; b ++)
+    {
+        if (c->blk[b].state != FTL_BLK_CKPT)
+            continue;
+
+        ftl_ckpt_scan(c, b, &h, &ppn);
+        if (ppn != FTL_NONE && (last_ppn == FTL_NONE || h.seq > last.seq))
+        {
+            last = h;
+            last_ppn = ppn;
+            c->ckpt_blk[0] = b;
+        }
+    }
+
+    if (last_ppn == FTL_NONE)
+    {
+        rt_kprintf("ftl: no checkpoint on %s\n", c->mtd->parent.parent.name);
+        ret = -ENOENT;
+        goto out;
+    }
+
+    ret = ftl_ckpt_load(c, last_ppn);
+    if (ret)
+        goto out;
+    c->seq = last.seq;
+    /* the pages behind the checkpoint may be torn, the next one is in another block */
+    c->ckpt_page = c->pages_pb;
+
+    /* one more checkpoint block is kept, the others are collected */
+    c->nr_free = 0;
+    for (b = 0; b < (int)c->blocks; b ++)
+    {
+        if (c->blk[b].state == FTL_BLK_CKPT && b != c->ckpt_blk[0])
+        {
+            if (c->ckpt_blk[1] < 0)
+                c->ckpt_blk[1] = b;
+            else
+                c->blk[b].state = FTL_BLK_LOG;
+        }
+        if (c->blk[b].state == FTL_BLK_FREE)
+            c->nr_free ++;
+    }
+
+    /* the blocks written after the checkpoint, in the order of writing */
+    for (b = 0, n = 0; b < (int)c->blocks; b ++)
+    {
+        if (c->blk[b].state != FTL_BLK_LOG ||
+            (seq0[b] <= last.seq && (uint32_t)b != last.active))
+            continue;
+
+        for (i = n ++; i > 0 && seq0[order[i - 1]] > seq0[b]; i --)
+            order[i] = order[i - 1];
+        order[i] = b;
+    }
+
+    if (n)
+    {
+        map_seq = rt_malloc(c->map_pages * sizeof(uint32_t));
+        if (map_seq == RT_NULL)
+        {
+            ret = -ENOMEM;
+            goto out;
+        }
+        rt_memset(map_seq, 0, c->map_pages * sizeof(uint32_t));
+
+        for (j = 0; j < 2 && ret == 0; j ++)
+        {
+            for (i = 0; i < n && ret == 0; i ++)
+                ret = ftl_replay_block(c, order[i], last.seq, map_seq, j);
+        }
+        if (ret == 0)
+            ret = ftl_checkpoint(c);
+        rt_free(map_seq);
+        if (ret)
+            goto out;
+    }
+
+    ret = ftl_count_valid(c);
+
+out:
+    rt_free(seq0);
+
+    return ret;
+}
+
+static rt_size_t mtd_ftl_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    struct mtd_ftl *c = (struct mtd_ftl *)dev;
+    uint8_t *data = buffer;
+    uint32_t lpn, ofs, n;
+    rt_size_t done = 0;
+
+    if ((uint32_t)pos >= c->sectors)
+        return 0;
+    if (size > c->sectors - (uint32_t)pos)
+        size = c->sectors - (uint32_t)pos;
+
+    rt_mutex_take(&c->lock, RT_WAITING_FOREVER);
+    while (done < size)
+    {
+        lpn = (pos + done) / c->sectors_pp;
+        ofs = (pos + done) % c->sectors_pp;
+        n = min(c->sectors_pp - ofs, size - done);
+
+        if (n == c->sectors_pp)
+        {
+            if (ftl_read_lpage(c, lpn, data) != 0)
+                break;
+        }
+        else
+        {
+            if (ftl_read_lpage(c, lpn, c->tmp) != 0)
+                break;
+            rt_memcpy(data, c->tmp + ofs * FTL_SECTOR_SIZE, n * FTL_SECTOR_SIZE);
+        }
+
+        data += n * FTL_SECTOR_SIZE;
+        done += n;
+    }
+    rt_mutex_release(&c->lock);
+
+    return done;
+}
+
+static rt_size_t mtd_ftl_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    struct mtd_ftl *c = (struct mtd_ftl *)dev;
+    const uint8_t *data = buffer;
+    uint32_t lpn, ofs, n;
+    rt_size_t done = 0;
+    int ret;
+
+    if ((uint32_t)pos >= c->sectors)
+        return 0;
+    if (size > c->sectors - (uint32_t)pos)
+        size = c->sectors - (uint32_t)pos;
+
+    rt_mutex_take(&c->lock, RT_WAITING_FOREVER);
+    while (done < size)
+    {
+        lpn = (pos + done) / c->sectors_pp;
+        ofs = (pos + done) % c->sectors_pp;
+        n = min(c->sectors_pp - ofs, size - done);
+
+        if (n == c->sectors_pp)
+        {
+            /* the page in buffer is overwritten */
+            if (c->buf_lpn == lpn)
+                c->buf_lpn = FTL_NONE;
+            ret = ftl_write_lpage(c, lpn, data);
+        }
+        else
+        {
+            ret = ftl_buf_load(c, lpn);
+            if (ret == 0)
+            {
+                rt_memcpy(c->buf + ofs * FTL_SECTOR_SIZE, data, n * FTL_SECTOR_SIZE);
+                c->buf_dirty = 1;
+            }
+        }
+        if (ret)
+            break;
+
+        data += n * FTL_SECTOR_SIZE;
+        done += n;
+    }
+
+    if (c->ckpt_due)
+        ftl_checkpoint(c);
+    rt_mutex_release(&c->lock);
+
+    return done;
+}
+
+static rt_err_t mtd_ftl_control(rt_device_t dev, int cmd, void *args)
+{
+    struct mtd_ftl *c = (struct mtd_ftl *)dev;
+    int ret = 0;
+
+    switch (cmd)
+    {
+    case RT_DEVICE_CTRL_BLK_GETGEOME:
+    {
+        struct rt_device_blk_geometry *geometry = (struct rt_device_blk_geometry *)args;
+
+        if (geometry == RT_NULL)
+            return -RT_ERROR;
+
+        geometry->sector_count = c->sectors;
+        geometry->bytes_per_sector = FTL_SECTOR_SIZE;
+        geometry->block_size = c->page_size;
+    }break;
+
+    case RT_DEVICE_CTRL_BLK_SYNC:
+        /* the pages written are replayed on mount, but not the trims */
+        rt_mutex_take(&c->lock, RT_WAITING_FOREVER);
+        ret = ftl_buf_flush(c);
+        if (ret == 0 && c->trimmed)
+            ret = ftl_checkpoint(c);
+        rt_mutex_release(&c->lock);
+        break;
+
+    case RT_DEVICE_CTRL_BLK_ERASE:
+    {
+        struct rt_device_blk_sectors *sectors = (struct rt_device_blk_sectors *)args;
+
+        if (sectors == RT_NULL)
+            return -RT_ERROR;
+
+        rt_mutex_take(&c->lock, RT_WAITING_FOREVER);
+        ret = ftl_trim(c, sectors->sector_begin, sectors->sector_end);
+        rt_mutex_release(&c->lock);
+    }break;
+
+    default:
+        break;
+    }
+
+    return ret ? -RT_EIO : RT_EOK;
+}
+
+static const struct rt_device_ops _mtd_ftl_ops =
+{
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    mtd_ftl_read,
+    mtd_ftl_write,
+    mtd_ftl_control,
+};
+
+static int ftl_geometry(struct mtd_ftl *c)
+{
+    rt_mtd_t *mtd = c->mtd;
+    uint32_t usable, pages;
+
+    c->page_size = mtd->writesize;
+    c->pages_pb = mtd->erasesize / mtd->writesize;
+    c->blocks = mtd->size / mtd->erasesize;
+    c->sectors_pp = c->page_size / FTL_SECTOR_SIZE;
+    c->entries_pp = c->page_size / sizeof(uint32_t);
+
+    /* two checkpoint blocks and the block of log are not counted */
+    usable = c->blocks * (100 - MTD_FTL_OP_PERCENT) / 100;
+    if (usable <= MTD_FTL_RESERVED_BLOCKS + 3)
+        return -EINVAL;
+    pages = (usable - MTD_FTL_RESERVED_BLOCKS - 3) * c->pages_pb;
+
+    /* the map pages are in the log with the data */
+    c->lpages = (uint32_t)((uint64_t)pages * c->entries_pp / (c->entries_pp + 1));
+    c->map_pages = (c->lpages + c->entries_pp - 1) / c->entries_pp;
+    c->sectors = c->lpages * c->sectors_pp;
+
+    c->ckpt_pages = ((FTL_CKPT_HDR_WORDS + c->map_pages + c->blocks) * 4 + c->page_size - 1) / c->page_size;
+    if (c->ckpt_pages * 2 > c->pages_pb)
+        return -EINVAL;
+
+    return 0;
+}
+
+static void ftl_free(struct mtd_ftl *c)
+{
+    int i;
+
+    for (i = 0; i < MTD_FTL_MAP_CACHE; i ++)
+        rt_free(c->cache[i].map);
+    rt_free(c->gc_lpn);
+    rt_free(c->tmp);
+    rt_free(c->buf);
+    rt_free(c->dir);
+    rt_free(c->blk);
+    rt_free(c);
+}
+
+/* look up the nand mtd device and allocate the ftl on it */
+static int ftl_create(const char *mtd_name, struct mtd_ftl **pc)
+{
+    struct mtd_ftl *c;
+    rt_mtd_t *mtd;
+    int i, ret;
+
+    mtd = mtd_device_get(mtd_name);
+    if (mtd == RT_NULL)
+        return -ENODEV;
+
+    /* the tags are kept in the free oob of nand */
+    if (mtd->type != MTD_NANDFLASH || mtd->writesize % FTL_SECTOR_SIZE ||
+        ((rt_nand_t *)mtd->priv)->freelayout->length < sizeof(struct ftl_tag))
+        return -EINVAL;
+
+    c = rt_malloc(sizeof(struct mtd_ftl));
+    if (c == RT_NULL)
+        return -ENOMEM;
+    rt_memset(c, 0, sizeof(struct mtd_ftl));
+    c->mtd = mtd;
+
+    ret = ftl_geometry(c);
+    if (ret)
+    {
+        rt_free(c);
+        return ret;
+    }
+
+    c->blk = rt_malloc(c->blocks * sizeof(struct ftl_block));
+    c->dir = rt_malloc(c->map_pages * sizeof(uint32_t));
+    c->buf = rt_malloc(c->page_size);
+    c->tmp = rt_malloc(c->page_size);
+    c->gc_lpn = rt_malloc(c->pages_pb * sizeof(uint32_t));
+    ret = (c->blk && c->dir && c->buf && c->tmp && c->gc_lpn) ? 0 : -ENOMEM;
+    for (i = 0; i < MTD_FTL_MAP_CACHE; i ++)
+    {
+        c->cache[i].index = FTL_NONE;
+        c->cache[i].map = rt_malloc(c->page_size);
+        if (c->cache[i].map == RT_NULL)
+            ret = -ENOMEM;
+    }
+    if (ret)
+    {
+        ftl_free(c);
+        return ret;
+    }
+
+    rt_memset(c->dir, 0xFF, c->map_pages * sizeof(uint32_t));
+    c->active = -1;
+    c->buf_lpn = FTL_NONE;
+    *pc = c;
+
+    return 0;
+}
+
+/* whether a block device of ftl is registered on the mtd device */
+static rt_bool_t ftl_in_use(rt_mtd_t *mtd)
+{
+    struct rt_object_information *info;
+    struct rt_list_node *node;
+    rt_device_t dev;
+    rt_bool_t used = RT_FALSE;
+
+    info = rt_object_get_information(RT_Object_Class_Device);
+    rt_enter_critical();
+    for (node = info->object_list.next; node != &info->object_list; node = node->next)
+    {
+        dev = (rt_device_t)rt_list_entry(node, struct rt_object, list);
+        if (dev->dops == &_mtd_ftl_ops && ((struct mtd_ftl *)dev)->mtd == mtd)
+        {
+            used = RT_TRUE;
+            break;
+        }
+    }
+    rt_exit_critical();
+
+    return used;
+}
+
+/**
+ * This function will format a nand mtd device for the ftl, all the data on
+ * it is lost. The bad blocks are skipped.
+ *
+ * @param mtd_name the nand mtd device or partition
+ *
+ * @return 0 on OK, -EBUSY if a block device of ftl is on it, or a negative
+ * errno on failure
+ */
+int rt_mtd_ftl_format(const char *mtd_name)
+{
+    struct mtd_ftl *c;
+    uint32_t b;
+    int ret;
+
+    ret = ftl_create(mtd_name, &c);
+    if (ret)
+        return ret;
+
+    if (ftl_in_use(c->mtd))
+    {
+        ftl_free(c);
+        return -EBUSY;
+    }
+
+    for (b = 0; b < c->blocks; b ++)
+    {
+        rt_memset(&c->blk[b], 0, sizeof(struct ftl_block));
+        c->blk[b].state = mtd_block_isbad(c->mtd, OFS(c, PPN(c, b, 0))) ?
+                          FTL_BLK_BAD : FTL_BLK_FREE;
+    }
+
+    ret = ftl_format(c);
+    ftl_free(c);
+
+    return ret;
+}
+RTM_EXPORT(rt_mtd_ftl_format);
+
+/**
+ * This function will create a block device of 512 bytes sectors on a nand
+ * mtd device. The mtd device must be formatted by rt_mtd_ftl_format first,
+ * it is not mounted if there is no checkpoint on it.
+ *
+ * @param name the block device name
+ * @param mtd_name the nand mtd device or partition
+ *
+ * @return 0 on OK, -ENOENT if the mtd device is not formatted, or a negative
+ * errno on failure
+ */
+int rt_mtd_ftl_init(const char *name, const char *mtd_name)
+{
+    struct mtd_ftl *c;
+    int ret;
+
+    ret = ftl_create(mtd_name, &c);
+    if (ret)
+        return ret;
+
+    ret = ftl_mount(c);
+    if (ret)
+        goto out;
+
+    rt_mutex_init(&c->lock, name, RT_IPC_FLAG_FIFO);
+    c->parent.type = RT_Device_Class_Block;
+    c->parent.dops = &_mtd_ftl_ops;
+    if (rt_device_register(&c->parent, name, RT_DEVICE_FLAG_RDWR) != RT_EOK)
+    {
+        rt_mutex_detach(&c->lock);
+        ret = -EIO;
+        goto out;
+    }
+
+    return 0;
+
+out:
+    ftl_free(c);
+
+    return ret;
+}
+RTM_EXPORT(rt_mtd_ftl_init);
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+static int mtd_ftl(int argc, char **argv)
+{
+    int ret, format = 0;
+
+    if (argc > 1 && rt_strcmp(argv[1], "-f") == 0)
+    {
+        format = 1;
+        argc --;
+        argv ++;
+    }
+
+    if (argc < 3)
+    {
+        rt_kprintf("mtd_ftl [-f] <name> <mtd>, -f formats the mtd first\n");
+        return -1;
+    }
+
+    if (format)
+    {
+        ret = rt_mtd_ftl_format(argv[2]);
+        if (ret)
+        {
+            rt_kprintf("format ftl failed: %d\n", ret);
+            return ret;
+        }
+    }
+
+    ret = rt_mtd_ftl_init(argv[1], argv[2]);
+    if (ret == -ENOENT)
+        rt_kprintf("no ftl on %s, format it by mtd_ftl -f\n", argv[2]);
+    else if (ret)
+        rt_kprintf("create ftl failed: %d\n", ret);
+
+    return ret;
+}
+MSH_CMD_EXPORT(mtd_ftl, create block device on nand mtd);
+#endif
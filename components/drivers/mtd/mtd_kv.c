@@ -0,0 +1,1249 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ */
+
+/*
+ * Log structured key-value store on a mtd partition.
+ *
+ * The records of set and delete are appended to the log in the erase
+ * blocks, each one checked by crc. An index of hashes in RAM points to the
+ * last record of every key. A checkpoint of the index is appended every
+ * MTD_KV_CKPT_RECORDS records, mount loads the last one and replays the
+ * records behind it.
+ *
+ * A thread compacts the blocks with fewest live records: the live records
+ * are appended again and a checkpoint is written before the block is
+ * erased, so the deleted keys don't come back. Nor is programmed by
+ * record, nand by page with the records buffered for MTD_KV_FLUSH_MS.
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+
+#define KV_NONE             0xFFFFFFFF
+#define KV_NIL              0xFFFF
+#define KV_BLK_MAGIC        0x4B564231
+
+#define KV_REC_SET          0x01
+#define KV_REC_DEL          0x02
+#define KV_REC_CKPT         0x03
+
+#define KV_BLK_FREE         0
+#define KV_BLK_USED         1
+#define KV_BLK_BAD          2
+
+#define KV_ALIGN(n)         (((n) + 3) & ~3)
+#define KV_REC_SIZE(k, v)   KV_ALIGN(sizeof(struct kv_rec) + (k) + (v))
+
+#define min(a, b)           ((a) < (b) ? (a) : (b))
+
+struct kv_blk_hdr
+{
+    uint32_t magic;
+    uint32_t seq;                   /* the blocks are replayed in order */
+    uint32_t ec;
+    uint32_t crc;
+};
+
+struct kv_rec
+{
+    uint32_t crc;                   /* of the record behind it */
+    uint8_t type;
+    uint8_t key_len;
+    uint16_t val_len;
+    /* followed by the key and the value, padded to 4 bytes */
+};
+
+struct kv_ckpt
+{
+    uint32_t blocks;
+    uint32_t count;
+    /* followed by the erase counts and the entries */
+};
+
+struct kv_ckpt_entry
+{
+    uint32_t hash;
+    uint32_t addr;
+    uint16_t size;
+    uint8_t key_len;
+    uint8_t reserved;
+};
+
+struct kv_entry
+{
+    uint32_t hash;
+    uint32_t addr;                  /* of the record in the partition */
+    uint16_t size;                  /* of the record, 0 for a free entry */
+    uint8_t key_len;
+    uint8_t reserved;
+    uint16_t next;                  /* in the bucket or the free list */
+};
+
+struct kv_block
+{
+    uint32_t seq;
+    uint32_t ec;
+    uint32_t valid;                 /* bytes of live records */
+    uint8_t state;
+    uint8_t erased;                 /* erased since mount */
+};
+
+struct mtd_kv
+{
+    rt_list_t list;
+    rt_mtd_t *mtd;
+    struct rt_mutex lock;
+    struct rt_event event;          /* wakes the thread */
+
+    uint32_t unit;                  /* bytes of a program */
+    uint32_t blocks;
+    uint32_t payload;               /* bytes of records in a block */
+    uint32_t ckpt_max;              /* bytes of the largest checkpoint */
+    uint32_t capacity;              /* bytes of live records */
+    uint32_t live;
+    struct kv_block *blk;
+
+    struct kv_entry ent[MTD_KV_MAX_KEYS];
+    uint16_t bucket[MTD_KV_MAX_KEYS];
+    uint16_t free_ent;
+    uint16_t count;
+
+    uint32_t seq;
+    uint32_t nr_free;
+    int head;                       /* block of log, -1 for none */
+    uint32_t head_ofs;
+    uint32_t records;               /* since the last checkpoint */
+    uint32_t erases_since_wl;
+    uint8_t in_gc;
+
+    uint8_t *wbuf;                  /* the page being filled, when unit > 1 */
+    uint32_t wbuf_addr;
+    rt_tick_t wbuf_tick;
+    uint8_t *rbuf;                  /* the page read last */
+    uint32_t rbuf_addr;
+    uint8_t *rec;                   /* a record or a checkpoint */
+    uint32_t rec_size;
+};
+
+#define BLK(kv, addr)       ((addr) / (kv)->mtd->erasesize)
+#define ADDR(kv, b, ofs)    ((uint32_t)(b) * (kv)->mtd->erasesize + (ofs))
+
+static rt_list_t _kv_list = RT_LIST_OBJECT_INIT(_kv_list);
+static struct rt_mutex _kv_list_lock;
+
+static uint32_t kv_crc32(uint32_t crc, const void *data, uint32_t len)
+{
+    const uint8_t *buf = data;
+    int i;
+
+    crc = ~crc;
+    while (len --)
+    {
+        crc ^= *buf ++;
+        for (i = 0; i < 8; i ++)
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+
+    return ~crc;
+}
+
+static uint32_t kv_hash(const char *key, uint32_t len)
+{
+    uint32_t hash = 2166136261u;
+
+    while (len --)
+        hash = (hash ^ (uint8_t)*key ++) * 16777619u;
+
+    return hash;
+}
+
+static int kv_read(struct mtd_kv *kv, uint32_t addr, void *buf, uint32_t len)
+{
+    uint8_t *data = buf;
+    uint32_t page, n;
+    size_t retlen;
+
+    if (kv->unit == 1)
+        return (mtd_read(kv->mtd, addr, len, &retlen, data) < 0) ? -EIO : 0;
+
+    /* the page being filled is not on flash yet */
+    for (; len > 0; data += n, addr += n, len -= n)
+    {
+        page = addr - addr % kv->unit;
+        n = min(len, page + kv->unit - addr);
+
+        if (page == kv->wbuf_addr)
+        {
+            rt_memcpy(data, kv->wbuf + addr - page, n);
+            continue;
+        }
+        if (page != kv->rbuf_addr)
+        {
+            kv->rbuf_addr = KV_NONE;
+            if (mtd_read(kv->mtd, page, kv->unit, &retlen, kv->rbuf) < 0)
+                return -EIO;
+            kv->rbuf_addr = page;
+        }
+        rt_memcpy(data, kv->rbuf + addr - page, n);
+    }
+
+    return 0;
+}
+
+static int kv_prog_page(struct mtd_kv *kv)
+{
+    size_t retlen;
+    int ret;
+
+    ret = mtd_write(kv->mtd, kv->wbuf_addr, kv->unit, &retlen, kv->wbuf);
+    if (kv->rbuf_addr == kv->wbuf_addr)
+        kv->rbuf_addr = KV_NONE;
+    kv->wbuf_addr = KV_NONE;
+
+    return ret ? -EIO : 0;
+}
+
+/* write the page being filled, the rest of it can't be programmed again */
+static int kv_flush(struct mtd_kv *kv)
+{
+    if (kv->wbuf_addr == KV_NONE)
+        return 0;
+
+    kv->head_ofs = kv->wbuf_addr % kv->mtd->erasesize + kv->unit;
+
+    return kv_prog_page(kv);
+}
+
+/* append the bytes to the head block, which has room for them */
+static int kv_log_write(struct mtd_kv *kv, const void *buf, uint32_t len)
+{
+    const uint8_t *data = buf;
+    uint32_t addr, page, n;
+    size_t retlen;
+    int ret;
+
+    addr = ADDR(kv, kv->head, kv->head_ofs);
+    kv->head_ofs += len;
+    if (kv->unit == 1)
+        return mtd_write(kv->mtd, addr, len, &retlen, data) ? -EIO : 0;
+
+    for (; len > 0; data += n, addr += n, len -= n)
+    {
+        page = addr - addr % kv->unit;
+        n = min(len, page + kv->unit - addr);
+
+        if (kv->wbuf_addr != page)
+        {
+            rt_memset(kv->wbuf, 0xFF, kv->unit);
+            kv->wbuf_addr = page;
+            kv->wbuf_tick = rt_tick_get();
+            /* to be written in MTD_KV_FLUSH_MS */
+            rt_event_send(&kv->event, 1);
+        }
+        rt_memcpy(kv->wbuf + addr - page, data, n);
+
+        if ((addr + n) % kv->unit == 0)
+        {
+            ret = kv_prog_page(kv);
+            if (ret)
+                return ret;
+        }
+    }
+
+    return 0;
+}
+
+static int kv_erase_block(struct mtd_kv *kv, int b)
+{
+    struct erase_info instr;
+
+    if (kv->rbuf_addr != KV_NONE && BLK(kv, kv->rbuf_addr) == (uint32_t)b)
+        kv->rbuf_addr = KV_NONE;
+
+    instr.addr = ADDR(kv, b, 0);
+    instr.len = kv->mtd->erasesize;
+    if (mtd_erase(kv->mtd, &instr) != 0)
+    {
+        /* instr.addr has the offset of partition added by mtd_erase */
+        mtd_block_markbad(kv->mtd, ADDR(kv, b, 0));
+        kv->blk[b].state = KV_BLK_BAD;
+        return -EIO;
+    }
+
+    kv->blk[b].ec ++;
+    kv->blk[b].erased = 1;
+    kv->erases_since_wl ++;
+
+    return 0;
+}
+
+/* take the free block with lowest erase count, for dynamic wear leveling */
+static int kv_take_free(struct mtd_kv *kv)
+{
+    int b, best;
+
+    while (1)
+    {
+        best = -1;
+        for (b = 0; b < (int)kv->blocks; b ++)
+        {
+            if (kv->blk[b].state == KV_BLK_FREE &&
+                (best < 0 || kv->blk[b].ec < kv->blk[best].ec))
+                best = b;
+        }
+        if (best < 0)
+            return -ENOSPC;
+
+        kv->nr_free --;
+        /* the free blocks found on mount may be erased partly */
+        if (!kv->blk[best].erased && kv_erase_block(kv, best) != 0)
+            continue;
+
+        return best;
+    }
+}
+
+static int kv_open_head(struct mtd_kv *kv)
+{
+    struct kv_blk_hdr hdr;
+    int b, ret;
+
+    ret = kv_flush(kv);
+    if (ret)
+        return ret;
+
+    b = kv_take_free(kv);
+    if (b < 0)
+        return b;
+
+    kv->blk[b].state = KV_BLK_USED;
+    kv->blk[b].seq = ++ kv->seq;
+    kv->blk[b].valid = 0;
+    kv->blk[b].erased = 0;
+    kv->head = b;
+    kv->head_ofs = 0;
+
+    hdr.magic = KV_BLK_MAGIC;
+    hdr.seq = kv->blk[b].seq;
+    hdr.ec = kv->blk[b].ec;
+    hdr.crc = kv_crc32(0, &hdr, sizeof(hdr) - sizeof(uint32_t));
+
+    /* the thread keeps some blocks free */
+    if (kv->nr_free <= MTD_KV_GC_BLOCKS)
+        rt_event_send(&kv->event, 1);
+
+    return kv_log_write(kv, &hdr, sizeof(hdr));
+}
+
+static int kv_gc(struct mtd_kv *kv, uint32_t min_dead);
+
+/* make room for a record in the head block */
+static int kv_reserve(struct mtd_kv *kv, uint32_t size)
+{
+    int ret;
+
+    if (kv->head >= 0 && kv->head_ofs + size <= kv->mtd->erasesize)
+        return 0;
+
+    /* the thread is behind, the last free block is kept for compaction */
+    while (!kv->in_gc && kv->nr_free <= 1)
+    {
+        ret = kv_gc(kv, kv->ckpt_max + 1);
+        if (ret)
+            return ret;
+
+        if (kv->head >= 0 && kv->head_ofs + size <= kv->mtd->erasesize)
+            return 0;
+    }
+
+    return kv_open_head(kv);
+}
+
+static int kv_append(struct mtd_kv *kv, uint8_t type, const char *key, uint8_t key_len,
+                     const void *value, uint16_t val_len, uint32_t *addr)
+{
+    static const uint8_t pad[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+    struct kv_rec rec;
+    uint32_t size = KV_REC_SIZE(key_len, val_len);
+    int ret;
+
+    ret = kv_reserve(kv, size);
+    if (ret)
+        return ret;
+
+    rec.type = type;
+    rec.key_len = key_len;
+    rec.val_len = val_len;
+    rec.crc = kv_crc32(0, &rec.type, sizeof(rec) - sizeof(uint32_t));
+    rec.crc = kv_crc32(rec.crc, key, key_len);
+    rec.crc = kv_crc32(rec.crc, value, val_len);
+
+    *addr = ADDR(kv, kv->head, kv->head_ofs);
+    ret = kv_log_write(kv, &rec, sizeof(rec));
+    if (ret == 0 && key_len)
+        ret = kv_log_write(kv, key, key_len);
+    if (ret == 0 && val_len)
+        ret = kv_log_write(kv, value, val_len);
+    if (ret == 0 && size > sizeof(rec) + key_len + val_len)
+        ret = kv_log_write(kv, pad, size - sizeof(rec) - key_len - val_len);
+    if (ret)
+        return ret;
+
+    kv->records ++;
+
+    return 0;
+}
+
+static int kv_find(struct mtd_kv *kv, const char *key, uint8_t key_len, uint32_t hash)
+{
+    char buf[MTD_KV_KEY_MAX];
+    struct kv_entry *e;
+    int i;
+
+    for (i = kv->bucket[hash % MTD_KV_MAX_KEYS]; i != KV_NIL; i = e->next)
+    {
+        e = &kv->ent[i];
+        if (e->hash != hash || e->key_len != key_len)
+            continue;
+
+        /* the keys are not kept in RAM */
+        if (kv_read(kv, e->addr + sizeof(struct kv_rec), buf, key_len) == 0 &&
+            rt_memcmp(buf, key, key_len) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+/* point the entry to the record, a new entry if it's negative */
+static int kv_index_put(struct mtd_kv *kv, int i, uint32_t hash, uint8_t key_len,
+                        uint32_t addr, uint16_t size)
+{
+    struct kv_entry *e;
+
+    if (i < 0)
+    {
+        if (kv->free_ent == KV_NIL)
+            return -ENOSPC;
+
+        i = kv->free_ent;
+        e = &kv->ent[i];
+        kv->free_ent = e->next;
+        e->hash = hash;
+        e->key_len = key_len;
+        e->next = kv->bucket[hash % MTD_KV_MAX_KEYS];
+        kv->bucket[hash % MTD_KV_MAX_KEYS] = i;
+        kv->count ++;
+    }
+    else
+    {
+        e = &kv->ent[i];
+        kv->blk[BLK(kv, e->addr)].valid -= e->size;
+        kv->live -= e->size;
+    }
+
+    e->addr = addr;
+    e->size = size;
+    kv->blk[BLK(kv, addr)].valid += size;
+    kv->live += size;
+
+    return 0;
+}
+
+static void kv_index_del(struct mtd_kv *kv, int i)
+{
+    struct kv_entry *e = &kv->ent[i];
+    uint16_t *p = &kv->bucket[e->hash % MTD_KV_MAX_KEYS];
+
+    while (*p != i)
+        p = &kv->ent[*p].next;
+    *p = e->next;
+
+    kv->blk[BLK(kv, e->addr)].valid -= e->size;
+    kv->live -= e->size;
+    e->size = 0;
+    e->next = kv->free_ent;
+    kv->free_ent = i;
+    kv->count --;
+}
+
+static int kv_checkpoint(struct mtd_kv *kv)
+{
+    struct kv_ckpt *ckpt = (struct kv_ckpt *)kv->rec;
+    uint32_t *ec = (uint32_t *)(ckpt + 1);
+    struct kv_ckpt_entry *ce = (struct kv_ckpt_entry *)(ec + kv->blocks);
+    uint32_t i, len, addr;
+    int ret;
+
+    len = sizeof(struct kv_ckpt) + kv->blocks * sizeof(uint32_t) + kv->count * sizeof(struct kv_ckpt_entry);
+
+    /* the record buffer is used by compaction */
+    ret = kv_reserve(kv, KV_REC_SIZE(0, len));
+    if (ret)
+        return ret;
+
+    ckpt->blocks = kv->blocks;
+    ckpt->count = kv->count;
+    for (i = 0; i < kv->blocks; i ++)
+        ec[i] = kv->blk[i].ec;
+    for (i = 0; i < MTD_KV_MAX_KEYS; i ++)
+    {
+        if (kv->ent[i].size == 0)
+            continue;
+
+        ce->hash = kv->ent[i].hash;
+        ce->addr = kv->ent[i].addr;
+        ce->size = kv->ent[i].size;
+        ce->key_len = kv->ent[i].key_len;
+        ce->reserved = 0xFF;
+        ce ++;
+    }
+
+    ret = kv_append(kv, KV_REC_CKPT, RT_NULL, 0, kv->rec, (uint16_t)len, &addr);
+    if (ret == 0)
+        kv->records = 0;
+
+    return ret;
+}
+
+/*
+ * The coldest block is moved when the spread of erase counts is over the
+ * threshold, once in every round of erases at most. -1 if it's not due.
+ */
+static int kv_wl_victim(struct mtd_kv *kv)
+{
+    uint32_t b, lo = KV_NONE, hi = 0;
+    int coldest = -1;
+
+    if (kv->erases_since_wl < kv->blocks)
+        return -1;
+
+    for (b = 0; b < kv->blocks; b ++)
+    {
+        if (kv->blk[b].state == KV_BLK_BAD)
+            continue;
+        if (kv->blk[b].ec > hi)
+            hi = kv->blk[b].ec;
+        if (kv->blk[b].state == KV_BLK_USED && (int)b != kv->head && kv->blk[b].ec < lo)
+        {
+            lo = kv->blk[b].ec;
+            coldest = b;
+        }
+    }
+    if (coldest < 0 || hi - lo <= MTD_KV_WL_THRESHOLD ||
+        kv->blk[coldest].valid + kv->ckpt_max > kv->payload)
+        return -1;
+
+    return coldest;
+}
+
+/*
+ * Compact the block with fewest live records, which has min_dead bytes of
+ * garbage at least, or the coldest one for static wear leveling.
+ */
+static int kv_gc(struct mtd_kv *kv, uint32_t min_dead)
+{
+    struct kv_entry *e;
+    uint32_t addr;
+    int b, victim, ret;
+
+    victim = kv_wl_victim(kv);
+    if (victim >= 0)
+    {
+        kv->erases_since_wl = 0;
+    }
+    else
+    {
+        for (b = 0; b < (int)kv->blocks; b ++)
+        {
+            if (kv->blk[b].state != KV_BLK_USED || b == kv->head)
+                continue;
+            if (victim < 0 || kv->blk[b].valid < kv->blk[victim].valid ||
+                (kv->blk[b].valid == kv->blk[victim].valid && kv->blk[b].ec < kv->blk[victim].ec))
+                victim = b;
+        }
+        if (victim < 0 || kv->blk[victim].valid + min_dead > kv->payload)
+            return -ENOSPC;
+    }
+
+    kv->in_gc = 1;
+    for (e = kv->ent; e < kv->ent + MTD_KV_MAX_KEYS && kv->blk[victim].valid; e ++)
+    {
+        if (e->size == 0 || BLK(kv, e->addr) != (uint32_t)victim)
+            continue;
+
+        ret = kv_read(kv, e->addr, kv->rec, e->size);
+        if (ret == 0)
+            ret = kv_reserve(kv, e->size);
+        if (ret == 0)
+        {
+            addr = ADDR(kv, kv->head, kv->head_ofs);
+            ret = kv_log_write(kv, kv->rec, e->size);
+        }
+        if (ret)
+            goto out;
+
+        kv_index_put(kv, e - kv->ent, e->hash, e->key_len, addr, e->size);
+        kv->records ++;
+    }
+
+    /* the deleted records and the old checkpoints are dropped with the block */
+    ret = kv_checkpoint(kv);
+    if (ret == 0)
+        ret = kv_flush(kv);
+    if (ret)
+        goto out;
+
+    if (kv_erase_block(kv, victim) == 0)
+    {
+        kv->blk[victim].state = KV_BLK_FREE;
+        kv->blk[victim].valid = 0;
+        kv->nr_free ++;
+    }
+
+out:
+    kv->in_gc = 0;
+
+    return ret;
+}
+
+static void kv_thread_entry(void *parameter)
+{
+    struct mtd_kv *kv = (struct mtd_kv *)parameter;
+    rt_int32_t timeout, period = rt_tick_from_millisecond(MTD_KV_FLUSH_MS);
+    rt_uint32_t set;
+    int ret;
+
+    while (1)
+    {
+        /* a block at a time, the writers go on between */
+        do
+        {
+            rt_mutex_take(&kv->lock, RT_WAITING_FOREVER);
+            ret = -ENOSPC;
+            if (kv->nr_free <= MTD_KV_GC_BLOCKS || kv_wl_victim(kv) >= 0)
+                ret = kv_gc(kv, kv->payload / 2);
+            rt_mutex_release(&kv->lock);
+        } while (ret == 0);
+
+        timeout = RT_WAITING_FOREVER;
+        rt_mutex_take(&kv->lock, RT_WAITING_FOREVER);
+        if (kv->wbuf_addr != KV_NONE)
+        {
+            timeout = period - (rt_int32_t)(rt_tick_get() - kv->wbuf_tick);
+            if (timeout <= 0)
+            {
+                kv_flush(kv);
+                timeout = RT_WAITING_FOREVER;
+            }
+        }
+        rt_mutex_release(&kv->lock);
+
+        rt_event_recv(&kv->event, 1, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, timeout, &set);
+    }
+}
+
+/*
+ * Walk the records of a block from the offset, the records are replayed or
+ * the last checkpoint is found. Return the offset behind the last record.
+ */
+static uint32_t kv_scan_block(struct mtd_kv *kv, int b, uint32_t ofs, int replay, uint32_t *ckpt)
+{
+    struct kv_rec rec;
+    uint32_t addr, len, hash;
+    int i;
+
+    while (ofs + sizeof(rec) <= kv->mtd->erasesize)
+    {
+        addr = ADDR(kv, b, ofs);
+        if (kv_read(kv, addr, &rec, sizeof(rec)) != 0)
+            break;
+
+        /* the rest of a page flushed partly, the log goes on in the next page */
+        if (rec.crc == KV_NONE && (rec.type == 0xFF || ofs % kv->unit + sizeof(rec) > kv->unit))
+        {
+            if (kv->unit == 1 || ofs % kv->unit == 0)
+                break;
+            ofs += kv->unit - ofs % kv->unit;
+            continue;
+        }
+
+        len = rec.key_len + rec.val_len;
+        if (rec.type < KV_REC_SET || rec.type > KV_REC_CKPT || rec.key_len > MTD_KV_KEY_MAX ||
+            len > kv->rec_size || ofs + KV_REC_SIZE(rec.key_len, rec.val_len) > kv->mtd->erasesize)
+            break;
+        if (kv_read(kv, addr + sizeof(rec), kv->rec, len) != 0 ||
+            kv_crc32(kv_crc32(0, &rec.type, sizeof(rec) - sizeof(uint32_t)), kv->rec, len) != rec.crc)
+            break;
+
+        if (!replay && rec.type == KV_REC_CKPT)
+        {
+            *ckpt = addr;
+        }
+        else if (replay && rec.type != KV_REC_CKPT)
+        {
+            hash = kv_hash((const char *)kv->rec, rec.key_len);
+            i = kv_find(kv, (const char *)kv->rec, rec.key_len, hash);
+            if (rec.type == KV_REC_SET)
+                kv_index_put(kv, i, hash, rec.key_len, addr, KV_REC_SIZE(rec.key_len, rec.val_len));
+            else if (i >= 0)
+                kv_index_del(kv, i);
+            kv->records ++;
+        }
+        ofs += KV_REC_SIZE(rec.key_len, rec.val_len);
+    }
+
+    return ofs;
+}
+
+/* load the checkpoint, the offset behind it is returned in end */
+static int kv_ckpt_load(struct mtd_kv *kv, uint32_t addr, uint32_t *end)
+{
+    struct kv_rec rec;
+    struct kv_ckpt *ckpt = (struct kv_ckpt *)kv->rec;
+    uint32_t *ec = (uint32_t *)(ckpt + 1);
+    struct kv_ckpt_entry *ce;
+    uint32_t i;
+    int ret;
+
+    ret = kv_read(kv, addr, &rec, sizeof(rec));
+    if (ret == 0)
+        ret = kv_read(kv, addr + sizeof(rec), kv->rec, rec.val_len);
+    if (ret)
+        return ret;
+    if (ckpt->blocks != kv->blocks || ckpt->count > MTD_KV_MAX_KEYS)
+        return -EINVAL;
+    *end = addr % kv->mtd->erasesize + KV_REC_SIZE(0, rec.val_len);
+
+    for (i = 0; i < kv->blocks; i ++)
+    {
+        if (ec[i] > kv->blk[i].ec)
+            kv->blk[i].ec = ec[i];
+    }
+
+    ce = (struct kv_ckpt_entry *)(ec + kv->blocks);
+    for (i = 0; i < ckpt->count; i ++, ce ++)
+    {
+        if (ce->addr >= kv->mtd->size)
+            return -EINVAL;
+        kv_index_put(kv, -1, ce->hash, ce->key_len, ce->addr, ce->size);
+    }
+
+    return 0;
+}
+
+static int kv_format(struct mtd_kv *kv)
+{
+    int ret;
+
+    rt_kprintf("kv: format %s\n", kv->mtd->parent.parent.name);
+
+    ret = kv_open_head(kv);
+    if (ret == 0)
+        ret = kv_checkpoint(kv);
+    if (ret == 0)
+        ret = kv_flush(kv);
+
+    return ret;
+}
+
+static int kv_load(struct mtd_kv *kv)
+{
+    struct kv_blk_hdr hdr;
+    uint32_t *order, ckpt = KV_NONE, end = 0, i, j, n, ofs, good = 0;
+    int b, ret = 0;
+
+    order = rt_malloc(kv->blocks * sizeof(uint32_t));
+    if (order == RT_NULL)
+        return -ENOMEM;
+
+    /* the used blocks in the order of writing */
+    for (b = 0, n = 0; b < (int)kv->blocks; b ++)
+    {
+        rt_memset(&kv->blk[b], 0, sizeof(struct kv_block));
+        if (mtd_block_isbad(kv->mtd, ADDR(kv, b, 0)))
+        {
+            kv->blk[b].state = KV_BLK_BAD;
+            continue;
+        }
+        good ++;
+
+        if (kv_read(kv, ADDR(kv, b, 0), &hdr, sizeof(hdr)) != 0 || hdr.magic != KV_BLK_MAGIC ||
+            hdr.crc != kv_crc32(0, &hdr, sizeof(hdr) - sizeof(uint32_t)))
+        {
+            kv->blk[b].state = KV_BLK_FREE;
+            kv->nr_free ++;
+            continue;
+        }
+
+        kv->blk[b].state = KV_BLK_USED;
+        kv->blk[b].seq = hdr.seq;
+        kv->blk[b].ec = hdr.ec;
+        if (hdr.seq > kv->seq)
+            kv->seq = hdr.seq;
+
+        for (i = n ++; i > 0 && kv->blk[order[i - 1]].seq > hdr.seq; i --)
+            order[i] = order[i - 1];
+        order[i] = b;
+    }
+
+    /* a block for log and one for compaction at least */
+    if (good < 3)
+    {
+        ret = -ENOSPC;
+        goto out;
+    }
+    kv->capacity = (good - 2) * (kv->payload - kv->ckpt_max);
+
+    if (n == 0)
+    {
+        ret = kv_format(kv);
+        goto out;
+    }
+
+    /* the last checkpoint is in the last blocks */
+    for (i = n; i > 0 && ckpt == KV_NONE; i --)
+        kv_scan_block(kv, order[i - 1], sizeof(hdr), 0, &ckpt);
+
+    if (ckpt != KV_NONE)
+    {
+        ret = kv_ckpt_load(kv, ckpt, &ofs);
+        if (ret)
+            goto out;
+
+        /* the records behind it */
+        for (i = 0; order[i] != BLK(kv, ckpt); i ++);
+    }
+    else
+    {
+        rt_kprintf("kv: no checkpoint on %s, replay all\n", kv->mtd->parent.parent.name);
+        i = 0;
+        ofs = sizeof(hdr);
+    }
+
+    for (j = i; j < n; j ++, ofs = sizeof(hdr))
+        end = kv_scan_block(kv, order[j], ofs, 1, RT_NULL);
+    kv->records = 0;
+    /* the erases before mount are not known, a cold block may be moved once */
+    kv->erases_since_wl = kv->blocks;
+
+    /* nor goes on behind the last record if the rest is blank, nand in a new block */
+    b = order[n - 1];
+    if (kv->unit == 1)
+    {
+        for (ofs = end; ofs < kv->mtd->erasesize; ofs += j)
+        {
+            j = min(kv->rec_size, kv->mtd->erasesize - ofs);
+            if (kv_read(kv, ADDR(kv, b, ofs), kv->rec, j) != 0)
+                break;
+            for (i = 0; i < j && kv->rec[i] == 0xFF; i ++);
+            if (i < j)
+                break;
+        }
+        if (ofs >= kv->mtd->erasesize)
+        {
+            kv->head = b;
+            kv->head_ofs = end;
+        }
+    }
+
+out:
+    rt_free(order);
+
+    return ret;
+}
+
+/**
+ * This function will mount the key-value store on a mtd partition, which
+ * is formatted if there is no store on it.
+ *
+ * @param mtd_name the name of mtd partition
+ *
+ * @return the store, or RT_NULL on failure
+ */
+struct mtd_kv *kv_mount(const char *mtd_name)
+{
+    struct mtd_kv *kv;
+    rt_mtd_t *mtd;
+    rt_thread_t tid;
+    int i, ret;
+
+    mtd = mtd_device_get(mtd_name);
+    if (mtd == RT_NULL)
+        return RT_NULL;
+
+    if (mtd->writesize == 0 || mtd->erasesize % mtd->writesize || mtd->erasesize < 4 * mtd->writesize)
+        return RT_NULL;
+
+    /* held until the store is in the list, a partition is mounted once */
+    rt_mutex_take(&_kv_list_lock, RT_WAITING_FOREVER);
+    rt_list_for_each_entry(kv, &_kv_list, list)
+    {
+        if (kv->mtd == mtd)
+        {
+            rt_mutex_release(&_kv_list_lock);
+            return kv;
+        }
+    }
+
+    kv = rt_malloc(sizeof(struct mtd_kv));
+    if (kv == RT_NULL)
+    {
+        rt_mutex_release(&_kv_list_lock);
+        return RT_NULL;
+    }
+    rt_memset(kv, 0, sizeof(struct mtd_kv));
+
+    kv->mtd = mtd;
+    kv->unit = mtd->writesize;
+    kv->blocks = mtd->size / mtd->erasesize;
+    kv->payload = mtd->erasesize - sizeof(struct kv_blk_hdr);
+    kv->ckpt_max = KV_REC_SIZE(0, sizeof(struct kv_ckpt) + kv->blocks * sizeof(uint32_t) +
+                               MTD_KV_MAX_KEYS * sizeof(struct kv_ckpt_entry));
+    kv->rec_size = kv->ckpt_max;
+    if (kv->rec_size < KV_REC_SIZE(MTD_KV_KEY_MAX, MTD_KV_VALUE_MAX))
+        kv->rec_size = KV_REC_SIZE(MTD_KV_KEY_MAX, MTD_KV_VALUE_MAX);
+    kv->head = -1;
+    kv->wbuf_addr = KV_NONE;
+    kv->rbuf_addr = KV_NONE;
+
+    /* a checkpoint takes half of a block at most */
+    ret = -EINVAL;
+    if (kv->ckpt_max > 0xFFFF || kv->ckpt_max * 2 > kv->payload)
+        goto out;
+
+    kv->blk = rt_malloc(kv->blocks * sizeof(struct kv_block));
+    kv->rec = rt_malloc(kv->rec_size);
+    if (kv->unit > 1)
+    {
+        kv->wbuf = rt_malloc(kv->unit);
+        kv->rbuf = rt_malloc(kv->unit);
+    }
+    ret = -ENOMEM;
+    if (kv->blk == RT_NULL || kv->rec == RT_NULL || (kv->unit > 1 && (kv->wbuf == RT_NULL || kv->rbuf == RT_NULL)))
+        goto out;
+
+    for (i = 0; i < MTD_KV_MAX_KEYS; i ++)
+    {
+        kv->bucket[i] = KV_NIL;
+        kv->ent[i].next = i + 1;
+    }
+    kv->ent[MTD_KV_MAX_KEYS - 1].next = KV_NIL;
+    kv->free_ent = 0;
+
+    rt_mutex_init(&kv->lock, "kv", RT_IPC_FLAG_FIFO);
+    rt_event_init(&kv->event, "kv", RT_IPC_FLAG_FIFO);
+
+    ret = kv_load(kv);
+    if (ret == 0)
+    {
+        /* no garbage collection and write-back without the thread */
+        tid = rt_thread_create("kv", kv_thread_entry, kv, MTD_KV_THREAD_STACK, MTD_KV_THREAD_PRIORITY, 10);
+        if (tid == RT_NULL)
+            ret = -ENOMEM;
+    }
+    if (ret)
+    {
+        rt_kprintf("kv: mount %s failed: %d\n", mtd_name, ret);
+        rt_event_detach(&kv->event);
+        rt_mutex_detach(&kv->lock);
+        goto out;
+    }
+
+    rt_list_insert_after(&_kv_list, &kv->list);
+    rt_mutex_release(&_kv_list_lock);
+    rt_thread_startup(tid);
+
+    return kv;
+
+out:
+    rt_mutex_release(&_kv_list_lock);
+    rt_free(kv->wbuf);
+    rt_free(kv->rbuf);
+    rt_free(kv->rec);
+    rt_free(kv->blk);
+    rt_free(kv);
+
+    return RT_NULL;
+}
+RTM_EXPORT(kv_mount);
+
+static int kv_system_init(void)
+{
+    rt_mutex_init(&_kv_list_lock, "kvlist", RT_IPC_FLAG_FIFO);
+
+    return 0;
+}
+INIT_PREV_EXPORT(kv_system_init);
+
+/**
+ * This function will read the value of a key.
+ *
+ * @param kv the store
+ * @param key the key
+ * @param value the buffer of value
+ * @param size the size of buffer
+ *
+ * @return the length of value, which may be larger than the buffer, or
+ *         -ENOENT if the key is not found
+ */
+int kv_get(struct mtd_kv *kv, const char *key, void *value, size_t size)
+{
+    struct kv_rec rec;
+    uint32_t key_len = rt_strlen(key);
+    int i, ret;
+
+    if (key_len == 0 || key_len > MTD_KV_KEY_MAX)
+        return -EINVAL;
+
+    rt_mutex_take(&kv->lock, RT_WAITING_FOREVER);
+    i = kv_find(kv, key, key_len, kv_hash(key, key_len));
+    ret = -ENOENT;
+    if (i >= 0)
+    {
+        ret = kv_read(kv, kv->ent[i].addr, &rec, sizeof(rec));
+        if (ret == 0 && size)
+            ret = kv_read(kv, kv->ent[i].addr + sizeof(rec) + key_len, value, min(size, rec.val_len));
+        if (ret == 0)
+            ret = rec.val_len;
+    }
+    rt_mutex_release(&kv->lock);
+
+    return ret;
+}
+RTM_EXPORT(kv_get);
+
+/**
+ * This function will set the value of a key. The value is on flash when it
+ * returns on nor, and in MTD_KV_FLUSH_MS or by kv_sync on nand.
+ *
+ * @param kv the store
+ * @param key the key
+ * @param value the value
+ * @param len the length of value
+ *
+ * @return 0 on OK, -ENOSPC if the store is full
+ */
+int kv_set(struct mtd_kv *kv, const char *key, const void *value, size_t len)
+{
+    struct kv_rec rec;
+    uint32_t key_len = rt_strlen(key), hash, size, addr;
+    int i, ret;
+
+    if (key_len == 0 || key_len > MTD_KV_KEY_MAX || len > MTD_KV_VALUE_MAX)
+        return -EINVAL;
+
+    size = KV_REC_SIZE(key_len, len);
+    hash = kv_hash(key, key_len);
+
+    rt_mutex_take(&kv->lock, RT_WAITING_FOREVER);
+    i = kv_find(kv, key, key_len, hash);
+
+    /* the same value is not written again */
+    if (i >= 0 && kv->ent[i].size == size &&
+        kv_read(kv, kv->ent[i].addr, &rec, sizeof(rec)) == 0 && rec.val_len == len &&
+        kv_read(kv, kv->ent[i].addr + sizeof(rec) + key_len, kv->rec, len) == 0 &&
+        rt_memcmp(kv->rec, value, len) == 0)
+    {
+        ret = 0;
+        goto out;
+    }
+
+    ret = -ENOSPC;
+    if ((i < 0 && kv->count == MTD_KV_MAX_KEYS) ||
+        kv->live - (i >= 0 ? kv->ent[i].size : 0) + size > kv->capacity)
+        goto out;
+
+    ret = kv_append(kv, KV_REC_SET, key, key_len, value, len, &addr);
+    if (ret)
+        goto out;
+    kv_index_put(kv, i, hash, key_len, addr, size);
+
+    if (kv->records >= MTD_KV_CKPT_RECORDS)
+        ret = kv_checkpoint(kv);
+
+out:
+    rt_mutex_release(&kv->lock);
+
+    return ret;
+}
+RTM_EXPORT(kv_set);
+
+/**
+ * This function will delete a key.
+ *
+ * @param kv the store
+ * @param key the key
+ *
+ * @return 0 on OK, -ENOENT if the key is not found
+ */
+int kv_del(struct mtd_kv *kv, const char *key)
+{
+    uint32_t key_len = rt_strlen(key), addr;
+    int i, ret;
+
+    if (key_len == 0 || key_len > MTD_KV_KEY_MAX)
+        return -EINVAL;
+
+    rt_mutex_take(&kv->lock, RT_WAITING_FOREVER);
+    i = kv_find(kv, key, key_len, kv_hash(key, key_len));
+    ret = -ENOENT;
+    if (i >= 0)
+    {
+        ret = kv_append(kv, KV_REC_DEL, key, key_len, RT_NULL, 0, &addr);
+        if (ret == 0)
+            kv_index_del(kv, i);
+        if (ret == 0 && kv->records >= MTD_KV_CKPT_RECORDS)
+            ret = kv_checkpoint(kv);
+    }
+    rt_mutex_release(&kv->lock);
+
+    return ret;
+}
+RTM_EXPORT(kv_del);
+
+/**
+ * This function will write the records buffered for a nand page.
+ *
+ * @param kv the store
+ *
+ * @return 0 on OK
+ */
+int kv_sync(struct mtd_kv *kv)
+{
+    int ret;
+
+    rt_mutex_take(&kv->lock, RT_WAITING_FOREVER);
+    ret = kv_flush(kv);
+    rt_mutex_release(&kv->lock);
+
+    return ret;
+}
+RTM_EXPORT(kv_sync);
+
+/**
+ * This function will call the function for every key, until it returns
+ * non-zero.
+ *
+ * @param kv the store
+ * @param func the function, with the key and the length of its value
+ * @param arg the argument of function
+ *
+ * @return the value returned by the function, or 0
+ */
+int kv_foreach(struct mtd_kv *kv, int (*func)(struct mtd_kv *kv, const char *key, size_t len, void *arg),
+               void *arg)
+{
+    char key[MTD_KV_KEY_MAX + 1];
+    struct kv_rec rec;
+    int i, ret = 0;
+
+    rt_mutex_take(&kv->lock, RT_WAITING_FOREVER);
+    for (i = 0; i < MTD_KV_MAX_KEYS && ret == 0; i ++)
+    {
+        if (kv->ent[i].size == 0)
+            continue;
+
+        ret = kv_read(kv, kv->ent[i].addr, &rec, sizeof(rec));
+        if (ret == 0)
+            ret = kv_read(kv, kv->ent[i].addr + sizeof(rec), key, rec.key_len);
+        if (ret)
+            break;
+        key[rec.key_len] = '\0';
+
+        ret = func(kv, key, rec.val_len, arg);
+    }
+    rt_mutex_release(&kv->lock);
+
+    return ret;
+}
+RTM_EXPORT(kv_foreach);
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+static int kv_print(struct mtd_kv *kv, const char *key, size_t len, void *arg)
+{
+    uint8_t value[MTD_KV_VALUE_MAX + 1];
+    size_t i;
+
+    kv_get(kv, key, value, MTD_KV_VALUE_MAX);
+    rt_kprintf("%-*s ", MTD_KV_KEY_MAX, key);
+    for (i = 0; i < len && value[i] >= 0x20 && value[i] < 0x7F; i ++);
+    if (i == len)
+    {
+        value[len] = '\0';
+        rt_kprintf("%s\n", value);
+        return 0;
+    }
+
+    for (i = 0; i < len; i ++)
+        rt_kprintf("%02x", value[i]);
+    rt_kprintf("\n");
+
+    return 0;
+}
+
+static int kv(int argc, char **argv)
+{
+    struct mtd_kv *kv;
+    int ret = -1;
+
+    if (argc < 3)
+    {
+        rt_kprintf("kv <mtd> info|list|sync\n");
+        rt_kprintf("kv <mtd> get|del <key>\n");
+        rt_kprintf("kv <mtd> set <key> <value>\n");
+        return -1;
+    }
+
+    kv = kv_mount(argv[1]);
+    if (kv == RT_NULL)
+    {
+        rt_kprintf("mount %s failed\n", argv[1]);
+        return -1;
+    }
+
+    if (!rt_strcmp(argv[2], "info"))
+    {
+        rt_kprintf("keys %d/%d, live %d/%d bytes, %d blocks free of %d\n", kv->count, MTD_KV_MAX_KEYS,
+                   kv->live, kv->capacity, kv->nr_free, kv->blocks);
+        ret = 0;
+    }
+    else if (!rt_strcmp(argv[2], "list"))
+    {
+        ret = kv_foreach(kv, kv_print, RT_NULL);
+    }
+    else if (!rt_strcmp(argv[2], "sync"))
+    {
+        ret = kv_sync(kv);
+    }
+    else if (argc > 3 && !rt_strcmp(argv[2], "get"))
+    {
+        ret = kv_get(kv, argv[3], RT_NULL, 0);
+        if (ret >= 0)
+            ret = kv_print(kv, argv[3], ret, RT_NULL);
+    }
+    else if (argc > 3 && !rt_strcmp(argv[2], "del"))
+    {
+        ret = kv_del(kv, argv[3]);
+    }
+    else if (argc > 4 && !rt_strcmp(argv[2], "set"))
+    {
+        ret = kv_set(kv, argv[3], argv[4], rt_strlen(argv[4]));
+    }
+
+    if (ret)
+        rt_kprintf("kv %s failed: %d\n", argv[2], ret);
+
+    return ret;
+}
+MSH_CMD_EXPORT(kv, key-value store on mtd);
+#endif
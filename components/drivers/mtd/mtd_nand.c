@@ -23,7 +23,7 @@ static int check_offs_len(rt_nand_t *chip, loff_t ofs, size_t len)
     }
 
     /* Length must align on block boundary */
-    if (len % blkmask)
+    if (len & blkmask)
     {
         ret = -EINVAL;
     }
@@ -130,17 +130,25 @@ static int nand_erase(rt_mtd_t *mtd, struct erase_info *instr)
 
     while (pages)
     {
-        int status;
+        int status, n = 1;
+
+        /* the blocks of all planes are erased together if they are aligned */
+        if (nand->planes > 1 && (page / nand->pages_pb) % nand->planes == 0 &&
+            pages >= nand->planes * nand->pages_pb)
+        {
+            for (; n < nand->planes; n ++, page += nand->pages_pb)
+                nand->ops->cmdfunc(nand, NAND_BLK_ERASE_MP, page, 0);
+        }
 
         status = nand->ops->cmdfunc(nand, NAND_BLK_ERASE, page, 0);
         if (status & NAND_STATUS_FAIL)
         {
             ret = -EIO;
-            instr->fail_addr = ((loff_t)page * nand->page_size);
+            instr->fail_addr = ((loff_t)(page - (n - 1) * nand->pages_pb) * nand->page_size);
         }
 
         page += nand->pages_pb;
-        pages -= nand->pages_pb;
+        pages -= n * nand->pages_pb;
     }
 
     return ret;
@@ -161,9 +169,11 @@ static int nand_do_read_ops(rt_mtd_t *mtd, loff_t from, struct mtd_oob_ops *ops)
     int page, bytes;
     char oob_required;
     char ecc_fail = 0;
+    char cached;
     struct nand_chip *chip = mtd->priv;
     int ret = 0;
     uint32_t readlen = ops->len;
+    uint32_t chip_pages = chip->size / chip->page_size;
     uint16_t oobreadlen = ops->ooblen;
     uint16_t max_oobsize = ops->mode == MTD_OPS_AUTO_OOB ?
                            chip->freelayout->length : chip->oobsize;
@@ -182,11 +192,26 @@ static int nand_do_read_ops(rt_mtd_t *mtd, loff_t from, struct mtd_oob_ops *ops)
     oob = ops->oobbuf;
     oob_required = oob ? 1 : 0;
 
+    /* the next page is loaded while this one is transferred */
+    cached = (chip->ops->read_page_cached != RT_NULL) && (readlen > chip->page_size);
+
     while (1)
     {
         bytes = min(chip->page_size, readlen);
 
-        chip->ops->cmdfunc(chip, NAND_PAGE_RD, page, 0x00);
+        if (cached)
+        {
+            int next = -1;
+
+            /* don't go across chips */
+            if (readlen > bytes && (page + 1) % chip_pages != 0)
+                next = page + 1;
+            chip->ops->read_page_cached(chip, page, next);
+        }
+        else
+        {
+            chip->ops->cmdfunc(chip, NAND_PAGE_RD, page, 0x00);
+        }
 
         /*
          * Now read the page into the buffer.  Absent an error,
@@ -201,7 +226,10 @@ static int nand_do_read_ops(rt_mtd_t *mtd, loff_t from, struct mtd_oob_ops *ops)
             ret = chip->ecc.read_page(chip, buf, oob_required, page);
         }
 
-        max_bitflips = 0;//max_t(unsigned int, max_bitflips, ret);
+        if (ret < 0)
+            ecc_fail = 1;
+        else if ((uint32_t)ret > max_bitflips)
+            max_bitflips = ret;
 
         if (oob)
         {
@@ -227,9 +255,6 @@ static int nand_do_read_ops(rt_mtd_t *mtd, loff_t from, struct mtd_oob_ops *ops)
     if (oob)
         ops->oobretlen = ops->ooblen - oobreadlen;
 
-    if (ret < 0)
-        return ret;
-
     if (ecc_fail)
         return -EBADMSG;
 
@@ -282,12 +307,30 @@ static int nand_write_page(rt_nand_t *chip, const uint8_t *buf,
     return status;
 }
 
+/* the status of previous page is returned too, see write_page_cached */
+static int nand_write_page_cached(rt_nand_t *chip, const uint8_t *buf,
+                                  int oob_required, int page, int raw, int last)
+{
+    chip->ops->cmdfunc(chip, NAND_PAGE_WR0, page, 0x00);
+
+    if (raw)
+    {
+        nand_write_page_raw(chip, buf, oob_required, page);
+    }
+    else
+    {
+        chip->ecc.write_page(chip, buf, oob_required, page);
+    }
+
+    return chip->ops->write_page_cached(chip, page, last);
+}
+
 
 static int nand_do_write_ops(rt_mtd_t *mtd, loff_t to, struct mtd_oob_ops *ops)
 {
     int page;
     struct nand_chip *chip = mtd->priv;
-    uint16_t writelen = ops->len;
+    uint32_t writelen = ops->len;
     uint16_t oob_required = ops->oobbuf ? 1 : 0;
     uint16_t oobwritelen = ops->ooblen;
     uint16_t oobmaxlen = ops->mode == MTD_OPS_AUTO_OOB ?
@@ -295,12 +338,16 @@ static int nand_do_write_ops(rt_mtd_t *mtd, loff_t to, struct mtd_oob_ops *ops)
 
     uint8_t *oob = ops->oobbuf;
     uint8_t *buf = ops->datbuf;
+    char cached;
     int ret;
 
     ops->retlen = 0;
     if (!writelen)
         return 0;
 
+    /* the page is transferred while the previous one is programmed */
+    cached = (chip->ops->write_page_cached != RT_NULL) && (writelen > chip->page_size);
+
     /* Reject writes, which are not page aligned */
     if (NOTALIGNED(to) || NOTALIGNED(ops->len))
     {
@@ -332,9 +379,26 @@ static int nand_do_write_ops(rt_mtd_t *mtd, loff_t to, struct mtd_oob_ops *ops)
             rt_memset(chip->oob_poi, 0xff, chip->oobsize);
         }
 
-        ret = nand_write_page(chip, buf, oob_required, page, (ops->mode == MTD_OPS_RAW));
-        if (ret)
-            break;
+        if (cached)
+        {
+            ret = nand_write_page_cached(chip, buf, oob_required, page,
+                                         (ops->mode == MTD_OPS_RAW), writelen == bytes);
+            if (ret & (NAND_STATUS_FAIL | NAND_STATUS_FAIL_N1))
+            {
+                /* the previous page is not written either */
+                if (ret & NAND_STATUS_FAIL_N1)
+                    writelen += bytes;
+                ret = -EIO;
+                break;
+            }
+            ret = 0;
+        }
+        else
+        {
+            ret = nand_write_page(chip, buf, oob_required, page, (ops->mode == MTD_OPS_RAW));
+            if (ret)
+                break;
+        }
 
         writelen -= bytes;
         if (!writelen)
@@ -388,6 +452,7 @@ static int nand_read_page_hwecc(rt_nand_t *chip, uint8_t *buf, int oob_required,
     uint8_t *ecc_calc = chip->buffers.ecccalc;
     uint8_t *ecc_code = chip->buffers.ecccode;
     unsigned int max_bitflips = 0;
+    int failed = 0;
 
     for (i = 0; eccsteps; eccsteps--, i += eccbytes, p += eccsize)
     {
@@ -408,17 +473,120 @@ static int nand_read_page_hwecc(rt_nand_t *chip, uint8_t *buf, int oob_required,
 
         stat = chip->ecc.correct(chip, p, &ecc_code[i], &ecc_calc[i]);
         if (stat < 0)
-        {
-            //mtd->ecc_stats.failed++;
-        }
-        else
-        {
-            //mtd->ecc_stats.corrected += stat;
-            //max_bitflips = max_t(unsigned int, max_bitflips, stat);
-        }
+            failed ++;
+        else if ((unsigned int)stat > max_bitflips)
+            max_bitflips = stat;
     }
 
-    return max_bitflips;
+    return failed ? -EBADMSG : max_bitflips;
+}
+
+static int nand_write_page_swecc(rt_nand_t *chip, const uint8_t *buf, int oob_required, int page)
+{
+    uint16_t i;
+    uint16_t eccsize = chip->ecc.stepsize;
+    uint16_t eccbytes = chip->ecc.bytes;
+    uint16_t eccsteps = chip->page_size / chip->ecc.stepsize;
+    uint16_t eccpos = chip->ecc.layout->offset;
+    uint8_t *ecc_calc = chip->buffers.ecccalc;
+    const uint8_t *p = buf;
+
+    for (i = 0; eccsteps; eccsteps--, i += eccbytes, p += eccsize)
+        chip->ecc.calculate(chip, p, &ecc_calc[i]);
+
+    rt_memcpy(&chip->oob_poi[eccpos], ecc_calc, chip->ecc.layout->length);
+
+    chip->ops->write_buf(chip, buf, chip->page_size);
+    chip->ops->write_buf(chip, chip->oob_poi, chip->oobsize);
+
+    return 0;
+}
+
+static int nand_read_page_swecc(rt_nand_t *chip, uint8_t *buf, int oob_required, int page)
+{
+    uint16_t i;
+    uint16_t eccsize = chip->ecc.stepsize;
+    uint16_t eccbytes = chip->ecc.bytes;
+    uint16_t eccsteps = chip->page_size / chip->ecc.stepsize;
+    uint16_t eccpos = chip->ecc.layout->offset;
+    uint8_t *p = buf;
+    uint8_t *ecc_calc = chip->buffers.ecccalc;
+    uint8_t *ecc_code = chip->buffers.ecccode;
+    unsigned int max_bitflips = 0;
+    int failed = 0;
+
+    chip->ops->read_buf(chip, buf, chip->page_size);
+    chip->ops->read_buf(chip, chip->oob_poi, chip->oobsize);
+    rt_memcpy(ecc_code, &chip->oob_poi[eccpos], chip->ecc.layout->length);
+
+    for (i = 0; eccsteps; eccsteps--, i += eccbytes, p += eccsize)
+    {
+        int stat;
+
+        chip->ecc.calculate(chip, p, &ecc_calc[i]);
+        stat = chip->ecc.correct(chip, p, &ecc_code[i], &ecc_calc[i]);
+        if (stat < 0)
+            failed ++;
+        else if ((unsigned int)stat > max_bitflips)
+            max_bitflips = stat;
+    }
+
+    return failed ? -EBADMSG : max_bitflips;
+}
+
+static int nand_bch_calculate_ecc(struct nand_chip *chip, const uint8_t *dat, uint8_t *ecc_code)
+{
+    nand_bch_calculate(chip->ecc.priv, dat, ecc_code);
+
+    return 0;
+}
+
+static int nand_bch_correct_data(struct nand_chip *chip, uint8_t *dat, uint8_t *read_ecc, uint8_t *calc_ecc)
+{
+    return nand_bch_correct(chip->ecc.priv, dat, read_ecc, calc_ecc);
+}
+
+/* the ecc is at the end of oob, and the free bytes are after bad mark */
+static int nand_bch_setup(rt_nand_t *nand)
+{
+    struct nand_bch *bch;
+    int eccsize;
+
+    if (nand->ecc.stepsize == 0)
+        nand->ecc.stepsize = 512;
+    if (nand->ecc.strength == 0)
+        nand->ecc.strength = 4;
+    if (nand->page_size % nand->ecc.stepsize)
+        return -EINVAL;
+
+    bch = nand_bch_init(nand->ecc.stepsize, nand->ecc.strength);
+    if (bch == RT_NULL)
+        return -ENOMEM;
+
+    eccsize = nand->page_size / nand->ecc.stepsize * bch->ecc_bytes;
+    if (eccsize + 2 > nand->oobsize)
+    {
+        nand_bch_free(bch);
+        return -EINVAL;
+    }
+
+    nand->ecc.priv = bch;
+    nand->ecc.bytes = bch->ecc_bytes;
+    nand->ecc.calculate = nand_bch_calculate_ecc;
+    nand->ecc.correct = nand_bch_correct_data;
+    nand->ecc.read_page = nand_read_page_swecc;
+    nand->ecc.write_page = nand_write_page_swecc;
+
+    nand->oob_layout[0].offset = 2;
+    nand->oob_layout[0].length = nand->oobsize - eccsize - 2;
+    nand->oob_layout[1].offset = 0;
+    nand->oob_layout[1].length = 0;
+    nand->oob_layout[2].offset = nand->oobsize - eccsize;
+    nand->oob_layout[2].length = eccsize;
+    nand->freelayout = &nand->oob_layout[0];
+    nand->ecc.layout = &nand->oob_layout[2];
+
+    return 0;
 }
 
 static int nand_write(rt_mtd_t *mtd, loff_t to, size_t len, size_t *retlen, const uint8_t *buf)
@@ -610,34 +778,275 @@ out:
     return ret;
 }
 
-static int nand_block_isbad(rt_mtd_t *mtd, loff_t ofs)
+/* read the bad block mark in the oob of first page */
+static int nand_block_checkbad(rt_nand_t *chip, int block)
 {
-    int page, res = 0;
-    struct nand_chip *chip = mtd->priv;
     uint16_t bad;
 
-    page = (int)(ofs/chip->page_size);
-
-    chip->ops->cmdfunc(chip, NAND_PAGE_RD, page, chip->page_size);
+    chip->ops->cmdfunc(chip, NAND_PAGE_RD, block * chip->pages_pb, chip->page_size);
     chip->ops->read_buf(chip, (uint8_t*)&bad, 2);
 
-    res = (bad != 0xFFFF);
+    return (bad != 0xFFFF);
+}
+
+#define BBT_ISBAD(chip, blk)    ((chip)->bbt[(blk) >> 3] & (1 << ((blk) & 7)))
+#define BBT_SETBAD(chip, blk)   ((chip)->bbt[(blk) >> 3] |= (1 << ((blk) & 7)))
+#define BBT_BYTES(chip)         (((chip)->blocks + 7) >> 3)
+#define BBT_IN_FLASH(chip)      ((chip)->options & NAND_BBT_USE_FLASH)
+/* the first block reserved for the table in flash */
+#define BBT_FIRST(chip)         ((int)(chip)->blocks - (BBT_IN_FLASH(chip) ? NAND_BBT_BLOCKS : 0))
+
+/* the pattern in free oob of main and mirror table, followed by version */
+static const uint8_t _bbt_pattern[2][4] = {{'B', 'b', 't', '0'}, {'1', 't', 'b', 'B'}};
+
+/* get the version of table in a block, -1 for no table */
+static int nand_bbt_check(rt_nand_t *chip, int block, int which, uint32_t *version)
+{
+    uint8_t *oob;
 
-    return res;
+    if (BBT_ISBAD(chip, block))
+        return -1;
+
+    nand_read_oob_std(chip, block * chip->pages_pb);
+    oob = chip->oob_poi + chip->freelayout->offset;
+    if (rt_memcmp(oob, _bbt_pattern[which], 4) != 0)
+        return -1;
+
+    *version = oob[4] | (oob[5] << 8) | (oob[6] << 16) | ((uint32_t)oob[7] << 24);
+
+    return 0;
+}
+
+static int nand_bbt_read(rt_nand_t *chip, int block)
+{
+    uint8_t *buf = chip->buffers.databuf;
+    uint32_t len, bytes;
+    int page;
+
+    page = block * chip->pages_pb;
+    for (len = 0; len < BBT_BYTES(chip); len += bytes, page ++)
+    {
+        bytes = min(chip->page_size, BBT_BYTES(chip) - len);
+
+        chip->ops->cmdfunc(chip, NAND_PAGE_RD, page, 0x00);
+        if (chip->ecc.read_page(chip, buf, 1, page) < 0)
+            return -EIO;
+        rt_memcpy(chip->bbt + len, buf, bytes);
+    }
+
+    return 0;
+}
+
+/* write a table to the block, the block is erased before */
+static int nand_bbt_write_block(rt_nand_t *chip, int block, int which)
+{
+    uint8_t *buf = chip->buffers.databuf;
+    uint8_t *oob;
+    uint32_t len, bytes;
+    int page, status;
+
+    page = block * chip->pages_pb;
+    status = chip->ops->cmdfunc(chip, NAND_BLK_ERASE, page, 0);
+    if (status & NAND_STATUS_FAIL)
+        return -EIO;
+
+    for (len = 0; len < BBT_BYTES(chip); len += bytes, page ++)
+    {
+        bytes = min(chip->page_size, BBT_BYTES(chip) - len);
+
+        rt_memset(buf, 0xff, chip->page_size);
+        rt_memcpy(buf, chip->bbt + len, bytes);
+
+        rt_memset(chip->oob_poi, 0xff, chip->oobsize);
+        if (len == 0)
+        {
+            oob = chip->oob_poi + chip->freelayout->offset;
+            rt_memcpy(oob, _bbt_pattern[which], 4);
+            oob[4] = chip->bbt_version;
+            oob[5] = chip->bbt_version >> 8;
+            oob[6] = chip->bbt_version >> 16;
+            oob[7] = chip->bbt_version >> 24;
+        }
+
+        status = nand_write_page(chip, buf, 1, page, 0);
+        if (status & NAND_STATUS_FAIL)
+            return -EIO;
+    }
+
+    return 0;
+}
+
+/*
+ * write the table to its block, or another good block in the reserved area
+ * when there is no block or it fails. A failed block is marked bad.
+ */
+static int nand_bbt_write(rt_nand_t *chip, int which)
+{
+    int block, tries;
+
+    block = chip->bbt_block[which];
+    for (tries = 0; tries < NAND_BBT_BLOCKS; tries ++)
+    {
+        if (block < 0)
+        {
+            /* search from the end, skip bad one and the other table */
+            for (block = chip->blocks - 1; block >= BBT_FIRST(chip); block --)
+            {
+                if (!BBT_ISBAD(chip, block) && block != chip->bbt_block[!which])
+                    break;
+            }
+            if (block < BBT_FIRST(chip))
+                break;
+        }
+
+        if (nand_bbt_write_block(chip, block, which) == 0)
+        {
+            chip->bbt_block[which] = block;
+            return 0;
+        }
+
+        BBT_SETBAD(chip, block);
+        chip->bbt_block[which] = -1;
+        block = -1;
+    }
+
+    return -EIO;
+}
+
+/* write the main and mirror table with a new version */
+static int nand_bbt_update(rt_nand_t *chip)
+{
+    int ret;
+
+    if (!BBT_IN_FLASH(chip))
+        return 0;
+
+    chip->bbt_version ++;
+    ret = nand_bbt_write(chip, 0);
+    ret |= nand_bbt_write(chip, 1);
+
+    return ret;
+}
+
+/* build the table by the bad mark of every block */
+static void nand_bbt_scan(rt_nand_t *chip)
+{
+    int block;
+
+    rt_memset(chip->bbt, 0, BBT_BYTES(chip));
+    for (block = 0; block < chip->blocks; block ++)
+    {
+        if (nand_block_checkbad(chip, block))
+            BBT_SETBAD(chip, block);
+    }
+}
+
+/*
+ * Load the table from flash, or scan the blocks when it's kept in RAM only.
+ * With the table in flash, the blocks are scanned only when neither table
+ * can be read, which is done once at the first boot.
+ */
+static int nand_bbt_init(rt_nand_t *chip)
+{
+    uint32_t version[2];
+    int block, which, found = -1;
+
+    chip->bbt = rt_malloc(BBT_BYTES(chip));
+    if (chip->bbt == RT_NULL)
+        return -ENOMEM;
+    rt_memset(chip->bbt, 0, BBT_BYTES(chip));
+
+    chip->bbt_version = 0;
+    chip->bbt_block[0] = chip->bbt_block[1] = -1;
+    if (!BBT_IN_FLASH(chip))
+    {
+        nand_bbt_scan(chip);
+        return 0;
+    }
+    for (block = chip->blocks - 1; block >= BBT_FIRST(chip); block --)
+    {
+        for (which = 0; which < 2; which ++)
+        {
+            if (chip->bbt_block[which] < 0 &&
+                nand_bbt_check(chip, block, which, &version[which]) == 0)
+            {
+                chip->bbt_block[which] = block;
+            }
+        }
+    }
+
+    /* get the newer one */
+    for (which = 0; which < 2; which ++)
+    {
+        if (chip->bbt_block[which] < 0)
+            continue;
+        if (found < 0 || (int32_t)(version[which] - version[found]) > 0)
+            found = which;
+    }
+
+    if (found >= 0 && nand_bbt_read(chip, chip->bbt_block[found]) == 0)
+    {
+        chip->bbt_version = version[found];
+
+        /* both are the same */
+        if (chip->bbt_block[!found] >= 0 && version[!found] == version[found])
+            return 0;
+
+        /* write the missing or older one */
+        return nand_bbt_write(chip, !found);
+    }
+
+    /* the newer one can't be read, use the other and write both again */
+    if (found >= 0 && chip->bbt_block[!found] >= 0 &&
+        nand_bbt_read(chip, chip->bbt_block[!found]) == 0)
+    {
+        /* the new version is above both of them */
+        chip->bbt_version = version[found];
+
+        return nand_bbt_update(chip);
+    }
+
+    nand_bbt_scan(chip);
+
+    return nand_bbt_update(chip);
+}
+
+static int nand_block_isbad(rt_mtd_t *mtd, loff_t ofs)
+{
+    struct nand_chip *chip = mtd->priv;
+    int block;
+
+    block = (int)(ofs / (chip->page_size * chip->pages_pb));
+
+    /* the blocks of bad block table in flash are reserved */
+    if (block >= BBT_FIRST(chip))
+        return 1;
+
+    return BBT_ISBAD(chip, block) ? 1 : 0;
 }
 
 static int nand_block_markbad(rt_mtd_t *mtd, loff_t ofs)
 {
+    struct nand_chip *chip = mtd->priv;
     struct mtd_oob_ops ops;
     uint8_t buf[2] = { 0, 0 };
-    int ret ;
+    int block, ret;
+
+    block = (int)(ofs / (chip->page_size * chip->pages_pb));
+    if (BBT_ISBAD(chip, block))
+        return 0;
 
     rt_memset(&ops, 0, sizeof(ops));
     ops.oobbuf = buf;
     ops.len = ops.ooblen = 2;
     ops.mode = MTD_OPS_PLACE_OOB;
 
-    ret = nand_do_write_oob(mtd, ofs, &ops);
+    /* the mark is kept in table even if it can't be written */
+    ret = nand_do_write_oob(mtd, (loff_t)block * chip->page_size * chip->pages_pb, &ops);
+
+    BBT_SETBAD(chip, block);
+    if (nand_bbt_update(chip) == 0)
+        ret = 0;
 
     return ret;
 }
@@ -657,7 +1066,7 @@ int rt_mtd_nand_init(rt_nand_t *nand, int blks_pc, int nchip)
 {
     uint8_t *buf;
 
-    buf = rt_malloc(nand->oobsize * 3);
+    buf = rt_malloc(nand->oobsize * 3 + nand->page_size);
     if (buf == RT_NULL)
         return -ENOMEM;
 
@@ -666,12 +1075,16 @@ int rt_mtd_nand_init(rt_nand_t *nand, int blks_pc, int nchip)
     nand->buffers.ecccalc = buf;
     buf += nand->oobsize;
     nand->buffers.ecccode = buf;
+    buf += nand->oobsize;
+    nand->buffers.databuf = buf;
 
     nand->size = nand->page_size * nand->pages_pb * blks_pc;
 	nand->nchip = nchip;
 
 	nand->mtd.offset = 0;
     nand->mtd.size = nand->size * nchip;
+    nand->mtd.erasesize = nand->page_size * nand->pages_pb;
+    nand->mtd.writesize = nand->page_size;
     nand->mtd.parent.type = RT_Device_Class_MTD;
     nand->mtd.ops = &_ops;
     nand->mtd.priv = nand;
@@ -691,13 +1104,41 @@ int rt_mtd_nand_init(rt_nand_t *nand, int blks_pc, int nchip)
     {
         nand->ecc.read_page = nand_read_page_hwecc;
         nand->ecc.write_page = nand_write_page_hwecc;
+    }break;
+    case NAND_ECC_SOFT_BCH:
+    {
+        int ret;
+
+        ret = nand_bch_setup(nand);
+        if (ret)
+        {
+            rt_free(nand->oob_poi);
+            return ret;
+        }
     }break;
 	default:
 	{
-	    rt_free(buf);
+	    rt_free(nand->oob_poi);
 		return -1;
 	}
     }
 
+    nand->blocks = nand->mtd.size / (nand->page_size * nand->pages_pb);
+    /* the table in flash fits in a block, and its pattern and version in free oob */
+    if (BBT_IN_FLASH(nand) &&
+        (nand->blocks <= NAND_BBT_BLOCKS ||
+         (nand->blocks + 7) / 8 > (uint32_t)nand->page_size * nand->pages_pb ||
+         nand->freelayout->length < 8))
+    {
+        rt_free(nand->oob_poi);
+        return -EINVAL;
+    }
+
+    if (nand_bbt_init(nand) == -ENOMEM)
+    {
+        rt_free(nand->oob_poi);
+        return -ENOMEM;
+    }
+
     return 0;
 }
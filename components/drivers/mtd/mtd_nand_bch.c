@@ -0,0 +1,540 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ */
+
+/*
+ * Software BCH ecc for nand.
+ *
+ * A step of data is the polynomial with the msb of first byte as the highest
+ * term, and the ecc is the remainder of data * x^ecc_bits divided by the
+ * generator polynomial, which is calculated a byte a time by table and 32
+ * bits a word. The error locator polynomial is got from syndromes by
+ * Berlekamp-Massey, and its roots are found by Chien search with log table.
+ */
+
+#include <rtdevice.h>
+
+/* primitive polynomials of GF(2^m), m = 5 - 15 */
+static const uint16_t _prim_poly[] =
+{
+    0x25, 0x43, 0x83, 0x11d, 0x211, 0x409, 0x805, 0x1053, 0x201b, 0x402b, 0x8003
+};
+
+#define BCH_M_MIN       5
+#define BCH_M_MAX       15
+
+rt_inline int gf_mod(struct nand_bch *bch, int v)
+{
+    while (v >= bch->n)
+        v -= bch->n;
+
+    return v;
+}
+
+rt_inline uint16_t gf_mul(struct nand_bch *bch, uint16_t a, uint16_t b)
+{
+    if (a == 0 || b == 0)
+        return 0;
+
+    return bch->a_pow[gf_mod(bch, bch->a_log[a] + bch->a_log[b])];
+}
+
+rt_inline uint16_t gf_div(struct nand_bch *bch, uint16_t a, uint16_t b)
+{
+    if (a == 0)
+        return 0;
+
+    return bch->a_pow[gf_mod(bch, bch->a_log[a] + bch->n - bch->a_log[b])];
+}
+
+/* get the remainder of a step in ecc_buf, left aligned */
+static void bch_encode(struct nand_bch *bch, const uint8_t *dat)
+{
+    uint32_t *r = bch->ecc_buf;
+    const uint32_t *p;
+    int i, w, last = bch->ecc_words - 1;
+
+    rt_memset(r, 0, bch->ecc_words * sizeof(uint32_t));
+
+    for (i = 0; i < bch->len; i ++)
+    {
+        p = bch->mod8_tab + ((r[0] >> 24) ^ dat[i]) * bch->ecc_words;
+        for (w = 0; w < last; w ++)
+            r[w] = ((r[w] << 8) | (r[w + 1] >> 24)) ^ p[w];
+        r[last] = (r[last] << 8) ^ p[last];
+    }
+}
+
+static void bch_store(struct nand_bch *bch, uint8_t *ecc)
+{
+    int i;
+
+    for (i = 0; i < bch->ecc_bytes; i ++)
+        ecc[i] = bch->ecc_buf[i >> 2] >> (24 - ((i & 3) << 3));
+}
+
+static int bch_init_field(struct nand_bch *bch)
+{
+    int i, x = 1;
+
+    for (i = 0; i < bch->n; i ++)
+    {
+        bch->a_pow[i] = x;
+        bch->a_log[x] = i;
+        x <<= 1;
+        if (x & (1 << bch->m))
+            x ^= _prim_poly[bch->m - BCH_M_MIN];
+    }
+    bch->a_pow[bch->n] = 1;
+    bch->a_log[0] = 0;
+
+    /* not a primitive polynomial */
+    return (x == 1) ? 0 : -1;
+}
+
+/*
+ * get the generator polynomial, which has the conjugates of alpha^1 to
+ * alpha^2t as roots. It's left aligned in words without the highest term.
+ */
+static int bch_init_generator(struct nand_bch *bch, uint32_t *genpoly)
+{
+    uint16_t *roots, *g;
+    int i, k, e, nroots = 0, deg = 0;
+
+    roots = rt_malloc(bch->m * bch->t * sizeof(uint16_t));
+    g = rt_malloc((bch->m * bch->t + 1) * sizeof(uint16_t));
+    if (roots == RT_NULL || g == RT_NULL)
+    {
+        rt_free(roots);
+        rt_free(g);
+        return -ENOMEM;
+    }
+
+    g[0] = 1;
+    for (i = 1; i < 2 * bch->t; i += 2)
+    {
+        for (k = 0; k < nroots && roots[k] != i; k ++);
+        if (k < nroots)
+            continue;
+
+        /* multiply (x + alpha^e) of every conjugate */
+        e = i;
+        do
+        {
+            roots[nroots ++] = e;
+
+            g[deg + 1] = g[deg];
+            for (k = deg; k > 0; k --)
+                g[k] = g[k - 1] ^ gf_mul(bch, bch->a_pow[e], g[k]);
+            g[0] = gf_mul(bch, bch->a_pow[e], g[0]);
+            deg ++;
+
+            e = gf_mod(bch, e << 1);
+        }
+        while (e != i);
+    }
+
+    bch->ecc_bits = deg;
+    bch->ecc_words = (deg + 31) / 32;
+    bch->ecc_bytes = (deg + 7) / 8;
+
+    rt_memset(genpoly, 0, bch->ecc_words * sizeof(uint32_t));
+    for (k = 0; k < deg; k ++)
+    {
+        /* the term of degree k is at bit deg - 1 - k from the top */
+        e = deg - 1 - k;
+        if (g[k])
+            genpoly[e >> 5] |= 0x80000000UL >> (e & 31);
+    }
+
+    rt_free(roots);
+    rt_free(g);
+
+    return 0;
+}
+
+static void bch_init_mod8_tab(struct nand_bch *bch, const uint32_t *genpoly)
+{
+    uint32_t *p;
+    int v, b, w, fb, last = bch->ecc_words - 1;
+
+    for (v = 0; v < 256; v ++)
+    {
+        p = bch->mod8_tab + v * bch->ecc_words;
+        rt_memset(p, 0, bch->ecc_words * sizeof(uint32_t));
+
+        /* the lfsr of 8 bits */
+        for (b = 7; b >= 0; b --)
+        {
+            fb = (p[0] >> 31) ^ ((v >> b) & 1);
+            for (w = 0; w < last; w ++)
+                p[w] = (p[w] << 1) | (p[w + 1] >> 31);
+            p[last] <<= 1;
+
+            if (fb)
+            {
+                for (w = 0; w <= last; w ++)
+                    p[w] ^= genpoly[w];
+            }
+        }
+    }
+}
+
+/**
+ * This function will create a BCH ecc engine.
+ *
+ * @param stepsize the bytes of data in a step
+ * @param t the bits could be corrected in a step
+ *
+ * @return the engine, RT_NULL on failure.
+ */
+struct nand_bch *nand_bch_init(int stepsize, int t)
+{
+    struct nand_bch *bch;
+    uint32_t *genpoly = RT_NULL;
+    uint8_t *erased = RT_NULL;
+    int m, i;
+
+    if (stepsize <= 0 || t <= 0)
+        return RT_NULL;
+
+    /* the shortest code could hold the data and ecc */
+    for (m = BCH_M_MIN; m <= BCH_M_MAX; m ++)
+    {
+        if ((1 << m) - 1 >= stepsize * 8 + m * t)
+            break;
+    }
+    if (m > BCH_M_MAX)
+        return RT_NULL;
+
+    bch = rt_malloc(sizeof(struct nand_bch));
+    if (bch == RT_NULL)
+        return RT_NULL;
+    rt_memset(bch, 0, sizeof(struct nand_bch));
+
+    bch->m = m;
+    bch->t = t;
+    bch->n = (1 << m) - 1;
+    bch->len = stepsize;
+
+    bch->a_pow = rt_malloc((bch->n + 1) * sizeof(uint16_t));
+    bch->a_log = rt_malloc((bch->n + 1) * sizeof(uint16_t));
+    bch->syn = rt_malloc(2 * t * sizeof(uint16_t));
+    bch->elp = rt_malloc(3 * (2 * t + 1) * sizeof(uint16_t));
+    genpoly = rt_malloc(((m * t + 31) / 32) * sizeof(uint32_t));
+    if (bch->a_pow == RT_NULL || bch->a_log == RT_NULL || bch->syn == RT_NULL ||
+        bch->elp == RT_NULL || genpoly == RT_NULL)
+        goto __fail;
+
+    if (bch_init_field(bch) != 0 || bch_init_generator(bch, genpoly) != 0)
+        goto __fail;
+
+    bch->mod8_tab = rt_malloc(256 * bch->ecc_words * sizeof(uint32_t));
+    bch->ecc_buf = rt_malloc(bch->ecc_words * sizeof(uint32_t));
+    bch->ecc_mask = rt_malloc(bch->ecc_bytes);
+    erased = rt_malloc(stepsize);
+    if (bch->mod8_tab == RT_NULL || bch->ecc_buf == RT_NULL ||
+        bch->ecc_mask == RT_NULL || erased == RT_NULL)
+        goto __fail;
+
+    bch_init_mod8_tab(bch, genpoly);
+
+    /* the ecc of an erased step is all 0xff with the mask */
+    rt_memset(erased, 0xff, stepsize);
+    bch_encode(bch, erased);
+    bch_store(bch, bch->ecc_mask);
+    for (i = 0; i < bch->ecc_bytes; i ++)
+        bch->ecc_mask[i] = ~bch->ecc_mask[i];
+
+    rt_free(erased);
+    rt_free(genpoly);
+
+    return bch;
+
+__fail:
+    rt_free(erased);
+    rt_free(genpoly);
+    nand_bch_free(bch);
+
+    return RT_NULL;
+}
+
+/**
+ * This function will release a BCH ecc engine.
+ *
+ * @param bch the engine
+ */
+void nand_bch_free(struct nand_bch *bch)
+{
+    if (bch == RT_NULL)
+        return;
+
+    rt_free(bch->a_pow);
+    rt_free(bch->a_log);
+    rt_free(bch->mod8_tab);
+    rt_free(bch->ecc_mask);
+    rt_free(bch->ecc_buf);
+    rt_free(bch->syn);
+    rt_free(bch->elp);
+    rt_free(bch);
+}
+
+/**
+ * This function will calculate the ecc of a step.
+ *
+ * @param bch the engine
+ * @param dat the data of stepsize
+ * @param ecc the ecc of ecc_bytes
+ */
+void nand_bch_calculate(struct nand_bch *bch, const uint8_t *dat, uint8_t *ecc)
+{
+    int i;
+
+    bch_encode(bch, dat);
+    bch_store(bch, ecc);
+
+    for (i = 0; i < bch->ecc_bytes; i ++)
+        ecc[i] ^= bch->ecc_mask[i];
+}
+
+/* get the syndromes of the remainder of errors in ecc_buf */
+static void bch_syndromes(struct nand_bch *bch)
+{
+    uint16_t *syn = bch->syn;
+    int i, j, d, d2, e;
+
+    rt_memset(syn, 0, 2 * bch->t * sizeof(uint16_t));
+
+    for (i = 0; i < bch->ecc_bits; i ++)
+    {
+        if (!(bch->ecc_buf[i >> 5] & (0x80000000UL >> (i & 31))))
+            continue;
+
+        /* the odd syndromes, S(j + 1) = R(alpha^(j + 1)) */
+        d = bch->ecc_bits - 1 - i;
+        d2 = gf_mod(bch, d << 1);
+        for (j = 0, e = d; j < 2 * bch->t; j += 2)
+        {
+            syn[j] ^= bch->a_pow[e];
+            e = gf_mod(bch, e + d2);
+        }
+    }
+
+    /* the even syndromes, S(2j) = S(j)^2 */
+    for (j = 1; j < 2 * bch->t; j += 2)
+        syn[j] = gf_mul(bch, syn[j >> 1], syn[j >> 1]);
+}
+
+/* get the error locator polynomial by Berlekamp-Massey, return the degree */
+static int bch_elp(struct nand_bch *bch)
+{
+    int size = 2 * bch->t + 1;
+    uint16_t *c = bch->elp, *b = c + size, *tmp = b + size;
+    uint16_t d, db = 1, coef;
+    int i, k, l = 0, m = 1;
+
+    rt_memset(c, 0, size * sizeof(uint16_t));
+    rt_memset(b, 0, size * sizeof(uint16_t));
+    c[0] = b[0] = 1;
+
+    for (k = 0; k < 2 * bch->t; k ++)
+    {
+        /* discrepancy */
+        d = bch->syn[k];
+        for (i = 1; i <= l; i ++)
+            d ^= gf_mul(bch, c[i], bch->syn[k - i]);
+
+        if (d == 0)
+        {
+            m ++;
+            continue;
+        }
+
+        coef = gf_div(bch, d, db);
+        rt_memcpy(tmp, c, size * sizeof(uint16_t));
+        for (i = 0; i + m < size; i ++)
+            c[i + m] ^= gf_mul(bch, coef, b[i]);
+
+        if (2 * l <= k)
+        {
+            l = k + 1 - l;
+            rt_memcpy(b, tmp, size * sizeof(uint16_t));
+            db = d;
+            m = 1;
+        }
+        else
+        {
+            m ++;
+        }
+    }
+
+    return l;
+}
+
+/**
+ * This function will correct the data of a step by ecc.
+ *
+ * @param bch the engine
+ * @param dat the data of stepsize
+ * @param read_ecc the ecc read from flash
+ * @param calc_ecc the ecc calculated from data by nand_bch_calculate
+ *
+ * @return the number of bits corrected, -EBADMSG when it can't be corrected
+ */
+int nand_bch_correct(struct nand_bch *bch, uint8_t *dat,
+                     const uint8_t *read_ecc, const uint8_t *calc_ecc)
+{
+    uint16_t *c = bch->elp;
+    uint16_t *idx = c + 2 * (2 * bch->t + 1);
+    uint16_t sum;
+    int i, d, l, nbits, found = 0;
+    uint32_t diff = 0;
+
+    /* the remainder of errors, the mask is cancelled */
+    rt_memset(bch->ecc_buf, 0, bch->ecc_words * sizeof(uint32_t));
+    for (i = 0; i < bch->ecc_bytes; i ++)
+    {
+        bch->ecc_buf[i >> 2] |= (uint32_t)(read_ecc[i] ^ calc_ecc[i]) << (24 - ((i & 3) << 3));
+        diff |= read_ecc[i] ^ calc_ecc[i];
+    }
+    if (diff == 0)
+        return 0;
+
+    /* the bits out of ecc_bits */
+    if (bch->ecc_bits & 7)
+        bch->ecc_buf[(bch->ecc_bytes - 1) >> 2] &= ~(0xFFFFFFFFUL >> (bch->ecc_bits & 31));
+
+    bch_syndromes(bch);
+    l = bch_elp(bch);
+    if (l > bch->t)
+        return -EBADMSG;
+
+    /*
+     * Chien search, the error of degree d is found when c(alpha^-d) is 0.
+     * The term i of c is kept in idx as log, and divided by alpha^i a step.
+     */
+    for (i = 1; i <= l; i ++)
+        idx[i] = c[i] ? bch->a_log[c[i]] : 0;
+
+    nbits = bch->len * 8 + bch->ecc_bits;
+    for (d = 0; d < nbits && found < l; d ++)
+    {
+        sum = 1;
+        for (i = 1; i <= l; i ++)
+        {
+            if (c[i] == 0)
+                continue;
+
+            sum ^= bch->a_pow[idx[i]];
+            idx[i] = (idx[i] >= i) ? idx[i] - i : idx[i] + bch->n - i;
+        }
+
+        if (sum != 0)
+            continue;
+
+        found ++;
+        if (d >= bch->ecc_bits)
+        {
+            /* an error in data, the error in ecc is not corrected */
+            i = d - bch->ecc_bits;
+            dat[bch->len - 1 - (i >> 3)] ^= 1 << (i & 7);
+        }
+    }
+
+    if (found != l)
+        return -EBADMSG;
+
+    return l;
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+#include <stdlib.h>
+
+static int nand_bch_bench(int argc, char **argv)
+{
+    struct nand_bch *bch;
+    uint8_t *dat, *ref, *ecc, *calc;
+    uint32_t seed = 0x12345678;
+    rt_tick_t tick[3];
+    int t, steps, i, k, failed = 0;
+
+    t = (argc > 1) ? atoi(argv[1]) : 8;
+    steps = (argc > 2) ? atoi(argv[2]) : 1024;
+
+    bch = nand_bch_init(512, t);
+    dat = rt_malloc(512 * 2 + 128);
+    if (bch == RT_NULL || dat == RT_NULL || steps <= 0)
+    {
+        rt_kprintf("nand_bch_bench [t] [steps]\n");
+        nand_bch_free(bch);
+        rt_free(dat);
+        return -1;
+    }
+    ref = dat + 512;
+    ecc = ref + 512;
+    calc = ecc + 64;
+
+    for (i = 0; i < 512; i ++)
+    {
+        seed = seed * 1103515245 + 12345;
+        ref[i] = seed >> 16;
+    }
+    rt_memcpy(dat, ref, 512);
+    nand_bch_calculate(bch, ref, ecc);
+
+    /* encode */
+    tick[0] = rt_tick_get();
+    for (i = 0; i < steps; i ++)
+        nand_bch_calculate(bch, dat, calc);
+    tick[0] = rt_tick_get() - tick[0];
+
+    /* decode without error */
+    tick[1] = rt_tick_get();
+    for (i = 0; i < steps; i ++)
+    {
+        nand_bch_calculate(bch, dat, calc);
+        nand_bch_correct(bch, dat, ecc, calc);
+    }
+    tick[1] = rt_tick_get() - tick[1];
+
+    /* decode with t errors */
+    tick[2] = rt_tick_get();
+    for (i = 0; i < steps; i ++)
+    {
+        for (k = 0; k < t; k ++)
+        {
+            seed = seed * 1103515245 + 12345;
+            dat[(seed >> 16) & 511] ^= 1 << k % 8;
+        }
+        nand_bch_calculate(bch, dat, calc);
+        if (nand_bch_correct(bch, dat, ecc, calc) < 0 || rt_memcmp(dat, ref, 512) != 0)
+        {
+            failed ++;
+            rt_memcpy(dat, ref, 512);
+        }
+    }
+    tick[2] = rt_tick_get() - tick[2];
+
+    rt_kprintf("bch m=%d t=%d ecc=%d bytes, %d steps of 512 bytes\n",
+               bch->m, bch->t, bch->ecc_bytes, steps);
+    rt_kprintf("encode:          %d ticks, %d KB/s\n", tick[0],
+               tick[0] ? steps / 2 * RT_TICK_PER_SECOND / tick[0] : 0);
+    rt_kprintf("decode clean:    %d ticks, %d KB/s\n", tick[1],
+               tick[1] ? steps / 2 * RT_TICK_PER_SECOND / tick[1] : 0);
+    rt_kprintf("decode %2d flips: %d ticks, %d KB/s, %d failed\n", t, tick[2],
+               tick[2] ? steps / 2 * RT_TICK_PER_SECOND / tick[2] : 0, failed);
+
+    nand_bch_free(bch);
+    rt_free(dat);
+
+    return 0;
+}
+MSH_CMD_EXPORT(nand_bch_bench, benchmark of nand bch ecc: nand_bch_bench [t] [steps]);
+#endif
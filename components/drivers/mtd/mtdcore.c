@@ -33,12 +33,17 @@ out:
 	return slave;
 }	
 
+/* mtd is accessed by mtd_xxx, the device interfaces are not used */
+static const struct rt_device_ops _mtd_dops = {0};
+
 int mtd_part_add(rt_mtd_t *master, const rt_mtdpart_t *parts, int n)
 {
 	int ret;
     rt_mtd_t *slave;
 
     master->master = master;
+	if (master->parent.dops == RT_NULL)
+		master->parent.dops = &_mtd_dops;
 
 	if (n == 1)
 	{
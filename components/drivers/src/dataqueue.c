@@ -20,6 +20,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2012-09-30     Bernard      first version.
+ * 2026-10-19     heyuanjie    add batched pop
  */
 
 #include <rthw.h>
@@ -155,32 +156,29 @@ __exit:
 }
 RTM_EXPORT(rt_data_queue_push);
 
-rt_err_t rt_data_queue_pop(struct rt_data_queue *queue,
-                           const void** data_ptr,
-                           rt_size_t *size, 
-                           rt_int32_t timeout)
+/*
+ * wait for the data to pop. It returns RT_EOK with interrupt disabled,
+ * otherwise the error code with interrupt enabled.
+ */
+static rt_err_t _rt_data_queue_wait_pop(struct rt_data_queue *queue,
+                                        rt_int32_t            timeout,
+                                        rt_ubase_t           *level)
 {
-    rt_ubase_t  level;
+    rt_ubase_t  temp;
     rt_thread_t thread;
     rt_err_t    result;
-    rt_uint16_t mask;
-
-    RT_ASSERT(queue != RT_NULL);
-    RT_ASSERT(data_ptr != RT_NULL);
-    RT_ASSERT(size != RT_NULL);
 
-    result = RT_EOK;
     thread = rt_thread_self();
-    mask   = queue->size - 1;
 
-    level = rt_hw_interrupt_disable();
+    temp = rt_hw_interrupt_disable();
     while (queue->get_index == queue->put_index)
     {
         /* queue is empty */
         if (timeout == 0)
         {
-            result = -RT_ETIMEOUT;
-            goto __exit;
+            rt_hw_interrupt_enable(temp);
+
+            return -RT_ETIMEOUT;
         }
 
         /* current context checking */
@@ -188,7 +186,7 @@ rt_err_t rt_data_queue_pop(struct rt_data_queue *queue,
 
         /* reset thread error number */
         thread->error = RT_EOK;
-        
+
         /* suspend thread on the pop list */
         rt_thread_suspend(thread);
         rt_list_insert_before(&(queue->suspended_pop_list), &(thread->tlist));
@@ -203,33 +201,48 @@ rt_err_t rt_data_queue_pop(struct rt_data_queue *queue,
         }
 
         /* enable interrupt */
-        rt_hw_interrupt_enable(level);
+        rt_hw_interrupt_enable(temp);
 
         /* do schedule */
         rt_schedule();
 
         /* thread is waked up */
         result = thread->error;
-        level  = rt_hw_interrupt_disable();
         if (result != RT_EOK)
-            goto __exit;
+            return result;
+
+        temp = rt_hw_interrupt_disable();
     }
 
-    *data_ptr = queue->queue[queue->get_index & mask].data_ptr;
-    *size     = queue->queue[queue->get_index & mask].data_size;
+    *level = temp;
+
+    return RT_EOK;
+}
 
-    queue->get_index += 1;
+/*
+ * the data are popped with interrupt disabled. Wake up the pushers for
+ * the free items when it's below the low water mark, then enable interrupt
+ * and notify the event.
+ */
+static void _rt_data_queue_popped(struct rt_data_queue *queue,
+                                  rt_size_t             count,
+                                  rt_ubase_t            level)
+{
+    rt_thread_t thread;
+    rt_uint32_t event = RT_DATAQUEUE_EVENT_POP;
+    rt_bool_t   resumed = RT_FALSE;
 
-    if ((queue->waiting_lwm == RT_TRUE) && 
-        (queue->put_index - queue->get_index) <= queue->lwm)
+    if ((queue->waiting_lwm == RT_TRUE) &&
+        (rt_uint16_t)(queue->put_index - queue->get_index) <= queue->lwm)
     {
         queue->waiting_lwm = RT_FALSE;
+        event = RT_DATAQUEUE_EVENT_LWM;
 
         /*
          * there is at least one thread in suspended list
          * and less than low water mark
          */
-        if (!rt_list_isempty(&(queue->suspended_push_list)))
+        while (count > 0 && !rt_list_isempty(&(queue->suspended_push_list)))
         {
             /* get thread entry */
             thread = rt_list_entry(queue->suspended_push_list.next,
@@ -238,28 +251,81 @@ rt_err_t rt_data_queue_pop(struct rt_data_queue *queue,
 
             /* resume it */
             rt_thread_resume(thread);
-            rt_hw_interrupt_enable(level);
-
-            /* perform a schedule */
-            rt_schedule();
+            resumed = RT_TRUE;
+            count --;
         }
+    }
+
+    rt_hw_interrupt_enable(level);
+
+    /* perform a schedule */
+    if (resumed)
+        rt_schedule();
+
+    if (queue->evt_notify != RT_NULL)
+        queue->evt_notify(queue, event);
+}
+
+rt_err_t rt_data_queue_pop(struct rt_data_queue *queue,
+                           const void** data_ptr,
+                           rt_size_t *size, 
+                           rt_int32_t timeout)
+{
+    rt_size_t count = 1;
+
+    return rt_data_queue_pop_batch(queue, data_ptr, size, &count, timeout);
+}
+RTM_EXPORT(rt_data_queue_pop);
+
+/*
+ * pop the data up to count with interrupt disabled once, and the pushers
+ * are waked up and scheduled once. It waits only when the queue is empty,
+ * and count is set to the number of data popped on return.
+ */
+rt_err_t rt_data_queue_pop_batch(struct rt_data_queue *queue,
+                                 const void          **data_ptr,
+                                 rt_size_t            *size,
+                                 rt_size_t            *count,
+                                 rt_int32_t            timeout)
+{
+    rt_ubase_t  level;
+    rt_err_t    result;
+    rt_uint16_t mask;
+    rt_size_t   index, number;
+
+    RT_ASSERT(queue != RT_NULL);
+    RT_ASSERT(data_ptr != RT_NULL);
+    RT_ASSERT(size != RT_NULL);
+    RT_ASSERT(count != RT_NULL && *count != 0);
+
+    mask = queue->size - 1;
 
-        if (queue->evt_notify != RT_NULL)
-            queue->evt_notify(queue, RT_DATAQUEUE_EVENT_LWM);
+    result = _rt_data_queue_wait_pop(queue, timeout, &level);
+    if (result != RT_EOK)
+    {
+        *count = 0;
 
         return result;
     }
 
-__exit:
-    rt_hw_interrupt_enable(level);
-    if ((result == RT_EOK) && (queue->evt_notify != RT_NULL))
+    number = (rt_uint16_t)(queue->put_index - queue->get_index);
+    if (number > *count)
+        number = *count;
+
+    for (index = 0; index < number; index ++)
     {
-        queue->evt_notify(queue, RT_DATAQUEUE_EVENT_POP);
+        data_ptr[index] = queue->queue[queue->get_index & mask].data_ptr;
+        size[index]     = queue->queue[queue->get_index & mask].data_size;
+
+        queue->get_index += 1;
     }
+    *count = number;
 
-    return result;
+    _rt_data_queue_popped(queue, number, level);
+
+    return RT_EOK;
 }
-RTM_EXPORT(rt_data_queue_pop);
+RTM_EXPORT(rt_data_queue_pop_batch);
 
 rt_err_t rt_data_queue_peak(struct rt_data_queue *queue,
                             const void** data_ptr,
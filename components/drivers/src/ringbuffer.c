@@ -22,6 +22,7 @@
  * 2012-09-30     Bernard      first version.
  * 2013-05-08     Grissiom     reimplement
  * 2016-08-18     heyuanjie    add interface
+ * 2026-10-19     heyuanjie    add peek/skip interface for zero-copy readers
  */
 
 #include <rtthread.h>
@@ -203,6 +204,57 @@ rt_size_t rt_ringbuffer_get(struct rt_ringbuffer *rb,
 }
 RTM_EXPORT(rt_ringbuffer_get);
 
+/**
+ * get the contiguous readable area at the read index without consuming it,
+ * the caller must call rt_ringbuffer_skip to release the data it used.
+ *
+ * @return the length of contiguous data starting at *ptr
+ */
+rt_size_t rt_ringbuffer_peek(struct rt_ringbuffer *rb, rt_uint8_t **ptr)
+{
+    rt_size_t size;
+
+    RT_ASSERT(rb != RT_NULL);
+    RT_ASSERT(ptr != RT_NULL);
+
+    *ptr = &rb->buffer_ptr[rb->read_index];
+
+    size = rt_ringbuffer_data_len(rb);
+    if (size > (rt_size_t)(rb->buffer_size - rb->read_index))
+        size = rb->buffer_size - rb->read_index;
+
+    return size;
+}
+RTM_EXPORT(rt_ringbuffer_peek);
+
+/**
+ * drop data from the read side of ring buffer
+ *
+ * @return the length of data dropped
+ */
+rt_size_t rt_ringbuffer_skip(struct rt_ringbuffer *rb, rt_uint16_t length)
+{
+    rt_size_t size;
+
+    RT_ASSERT(rb != RT_NULL);
+
+    size = rt_ringbuffer_data_len(rb);
+    if (size < length)
+        length = size;
+
+    if (rb->buffer_size - rb->read_index > length)
+    {
+        rb->read_index += length;
+        return length;
+    }
+
+    rb->read_mirror = ~rb->read_mirror;
+    rb->read_index = length - (rb->buffer_size - rb->read_index);
+
+    return length;
+}
+RTM_EXPORT(rt_ringbuffer_skip);
+
 /**
  * put a character into ring buffer
  */
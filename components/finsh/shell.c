@@ -34,6 +34,7 @@
  * 2011-02-23     Bernard      fix variable section end issue of finsh shell
  *                             initialization when use GNU GCC compiler.
  * 2017-01-11     heyuanjie    using stdio
+ * 2026-10-19     heyuanjie    add shell instances bound to a stream
  */
 
 #include <rthw.h>
@@ -46,6 +47,7 @@
 #endif
 
 #include <stdio.h>
+#include <stdarg.h>
 
 /* finsh thread */
 static struct rt_thread finsh_thread;
@@ -74,9 +76,36 @@ const char *finsh_get_prompt()
     return finsh_prompt;
 }
 
-static void shell_auto_complete(char *prefix)
+/* the console shell follows stdin/stdout, a session shell owns its stream */
+#define shell_in(shell)     ((shell)->in  ? (shell)->in  : stdin)
+#define shell_out(shell)    ((shell)->out ? (shell)->out : stdout)
+
+static int shell_getchar(struct finsh_shell *shell)
 {
-    printf("\n");
+    /* push out the pending echo and prompt before blocking on input */
+    if (shell->out != RT_NULL)
+        fflush(shell->out);
+
+    return fgetc(shell_in(shell));
+}
+
+static void shell_putchar(struct finsh_shell *shell, int ch)
+{
+    fputc(ch, shell_out(shell));
+}
+
+static void shell_printf(struct finsh_shell *shell, const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    vfprintf(shell_out(shell), fmt, args);
+    va_end(args);
+}
+
+static void shell_auto_complete(struct finsh_shell *shell, char *prefix)
+{
+    shell_printf(shell, "\n");
 #ifdef FINSH_USING_MSH
     if (msh_is_used() == RT_TRUE)
     {
@@ -91,7 +120,7 @@ static void shell_auto_complete(char *prefix)
 #endif
     }
 
-    printf("%s%s", FINSH_PROMPT, prefix);
+    shell_printf(shell, "%s%s", FINSH_PROMPT, prefix);
 }
 
 #ifndef FINSH_USING_MSH_ONLY
@@ -144,16 +173,16 @@ static rt_bool_t shell_handle_history(struct finsh_shell *shell)
 {
 #if defined(_WIN32)
     int i;
-    printf("\r");
+    shell_printf(shell, "\r");
 
     for (i = 0; i <= 60; i++)
-        putchar(' ');
-    printf("\r");
+        shell_putchar(shell, ' ');
+    shell_printf(shell, "\r");
 
 #else
-    printf("\033[2K\r");
+    shell_printf(shell, "\033[2K\r");
 #endif
-    printf("%s%s", FINSH_PROMPT, shell->line);
+    shell_printf(shell, "%s%s", FINSH_PROMPT, shell->line);
     return RT_FALSE;
 }
 
@@ -201,19 +230,28 @@ int finsh_exec(rt_shell_t *shell)
 
     rt_thread_self()->parameter = shell;
 
-    /* normal is echo mode */
-    shell->echo_mode = 1;
+    /* normal is echo mode, a session shell keeps the mode it is created with */
+    if (shell->in == RT_NULL)
+        shell->echo_mode = 1;
 
 #ifndef FINSH_USING_MSH_ONLY
     finsh_init(&shell->parser);
 #endif
 
-    printf(FINSH_PROMPT);
+    shell_printf(shell, FINSH_PROMPT);
 
     while (1)
     {
         /* read one character from device */
-        ch = getchar();
+        ch = shell_getchar(shell);
+        if (ch == EOF)
+        {
+            /* the peer of a session shell has hung up */
+            if (shell->in != RT_NULL)
+                break;
+
+            continue;
+        }
 
         /*
          * handle control key
@@ -287,7 +325,7 @@ int finsh_exec(rt_shell_t *shell)
             {
                 if (shell->line_curpos)
                 {
-                    putchar('\b');
+                    shell_putchar(shell, '\b');
                     shell->line_curpos --;
                 }
 
@@ -297,7 +335,7 @@ int finsh_exec(rt_shell_t *shell)
             {
                 if (shell->line_curpos < shell->line_position)
                 {
-                    putchar(shell->line[shell->line_curpos]);
+                    shell_putchar(shell, shell->line[shell->line_curpos]);
                     shell->line_curpos ++;
                 }
 
@@ -316,10 +354,10 @@ int finsh_exec(rt_shell_t *shell)
             int i;
             /* move the cursor to the beginning of line */
             for (i = 0; i < shell->line_curpos; i++)
-                putchar('\b');
+                shell_putchar(shell, '\b');
 
             /* auto complete */
-            shell_auto_complete(&shell->line[0]);
+            shell_auto_complete(shell, &shell->line[0]);
             /* re-calculate position */
             shell->line_curpos = shell->line_position = strlen(shell->line);
 
@@ -344,15 +382,15 @@ int finsh_exec(rt_shell_t *shell)
                            shell->line_position - shell->line_curpos);
                 shell->line[shell->line_position] = 0;
 
-                printf("\b%s  \b", &shell->line[shell->line_curpos]);
+                shell_printf(shell, "\b%s  \b", &shell->line[shell->line_curpos]);
 
                 /* move the cursor to the origin position */
                 for (i = shell->line_curpos; i <= shell->line_position; i++)
-                    putchar('\b');
+                    shell_putchar(shell, '\b');
             }
             else
             {
-                printf("\b \b");
+                shell_printf(shell, "\b \b");
                 shell->line[shell->line_position] = 0;
             }
 
@@ -370,7 +408,7 @@ int finsh_exec(rt_shell_t *shell)
             if (msh_is_used() == RT_TRUE)
             {
 				if (shell->line_position)
-				    putchar('\n');
+				    shell_putchar(shell, '\n');
                 msh_exec(shell->line, shell->line_position);
             }
             else
@@ -388,8 +426,8 @@ int finsh_exec(rt_shell_t *shell)
             if (pmt == 0 || pmt == ch)
 			{
 				pmt = ch;
-				putchar('\n');
-			    printf(FINSH_PROMPT);			
+				shell_putchar(shell, '\n');
+			    shell_printf(shell, FINSH_PROMPT);			
 			}
 
             memset(shell->line, 0, sizeof(shell->line));
@@ -411,17 +449,17 @@ int finsh_exec(rt_shell_t *shell)
                        shell->line_position - shell->line_curpos);
             shell->line[shell->line_curpos] = ch;
             if (shell->echo_mode)
-                printf("%s", &shell->line[shell->line_curpos]);
+                shell_printf(shell, "%s", &shell->line[shell->line_curpos]);
 
             /* move the cursor to new position */
             for (i = shell->line_curpos; i < shell->line_position; i++)
-                putchar('\b');
+                shell_putchar(shell, '\b');
         }
         else
         {
             shell->line[shell->line_position] = ch;
             if (shell->echo_mode)
-                putchar(ch);
+                shell_putchar(shell, ch);
         }
 
         ch = 0;
@@ -447,6 +485,82 @@ static void finsh_thread_entry(void *parameter)
     finsh_exec(shell);
 }
 
+#ifdef RT_USING_HEAP
+static void finsh_session_entry(void *parameter)
+{
+    struct finsh_shell *shell;
+
+    shell = (struct finsh_shell *)parameter;
+
+    finsh_exec(shell);
+
+#ifdef RT_USING_CONSOLE
+    rt_thread_self()->console = RT_NULL;
+#endif
+    fclose(shell->out);
+    fclose(shell->in);
+    rt_free(shell);
+}
+
+/*
+ * @ingroup finsh
+ *
+ * This function creates a shell instance which reads its command line from
+ * the stream on path, such as a telnet session device. The shell thread
+ * releases itself once the stream reaches end-of-file.
+ *
+ * @param name the name of shell thread
+ * @param path the path of stream, e.g. "/dev/telnet0"
+ * @param echo whether to echo the input characters
+ * @param console the console of shell thread for rt_kprintf, RT_NULL for
+ *        the system console
+ *
+ * @return the shell instance, RT_NULL on failure.
+ */
+rt_shell_t *finsh_shell_create(const char *name, const char *path, rt_bool_t echo, rt_console_t console)
+{
+    struct finsh_shell *shell;
+    rt_thread_t tid;
+
+    shell = (struct finsh_shell *)rt_malloc(sizeof(struct finsh_shell));
+    if (shell == RT_NULL)
+        return RT_NULL;
+    memset(shell, 0, sizeof(struct finsh_shell));
+
+    shell->in  = fopen(path, "r");
+    shell->out = fopen(path, "w");
+    if (shell->in == RT_NULL || shell->out == RT_NULL)
+        goto __failed;
+
+    /*
+     * input is taken character by character, and output is not buffered to
+     * keep the order with rt_kprintf of commands, which goes to the console.
+     */
+    setvbuf(shell->in, NULL, _IONBF, 0);
+    setvbuf(shell->out, NULL, _IONBF, 0);
+    shell->echo_mode = echo ? 1 : 0;
+
+    tid = rt_thread_create(name, finsh_session_entry, shell,
+                           FINSH_THREAD_STACK_SIZE, FINSH_THREAD_PRIORITY, 10);
+    if (tid == RT_NULL)
+        goto __failed;
+
+#ifdef RT_USING_CONSOLE
+    tid->console = console;
+#endif
+    rt_thread_startup(tid);
+
+    return shell;
+
+__failed:
+    if (shell->out) fclose(shell->out);
+    if (shell->in) fclose(shell->in);
+    rt_free(shell);
+
+    return RT_NULL;
+}
+#endif
+
 void finsh_system_function_init(const void *begin, const void *end)
 {
     _syscall_table_begin = (struct finsh_syscall *) begin;
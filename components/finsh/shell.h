@@ -25,12 +25,14 @@
  * Change Logs:
  * Date           Author       Notes
  * 2011-06-02     Bernard      Add finsh_get_prompt function declaration
+ * 2026-10-19     heyuanjie    add session shell stream
  */
 
 #ifndef __SHELL_H__
 #define __SHELL_H__
 
 #include <rtthread.h>
+#include <stdio.h>
 
 /* For historical reasons, users don't define FINSH_USING_HISTORY in rtconfig.h
  * but expect the history feature. So you sould define FINSH_USING_HISTORY to 0
@@ -94,10 +96,17 @@ struct finsh_shell
 	char line[FINSH_CMD_SIZE];
 	rt_uint8_t line_position;
 	rt_uint8_t line_curpos;
+
+	/* stream of a session shell, RT_NULL to follow stdin/stdout */
+	FILE *in;
+	FILE *out;
 };
 typedef struct finsh_shell rt_shell_t;
 
 int finsh_system_init(void);
 int finsh_exec(rt_shell_t *shell);
+#ifdef RT_USING_HEAP
+rt_shell_t *finsh_shell_create(const char *name, const char *path, rt_bool_t echo, rt_console_t console);
+#endif
 
 #endif
@@ -10,6 +10,7 @@
  * Change Logs:
  * Date           Author		Notes
  * 2010-11-17      yi.qiu	first version
+ * 2026-10-19      heyuanjie	share opened library by module name
  */
  
 #include <rtthread.h>
@@ -40,11 +41,8 @@ void* dlopen(const char *filename, int flags)
 		fullpath = (char*)filename; /* absolute path, use it directly */
 	}	
 
-	/* find in module list */
-	module = rt_module_find(fullpath);
-	
-	if(module != RT_NULL) module->nref++;
-	else module = rt_module_open(fullpath);
+	/* a library opened already is shared by rt_module_open */
+	module = rt_module_open(fullpath);
 
 	if(fullpath != filename)
 	{
@@ -10,6 +10,7 @@
  * Change Logs:
  * Date           Author		Notes
  * 2010-11-17      yi.qiu	first version
+ * 2026-10-19      heyuanjie	binary search in sorted symbol table
  */
 
 #include <rtthread.h>
@@ -17,18 +18,28 @@
 
 void* dlsym(void *handle, const char* symbol)
 {
-	int i;
+	int low, high, mid, result;
 	rt_module_t module;
 	
 	RT_ASSERT(handle != RT_NULL);
 
 	module = (rt_module_t)handle;
 
-	for(i=0; i<module->nsym; i++)
+	/* symbol table is sorted by name when module is loaded */
+	low = 0;
+	high = module->nsym - 1;
+	while (low <= high)
 	{
-		if (rt_strcmp(module->symtab[i].name, symbol) == 0)
-			return (void*)module->symtab[i].addr;
-	}	
+		mid = (low + high) / 2;
+		result = rt_strcmp(module->symtab[mid].name, symbol);
+		if (result == 0)
+			return (void*)module->symtab[mid].addr;
+
+		if (result < 0)
+			low = mid + 1;
+		else
+			high = mid - 1;
+	}
 
 	return RT_NULL;
 }
@@ -21,16 +21,36 @@
  * Date           Author       Notes
  * 2012-12-08     Bernard      fix the issue of _timevalue.tv_usec initialization, 
  *                             which found by Rob <rdent@iinet.net.au>
+ * 2026-10-19     heyuanjie    use nanosecond clock of kernel, add
+ *                             CLOCK_MONOTONIC and cpu time clocks
+ * 2026-10-19     heyuanjie    add clock_nanosleep and nanosleep
  */
 
 #include <rtthread.h>
 #include <pthread.h>
 
+/* realtime = _timevalue + rt_clock_ns() */
 struct timeval _timevalue;
+
+static void clock_time_set_realtime(time_t second)
+{
+    rt_uint64_t ns;
+
+    ns = rt_clock_ns();
+
+    _timevalue.tv_usec = MICROSECOND_PER_SECOND - (ns % NANOSECOND_PER_SECOND) / 1000;
+    _timevalue.tv_sec = second - (time_t)(ns / NANOSECOND_PER_SECOND) - 1;
+}
+
+static void clock_time_from_ns(struct timespec *tp, rt_uint64_t ns)
+{
+    tp->tv_sec  = (time_t)(ns / NANOSECOND_PER_SECOND);
+    tp->tv_nsec = (long)(ns % NANOSECOND_PER_SECOND);
+}
+
 void clock_time_system_init()
 {
     time_t time;
-    rt_tick_t tick;
     rt_device_t device;
 
     time = 0;
@@ -41,11 +61,7 @@ void clock_time_system_init()
         rt_device_control(device, RT_DEVICE_CTRL_RTC_GET_TIME, &time);
     }
 
-    /* get tick */
-    tick = rt_tick_get();
-
-    _timevalue.tv_usec = (tick%RT_TICK_PER_SECOND) * MICROSECOND_PER_TICK;
-    _timevalue.tv_sec = time - tick/RT_TICK_PER_SECOND - 1;
+    clock_time_set_realtime(time);
 }
 
 int clock_time_to_tick(const struct timespec *time)
@@ -83,15 +99,30 @@ RTM_EXPORT(clock_time_to_tick);
 
 int clock_getres(clockid_t clockid, struct timespec *res)
 {
-    if ((clockid != CLOCK_REALTIME) || (res == RT_NULL))
+    if (res == RT_NULL)
     {
         rt_set_errno(EINVAL);
 
         return -1;
     }
 
-    res->tv_sec = 0;
-    res->tv_nsec = NANOSECOND_PER_SECOND/RT_TICK_PER_SECOND;
+    switch (clockid)
+    {
+    case CLOCK_REALTIME:
+    case CLOCK_MONOTONIC:
+#ifdef RT_USING_CPUTIME
+    case CLOCK_PROCESS_CPUTIME_ID:
+    case CLOCK_THREAD_CPUTIME_ID:
+#endif
+        res->tv_sec = 0;
+        res->tv_nsec = rt_clock_resolution_ns();
+        break;
+
+    default:
+        rt_set_errno(EINVAL);
+
+        return -1;
+    }
 
     return 0;
 }
@@ -99,21 +130,55 @@ RTM_EXPORT(clock_getres);
 
 int clock_gettime(clockid_t clockid, struct timespec *tp)
 {
-    rt_tick_t tick;
+    rt_uint64_t ns;
 
-    if ((clockid != CLOCK_REALTIME) || (tp == RT_NULL))
+    if (tp == RT_NULL)
     {
         rt_set_errno(EINVAL);
 
         return -1;
     }
 
-    /* get tick */
-    tick = rt_tick_get();
+    switch (clockid)
+    {
+    case CLOCK_REALTIME:
+        ns = rt_clock_ns();
+
+        tp->tv_sec = _timevalue.tv_sec + (time_t)(ns / NANOSECOND_PER_SECOND);
+        tp->tv_nsec = _timevalue.tv_usec * 1000 + (long)(ns % NANOSECOND_PER_SECOND);
+        if (tp->tv_nsec >= NANOSECOND_PER_SECOND)
+        {
+            tp->tv_sec ++;
+            tp->tv_nsec -= NANOSECOND_PER_SECOND;
+        }
+        break;
+
+    case CLOCK_MONOTONIC:
+        clock_time_from_ns(tp, rt_clock_ns());
+        break;
+
+#ifdef RT_USING_CPUTIME
+    case CLOCK_PROCESS_CPUTIME_ID:
+        /* the whole system is one process, it runs when cpu is not idle */
+#ifdef RT_USING_SMP
+        ns = rt_clock_ns() * RT_CPUS_NR;
+#else
+        ns = rt_clock_ns();
+#endif
+        clock_time_from_ns(tp, ns - rt_thread_idle_cputime());
+        break;
+
+    case CLOCK_THREAD_CPUTIME_ID:
+        clock_time_from_ns(tp, rt_thread_cputime(rt_thread_self()));
+        break;
+#endif
+
+    default:
+        rt_set_errno(EINVAL);
+
+        return -1;
+    }
 
-    tp->tv_sec = _timevalue.tv_sec + tick / RT_TICK_PER_SECOND;
-    tp->tv_nsec = (_timevalue.tv_usec + (tick % RT_TICK_PER_SECOND) * MICROSECOND_PER_TICK) * 1000;
-    
     return 0;
 }
 RTM_EXPORT(clock_gettime);
@@ -121,7 +186,6 @@ RTM_EXPORT(clock_gettime);
 int clock_settime(clockid_t clockid, const struct timespec *tp)
 {
     int second;
-    rt_tick_t tick;
     rt_device_t device;
 
     if ((clockid != CLOCK_REALTIME) || (tp == RT_NULL))
@@ -133,12 +197,9 @@ int clock_settime(clockid_t clockid, const struct timespec *tp)
 
     /* get second */
     second = tp->tv_sec;
-    /* get tick */
-    tick = rt_tick_get();
 
     /* update timevalue */
-    _timevalue.tv_usec = MICROSECOND_PER_SECOND - (tick % RT_TICK_PER_SECOND) * MICROSECOND_PER_TICK;
-    _timevalue.tv_sec = second - tick/RT_TICK_PER_SECOND - 1;
+    clock_time_set_realtime(second);
 
     /* update for RTC device */
     device = rt_device_find("rtc");
@@ -153,3 +214,93 @@ int clock_settime(clockid_t clockid, const struct timespec *tp)
     return 0;
 }
 RTM_EXPORT(clock_settime);
+
+/* sleep until rt_clock_ns reaches expire, return 0 or EINTR */
+static int clock_time_sleep_until(rt_uint64_t expire)
+{
+#ifdef RT_USING_HRTIMER
+    if (rt_hrtimer_sleep_until(expire) != RT_EOK)
+        return EINTR;
+#else
+    rt_uint64_t now;
+
+    now = rt_clock_ns();
+    if (expire > now)
+    {
+        /* round up to tick without high-resolution timer */
+        rt_thread_delay((rt_tick_t)((expire - now + NANOSECOND_PER_TICK - 1) / NANOSECOND_PER_TICK));
+    }
+#endif
+
+    return 0;
+}
+
+int clock_nanosleep(clockid_t clockid, int flags, const struct timespec *rqtp, struct timespec *rmtp)
+{
+    rt_uint64_t ns, now, expire;
+    rt_int64_t offset;
+    int result;
+
+    if ((rqtp == RT_NULL) || (rqtp->tv_sec < 0) ||
+        (rqtp->tv_nsec < 0) || (rqtp->tv_nsec >= NANOSECOND_PER_SECOND))
+    {
+        return EINVAL;
+    }
+
+    ns  = (rt_uint64_t)rqtp->tv_sec * NANOSECOND_PER_SECOND + rqtp->tv_nsec;
+    now = rt_clock_ns();
+
+    switch (clockid)
+    {
+    case CLOCK_REALTIME:
+        if (flags & TIMER_ABSTIME)
+        {
+            /* the realtime is _timevalue + rt_clock_ns() */
+            offset = (rt_int64_t)_timevalue.tv_sec * NANOSECOND_PER_SECOND +
+                     (rt_int64_t)_timevalue.tv_usec * 1000;
+            if ((rt_int64_t)ns - offset <= (rt_int64_t)now)
+                expire = now;
+            else
+                expire = (rt_uint64_t)((rt_int64_t)ns - offset);
+        }
+        else
+        {
+            expire = now + ns;
+        }
+        break;
+
+    case CLOCK_MONOTONIC:
+        expire = (flags & TIMER_ABSTIME) ? ns : now + ns;
+        break;
+
+    default:
+        return EINVAL;
+    }
+
+    result = clock_time_sleep_until(expire);
+    if ((result == EINTR) && (rmtp != RT_NULL) && !(flags & TIMER_ABSTIME))
+    {
+        /* get the remaining time */
+        now = rt_clock_ns();
+        clock_time_from_ns(rmtp, expire > now ? expire - now : 0);
+    }
+
+    return result;
+}
+RTM_EXPORT(clock_nanosleep);
+
+int nanosleep(const struct timespec *rqtp, struct timespec *rmtp)
+{
+    int result;
+
+    result = clock_nanosleep(CLOCK_MONOTONIC, 0, rqtp, rmtp);
+    if (result != 0)
+    {
+        rt_set_errno(result);
+
+        return -1;
+    }
+
+    return 0;
+}
+RTM_EXPORT(nanosleep);
@@ -19,72 +19,65 @@
  *
  * Change Logs:
  * Date           Author       Notes
+ * 2026-10-19     heyuanjie    find mqueue in hashed name registry
+ * 2026-10-19     heyuanjie    get the priority and size of received message
  */
 
 #include <string.h>
 #include "mqueue.h"
 #include "pthread_internal.h"
 
-static mqd_t posix_mq_list = RT_NULL;
-static struct rt_semaphore posix_mq_lock;
-void posix_mq_system_init()
+/* the named mqueue */
+struct posix_mq_named
 {
-    rt_sem_init(&posix_mq_lock, "pmq", 1, RT_IPC_FLAG_FIFO);
-}
+    struct mqdes mqdes;
+    struct posix_name name;
+};
 
-rt_inline void posix_mq_insert(mqd_t pmq)
+static void posix_mq_destroy(struct posix_name *pn)
 {
-    pmq->next = posix_mq_list;
-    posix_mq_list = pmq;
+    struct posix_mq_named *pmq;
+
+    pmq = rt_container_of(pn, struct posix_mq_named, name);
+
+    /* delete RT-Thread message queue */
+    if (pmq->mqdes.mq != RT_NULL)
+        rt_mq_delete(pmq->mqdes.mq);
+    rt_free(pmq);
 }
 
-static void posix_mq_delete(mqd_t pmq)
+static struct posix_name *posix_mq_create(const char *name, void *arg)
 {
-    mqd_t iter;
-    if (posix_mq_list == pmq)
-    {
-        posix_mq_list = pmq->next;
+    struct posix_mq_named *pmq;
+    struct mq_attr *attr = (struct mq_attr *)arg;
 
-        rt_mq_delete(pmq->mq);
-        rt_free(pmq);
+    if (attr == RT_NULL)
+    {
+        rt_set_errno(EINVAL);
 
-        return;
+        return RT_NULL;
     }
-    for (iter = posix_mq_list; iter->next != RT_NULL; iter = iter->next)
+
+    pmq = (struct posix_mq_named *) rt_malloc (sizeof(struct posix_mq_named));
+    if (pmq == RT_NULL)
     {
-        if (iter->next == pmq)
-        {
-            /* delete this mq */
-            if (pmq->next != RT_NULL)
-                iter->next = pmq->next;
-            else
-                iter->next = RT_NULL;
-
-            /* delete RT-Thread mqueue */
-            rt_mq_delete(pmq->mq);
-            rt_free(pmq);
-
-            return ;
-        }
-    }
-}
+        rt_set_errno(ENFILE);
 
-static mqd_t posix_mq_find(const char* name)
-{
-    mqd_t iter;
-    rt_object_t object;
+        return RT_NULL;
+    }
+    pmq->name.destroy = posix_mq_destroy;
 
-    for (iter = posix_mq_list; iter != RT_NULL; iter = iter->next)
+    /* create RT-Thread message queue */
+    pmq->mqdes.mq = rt_mq_create(name, attr->mq_msgsize, attr->mq_maxmsg, RT_IPC_FLAG_FIFO);
+    if (pmq->mqdes.mq == RT_NULL) /* create failed */
     {
-        object = (rt_object_t)(iter->mq);
+        posix_mq_destroy(&(pmq->name));
+        rt_set_errno(ENFILE);
 
-        if (strncmp(object->name, name, RT_NAME_MAX) == 0)
-        {
-            return iter;
-        }
+        return RT_NULL;
     }
 
-    return RT_NULL;
+    return &(pmq->name);
 }
 
 int mq_setattr(mqd_t                 mqdes,
@@ -117,15 +110,11 @@ RTM_EXPORT(mq_getattr);
 
 mqd_t mq_open(const char *name, int oflag, ...)
 {
-    mqd_t mqdes;
+    struct posix_name *pn;
     va_list arg;
     mode_t mode;
     struct mq_attr *attr = RT_NULL;
 
-    /* lock posix mqueue list */
-    rt_sem_take(&posix_mq_lock, RT_WAITING_FOREVER);
-
-    mqdes = RT_NULL;
     if (oflag & O_CREAT)
     {
         va_start(arg, oflag);
@@ -133,75 +122,21 @@ mqd_t mq_open(const char *name, int oflag, ...)
         mode = mode;
         attr = (struct mq_attr *)va_arg(arg, struct mq_attr *);
         va_end(arg);
-
-        if (oflag & O_EXCL)
-        {
-            if (posix_mq_find(name) != RT_NULL)
-            {
-                rt_set_errno(EEXIST);
-                goto __return;
-            }
-        }
-        mqdes = (mqd_t) rt_malloc (sizeof(struct mqdes));
-        if (mqdes == RT_NULL)
-        {
-            rt_set_errno(ENFILE);
-            goto __return;
-        }
-
-        /* create RT-Thread message queue */
-        mqdes->mq = rt_mq_create(name, attr->mq_msgsize, attr->mq_maxmsg, RT_IPC_FLAG_FIFO);
-        if (mqdes->mq == RT_NULL) /* create failed */
-        {
-            rt_set_errno(ENFILE);
-            goto __return;
-        }
-        /* initialize reference count */
-        mqdes->refcount = 1;
-        mqdes->unlinked = 0;
-
-        /* insert mq to posix mq list */
-        posix_mq_insert(mqdes);
-    }
-    else
-    {
-        /* find mqueue */
-        mqdes = posix_mq_find(name);
-        if (mqdes != RT_NULL)
-        {
-            mqdes->refcount ++; /* increase reference count */
-        }
-        else
-        {
-            rt_set_errno(ENOENT);
-            goto __return;
-        }
     }
-    rt_sem_release(&posix_mq_lock);
 
-    return mqdes;
+    pn = posix_name_open(name, POSIX_NAME_MQ, oflag, posix_mq_create, attr);
+    if (pn == RT_NULL)
+        return RT_NULL;
 
-__return:
-    /* release lock */
-    rt_sem_release(&posix_mq_lock);
-
-    /* release allocated memory */
-    if (mqdes != RT_NULL)
-    {
-        if (mqdes->mq != RT_NULL)
-        {
-            /* delete RT-Thread message queue */
-            rt_mq_delete(mqdes->mq);
-        }
-        rt_free(mqdes);
-    }
-    return RT_NULL;
+    return &(rt_container_of(pn, struct posix_mq_named, name)->mqdes);
 }
 RTM_EXPORT(mq_open);
 
 ssize_t mq_receive(mqd_t mqdes, char *msg_ptr, size_t msg_len, unsigned *msg_prio)
 {
     rt_err_t result;
+    rt_size_t length;
+    int prio;
 
     if ((mqdes == RT_NULL) || (msg_ptr == RT_NULL))
     {
@@ -210,9 +145,15 @@ ssize_t mq_receive(mqd_t mqdes, char *msg_ptr, size_t msg_len, unsigned *msg_pri
         return -1;
     }
 
-    result = rt_mq_recv(mqdes->mq, msg_ptr, msg_len, RT_WAITING_FOREVER);
+    result = rt_mq_recv_prio(mqdes->mq, msg_ptr, msg_len, &prio, &length, RT_WAITING_FOREVER);
     if (result == RT_EOK)
-        return msg_len;
+    {
+        /* the larger number is the higher priority in POSIX */
+        if (msg_prio != RT_NULL)
+            *msg_prio = RT_MQ_PRIO_MAX - 1 - prio;
+
+        return length;
+    }
 
     rt_set_errno(EBADF);
     return -1;
@@ -230,7 +171,16 @@ int mq_send(mqd_t mqdes, const char *msg_ptr, size_t msg_len, unsigned msg_prio)
         return -1;
     }
 
-    result = rt_mq_send(mqdes->mq, (void*)msg_ptr, msg_len);
+    /* the larger number is the higher priority in POSIX */
+    if (msg_prio >= RT_MQ_PRIO_MAX)
+    {
+        rt_set_errno(EINVAL);
+
+        return -1;
+    }
+
+    result = rt_mq_send_prio(mqdes->mq, (void*)msg_ptr, msg_len,
+                             RT_MQ_PRIO_MAX - 1 - msg_prio);
     if (result == RT_EOK)
         return 0;
 
@@ -248,6 +198,8 @@ ssize_t mq_timedreceive(mqd_t                  mqdes,
 {
     int tick;
     rt_err_t result;
+    rt_size_t length;
+    int prio;
 
     /* parameters check */
     if ((mqdes == RT_NULL) || (msg_ptr == RT_NULL))
@@ -259,9 +211,14 @@ ssize_t mq_timedreceive(mqd_t                  mqdes,
 
     tick = clock_time_to_tick(abs_timeout);
 
-    result = rt_mq_recv(mqdes->mq, msg_ptr, msg_len, tick);
+    result = rt_mq_recv_prio(mqdes->mq, msg_ptr, msg_len, &prio, &length, tick);
     if (result == RT_EOK)
-        return msg_len;
+    {
+        if (msg_prio != RT_NULL)
+            *msg_prio = RT_MQ_PRIO_MAX - 1 - prio;
+
+        return length;
+    }
 
     if (result == -RT_ETIMEOUT)
         rt_set_errno(ETIMEDOUT);
@@ -300,16 +257,7 @@ int mq_close(mqd_t mqdes)
         return -1;
     }
 
-    /* lock posix mqueue list */
-    rt_sem_take(&posix_mq_lock, RT_WAITING_FOREVER);
-    mqdes->refcount --;
-    if (mqdes->refcount == 0)
-    {
-        /* delete from posix mqueue list */
-        if (mqdes->unlinked)
-            posix_mq_delete(mqdes);
-    }
-    rt_sem_release(&posix_mq_lock);
+    posix_name_close(&(rt_container_of(mqdes, struct posix_mq_named, mqdes)->name));
 
     return 0;
 }
@@ -317,28 +265,6 @@ RTM_EXPORT(mq_close);
 
 int mq_unlink(const char *name)
 {
-    mqd_t pmq;
-
-    /* lock posix mqueue list */
-    rt_sem_take(&posix_mq_lock, RT_WAITING_FOREVER);
-    pmq = posix_mq_find(name);
-    if (pmq != RT_NULL)
-    {
-        pmq->unlinked = 1;
-        if (pmq->refcount == 0)
-        {
-            /* remove this mqueue */
-            posix_mq_delete(pmq);
-        }
-        rt_sem_release(&posix_mq_lock);
-
-        return 0;
-    }
-    rt_sem_release(&posix_mq_lock);
-
-    /* no this entry */
-    rt_set_errno(ENOENT);
-
-    return -1;
+    return posix_name_unlink(name, POSIX_NAME_MQ);
 }
 RTM_EXPORT(mq_unlink);
@@ -19,6 +19,7 @@
  *
  * Change Logs:
  * Date           Author       Notes
+ * 2026-10-19     heyuanjie    named mqueue is kept in name registry
  */
 
 #ifndef __MQUEUE_H__
@@ -29,14 +30,8 @@
 
 struct mqdes
 {
-    /* reference count and unlinked */
-    rt_uint16_t refcount;
-    rt_uint16_t unlinked;
-
     /* RT-Thread message queue */
     rt_mq_t mq;
-    /* next posix mqueue */
-    struct mqdes* next;
 };
 typedef struct mqdes* mqd_t;
 
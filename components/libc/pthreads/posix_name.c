@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ * 2026-10-19     heyuanjie    add posix_name_dup for shared memory
+ */
+
+#include <rtthread.h>
+#include <string.h>
+#include "pthread_internal.h"
+
+#ifndef POSIX_NAME_HASH_SIZE
+#define POSIX_NAME_HASH_SIZE    32
+#endif
+
+/* the named objects hashed by type and name */
+static rt_list_t posix_name_hash[POSIX_NAME_HASH_SIZE];
+static struct rt_semaphore posix_name_lock;
+
+void posix_name_system_init(void)
+{
+    int index;
+
+    for (index = 0; index < POSIX_NAME_HASH_SIZE; index ++)
+        rt_list_init(&posix_name_hash[index]);
+
+    rt_sem_init(&posix_name_lock, "pnam", 1, RT_IPC_FLAG_FIFO);
+}
+
+static rt_uint32_t posix_name_hash_value(const char *name, int type)
+{
+    rt_uint32_t hash = (rt_uint32_t)type;
+
+    while (*name)
+        hash = hash * 31 + (rt_uint8_t)*name ++;
+
+    return hash;
+}
+
+static struct posix_name *posix_name_find(const char *name, int type, rt_uint32_t hash)
+{
+    struct posix_name *pn;
+    rt_list_t *bucket, *node;
+
+    bucket = &posix_name_hash[hash % POSIX_NAME_HASH_SIZE];
+    for (node = bucket->next; node != bucket; node = node->next)
+    {
+        pn = rt_list_entry(node, struct posix_name, list);
+        if (pn->hash == hash && pn->type == type && strcmp(pn->name, name) == 0)
+            return pn;
+    }
+
+    return RT_NULL;
+}
+
+/**
+ * This function will open a named object. The object is found by name, or
+ * created by the create function with O_CREAT when it's not found. The
+ * name registry is locked during open, so only one object is created
+ * for a name.
+ *
+ * @param name the object name
+ * @param type the name space, POSIX_NAME_SEM etc.
+ * @param oflag O_CREAT and O_EXCL are used
+ * @param create the function to create object, which sets destroy function
+ * @param arg the parameter of create function
+ *
+ * @return the name entry of object with a reference taken, RT_NULL on
+ *         failure and errno is set.
+ */
+struct posix_name *posix_name_open(const char *name, int type, int oflag,
+                                   struct posix_name *(*create)(const char *name, void *arg),
+                                   void *arg)
+{
+    struct posix_name *pn;
+    rt_uint32_t hash;
+
+    if (name == RT_NULL)
+    {
+        rt_set_errno(EINVAL);
+
+        return RT_NULL;
+    }
+
+    hash = posix_name_hash_value(name, type);
+
+    /* lock name registry */
+    rt_sem_take(&posix_name_lock, RT_WAITING_FOREVER);
+    pn = posix_name_find(name, type, hash);
+    if (pn != RT_NULL)
+    {
+        if ((oflag & O_CREAT) && (oflag & O_EXCL))
+        {
+            rt_set_errno(EEXIST);
+            pn = RT_NULL;
+        }
+        else
+        {
+            pn->refcount ++; /* increase reference count */
+        }
+    }
+    else if (oflag & O_CREAT)
+    {
+        pn = create(name, arg);
+        if (pn != RT_NULL)
+        {
+            pn->name = rt_strdup(name);
+            if (pn->name == RT_NULL)
+            {
+                pn->destroy(pn);
+                pn = RT_NULL;
+
+                rt_set_errno(ENFILE);
+            }
+            else
+            {
+                pn->hash = hash;
+                pn->type = type;
+                pn->refcount = 1;
+                pn->unlinked = 0;
+                rt_list_insert_after(&posix_name_hash[hash % POSIX_NAME_HASH_SIZE], &(pn->list));
+            }
+        }
+    }
+    else
+    {
+        rt_set_errno(ENOENT);
+    }
+    rt_sem_release(&posix_name_lock);
+
+    return pn;
+}
+
+/**
+ * This function will take one more reference of an opened object, such as
+ * a mapping of shared memory which is kept after the object is closed.
+ *
+ * @param pn the name entry of object
+ */
+void posix_name_dup(struct posix_name *pn)
+{
+    RT_ASSERT(pn != RT_NULL);
+
+    rt_sem_take(&posix_name_lock, RT_WAITING_FOREVER);
+    pn->refcount ++;
+    rt_sem_release(&posix_name_lock);
+}
+
+static void posix_name_destroy(struct posix_name *pn)
+{
+    rt_free(pn->name);
+    pn->name = RT_NULL;
+    pn->destroy(pn);
+}
+
+/**
+ * This function will release a reference of named object. The object is
+ * destroyed when it's unlinked and no reference is left.
+ *
+ * @param pn the name entry of object
+ */
+void posix_name_close(struct posix_name *pn)
+{
+    int destroy = 0;
+
+    RT_ASSERT(pn != RT_NULL);
+
+    rt_sem_take(&posix_name_lock, RT_WAITING_FOREVER);
+    pn->refcount --;
+    if (pn->refcount == 0 && pn->unlinked)
+        destroy = 1;
+    rt_sem_release(&posix_name_lock);
+
+    if (destroy)
+        posix_name_destroy(pn);
+}
+
+/**
+ * This function will remove a name. The object opened is still used until
+ * it's closed, and an object created later with this name is a new one.
+ *
+ * @param name the object name
+ * @param type the name space, POSIX_NAME_SEM etc.
+ *
+ * @return 0 on OK, -1 when there is no such name and errno is set.
+ */
+int posix_name_unlink(const char *name, int type)
+{
+    struct posix_name *pn;
+    int destroy = 0;
+
+    if (name == RT_NULL)
+    {
+        rt_set_errno(ENOENT);
+
+        return -1;
+    }
+
+    rt_sem_take(&posix_name_lock, RT_WAITING_FOREVER);
+    pn = posix_name_find(name, type, posix_name_hash_value(name, type));
+    if (pn != RT_NULL)
+    {
+        rt_list_remove(&(pn->list));
+        pn->unlinked = 1;
+        if (pn->refcount == 0)
+            destroy = 1;
+    }
+    rt_sem_release(&posix_name_lock);
+
+    if (pn == RT_NULL)
+    {
+        /* no this entry */
+        rt_set_errno(ENOENT);
+
+        return -1;
+    }
+
+    if (destroy)
+        posix_name_destroy(pn);
+
+    return 0;
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ */
+
+#ifndef __POSIX_NAME_H__
+#define __POSIX_NAME_H__
+
+#include <rtthread.h>
+
+/* the name spaces of named objects */
+#define POSIX_NAME_SEM  1
+#define POSIX_NAME_MQ   2
+#define POSIX_NAME_SHM  3
+
+/* the name entry embedded in a named object */
+struct posix_name
+{
+    rt_list_t list;                 /* the list of hash bucket */
+    char *name;
+    rt_uint32_t hash;
+
+    rt_uint16_t refcount;
+    rt_uint8_t unlinked;
+    rt_uint8_t type;
+
+    /* release the object when it's unlinked and closed */
+    void (*destroy)(struct posix_name *pn);
+};
+
+struct posix_name *posix_name_open(const char *name, int type, int oflag,
+                                   struct posix_name *(*create)(const char *name, void *arg),
+                                   void *arg);
+void posix_name_dup(struct posix_name *pn);
+void posix_name_close(struct posix_name *pn);
+int posix_name_unlink(const char *name, int type);
+
+void posix_name_system_init(void);
+
+#endif
@@ -19,8 +19,11 @@
  *
  * Change Logs:
  * Date           Author       Notes
+ * 2026-10-19     heyuanjie    create pthread from thread cache, embed the
+ *                             joinable semaphore, exit by rt_thread_exit.
  */
 
+#include <rthw.h>
 #include <pthread.h>
 #include <sched.h>
 #include "pthread_internal.h"
@@ -32,15 +35,72 @@ int pthread_system_init(void)
 
     /* initialize key area */
     pthread_key_system_init();
-    /* initialize posix mqueue */
-    posix_mq_system_init();
-    /* initialize posix semaphore */
-    posix_sem_system_init();
+    /* initialize name registry of posix mqueue and semaphore */
+    posix_name_system_init();
 
     return 0;
 }
 INIT_COMPONENT_EXPORT(pthread_system_init);
 
+#ifdef RT_USING_THREAD_CACHE
+#ifndef RT_THREAD_CACHE_DEPTH
+#define RT_THREAD_CACHE_DEPTH   4
+#endif
+
+/* the released posix thread data */
+static _pthread_data_t *_pthread_data_cache[RT_THREAD_CACHE_DEPTH];
+static int _pthread_data_cached = 0;
+#endif
+
+static _pthread_data_t *_pthread_data_alloc(void)
+{
+#ifdef RT_USING_THREAD_CACHE
+    _pthread_data_t *ptd = RT_NULL;
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    if (_pthread_data_cached > 0)
+        ptd = _pthread_data_cache[-- _pthread_data_cached];
+    rt_hw_interrupt_enable(level);
+
+    if (ptd != RT_NULL)
+        return ptd;
+#endif
+
+    return (_pthread_data_t*)rt_malloc(sizeof(_pthread_data_t));
+}
+
+static void _pthread_data_free(_pthread_data_t *ptd)
+{
+#ifdef RT_USING_THREAD_CACHE
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    if (_pthread_data_cached < RT_THREAD_CACHE_DEPTH)
+    {
+        /* it's no more a valid posix thread */
+        ptd->magic = 0;
+        _pthread_data_cache[_pthread_data_cached ++] = ptd;
+        ptd = RT_NULL;
+    }
+    rt_hw_interrupt_enable(level);
+
+    if (ptd == RT_NULL)
+        return;
+#endif
+
+    rt_free(ptd);
+}
+
+/* release the thread object and the stack allocated by pthread_create */
+static void _pthread_thread_free(_pthread_data_t *ptd)
+{
+    if (ptd->attr.stack_base == 0)
+        rt_thread_free(ptd->tid);
+    else
+        rt_free(ptd->tid);
+}
+
 static void _pthread_cleanup(rt_thread_t tid)
 {
     _pthread_data_t *ptd;
@@ -77,7 +137,7 @@ int pthread_create(pthread_t            *tid,
                    void *(*start) (void *), void *parameter)
 {
     int result;
-    void *stack;
+    void *stack = RT_NULL;
     char name[RT_NAME_MAX];
     static rt_uint16_t pthread_number = 0;
     _pthread_data_t *ptd;
@@ -86,7 +146,7 @@ int pthread_create(pthread_t            *tid,
     RT_ASSERT(tid != RT_NULL);
 
     /* allocate posix thread data */
-    ptd = (_pthread_data_t*)rt_malloc(sizeof(_pthread_data_t));
+    ptd = _pthread_data_alloc();
     if (ptd == RT_NULL)
         return ENOMEM;
     /* clean posix thread data memory */
@@ -105,42 +165,32 @@ int pthread_create(pthread_t            *tid,
     }
 
     rt_snprintf(name, sizeof(name), "pth%02d", pthread_number ++);
+
+    /* pthread is a static thread object */
     if (ptd->attr.stack_base == 0)
     {
-        stack = (void*)rt_malloc(ptd->attr.stack_size);
+        /* allocate thread object with its stack */
+        ptd->tid = rt_thread_alloc(ptd->attr.stack_size);
+        if (ptd->tid != RT_NULL)
+            stack = ptd->tid->stack_addr;
     }
     else
-        stack = (void*)(ptd->attr.stack_base);
-
-    if (stack == RT_NULL) 
     {
-        rt_free(ptd);
-
-        return ENOMEM;
+        ptd->tid = (rt_thread_t) rt_malloc(sizeof(struct rt_thread));
+        stack = (void*)(ptd->attr.stack_base);
     }
 
-    /* pthread is a static thread object */
-    ptd->tid = (rt_thread_t) rt_malloc(sizeof(struct rt_thread));
     if (ptd->tid == RT_NULL)
     {
-        if (ptd->attr.stack_base == 0)
-            rt_free(stack);
-        rt_free(ptd);
+        _pthread_data_free(ptd);
 
         return ENOMEM;
     }
 
     if (ptd->attr.detachstate == PTHREAD_CREATE_JOINABLE)
     {
-        ptd->joinable_sem = rt_sem_create(name, 0, RT_IPC_FLAG_FIFO);
-        if (ptd->joinable_sem == RT_NULL)
-        {
-            if (ptd->attr.stack_base != 0)
-                rt_free(stack);
-            rt_free(ptd);
-
-            return ENOMEM;
-        }
+        rt_sem_init(&ptd->joinable, name, 0, RT_IPC_FLAG_FIFO);
+        ptd->joinable_sem = &ptd->joinable;
     }
     else
         ptd->joinable_sem = RT_NULL;
@@ -154,11 +204,10 @@ int pthread_create(pthread_t            *tid,
         stack, ptd->attr.stack_size, 
         ptd->attr.priority, 5) != RT_EOK)
     {
-        if (ptd->attr.stack_base == 0)
-            rt_free(stack);
+        _pthread_thread_free(ptd);
         if (ptd->joinable_sem != RT_NULL)
-            rt_sem_delete(ptd->joinable_sem);
-        rt_free(ptd);
+            rt_sem_detach(ptd->joinable_sem);
+        _pthread_data_free(ptd);
 
         return EINVAL;
     }
@@ -175,14 +224,14 @@ int pthread_create(pthread_t            *tid,
     if (result == RT_EOK)
         return 0;
 
-    /* start thread failed */
+    /* start thread failed, no cleanup in idle */
+    ptd->tid->cleanup = RT_NULL;
     rt_thread_detach(ptd->tid);
-    if (ptd->attr.stack_base == 0)
-        rt_free(stack);
+    _pthread_thread_free(ptd);
     if (ptd->joinable_sem != RT_NULL)
-        rt_sem_delete(ptd->joinable_sem);
+        rt_sem_detach(ptd->joinable_sem);
 
-    rt_free(ptd);
+    _pthread_data_free(ptd);
 
     return EINVAL;
 }
@@ -196,18 +245,14 @@ int pthread_detach(pthread_t thread)
 
     if ((thread->stat & RT_THREAD_STAT_MASK)== RT_THREAD_CLOSE)
     {
-        /* delete joinable semaphore */
+        /* detach joinable semaphore */
         if (ptd->joinable_sem != RT_NULL)
-            rt_sem_delete(ptd->joinable_sem);
+            rt_sem_detach(ptd->joinable_sem);
         /* detach thread object */
         rt_thread_detach(ptd->tid);
 
-        /* release thread resource */
-        if (ptd->attr.stack_base == RT_NULL)
-        {
-            /* release thread allocated stack */
-            rt_free(ptd->tid->stack_addr);
-        }
+        /* release thread object and its allocated stack */
+        _pthread_thread_free(ptd);
 
         /*
          * if this thread create the local thread data,
@@ -215,8 +260,7 @@ int pthread_detach(pthread_t thread)
          */
         if (ptd->tls != RT_NULL)
             rt_free(ptd->tls);
-        rt_free(ptd->tid);
-        rt_free(ptd);
+        _pthread_data_free(ptd);
     }
     else
     {
@@ -225,7 +269,8 @@ int pthread_detach(pthread_t thread)
         ptd->attr.detachstate = PTHREAD_CREATE_DETACHED;
 
         /* detach joinable semaphore */
-        rt_sem_delete(ptd->joinable_sem);
+        if (ptd->joinable_sem != RT_NULL)
+            rt_sem_detach(ptd->joinable_sem);
         ptd->joinable_sem = RT_NULL;
         rt_exit_critical();
     }
@@ -313,16 +358,11 @@ void pthread_exit (void *value)
         ptd->tls = RT_NULL;
     }
 
-    if (ptd->attr.detachstate == PTHREAD_CREATE_JOINABLE)
-    {
-        /* release the joinable pthread */
-        rt_sem_release(ptd->joinable_sem);
-    }
-
-    /* detach thread */
-    rt_thread_detach(ptd->tid);
-    /* reschedule thread */
-    rt_schedule();
+    /*
+     * exit as the entry returns, the joinable pthread is released
+     * or the detached pthread is deleted in the cleanup of idle.
+     */
+    rt_thread_exit();
 }
 RTM_EXPORT(pthread_exit);
 
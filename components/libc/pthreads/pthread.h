@@ -20,12 +20,14 @@
  * Change Logs:
  * Date           Author       Notes
  * 2010-10-26     Bernard      the first version
+ * 2026-10-19     heyuanjie    build mutex, condition and rwlock on futex
  */
 
 #ifndef __PTHREAD_H__
 #define __PTHREAD_H__
 
 #include <rtthread.h>
+#include <rtatomic.h>
 #include <posix_types.h>
 
 #define PTHREAD_KEY_MAX             8
@@ -96,17 +98,23 @@ struct pthread_attr
 };
 typedef struct pthread_attr pthread_attr_t;
 
+/* the locks are taken by atomic operations, and wait on futex when contended */
 struct pthread_mutex
 {
     pthread_mutexattr_t attr;
-    struct rt_mutex lock;
+    rt_atomic_t lock;       /* 0: unlocked, or the owner thread, bit 0 set when contended */
+    rt_thread_t owner;
+    rt_uint32_t hold;       /* the nested times of recursive mutex */
+    rt_uint32_t waiters;    /* the number of threads waiting on kmutex */
+    struct rt_mutex kmutex; /* the owner of a contended lock for priority inheritance */
 };
 typedef struct pthread_mutex pthread_mutex_t;
 
 struct pthread_cond
 {
     pthread_condattr_t attr;
-    struct rt_semaphore sem;
+    rt_atomic_t seq;        /* changed by each signal, the futex of waiters */
+    rt_atomic_t waiters;    /* the number of waiting threads */
 };
 typedef struct pthread_cond pthread_cond_t;
 
@@ -114,20 +122,16 @@ struct pthread_rwlock
 {
     pthread_rwlockattr_t attr;
 
-    pthread_mutex_t      rw_mutex;          /* basic lock on this struct */
-    pthread_cond_t       rw_condreaders;    /* for reader threads waiting */
-    pthread_cond_t       rw_condwriters;    /* for writer threads waiting */
-
-    int rw_nwaitreaders;    /* the number of reader threads waiting */
-    int rw_nwaitwriters;    /* the number of writer threads waiting */
-    int rw_refcount;    /* 0: unlocked, -1: locked by writer, > 0 locked by n readers */
+    rt_atomic_t rw_refcount;        /* 0: unlocked, -1: locked by writer, > 0 locked by n readers */
+    rt_atomic_t rw_nwaitreaders;    /* the number of reader threads waiting */
+    rt_atomic_t rw_nwaitwriters;    /* the number of writer threads waiting */
 };
 typedef struct pthread_rwlock pthread_rwlock_t;
 
 /* spinlock implementation, (ADVANCED REALTIME THREADS)*/
 struct pthread_spinlock
 {
-    int lock;
+    struct rt_ticket_lock lock;
 };
 typedef struct pthread_spinlock pthread_spinlock_t;
 
@@ -298,10 +302,43 @@ struct sigevent
 #ifndef CLOCK_REALTIME
 #define CLOCK_REALTIME      0
 #endif
+#ifndef CLOCK_MONOTONIC
+#define CLOCK_MONOTONIC     1
+#endif
+#ifndef CLOCK_PROCESS_CPUTIME_ID
+#define CLOCK_PROCESS_CPUTIME_ID    2
+#endif
+#ifndef CLOCK_THREAD_CPUTIME_ID
+#define CLOCK_THREAD_CPUTIME_ID     3
+#endif
+#ifndef TIMER_ABSTIME
+#define TIMER_ABSTIME       1
+#endif
 
 int clock_getres  (clockid_t clockid, struct timespec *res);
 int clock_gettime (clockid_t clockid, struct timespec *tp);
 int clock_settime (clockid_t clockid, const struct timespec *tp);
+int clock_nanosleep(clockid_t clockid, int flags, const struct timespec *rqtp, struct timespec *rmtp);
+int nanosleep(const struct timespec *rqtp, struct timespec *rmtp);
+
+#ifndef SIGEV_NONE
+#define SIGEV_NONE          1   /* No asynchronous notification */
+#define SIGEV_SIGNAL        2   /* Generate a queued signal */
+#define SIGEV_THREAD        3   /* Call a notification function */
+#endif
+#ifndef SI_TIMER
+#define SI_TIMER            3   /* Sent by expiration of a timer */
+#endif
+#ifndef DELAYTIMER_MAX
+#define DELAYTIMER_MAX      0x7fffffff
+#endif
+
+int timer_create(clockid_t clockid, struct sigevent *evp, timer_t *timerid);
+int timer_delete(timer_t timerid);
+int timer_settime(timer_t timerid, int flags, const struct itimerspec *value,
+                  struct itimerspec *ovalue);
+int timer_gettime(timer_t timerid, struct itimerspec *value);
+int timer_getoverrun(timer_t timerid);
 
 #endif
 
@@ -20,6 +20,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2010-10-26     Bernard      the first version
+ * 2026-10-19     heyuanjie    wait on futex of a sequence number
  */
 
 #include <pthread.h>
@@ -86,29 +87,19 @@ RTM_EXPORT(pthread_condattr_setpshared);
 
 int pthread_cond_init(pthread_cond_t *cond, const pthread_condattr_t *attr)
 {
-    rt_err_t result;
-    char cond_name[RT_NAME_MAX];
-    static rt_uint16_t cond_num = 0;
-
     /* parameter check */
     if (cond == RT_NULL)
         return EINVAL;
     if ((attr != RT_NULL) && (*attr != PTHREAD_PROCESS_PRIVATE))
         return EINVAL;
 
-    rt_snprintf(cond_name, sizeof(cond_name), "cond%02d", cond_num++);
-
 	if (attr == RT_NULL) /* use default value */
 		cond->attr = PTHREAD_PROCESS_PRIVATE;
 	else 
 	    cond->attr = *attr;
 
-    result = rt_sem_init(&cond->sem, cond_name, 0, RT_IPC_FLAG_FIFO);
-    if (result != RT_EOK)
-        return EINVAL;
-
-    /* detach the object from system object container */
-    rt_object_detach(&(cond->sem.parent.parent));
+    rt_atomic_store(&(cond->seq), 0);
+    rt_atomic_store(&(cond->waiters), 0);
 
     return 0;
 }
@@ -116,14 +107,12 @@ RTM_EXPORT(pthread_cond_init);
 
 int pthread_cond_destroy(pthread_cond_t *cond)
 {
-    rt_err_t result;
     if (cond == RT_NULL)
         return EINVAL;
     if (cond->attr == -1)
         return 0; /* which is not initialized */
 
-    result = rt_sem_trytake(&(cond->sem));
-    if (result != RT_EOK)
+    if (rt_atomic_load(&(cond->waiters)) != 0)
         return EBUSY;
 
     /* clean condition */
@@ -136,34 +125,15 @@ RTM_EXPORT(pthread_cond_destroy);
 
 int pthread_cond_broadcast(pthread_cond_t *cond)
 {
-    rt_err_t result;
     if (cond->attr == -1)
         pthread_cond_init(cond, RT_NULL);
 
-    rt_enter_critical();
-    while (1)
-    {
-        /* try to take condition semaphore */
-        result = rt_sem_trytake(&(cond->sem));
-        if (result == -RT_ETIMEOUT)
-        {
-            /* it's timeout, release this semaphore */
-            rt_sem_release(&(cond->sem));
-        }
-        else if (result == RT_EOK)
-        {
-            /* has taken this semaphore, release it */
-            rt_sem_release(&(cond->sem));
-            break;
-        }
-        else
-        {
-            rt_exit_critical();
-
-            return EINVAL;
-        }
-    }
-    rt_exit_critical();
+    /* no waiter, nothing to do */
+    if (rt_atomic_load(&(cond->waiters)) == 0)
+        return 0;
+
+    rt_atomic_add(&(cond->seq), 1);
+    rt_futex_wake(&(cond->seq), -1);
 
     return 0;
 }
@@ -171,15 +141,16 @@ RTM_EXPORT(pthread_cond_broadcast);
 
 int pthread_cond_signal(pthread_cond_t *cond)
 {
-    rt_err_t result;
-
     if (cond->attr == -1)
         pthread_cond_init(cond, RT_NULL);
 
-    result = rt_sem_release(&(cond->sem));
-    if (result == RT_EOK)
+    /* no waiter, nothing to do */
+    if (rt_atomic_load(&(cond->waiters)) == 0)
         return 0;
 
+    rt_atomic_add(&(cond->seq), 1);
+    rt_futex_wake(&(cond->seq), 1);
+
     return 0;
 }
 RTM_EXPORT(pthread_cond_signal);
@@ -189,6 +160,7 @@ rt_err_t _pthread_cond_timedwait(pthread_cond_t  *cond,
                                  rt_int32_t       timeout)
 {
     rt_err_t result;
+    rt_atomic_t seq;
 
     if (!cond || !mutex)
         return -RT_ERROR;
@@ -197,16 +169,31 @@ rt_err_t _pthread_cond_timedwait(pthread_cond_t  *cond,
         pthread_cond_init(cond, RT_NULL);
 
     /* The mutex was not owned by the current thread at the time of the call. */
-    if (mutex->lock.owner != pthread_self())
+    if (mutex->owner != pthread_self())
         return -RT_ERROR;
+
+    /* a signal after the mutex is unlocked changes the sequence */
+    seq = rt_atomic_load(&(cond->seq));
+    rt_atomic_add(&(cond->waiters), 1);
+
     /* unlock a mutex failed */
     if (pthread_mutex_unlock(mutex) != 0)
+    {
+        rt_atomic_sub(&(cond->waiters), 1);
+
         return -RT_ERROR;
+    }
+
+    result = rt_futex_wait(&(cond->seq), seq, timeout);
+    rt_atomic_sub(&(cond->waiters), 1);
 
-    result = rt_sem_take(&(cond->sem), timeout);
     /* lock mutex again */
     pthread_mutex_lock(mutex);
 
+    /* it's signaled before sleeping, or a spurious wakeup */
+    if (result == -RT_EBUSY || result == -RT_EINTR)
+        result = RT_EOK;
+
     return result;
 }
 RTM_EXPORT(_pthread_cond_timedwait);
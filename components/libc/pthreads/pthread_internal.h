@@ -20,6 +20,9 @@
  * Change Logs:
  * Date           Author       Notes
  * 2010-10-26     Bernard      the first version
+ * 2026-10-19     heyuanjie    embed the joinable semaphore
+ * 2026-10-19     heyuanjie    add name registry of named objects
+ * 2026-10-19     heyuanjie    move name registry to posix_name.h
  */
 
 #ifndef __PTHREAD_INTERNAL_H__
@@ -27,6 +30,7 @@
 
 #include <rtthread.h>
 #include <pthread.h>
+#include <posix_name.h>
 
 struct _pthread_cleanup
 {
@@ -59,6 +63,7 @@ struct _pthread_data
 
     /* semaphore for joinable thread */
     rt_sem_t joinable_sem;
+    struct rt_semaphore joinable;
 
     /* cancel state and type */
     rt_uint8_t cancelstate;
@@ -84,8 +89,6 @@ rt_inline _pthread_data_t *_pthread_get_data(pthread_t thread)
 
 int clock_time_to_tick(const struct timespec *time);
 void clock_time_system_init(void);
-void posix_mq_system_init(void);
-void posix_sem_system_init(void);
 void pthread_key_system_init(void);
 
 #endif
@@ -20,6 +20,10 @@
  * Change Logs:
  * Date           Author       Notes
  * 2010-10-26     Bernard      the first version
+ * 2026-10-19     heyuanjie    take mutex by atomic operation, wait on futex
+ *                             only when it's contended.
+ * 2026-10-19     heyuanjie    wait on a kernel mutex when it's contended for
+ *                             priority inheritance.
  */
 
 #include <rtthread.h>
@@ -118,29 +122,102 @@ int pthread_mutexattr_getpshared(pthread_mutexattr_t *attr, int *pshared)
 }
 RTM_EXPORT(pthread_mutexattr_getpshared);
 
-int pthread_mutex_init(pthread_mutex_t *mutex, const pthread_mutexattr_t *attr)
+#define  MUTEX_CONTENDED        0x01
+
+/*
+ * The lock word is the owner thread. An uncontended lock is taken and
+ * released by atomic operation only. The first waiter marks it contended
+ * and hands the ownership over to the kernel mutex, so the waiters are
+ * queued by priority and the owner inherits the priority of them. It's
+ * set back to the atomic way once there is no waiter.
+ */
+static void _pthread_mutex_take(pthread_mutex_t *mutex, rt_thread_t self)
 {
-    rt_err_t result;
-    char name[RT_NAME_MAX];
-    static rt_uint16_t pthread_mutex_number = 0;
+    rt_atomic_t c = 0;
+    rt_thread_t owner;
+
+    /* the fast path, it's unlocked */
+    if (rt_atomic_compare_exchange(&(mutex->lock), &c, (rt_atomic_t)self))
+        return;
+
+    rt_enter_critical();
+    while (1)
+    {
+        c = rt_atomic_load(&(mutex->lock));
+        if (c == 0)
+        {
+            /* released before the scheduler is locked */
+            if (rt_atomic_compare_exchange(&(mutex->lock), &c, (rt_atomic_t)self))
+            {
+                rt_exit_critical();
+                return;
+            }
+        }
+        else if (c & MUTEX_CONTENDED)
+        {
+            /* the kernel mutex holds the ownership already */
+            break;
+        }
+        else if (rt_atomic_compare_exchange(&(mutex->lock), &c, c | MUTEX_CONTENDED))
+        {
+            /* the owner took it by atomic operation, make it the owner of kmutex */
+            owner = (rt_thread_t)c;
+            mutex->kmutex.owner = owner;
+            mutex->kmutex.original_priority = owner->current_priority;
+            mutex->kmutex.hold = 1;
+            mutex->kmutex.value = 0;
+            break;
+        }
+    }
+    mutex->waiters ++;
+    rt_exit_critical();
+
+    /* the owner inherits the priority while waiting */
+    while (rt_mutex_take(&(mutex->kmutex), RT_WAITING_FOREVER) != RT_EOK);
+
+    rt_enter_critical();
+    mutex->waiters --;
+    rt_atomic_store(&(mutex->lock), (rt_atomic_t)self | MUTEX_CONTENDED);
+    rt_exit_critical();
+}
+
+static void _pthread_mutex_release(pthread_mutex_t *mutex, rt_thread_t self)
+{
+    rt_atomic_t c = (rt_atomic_t)self;
+
+    /* the fast path, nobody is waiting */
+    if (rt_atomic_compare_exchange(&(mutex->lock), &c, 0))
+        return;
+
+    /* the lock word and kmutex are changed together */
+    rt_enter_critical();
+    if (mutex->waiters == 0)
+        rt_atomic_store(&(mutex->lock), 0);
+    /* wake up the waiter with the highest priority and restore ours */
+    rt_mutex_release(&(mutex->kmutex));
+    rt_exit_critical();
+}
 
+int pthread_mutex_init(pthread_mutex_t *mutex, const pthread_mutexattr_t *attr)
+{
     if (!mutex)
         return EINVAL;
 
-    /* build mutex name */
-    rt_snprintf(name, sizeof(name), "pmtx%02d", pthread_mutex_number ++);
     if (attr == RT_NULL)
         mutex->attr = pthread_default_mutexattr;
     else
         mutex->attr = *attr;
 
     /* init mutex lock */
-    result = rt_mutex_init(&(mutex->lock), name, RT_IPC_FLAG_FIFO);
-    if (result != RT_EOK)
-        return EINVAL;
+    rt_atomic_store(&(mutex->lock), 0);
+    mutex->owner = RT_NULL;
+    mutex->hold = 0;
+    mutex->waiters = 0;
 
-    /* detach the object from system object container */
-    rt_object_detach(&(mutex->lock.parent.parent));
+    /* the kernel mutex is not in the object container */
+    rt_mutex_init(&(mutex->kmutex), "pmtx", RT_IPC_FLAG_PRIO);
+    rt_object_detach(&(mutex->kmutex.parent.parent));
+    mutex->kmutex.parent.parent.type = RT_Object_Class_Mutex;
 
     return 0;
 }
@@ -152,7 +229,7 @@ int pthread_mutex_destroy(pthread_mutex_t *mutex)
         return EINVAL;
 
     /* it's busy */
-    if (mutex->lock.owner != RT_NULL)
+    if (rt_atomic_load(&(mutex->lock)) != 0)
         return EBUSY;
 
     rt_memset(mutex, 0, sizeof(pthread_mutex_t));
@@ -165,7 +242,7 @@ RTM_EXPORT(pthread_mutex_destroy);
 int pthread_mutex_lock(pthread_mutex_t *mutex)
 {
     int mtype;
-    rt_err_t result;
+    rt_thread_t self;
 
     if (!mutex)
         return EINVAL;
@@ -177,28 +254,29 @@ int pthread_mutex_lock(pthread_mutex_t *mutex)
     }
 
     mtype = mutex->attr & MUTEXATTR_TYPE_MASK;
-    rt_enter_critical();
-    if (mutex->lock.owner == rt_thread_self() &&
-        mtype != PTHREAD_MUTEX_RECURSIVE)
+    self = rt_thread_self();
+
+    /* only the owner itself sets the owner to self */
+    if (mutex->owner == self)
     {
-        rt_exit_critical();
+        if (mtype != PTHREAD_MUTEX_RECURSIVE)
+            return EDEADLK;
 
-        return EDEADLK;
-    }
-    rt_exit_critical();
+        mutex->hold ++;
 
-    result = rt_mutex_take(&(mutex->lock), RT_WAITING_FOREVER);
-    if (result == RT_EOK)
         return 0;
+    }
 
-    return EINVAL;
+    _pthread_mutex_take(mutex, self);
+    mutex->owner = self;
+    mutex->hold = 1;
+
+    return 0;
 }
 RTM_EXPORT(pthread_mutex_lock);
 
 int pthread_mutex_unlock(pthread_mutex_t *mutex)
 {
-    rt_err_t result;
-
     if (!mutex)
         return EINVAL;
     if (mutex->attr == -1)
@@ -207,7 +285,7 @@ int pthread_mutex_unlock(pthread_mutex_t *mutex)
         pthread_mutex_init(mutex, RT_NULL);
     }
 
-    if (mutex->lock.owner != rt_thread_self())
+    if (mutex->owner != rt_thread_self())
     {
         int mtype;
         mtype = mutex->attr & MUTEXATTR_TYPE_MASK;
@@ -217,22 +295,27 @@ int pthread_mutex_unlock(pthread_mutex_t *mutex)
             return EPERM;
 
         /* no thread waiting on this mutex */
-        if (mutex->lock.owner == RT_NULL)
+        if (rt_atomic_load(&(mutex->lock)) == 0)
             return 0;
+
+        return EINVAL;
     }
 
-    result = rt_mutex_release(&(mutex->lock));
-    if (result == RT_EOK)
+    if (-- mutex->hold > 0)
         return 0;
-    
-    return EINVAL;
+
+    mutex->owner = RT_NULL;
+    _pthread_mutex_release(mutex, rt_thread_self());
+
+    return 0;
 }
 RTM_EXPORT(pthread_mutex_unlock);
 
 int pthread_mutex_trylock(pthread_mutex_t *mutex)
 {
-    rt_err_t result;
     int mtype;
+    rt_thread_t self;
+    rt_atomic_t c = 0;
 
     if (!mutex)
         return EINVAL;
@@ -243,19 +326,24 @@ int pthread_mutex_trylock(pthread_mutex_t *mutex)
     }
 
     mtype = mutex->attr & MUTEXATTR_TYPE_MASK;
-    rt_enter_critical();
-    if (mutex->lock.owner == rt_thread_self() &&
-        mtype != PTHREAD_MUTEX_RECURSIVE)
+    self = rt_thread_self();
+
+    if (mutex->owner == self)
     {
-        rt_exit_critical();
+        if (mtype != PTHREAD_MUTEX_RECURSIVE)
+            return EDEADLK;
 
-        return EDEADLK;
+        mutex->hold ++;
+
+        return 0;
     }
-    rt_exit_critical();
 
-    result = rt_mutex_take(&(mutex->lock), 0);
-    if (result == RT_EOK) return 0;
+    if (!rt_atomic_compare_exchange(&(mutex->lock), &c, (rt_atomic_t)self))
+        return EBUSY;
+
+    mutex->owner = self;
+    mutex->hold = 1;
 
-    return EBUSY;
+    return 0;
 }
 RTM_EXPORT(pthread_mutex_trylock);
@@ -20,9 +20,13 @@
  * Change Logs:
  * Date           Author       Notes
  * 2010-10-26     Bernard      the first version
+ * 2026-10-19     heyuanjie    take rwlock by atomic operation, wait on futex
+ *                             only when it's contended.
+ * 2026-10-19     heyuanjie    fix lost wakeup of reader on writer timeout
  */
 
 #include <pthread.h>
+#include "pthread_internal.h"
 
 int pthread_rwlockattr_init(pthread_rwlockattr_t *attr)
 {
@@ -64,291 +68,232 @@ int pthread_rwlockattr_setpshared(pthread_rwlockattr_t *attr, int pshared)
 }
 RTM_EXPORT(pthread_rwlockattr_setpshared);
 
-int pthread_rwlock_init(pthread_rwlock_t           *rwlock,
-                        const pthread_rwlockattr_t *attr)
+/* wake up all waiters when the lock is free */
+static void _pthread_rwlock_wake(pthread_rwlock_t *rwlock)
 {
-    if (!rwlock)
-        return EINVAL;
-
-    rwlock->attr = PTHREAD_PROCESS_PRIVATE;
-    pthread_mutex_init(&(rwlock->rw_mutex), NULL);
-    pthread_cond_init(&(rwlock->rw_condreaders), NULL);
-    pthread_cond_init(&(rwlock->rw_condwriters), NULL);
-    
-    rwlock->rw_nwaitwriters = 0;
-    rwlock->rw_nwaitreaders = 0;
-    rwlock->rw_refcount = 0;
-
-    return 0;
+    if (rt_atomic_load(&rwlock->rw_nwaitwriters) > 0 ||
+        rt_atomic_load(&rwlock->rw_nwaitreaders) > 0)
+    {
+        rt_futex_wake(&rwlock->rw_refcount, -1);
+    }
 }
-RTM_EXPORT(pthread_rwlock_init);
 
-int pthread_rwlock_destroy (pthread_rwlock_t *rwlock)
+static int _pthread_rwlock_rdlock(pthread_rwlock_t      *rwlock,
+                                  const struct timespec *abstime)
 {
-    int result;
+    rt_atomic_t refcount;
+    rt_int32_t timeout;
+    rt_err_t result;
 
     if (!rwlock)
         return EINVAL;
     if (rwlock->attr == -1)
-        return 0; /* rwlock is not initialized */
-
-    if ( (result = pthread_mutex_lock(&rwlock->rw_mutex)) != 0)
-        return(result);
+        pthread_rwlock_init(rwlock, NULL);
 
-    if (rwlock->rw_refcount != 0 ||
-        rwlock->rw_nwaitreaders != 0 ||
-        rwlock->rw_nwaitwriters != 0)
+    while (1)
     {
-        result = EBUSY;
+        refcount = rt_atomic_load(&rwlock->rw_refcount);
 
-        return result;
-    }
-    else
-    {
-        /* check whether busy */
-        result = rt_sem_trytake(&(rwlock->rw_condreaders.sem));
-        if (result == RT_EOK)
+        /* give preference to waiting writers */
+        if (refcount >= 0 && rt_atomic_load(&rwlock->rw_nwaitwriters) == 0)
         {
-            result = rt_sem_trytake(&(rwlock->rw_condwriters.sem));
-            if (result == RT_EOK)
-            {
-                rt_sem_release(&(rwlock->rw_condreaders.sem));
-                rt_sem_release(&(rwlock->rw_condwriters.sem));
+            if (rt_atomic_compare_exchange(&rwlock->rw_refcount, &refcount, refcount + 1))
+                return 0;
 
-                pthread_cond_destroy(&rwlock->rw_condreaders);
-                pthread_cond_destroy(&rwlock->rw_condwriters);
-            }
-            else
-            {
-                rt_sem_release(&(rwlock->rw_condreaders.sem));
-                result = EBUSY;
-            }
+            continue;
+        }
+
+        timeout = abstime ? clock_time_to_tick(abstime) : RT_WAITING_FOREVER;
+
+        rt_atomic_add(&rwlock->rw_nwaitreaders, 1);
+
+        /*
+         * the writers holding back may have timed out before they saw this
+         * reader, nobody wakes it up then: take the lock again
+         */
+        if (refcount >= 0 && rt_atomic_load(&rwlock->rw_nwaitwriters) == 0)
+        {
+            rt_atomic_sub(&rwlock->rw_nwaitreaders, 1);
+            continue;
         }
-        else
-            result = EBUSY;
-    }
 
-    pthread_mutex_unlock(&rwlock->rw_mutex);
-    if (result == 0)
-        pthread_mutex_destroy(&rwlock->rw_mutex);
-    
-    return result;
+        /* sleep until the lock is changed */
+        result = rt_futex_wait(&rwlock->rw_refcount, refcount, timeout);
+        rt_atomic_sub(&rwlock->rw_nwaitreaders, 1);
+
+        if (result == -RT_ETIMEOUT)
+            return ETIMEDOUT;
+    }
 }
-RTM_EXPORT(pthread_rwlock_destroy);
 
-int pthread_rwlock_rdlock(pthread_rwlock_t *rwlock)
+static int _pthread_rwlock_wrlock(pthread_rwlock_t      *rwlock,
+                                  const struct timespec *abstime)
 {
-    int result;
+    rt_atomic_t refcount;
+    rt_int32_t timeout;
+    rt_err_t result;
 
     if (!rwlock)
         return EINVAL;
     if (rwlock->attr == -1)
         pthread_rwlock_init(rwlock, NULL);
 
-    if ((result = pthread_mutex_lock(&rwlock->rw_mutex)) != 0)
-        return(result);
-
-    /* give preference to waiting writers */
-    while (rwlock->rw_refcount < 0 || rwlock->rw_nwaitwriters > 0)
+    while (1)
     {
-        rwlock->rw_nwaitreaders++;
-        /* rw_mutex will be released when waiting for rw_condreaders */
-        result = pthread_cond_wait(&rwlock->rw_condreaders, &rwlock->rw_mutex);
-        /* rw_mutex should have been taken again when returned from waiting */
-        rwlock->rw_nwaitreaders--;
-        if (result != 0) /* wait error */
-            break;
-    }
+        refcount = 0;
+        if (rt_atomic_compare_exchange(&rwlock->rw_refcount, &refcount, -1))
+            return 0;
+
+        timeout = abstime ? clock_time_to_tick(abstime) : RT_WAITING_FOREVER;
 
-    /* another reader has a read lock */
-    if (result == 0)
-        rwlock->rw_refcount++;
+        rt_atomic_add(&rwlock->rw_nwaitwriters, 1);
+        /* sleep until the lock is changed */
+        result = rt_futex_wait(&rwlock->rw_refcount, refcount, timeout);
 
-    pthread_mutex_unlock(&rwlock->rw_mutex);
+        if (result == -RT_ETIMEOUT)
+        {
+            /* the readers held back by this writer go on */
+            if (rt_atomic_sub(&rwlock->rw_nwaitwriters, 1) == 1 &&
+                rt_atomic_load(&rwlock->rw_nwaitreaders) > 0)
+            {
+                rt_futex_wake(&rwlock->rw_refcount, -1);
+            }
 
-    return (result);
+            return ETIMEDOUT;
+        }
+        rt_atomic_sub(&rwlock->rw_nwaitwriters, 1);
+    }
 }
-RTM_EXPORT(pthread_rwlock_rdlock);
 
-int pthread_rwlock_tryrdlock(pthread_rwlock_t *rwlock)
+int pthread_rwlock_init(pthread_rwlock_t           *rwlock,
+                        const pthread_rwlockattr_t *attr)
 {
-    int result;
-
     if (!rwlock)
         return EINVAL;
-    if (rwlock->attr == -1)
-        pthread_rwlock_init(rwlock, NULL);
-
-    if ((result = pthread_mutex_lock(&rwlock->rw_mutex)) != 0)
-        return(result);
 
-    if (rwlock->rw_refcount < 0 || rwlock->rw_nwaitwriters > 0)
-        result = EBUSY;                 /* held by a writer or waiting writers */
-    else
-        rwlock->rw_refcount++;          /* increment count of reader locks */
+    rwlock->attr = PTHREAD_PROCESS_PRIVATE;
 
-    pthread_mutex_unlock(&rwlock->rw_mutex);
+    rt_atomic_store(&rwlock->rw_nwaitwriters, 0);
+    rt_atomic_store(&rwlock->rw_nwaitreaders, 0);
+    rt_atomic_store(&rwlock->rw_refcount, 0);
 
-    return(result);
+    return 0;
 }
-RTM_EXPORT(pthread_rwlock_tryrdlock);
+RTM_EXPORT(pthread_rwlock_init);
 
-int pthread_rwlock_timedrdlock(pthread_rwlock_t      *rwlock,
-                               const struct timespec *abstime)
+int pthread_rwlock_destroy (pthread_rwlock_t *rwlock)
 {
-    int result;
-
     if (!rwlock)
         return EINVAL;
     if (rwlock->attr == -1)
-        pthread_rwlock_init(rwlock, NULL);
-
-    if ( (result = pthread_mutex_lock(&rwlock->rw_mutex)) != 0)
-        return(result);
+        return 0; /* rwlock is not initialized */
 
-    /* give preference to waiting writers */
-    while (rwlock->rw_refcount < 0 || rwlock->rw_nwaitwriters > 0)
+    if (rt_atomic_load(&rwlock->rw_refcount) != 0 ||
+        rt_atomic_load(&rwlock->rw_nwaitreaders) != 0 ||
+        rt_atomic_load(&rwlock->rw_nwaitwriters) != 0)
     {
-        rwlock->rw_nwaitreaders++;
-        /* rw_mutex will be released when waiting for rw_condreaders */
-        result = pthread_cond_timedwait(&rwlock->rw_condreaders, &rwlock->rw_mutex, abstime);
-        /* rw_mutex should have been taken again when returned from waiting */
-        rwlock->rw_nwaitreaders--;
-        if (result != 0)
-            break;
+        return EBUSY;
     }
 
-    /* another reader has a read lock */
-    if (result == 0)
-        rwlock->rw_refcount++;
+    rwlock->attr = -1;
 
-    pthread_mutex_unlock(&rwlock->rw_mutex);
+    return 0;
+}
+RTM_EXPORT(pthread_rwlock_destroy);
 
-    return (result);
+int pthread_rwlock_rdlock(pthread_rwlock_t *rwlock)
+{
+    return _pthread_rwlock_rdlock(rwlock, RT_NULL);
 }
-RTM_EXPORT(pthread_rwlock_timedrdlock);
+RTM_EXPORT(pthread_rwlock_rdlock);
 
-int pthread_rwlock_timedwrlock(pthread_rwlock_t      *rwlock,
-                               const struct timespec *abstime)
+int pthread_rwlock_tryrdlock(pthread_rwlock_t *rwlock)
 {
-    int result;
+    rt_atomic_t refcount;
 
     if (!rwlock)
         return EINVAL;
     if (rwlock->attr == -1)
         pthread_rwlock_init(rwlock, NULL);
 
-    if ((result = pthread_mutex_lock(&rwlock->rw_mutex)) != 0)
-        return(result);
-
-    while (rwlock->rw_refcount != 0)
+    refcount = rt_atomic_load(&rwlock->rw_refcount);
+    while (refcount >= 0 && rt_atomic_load(&rwlock->rw_nwaitwriters) == 0)
     {
-        rwlock->rw_nwaitwriters++;
-        /* rw_mutex will be released when waiting for rw_condwriters */
-        result = pthread_cond_timedwait(&rwlock->rw_condwriters, &rwlock->rw_mutex, abstime);
-        /* rw_mutex should have been taken again when returned from waiting */
-        rwlock->rw_nwaitwriters--;
-        
-        if (result != 0)
-            break;
+        /* increment count of reader locks */
+        if (rt_atomic_compare_exchange(&rwlock->rw_refcount, &refcount, refcount + 1))
+            return 0;
     }
 
-    if (result == 0)
-        rwlock->rw_refcount = -1;
+    /* held by a writer or waiting writers */
+    return EBUSY;
+}
+RTM_EXPORT(pthread_rwlock_tryrdlock);
 
-    pthread_mutex_unlock(&rwlock->rw_mutex);
+int pthread_rwlock_timedrdlock(pthread_rwlock_t      *rwlock,
+                               const struct timespec *abstime)
+{
+    return _pthread_rwlock_rdlock(rwlock, abstime);
+}
+RTM_EXPORT(pthread_rwlock_timedrdlock);
 
-    return(result);
+int pthread_rwlock_timedwrlock(pthread_rwlock_t      *rwlock,
+                               const struct timespec *abstime)
+{
+    return _pthread_rwlock_wrlock(rwlock, abstime);
 }
 RTM_EXPORT(pthread_rwlock_timedwrlock);
 
 int pthread_rwlock_trywrlock(pthread_rwlock_t *rwlock)
 {
-    int result;
+    rt_atomic_t refcount = 0;
 
     if (!rwlock)
         return EINVAL;
     if (rwlock->attr == -1)
         pthread_rwlock_init(rwlock, NULL);
 
-    if ((result = pthread_mutex_lock(&rwlock->rw_mutex)) != 0)
-        return(result);
+    /* available, indicate a writer has it */
+    if (rt_atomic_compare_exchange(&rwlock->rw_refcount, &refcount, -1))
+        return 0;
 
-    if (rwlock->rw_refcount != 0)
-        result = EBUSY;                 /* held by either writer or reader(s) */
-    else
-        rwlock->rw_refcount = -1;       /* available, indicate a writer has it */
-
-    pthread_mutex_unlock(&rwlock->rw_mutex);
-
-    return(result);
+    /* held by either writer or reader(s) */
+    return EBUSY;
 }
 RTM_EXPORT(pthread_rwlock_trywrlock);
 
 int pthread_rwlock_unlock(pthread_rwlock_t *rwlock)
 {
-    int result;
+    rt_atomic_t refcount;
 
     if (!rwlock)
         return EINVAL;
     if (rwlock->attr == -1)
         pthread_rwlock_init(rwlock, NULL);
 
-    if ( (result = pthread_mutex_lock(&rwlock->rw_mutex)) != 0)
-        return(result);
-
-    if (rwlock->rw_refcount > 0)
-        rwlock->rw_refcount--;              /* releasing a reader */
-    else if (rwlock->rw_refcount == -1)
-        rwlock->rw_refcount = 0;            /* releasing a writer */
-
-    /* give preference to waiting writers over waiting readers */
-    if (rwlock->rw_nwaitwriters > 0)
+    refcount = rt_atomic_load(&rwlock->rw_refcount);
+    if (refcount == -1)
     {
-        if (rwlock->rw_refcount == 0)
-            result = pthread_cond_signal(&rwlock->rw_condwriters);
+        /* releasing a writer */
+        rt_atomic_store(&rwlock->rw_refcount, 0);
+        _pthread_rwlock_wake(rwlock);
     }
-    else if (rwlock->rw_nwaitreaders > 0)
+    else if (refcount > 0)
     {
-        result = pthread_cond_broadcast(&rwlock->rw_condreaders);
+        /* releasing a reader, the last one wakes up the waiters */
+        if (rt_atomic_sub(&rwlock->rw_refcount, 1) == 1)
+            _pthread_rwlock_wake(rwlock);
+    }
+    else
+    {
+        return EPERM;
     }
 
-    pthread_mutex_unlock(&rwlock->rw_mutex);
-
-    return(result);
+    return 0;
 }
 RTM_EXPORT(pthread_rwlock_unlock);
 
 int pthread_rwlock_wrlock(pthread_rwlock_t *rwlock)
 {
-    int result;
-
-    if (!rwlock)
-        return EINVAL;
-    if (rwlock->attr == -1)
-        pthread_rwlock_init(rwlock, NULL);
-
-    if ((result = pthread_mutex_lock(&rwlock->rw_mutex)) != 0)
-        return(result);
-
-    while (rwlock->rw_refcount != 0)
-    {
-        rwlock->rw_nwaitwriters++;
-        /* rw_mutex will be released when waiting for rw_condwriters */
-        result = pthread_cond_wait(&rwlock->rw_condwriters, &rwlock->rw_mutex);
-        /* rw_mutex should have been taken again when returned from waiting */
-        rwlock->rw_nwaitwriters--;
-        
-        if (result != 0)
-            break;
-    }
-
-    if (result == 0)
-        rwlock->rw_refcount = -1;
-
-    pthread_mutex_unlock(&rwlock->rw_mutex);
-
-    return(result);
+    return _pthread_rwlock_wrlock(rwlock, RT_NULL);
 }
 RTM_EXPORT(pthread_rwlock_wrlock);
-
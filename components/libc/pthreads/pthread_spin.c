@@ -20,6 +20,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2010-10-26     Bernard      the first version
+ * 2026-10-19     heyuanjie    use atomic ticket lock
  */
 
 #include <pthread.h>
@@ -29,7 +30,7 @@ int pthread_spin_init (pthread_spinlock_t *lock, int pshared)
     if (!lock)
         return EINVAL;
 
-    lock->lock = 0;
+    rt_ticket_lock_init(&lock->lock);
 
     return 0;
 }
@@ -47,10 +48,7 @@ int pthread_spin_lock (pthread_spinlock_t *lock)
     if (!lock)
         return EINVAL;
 
-    while (!(lock->lock))
-    {
-        lock->lock = 1;
-    }
+    rt_ticket_lock(&lock->lock);
 
     return 0;
 }
@@ -60,12 +58,8 @@ int pthread_spin_trylock (pthread_spinlock_t *lock)
     if (!lock)
         return EINVAL;
 
-    if (!(lock->lock))
-    {
-        lock->lock = 1;
-
+    if (rt_ticket_trylock(&lock->lock))
         return 0;
-    }
 
     return EBUSY;
 }
@@ -74,10 +68,10 @@ int pthread_spin_unlock (pthread_spinlock_t *lock)
 {
     if (!lock)
         return EINVAL;
-    if (!(lock->lock))
+    if (!rt_ticket_is_locked(&lock->lock))
         return EPERM;
 
-    lock->lock = 0;
+    rt_ticket_unlock(&lock->lock);
 
     return 0;
 }
@@ -20,6 +20,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2010-10-26     Bernard      the first version
+ * 2026-10-19     heyuanjie    find named semaphore in hashed name registry
  */
 
 #include <rtthread.h>
@@ -27,88 +28,62 @@
 #include "semaphore.h"
 #include "pthread_internal.h"
 
-static sem_t *posix_sem_list = RT_NULL;
-static struct rt_semaphore posix_sem_lock;
-void posix_sem_system_init()
+/* the named semaphore */
+struct posix_sem_named
 {
-    rt_sem_init(&posix_sem_lock, "psem", 1, RT_IPC_FLAG_FIFO);
-}
+    sem_t sem;
+    struct posix_name name;
+};
 
-rt_inline void posix_sem_insert(sem_t *psem)
+static void posix_sem_destroy(struct posix_name *pn)
 {
-    psem->next = posix_sem_list;
-    posix_sem_list = psem;
+    struct posix_sem_named *psem;
+
+    psem = rt_container_of(pn, struct posix_sem_named, name);
+
+    /* delete RT-Thread semaphore */
+    if (psem->sem.sem != RT_NULL)
+        rt_sem_delete(psem->sem.sem);
+    rt_free(psem);
 }
 
-static void posix_sem_delete(sem_t *psem)
+static struct posix_name *posix_sem_create(const char *name, void *arg)
 {
-    sem_t *iter;
-    if (posix_sem_list == psem)
-    {
-        posix_sem_list = psem->next;
+    struct posix_sem_named *psem;
 
-        rt_sem_delete(psem->sem);
-        rt_free(psem);
-
-        return;
-    }
-    for (iter = posix_sem_list; iter->next != RT_NULL; iter = iter->next)
+    psem = (struct posix_sem_named *) rt_malloc (sizeof(struct posix_sem_named));
+    if (psem == RT_NULL)
     {
-        if (iter->next == psem)
-        {
-            /* delete this mq */
-            if (psem->next != RT_NULL)
-                iter->next = psem->next;
-            else
-                iter->next = RT_NULL;
-
-            /* delete RT-Thread mqueue */
-            rt_sem_delete(psem->sem);
-            rt_free(psem);
-
-            return ;
-        }
-    }
-}
+        rt_set_errno(ENFILE);
 
-static sem_t *posix_sem_find(const char* name)
-{
-    sem_t *iter;
-    rt_object_t object;
+        return RT_NULL;
+    }
+    psem->name.destroy = posix_sem_destroy;
+    psem->sem.unamed = 0;
 
-    for (iter = posix_sem_list; iter != RT_NULL; iter = iter->next)
+    /* create RT-Thread semaphore */
+    psem->sem.sem = rt_sem_create(name, *(unsigned int *)arg, RT_IPC_FLAG_FIFO);
+    if (psem->sem.sem == RT_NULL) /* create failed */
     {
-        object = (rt_object_t)&(iter->sem);
+        posix_sem_destroy(&(psem->name));
+        rt_set_errno(ENFILE);
 
-        if (strncmp(object->name, name, RT_NAME_MAX) == 0)
-        {
-            return iter;
-        }
+        return RT_NULL;
     }
 
-    return RT_NULL;
+    return &(psem->name);
 }
 
 int sem_close(sem_t *sem)
 {
-    if (sem == RT_NULL)
+    if (sem == RT_NULL || sem->unamed)
     {
         rt_set_errno(EINVAL);
 
         return -1;
     }
 
-    /* lock posix semaphore list */
-    rt_sem_take(&posix_sem_lock, RT_WAITING_FOREVER);
-    sem->refcount --;
-    if (sem->refcount == 0)
-    {
-        /* delete from posix semaphore list */
-        if (sem->unlinked)
-            posix_sem_delete(sem);
-        sem = RT_NULL;
-    }
-    rt_sem_release(&posix_sem_lock);
+    posix_name_close(&(rt_container_of(sem, struct posix_sem_named, sem)->name));
 
     return 0;
 }
@@ -125,20 +100,17 @@ int sem_destroy(sem_t *sem)
         return -1;
     }
 
-    /* lock posix semaphore list */
-    rt_sem_take(&posix_sem_lock, RT_WAITING_FOREVER);
     result = rt_sem_trytake(sem->sem);
     if (result != RT_EOK)
     {
-        rt_sem_release(&posix_sem_lock);
         rt_set_errno(EBUSY);
 
         return -1;
     }
 
     /* destroy an unamed posix semaphore */
-    posix_sem_delete(sem);
-    rt_sem_release(&posix_sem_lock);
+    rt_sem_delete(sem->sem);
+    sem->sem = RT_NULL;
 
     return 0;
 }
@@ -146,29 +118,7 @@ RTM_EXPORT(sem_destroy);
 
 int sem_unlink(const char *name)
 {
-    sem_t *psem;
-
-    /* lock posix semaphore list */
-    rt_sem_take(&posix_sem_lock, RT_WAITING_FOREVER);
-    psem = posix_sem_find(name);
-    if (psem != RT_NULL)
-    {
-        psem->unlinked = 1;
-        if (psem->refcount == 0)
-        {
-            /* remove this semaphore */
-            posix_sem_delete(psem);
-        }
-        rt_sem_release(&posix_sem_lock);
-
-        return 0;
-    }
-    rt_sem_release(&posix_sem_lock);
-
-    /* no this entry */
-    rt_set_errno(ENOENT);
-
-    return -1;
+    return posix_name_unlink(name, POSIX_NAME_SEM);
 }
 RTM_EXPORT(sem_unlink);
 
@@ -200,7 +150,7 @@ int sem_init(sem_t *sem, int pshared, unsigned int value)
 
     rt_snprintf(name, sizeof(name), "psem%02d", psem_number++);
     sem->sem = rt_sem_create(name, value, RT_IPC_FLAG_FIFO);
-    if (sem == RT_NULL)
+    if (sem->sem == RT_NULL)
     {
         rt_set_errno(ENOMEM);
 
@@ -208,13 +158,7 @@ int sem_init(sem_t *sem, int pshared, unsigned int value)
     }
 
     /* initialize posix semaphore */
-    sem->refcount = 1;
-    sem->unlinked = 0;
     sem->unamed = 1;
-    /* lock posix semaphore list */
-    rt_sem_take(&posix_sem_lock, RT_WAITING_FOREVER);
-    posix_sem_insert(sem);
-    rt_sem_release(&posix_sem_lock);
 
     return 0;
 }
@@ -222,84 +166,24 @@ RTM_EXPORT(sem_init);
 
 sem_t *sem_open(const char *name, int oflag, ...)
 {
-    sem_t* sem;
+    struct posix_name *pn;
     va_list arg;
     mode_t mode;
-    unsigned int value;
-
-    sem = RT_NULL;
+    unsigned int value = 0;
 
-    /* lock posix semaphore list */
-    rt_sem_take(&posix_sem_lock, RT_WAITING_FOREVER);
     if (oflag & O_CREAT)
     {
         va_start(arg, oflag);
         mode = (mode_t) va_arg( arg, unsigned int); mode = mode;
         value = va_arg( arg, unsigned int);
         va_end(arg);
-
-        if (oflag & O_EXCL)
-        {
-            if (posix_sem_find(name) != RT_NULL)
-            {
-                rt_set_errno(EEXIST);
-                goto __return;
-            }
-        }
-        sem = (sem_t*) rt_malloc (sizeof(struct posix_sem));
-        if (sem == RT_NULL)
-        {
-            rt_set_errno(ENFILE);
-            goto __return;
-        }
-
-        /* create RT-Thread semaphore */
-        sem->sem = rt_sem_create(name, value, RT_IPC_FLAG_FIFO);
-        if (sem->sem == RT_NULL) /* create failed */
-        {
-            rt_set_errno(ENFILE);
-            goto __return;
-        }
-        /* initialize reference count */
-        sem->refcount = 1;
-        sem->unlinked = 0;
-        sem->unamed = 0;
-
-        /* insert semaphore to posix semaphore list */
-        posix_sem_insert(sem);
-    }
-    else
-    {
-        /* find semaphore */
-        sem = posix_sem_find(name);
-        if (sem != RT_NULL)
-        {
-            sem->refcount ++; /* increase reference count */
-        }
-        else
-        {
-            rt_set_errno(ENOENT);
-            goto __return;
-        }
     }
-    rt_sem_release(&posix_sem_lock);
-
-    return sem;
 
-__return:
-    /* release lock */
-    rt_sem_release(&posix_sem_lock);
-
-    /* release allocated memory */
-    if (sem != RT_NULL)
-    {
-        /* delete RT-Thread semaphore */
-        if (sem->sem != RT_NULL)
-            rt_sem_delete(sem->sem);
-        rt_free(sem);
-    }
+    pn = posix_name_open(name, POSIX_NAME_SEM, oflag, posix_sem_create, &value);
+    if (pn == RT_NULL)
+        return RT_NULL;
 
-    return RT_NULL;
+    return &(rt_container_of(pn, struct posix_sem_named, name)->sem);
 }
 RTM_EXPORT(sem_open);
 
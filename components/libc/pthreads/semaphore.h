@@ -20,6 +20,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2010-10-26     Bernard      the first version
+ * 2026-10-19     heyuanjie    named semaphore is kept in name registry
  */
 
 #ifndef __POSIX_SEMAPHORE_H__
@@ -30,16 +31,10 @@
 
 struct posix_sem
 {
-    /* reference count and unlinked */
-    rt_uint16_t refcount;
-    rt_uint8_t unlinked;
     rt_uint8_t unamed;
 
     /* RT-Thread semaphore */
     rt_sem_t sem;
-
-    /* next posix semaphore */
-    struct posix_sem* next;
 };
 typedef struct posix_sem sem_t;
 
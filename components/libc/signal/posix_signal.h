@@ -116,6 +116,7 @@ rt_sighandler_t rt_signal_install(int signo, rt_sighandler_t handler);
 void rt_signal_mask(int signo);
 void rt_signal_unmask(int signo);
 int rt_thread_kill(rt_thread_t tid, int sig);
+int rt_thread_sigqueue(rt_thread_t tid, const rt_siginfo_t *info);
 
 int rt_system_signal_init(void);
 
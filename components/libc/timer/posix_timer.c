@@ -0,0 +1,574 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ * 2026-10-19     heyuanjie    look up the owner thread before signaling it
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#include <pthread.h>
+#include <signal.h>
+
+#ifndef POSIX_TIMER_MAX
+#define POSIX_TIMER_MAX                 16
+#endif
+
+#ifndef POSIX_TIMER_THREAD_NUM
+#define POSIX_TIMER_THREAD_NUM          1
+#endif
+
+#ifndef POSIX_TIMER_THREAD_STACK_SIZE
+#define POSIX_TIMER_THREAD_STACK_SIZE   2048
+#endif
+
+#ifndef POSIX_TIMER_THREAD_PRIO
+#define POSIX_TIMER_THREAD_PRIO         8
+#endif
+
+struct posix_timer
+{
+#ifdef RT_USING_HRTIMER
+    struct rt_hrtimer timer;
+#else
+    struct rt_timer timer;
+#endif
+
+    clockid_t clockid;
+    struct sigevent sigev;
+    rt_thread_t owner;              /* the thread created timer, signal goes to it while alive */
+
+    rt_uint64_t expire;             /* next expiration of rt_clock_ns */
+    rt_uint64_t interval;
+    rt_bool_t active;
+
+    /*
+     * a notification is pending from expiration until the worker takes
+     * it, the expirations meanwhile are counted as overrun.
+     */
+    rt_list_t list;
+    rt_bool_t pending;
+    int overrun;
+    int overrun_last;               /* the overrun of the last notification */
+};
+
+/* realtime = _timevalue + rt_clock_ns() */
+extern struct timeval _timevalue;
+
+static struct posix_timer *_timers[POSIX_TIMER_MAX];
+
+/* pending notifications, handled by the worker threads */
+static rt_list_t _timer_pending = RT_LIST_OBJECT_INIT(_timer_pending);
+static struct rt_semaphore _timer_sem;
+
+static struct posix_timer *posix_timer_get(timer_t timerid)
+{
+    rt_ubase_t index;
+
+    index = (rt_ubase_t)timerid;
+    if (index >= POSIX_TIMER_MAX)
+        return RT_NULL;
+
+    return _timers[index];
+}
+
+static void posix_timer_overrun(struct posix_timer *timer, rt_uint32_t count)
+{
+    if (count > (rt_uint32_t)(DELAYTIMER_MAX - timer->overrun))
+        timer->overrun = DELAYTIMER_MAX;
+    else
+        timer->overrun += count;
+}
+
+/*
+ * the owner may have exited and been freed since the timer was created, so
+ * it is looked up among the threads alive before it's touched. Interrupt is
+ * disabled or the scheduler is locked, so that it can not exit meanwhile.
+ */
+static rt_bool_t posix_timer_owner_alive(rt_thread_t owner)
+{
+    struct rt_object_information *information;
+    struct rt_list_node *node;
+    rt_bool_t alive = RT_FALSE;
+    rt_base_t level;
+
+    if (owner == RT_NULL)
+        return RT_FALSE;
+
+    information = rt_object_get_information(RT_Object_Class_Thread);
+    RT_ASSERT(information != RT_NULL);
+
+    level = rt_hw_interrupt_disable();
+    for (node = information->object_list.next;
+         node != &(information->object_list);
+         node = node->next)
+    {
+        if ((rt_thread_t)rt_list_entry(node, struct rt_object, list) == owner)
+        {
+            alive = (owner->stat & RT_THREAD_STAT_MASK) != RT_THREAD_CLOSE;
+            break;
+        }
+    }
+    rt_hw_interrupt_enable(level);
+
+    return alive;
+}
+
+/* the owner has exited, its signal timer is disarmed for good */
+static void posix_timer_orphan(struct posix_timer *timer)
+{
+#ifdef RT_USING_HRTIMER
+    rt_hrtimer_stop(&(timer->timer));
+#else
+    rt_timer_stop(&(timer->timer));
+#endif
+    timer->active = RT_FALSE;
+    timer->owner = RT_NULL;
+}
+
+/*
+ * expiration of timer, it is in interrupt or timer thread and never
+ * allocates: the timer itself is queued to workers.
+ */
+static void posix_timer_timeout(void *parameter)
+{
+    struct posix_timer *timer;
+    rt_uint32_t missed = 0;
+    rt_base_t level;
+
+    timer = (struct posix_timer *)parameter;
+
+    level = rt_hw_interrupt_disable();
+
+#ifdef RT_USING_HRTIMER
+    missed = timer->timer.overrun;
+#endif
+    if (timer->interval != 0)
+    {
+        timer->expire += (missed + 1ULL) * timer->interval;
+#ifndef RT_USING_HRTIMER
+        {
+            rt_tick_t tick;
+
+            /* the first expiration may differ from the period */
+            tick = (rt_tick_t)((timer->interval + NANOSECOND_PER_TICK - 1) / NANOSECOND_PER_TICK);
+            rt_timer_control(&(timer->timer), RT_TIMER_CTRL_SET_TIME, &tick);
+            rt_timer_control(&(timer->timer), RT_TIMER_CTRL_SET_PERIODIC, RT_NULL);
+        }
+#endif
+    }
+    else
+    {
+        timer->active = RT_FALSE;
+    }
+
+    if (timer->sigev.sigev_notify == SIGEV_NONE)
+    {
+        rt_hw_interrupt_enable(level);
+
+        return;
+    }
+
+    if (timer->pending)
+    {
+        posix_timer_overrun(timer, missed + 1);
+        rt_hw_interrupt_enable(level);
+
+        return;
+    }
+
+    posix_timer_overrun(timer, missed);
+    timer->pending = RT_TRUE;
+    rt_list_insert_before(&_timer_pending, &(timer->list));
+
+    rt_hw_interrupt_enable(level);
+
+    rt_sem_release(&_timer_sem);
+}
+
+static void posix_timer_thread_entry(void *parameter)
+{
+    struct posix_timer *timer;
+    struct sigevent sigev;
+    rt_thread_t owner;
+    rt_base_t level;
+
+    while (1)
+    {
+        rt_sem_take(&_timer_sem, RT_WAITING_FOREVER);
+
+        level = rt_hw_interrupt_disable();
+        if (rt_list_isempty(&_timer_pending))
+        {
+            /* the timer is deleted */
+            rt_hw_interrupt_enable(level);
+            continue;
+        }
+
+        timer = rt_list_first_entry(&_timer_pending, struct posix_timer, list);
+        rt_list_remove(&(timer->list));
+
+#ifdef RT_USING_SIGNALS
+        if (timer->sigev.sigev_notify == SIGEV_SIGNAL)
+        {
+            if (!posix_timer_owner_alive(timer->owner))
+            {
+                posix_timer_orphan(timer);
+                timer->pending = RT_FALSE;
+                rt_hw_interrupt_enable(level);
+                continue;
+            }
+
+            /* the signal of last expiration is not handled yet */
+            if (timer->owner->sig_pending & (1u << timer->sigev.sigev_signo))
+            {
+                posix_timer_overrun(timer, 1);
+                timer->pending = RT_FALSE;
+                rt_hw_interrupt_enable(level);
+                continue;
+            }
+        }
+#endif
+
+        timer->pending = RT_FALSE;
+        timer->overrun_last = timer->overrun;
+        timer->overrun = 0;
+
+        /* the timer may be deleted once interrupt is enabled */
+        sigev = timer->sigev;
+        owner = timer->owner;
+        rt_hw_interrupt_enable(level);
+
+        if (sigev.sigev_notify == SIGEV_THREAD)
+        {
+            sigev.sigev_notify_function(sigev.sigev_value);
+        }
+#ifdef RT_USING_SIGNALS
+        else if (sigev.sigev_notify == SIGEV_SIGNAL)
+        {
+            rt_siginfo_t si;
+
+            si.si_signo = sigev.sigev_signo;
+            si.si_code  = SI_TIMER;
+            si.si_value = sigev.sigev_value;
+
+            /* the owner can not exit while the scheduler is locked */
+            rt_enter_critical();
+            if (posix_timer_owner_alive(owner))
+                rt_thread_sigqueue(owner, &si);
+            rt_exit_critical();
+        }
+#endif
+    }
+}
+
+int posix_timer_system_init(void)
+{
+    rt_thread_t tid;
+    int index;
+
+    rt_sem_init(&_timer_sem, "ptimer", 0, RT_IPC_FLAG_FIFO);
+
+    for (index = 0; index < POSIX_TIMER_THREAD_NUM; index ++)
+    {
+        tid = rt_thread_create("ptimer", posix_timer_thread_entry, RT_NULL,
+                               POSIX_TIMER_THREAD_STACK_SIZE, POSIX_TIMER_THREAD_PRIO, 10);
+        if (tid == RT_NULL)
+            return -1;
+
+        rt_thread_startup(tid);
+    }
+
+    return 0;
+}
+INIT_COMPONENT_EXPORT(posix_timer_system_init);
+
+/* convert the time of clock to the time of rt_clock_ns */
+static rt_uint64_t posix_timer_to_clock(clockid_t clockid, int flags, const struct timespec *ts)
+{
+    rt_uint64_t ns, now;
+    rt_int64_t offset;
+
+    ns  = (rt_uint64_t)ts->tv_sec * NANOSECOND_PER_SECOND + ts->tv_nsec;
+    now = rt_clock_ns();
+
+    if (!(flags & TIMER_ABSTIME))
+        return now + ns;
+
+    if (clockid == CLOCK_MONOTONIC)
+        return ns;
+
+    offset = (rt_int64_t)_timevalue.tv_sec * NANOSECOND_PER_SECOND +
+             (rt_int64_t)_timevalue.tv_usec * 1000;
+    if ((rt_int64_t)ns - offset <= (rt_int64_t)now)
+        return now;
+
+    return (rt_uint64_t)((rt_int64_t)ns - offset);
+}
+
+static void posix_timer_to_timespec(struct timespec *ts, rt_uint64_t ns)
+{
+    ts->tv_sec  = (time_t)(ns / NANOSECOND_PER_SECOND);
+    ts->tv_nsec = (long)(ns % NANOSECOND_PER_SECOND);
+}
+
+static int posix_timer_valid(const struct timespec *ts)
+{
+    return (ts->tv_sec >= 0) && (ts->tv_nsec >= 0) && (ts->tv_nsec < NANOSECOND_PER_SECOND);
+}
+
+int timer_create(clockid_t clockid, struct sigevent *evp, timer_t *timerid)
+{
+    struct posix_timer *timer;
+    rt_base_t level;
+    int index;
+
+    if ((clockid != CLOCK_REALTIME && clockid != CLOCK_MONOTONIC) || timerid == RT_NULL)
+    {
+        rt_set_errno(EINVAL);
+
+        return -1;
+    }
+
+    if (evp != RT_NULL)
+    {
+        if ((evp->sigev_notify != SIGEV_NONE) &&
+            (evp->sigev_notify != SIGEV_SIGNAL) &&
+            (evp->sigev_notify != SIGEV_THREAD))
+        {
+            rt_set_errno(EINVAL);
+
+            return -1;
+        }
+        if ((evp->sigev_notify == SIGEV_THREAD) && (evp->sigev_notify_function == RT_NULL))
+        {
+            rt_set_errno(EINVAL);
+
+            return -1;
+        }
+#ifdef RT_USING_SIGNALS
+        if ((evp->sigev_notify == SIGEV_SIGNAL) &&
+            ((evp->sigev_signo <= 0) || (evp->sigev_signo >= RT_SIG_MAX)))
+        {
+            rt_set_errno(EINVAL);
+
+            return -1;
+        }
+#endif
+    }
+#ifndef RT_USING_SIGNALS
+    if ((evp == RT_NULL) || (evp->sigev_notify == SIGEV_SIGNAL))
+    {
+        rt_set_errno(ENOTSUP);
+
+        return -1;
+    }
+#endif
+
+    timer = (struct posix_timer *)rt_malloc(sizeof(struct posix_timer));
+    if (timer == RT_NULL)
+    {
+        rt_set_errno(EAGAIN);
+
+        return -1;
+    }
+    rt_memset(timer, 0, sizeof(struct posix_timer));
+
+    level = rt_hw_interrupt_disable();
+    for (index = 0; index < POSIX_TIMER_MAX; index ++)
+    {
+        if (_timers[index] == RT_NULL)
+        {
+            _timers[index] = timer;
+            break;
+        }
+    }
+    rt_hw_interrupt_enable(level);
+
+    if (index == POSIX_TIMER_MAX)
+    {
+        rt_free(timer);
+        rt_set_errno(EAGAIN);
+
+        return -1;
+    }
+
+    timer->clockid = clockid;
+    timer->owner = rt_thread_self();
+    rt_list_init(&(timer->list));
+    if (evp != RT_NULL)
+    {
+        timer->sigev = *evp;
+    }
+    else
+    {
+        /* the default is SIGALRM with timer id */
+        timer->sigev.sigev_notify = SIGEV_SIGNAL;
+        timer->sigev.sigev_signo = SIGALRM;
+        timer->sigev.sigev_value.sival_int = index;
+    }
+
+#ifdef RT_USING_HRTIMER
+    rt_hrtimer_init(&(timer->timer), posix_timer_timeout, timer);
+#else
+    rt_timer_init(&(timer->timer), "ptimer", posix_timer_timeout, timer,
+                  1, RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_HARD_TIMER);
+#endif
+
+    *timerid = (timer_t)(rt_ubase_t)index;
+
+    return 0;
+}
+RTM_EXPORT(timer_create);
+
+int timer_delete(timer_t timerid)
+{
+    struct posix_timer *timer;
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+
+    timer = posix_timer_get(timerid);
+    if (timer == RT_NULL)
+    {
+        rt_hw_interrupt_enable(level);
+        rt_set_errno(EINVAL);
+
+        return -1;
+    }
+    _timers[(rt_ubase_t)timerid] = RT_NULL;
+
+#ifdef RT_USING_HRTIMER
+    rt_hrtimer_stop(&(timer->timer));
+#else
+    rt_timer_detach(&(timer->timer));
+#endif
+    /* drop the pending notification */
+    rt_list_remove(&(timer->list));
+
+    rt_hw_interrupt_enable(level);
+
+    rt_free(timer);
+
+    return 0;
+}
+RTM_EXPORT(timer_delete);
+
+int timer_settime(timer_t timerid, int flags, const struct itimerspec *value,
+                  struct itimerspec *ovalue)
+{
+    struct posix_timer *timer;
+    rt_uint64_t expire, interval;
+    rt_base_t level;
+
+    timer = posix_timer_get(timerid);
+    if ((timer == RT_NULL) || (value == RT_NULL) ||
+        !posix_timer_valid(&(value->it_value)) || !posix_timer_valid(&(value->it_interval)))
+    {
+        rt_set_errno(EINVAL);
+
+        return -1;
+    }
+
+    if (ovalue != RT_NULL)
+        timer_gettime(timerid, ovalue);
+
+    interval = (rt_uint64_t)value->it_interval.tv_sec * NANOSECOND_PER_SECOND +
+               value->it_interval.tv_nsec;
+    expire = posix_timer_to_clock(timer->clockid, flags, &(value->it_value));
+
+    level = rt_hw_interrupt_disable();
+
+    /* stop timer firstly */
+#ifdef RT_USING_HRTIMER
+    rt_hrtimer_stop(&(timer->timer));
+#else
+    rt_timer_stop(&(timer->timer));
+#endif
+    timer->active = RT_FALSE;
+
+    /* a zero it_value disarms the timer */
+    if (value->it_value.tv_sec != 0 || value->it_value.tv_nsec != 0)
+    {
+        timer->expire = expire;
+        timer->interval = interval;
+        timer->active = RT_TRUE;
+
+#ifdef RT_USING_HRTIMER
+        rt_hrtimer_start(&(timer->timer), expire, interval);
+#else
+        {
+            rt_uint64_t now;
+            rt_tick_t tick;
+
+            now = rt_clock_ns();
+            tick = expire > now ? (rt_tick_t)((expire - now + NANOSECOND_PER_TICK - 1) / NANOSECOND_PER_TICK) : 1;
+            if (tick == 0) tick = 1;
+
+            rt_timer_control(&(timer->timer), RT_TIMER_CTRL_SET_TIME, &tick);
+            rt_timer_control(&(timer->timer), RT_TIMER_CTRL_SET_ONESHOT, RT_NULL);
+            rt_timer_start(&(timer->timer));
+        }
+#endif
+    }
+
+    rt_hw_interrupt_enable(level);
+
+    return 0;
+}
+RTM_EXPORT(timer_settime);
+
+int timer_gettime(timer_t timerid, struct itimerspec *value)
+{
+    struct posix_timer *timer;
+    rt_uint64_t now, expire, interval;
+    rt_bool_t active;
+    rt_base_t level;
+
+    timer = posix_timer_get(timerid);
+    if ((timer == RT_NULL) || (value == RT_NULL))
+    {
+        rt_set_errno(EINVAL);
+
+        return -1;
+    }
+
+    level = rt_hw_interrupt_disable();
+    active   = timer->active;
+    expire   = timer->expire;
+    interval = timer->interval;
+    rt_hw_interrupt_enable(level);
+
+    now = rt_clock_ns();
+    if (!active)
+        expire = now;
+    else if (expire <= now)
+        expire = now + 1; /* it is expiring, but still armed */
+
+    posix_timer_to_timespec(&(value->it_value), expire - now);
+    posix_timer_to_timespec(&(value->it_interval), active ? interval : 0);
+
+    return 0;
+}
+RTM_EXPORT(timer_gettime);
+
+int timer_getoverrun(timer_t timerid)
+{
+    struct posix_timer *timer;
+
+    timer = posix_timer_get(timerid);
+    if (timer == RT_NULL)
+    {
+        rt_set_errno(EINVAL);
+
+        return -1;
+    }
+
+    return timer->overrun_last;
+}
+RTM_EXPORT(timer_getoverrun);
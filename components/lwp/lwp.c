@@ -7,6 +7,9 @@
  * Date           Author       Notes
  * 2006-03-12     Bernard      first version
  * 2018-11-02     heyuanjie    fix complie error in iar
+ * 2026-10-19     heyuanjie    stream loader with lz4 chunk, crc32 and xip text
+ * 2026-10-19     heyuanjie    load block of lz4 frame up to 64KB by default
+ * 2026-10-19     heyuanjie    give up shared memory in cleanup of process
  */
 
 #include <rtthread.h>
@@ -18,6 +21,9 @@
 #endif
 
 #include "lwp.h"
+#ifdef LWP_USING_SHM
+#include "lwp_shm.h"
+#endif
 
 #define DBG_ENABLE
 #define DBG_SECTION_NAME    "LWP"
@@ -25,6 +31,11 @@
 #define DBG_LEVEL           DBG_WARNING
 #include <rtdbg.h>
 
+/* max size of a compressed block in image, 64KB is the least of lz4 frame */
+#ifndef LWP_LOAD_BLOCK_SIZE
+#define LWP_LOAD_BLOCK_SIZE     (64 * 1024)
+#endif
+
 extern void lwp_user_entry(void *args, const void *text, void *data);
 
 /**
@@ -82,20 +93,267 @@ static int lwp_argscopy(struct rt_lwp *lwp, int argc, char **argv)
     return 0;
 }
 
-static int lwp_load(const char *filename, struct rt_lwp *lwp, uint8_t *load_addr, size_t addr_size)
+struct lwp_loader
 {
     int fd;
+    uint8_t algo;       /* compress_encrypt_algo of image */
+    rt_bool_t check;    /* crc32 is checked */
+    uint32_t crc;
+    uint8_t *block;     /* buffer for a compressed block */
+    uint8_t *xip;       /* image address if it can be executed in place */
+    uint32_t pos;       /* file offset */
+};
+
+static const uint32_t crc32_table[16] =
+{
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+static uint32_t lwp_crc32(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    crc = ~crc;
+    while (len --)
+    {
+        crc ^= *buf ++;
+        crc = (crc >> 4) ^ crc32_table[crc & 0x0F];
+        crc = (crc >> 4) ^ crc32_table[crc & 0x0F];
+    }
+
+    return ~crc;
+}
+
+/* read from image, the crc32 is updated on the way */
+static int lwp_loader_read(struct lwp_loader *loader, void *buf, size_t len)
+{
+    int nbytes;
+
+    nbytes = read(loader->fd, buf, len);
+    if (nbytes > 0)
+    {
+        if (loader->check)
+            loader->crc = lwp_crc32(loader->crc, buf, nbytes);
+        loader->pos += nbytes;
+    }
+
+    return nbytes;
+}
+
+/* skip len bytes of image, or to the end of image if len is 0 */
+static int lwp_loader_skip(struct lwp_loader *loader, size_t len)
+{
+    uint8_t buf[64];
+    int nbytes;
+
+    if (!loader->check)
+    {
+        if (len == 0)
+            return RT_EOK;
+
+        loader->pos += len;
+
+        return lseek(loader->fd, loader->pos, SEEK_SET) < 0 ? -RT_EIO : RT_EOK;
+    }
+
+    do
+    {
+        nbytes = lwp_loader_read(loader, buf, (len && len < sizeof(buf)) ? len : sizeof(buf));
+        if (nbytes < 0)
+            return -RT_EIO;
+        if (len)
+        {
+            if (nbytes == 0)
+                return -RT_EIO;
+            len -= nbytes;
+            if (len == 0)
+                break;
+        }
+    } while (nbytes > 0);
+
+    return RT_EOK;
+}
+
+/*
+ * decompress one lz4 block to dst + out. The matches may refer to the
+ * output of former blocks, so linked blocks are supported.
+ *
+ * return the new output length, -1 on broken block.
+ */
+static int lwp_lz4_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t out, size_t size)
+{
+    const uint8_t *end = src + len;
+    uint8_t *op = dst + out;
+    uint8_t *oend = dst + size;
+    size_t length, offset;
+    uint8_t token;
+    uint8_t *match;
+
+    while (src < end)
+    {
+        token = *src ++;
+
+        /* literals */
+        length = token >> 4;
+        if (length == 15)
+        {
+            do
+            {
+                if (src >= end)
+                    return -1;
+                length += *src;
+            } while (*src ++ == 255);
+        }
+        if (length > (size_t)(end - src) || length > (size_t)(oend - op))
+            return -1;
+        rt_memcpy(op, src, length);
+        src += length;
+        op  += length;
+
+        /* the last sequence has literals only */
+        if (src >= end)
+            break;
+
+        /* match */
+        if (end - src < 2)
+            return -1;
+        offset = src[0] | (src[1] << 8);
+        src += 2;
+        if (offset == 0 || offset > (size_t)(op - dst))
+            return -1;
+
+        length = token & 0x0F;
+        if (length == 15)
+        {
+            do
+            {
+                if (src >= end)
+                    return -1;
+                length += *src;
+            } while (*src ++ == 255);
+        }
+        length += 4;
+        if (length > (size_t)(oend - op))
+            return -1;
+
+        /* the match may overlap the output */
+        match = op - offset;
+        while (length --)
+            *op ++ = *match ++;
+    }
+
+    return op - dst;
+}
+
+/* load data of a chunk into dst, which has size bytes */
+static int lwp_load_chunk(struct lwp_loader *loader, struct lwp_chunk *chunk, uint8_t *dst, size_t size)
+{
+    uint32_t remain, block;
+    int nbytes;
+    int out = 0;
+
+    if ((loader->algo & LWP_COMPRESS_MASK) == LWP_COMPRESS_NONE)
+    {
+        if (chunk->data_len > size)
+            return -RT_EINVAL;
+
+        nbytes = lwp_loader_read(loader, dst, chunk->data_len);
+        if (nbytes != chunk->data_len)
+            return -RT_EIO;
+    }
+    else
+    {
+        /* decompress block by block as they are read */
+        remain = chunk->data_len;
+        while (remain > 0)
+        {
+            if (remain < sizeof(uint32_t) ||
+                lwp_loader_read(loader, &block, sizeof(uint32_t)) != sizeof(uint32_t))
+                return -RT_EIO;
+            remain -= sizeof(uint32_t);
+
+            if ((block & ~LWP_BLOCK_STORED) > remain)
+                return -RT_EINVAL;
+            remain -= block & ~LWP_BLOCK_STORED;
+
+            if (block & LWP_BLOCK_STORED)
+            {
+                block &= ~LWP_BLOCK_STORED;
+                if (block > size - out)
+                    return -RT_EINVAL;
+
+                nbytes = lwp_loader_read(loader, dst + out, block);
+                if (nbytes != block)
+                    return -RT_EIO;
+                out += block;
+            }
+            else
+            {
+                if (block > LWP_LOAD_BLOCK_SIZE)
+                {
+                    dbg_log(DBG_ERROR, "lz4 block %d is larger than %d!\n", block, LWP_LOAD_BLOCK_SIZE);
+                    return -RT_EINVAL;
+                }
+
+                nbytes = lwp_loader_read(loader, loader->block, block);
+                if (nbytes != block)
+                    return -RT_EIO;
+
+                out = lwp_lz4_decompress(loader->block, block, dst, out, size);
+                if (out < 0)
+                    return -RT_EINVAL;
+            }
+        }
+    }
+
+    /* skip hole */
+    if ((chunk->total_len - sizeof(struct lwp_chunk) - chunk->data_len))
+    {
+        dbg_log(DBG_LOG, "skip hole %d!\n", (chunk->total_len - sizeof(struct lwp_chunk) - chunk->data_len));
+        if (lwp_loader_skip(loader, chunk->total_len - sizeof(struct lwp_chunk) - chunk->data_len) != RT_EOK)
+            return -RT_EIO;
+    }
+
+    return RT_EOK;
+}
+
+static void lwp_text_free(struct rt_lwp *lwp)
+{
+    if (lwp->text_entry == RT_NULL || (lwp->flags & LWP_FLAG_TEXT_XIP))
+        return;
+
+    dbg_log(DBG_LOG, "lwp text free: %p\n", lwp->text_entry);
+#ifdef RT_USING_CACHE
+    rt_free_align(lwp->text_entry);
+#else
+    rt_free(lwp->text_entry);
+#endif
+}
+
+/*
+ * load lwp image. The chunks are read in a stream: a compressed chunk is
+ * decompressed block by block into its place, and crc32 of image is
+ * computed as it is read. When the image is not compressed and the file
+ * can be mapped (romfs2 on flash), text is executed in place.
+ */
+static int lwp_load(const char *filename, struct rt_lwp *lwp, uint8_t *load_addr, size_t addr_size)
+{
     uint8_t *ptr;
     int result = RT_EOK;
     int nbytes;
+    int addr;
     struct lwp_header header;
     struct lwp_chunk  chunk;
+    struct lwp_loader loader;
 
     /* check file name */
     RT_ASSERT(filename != RT_NULL);
     /* check lwp control block */
     RT_ASSERT(lwp != RT_NULL);
 
+    rt_memset(&loader, 0, sizeof(loader));
+
     if (load_addr != RT_NULL)
     {
         lwp->lwp_type = LWP_TYPE_FIX_ADDR;
@@ -108,8 +366,8 @@ static int lwp_load(const char *filename, struct rt_lwp *lwp, uint8_t *load_addr
     }
 
     /* open lwp */
-    fd = open(filename, 0, O_RDONLY);
-    if (fd < 0)
+    loader.fd = open(filename, 0, O_RDONLY);
+    if (loader.fd < 0)
     {
         dbg_log(DBG_ERROR, "open file:%s failed!\n", filename);
         result = -RT_ENOSYS;
@@ -117,13 +375,14 @@ static int lwp_load(const char *filename, struct rt_lwp *lwp, uint8_t *load_addr
     }
 
     /* read lwp header */
-    nbytes = read(fd, &header, sizeof(struct lwp_header));
+    nbytes = read(loader.fd, &header, sizeof(struct lwp_header));
     if (nbytes != sizeof(struct lwp_header))
     {
         dbg_log(DBG_ERROR, "read lwp header return error size: %d!\n", nbytes);
         result = -RT_EIO;
         goto _exit;
     }
+    loader.pos = nbytes;
 
     /* check file header */
     if (header.magic != LWP_MAGIC)
@@ -133,8 +392,31 @@ static int lwp_load(const char *filename, struct rt_lwp *lwp, uint8_t *load_addr
         goto _exit;
     }
 
+    loader.algo = header.compress_encrypt_algo;
+    if ((loader.algo & LWP_ENCRYPT_MASK) != LWP_ENCRYPT_NONE ||
+        (loader.algo & LWP_COMPRESS_MASK) > LWP_COMPRESS_LZ4)
+    {
+        dbg_log(DBG_ERROR, "unsupported compress/encrypt algorithm: 0x%02X\n", loader.algo);
+        result = -RT_ENOSYS;
+        goto _exit;
+    }
+    if ((loader.algo & LWP_COMPRESS_MASK) == LWP_COMPRESS_LZ4)
+    {
+        loader.block = (uint8_t *)rt_malloc(LWP_LOAD_BLOCK_SIZE);
+        if (loader.block == RT_NULL)
+        {
+            result = -RT_ENOMEM;
+            goto _exit;
+        }
+    }
+    else if (load_addr == RT_NULL && ioctl(loader.fd, FIOMMAP, &addr) == 0)
+    {
+        loader.xip = (uint8_t *)addr;
+    }
+    loader.check = header.crc32 ? RT_TRUE : RT_FALSE;
+
     /* read text chunk info */
-    nbytes = read(fd, &chunk, sizeof(struct lwp_chunk));
+    nbytes = lwp_loader_read(&loader, &chunk, sizeof(struct lwp_chunk));
     if (nbytes != sizeof(struct lwp_chunk))
     {
         dbg_log(DBG_ERROR, "read text chunk info failed!\n");
@@ -148,56 +430,65 @@ static int lwp_load(const char *filename, struct rt_lwp *lwp, uint8_t *load_addr
     /* load text */
     {
         lwp->text_size = RT_ALIGN(chunk.data_len_space, 4);
-        if (load_addr)
-            lwp->text_entry = ptr;
+        if (loader.xip != RT_NULL && ((rt_uint32_t)(loader.xip + loader.pos) & 0x03) == 0 &&
+            chunk.data_len == chunk.data_len_space)
+        {
+            /* execute in place, text is checked in place too */
+            lwp->text_entry = loader.xip + loader.pos;
+            lwp->flags |= LWP_FLAG_TEXT_XIP;
+            dbg_log(DBG_LOG, "lwp text in place : %p, size: %d!\n", lwp->text_entry, lwp->text_size);
+
+            if (loader.check)
+                loader.crc = lwp_crc32(loader.crc, lwp->text_entry, chunk.data_len);
+            loader.pos += chunk.data_len + (chunk.total_len - sizeof(struct lwp_chunk) - chunk.data_len);
+            if (lseek(loader.fd, loader.pos, SEEK_SET) < 0)
+            {
+                result = -RT_EIO;
+                goto _exit;
+            }
+        }
         else
         {
+            if (load_addr)
+                lwp->text_entry = ptr;
+            else
+            {
 #ifdef RT_USING_CACHE
-            lwp->text_entry = (rt_uint8_t *)rt_malloc_align(lwp->text_size, RT_CPU_CACHE_LINE_SZ);
+                lwp->text_entry = (rt_uint8_t *)rt_malloc_align(lwp->text_size, RT_CPU_CACHE_LINE_SZ);
 #else
-            lwp->text_entry = (rt_uint8_t *)rt_malloc(lwp->text_size);
+                lwp->text_entry = (rt_uint8_t *)rt_malloc(lwp->text_size);
 #endif
 
-            if (lwp->text_entry == RT_NULL)
-            {
-                dbg_log(DBG_ERROR, "alloc text memory faild!\n");
-                result = -RT_ENOMEM;
-                goto _exit;
+                if (lwp->text_entry == RT_NULL)
+                {
+                    dbg_log(DBG_ERROR, "alloc text memory faild!\n");
+                    result = -RT_ENOMEM;
+                    goto _exit;
+                }
+                else
+                {
+                    dbg_log(DBG_LOG, "lwp text malloc : %p, size: %d!\n", lwp->text_entry, lwp->text_size);
+                }
             }
-            else
+            dbg_log(DBG_INFO, "load text %d  => (0x%08x, 0x%08x)\n", lwp->text_size, (uint32_t)lwp->text_entry, (uint32_t)lwp->text_entry + lwp->text_size);
+
+            result = lwp_load_chunk(&loader, &chunk, lwp->text_entry, lwp->text_size);
+            if (result != RT_EOK)
             {
-                dbg_log(DBG_LOG, "lwp text malloc : %p, size: %d!\n", lwp->text_entry, lwp->text_size);
+                dbg_log(DBG_ERROR, "read text region from file failed!\n");
+                goto _exit;
             }
-        }
-        dbg_log(DBG_INFO, "load text %d  => (0x%08x, 0x%08x)\n", lwp->text_size, (uint32_t)lwp->text_entry, (uint32_t)lwp->text_entry + lwp->text_size);
-
-        nbytes = read(fd, lwp->text_entry, chunk.data_len);
-        if (nbytes != chunk.data_len)
-        {
-            dbg_log(DBG_ERROR, "read text region from file failed!\n");
-            result = -RT_EIO;
-            goto _exit;
-        }
 #ifdef RT_USING_CACHE
-        else
-        {
             rt_hw_cpu_dcache_ops(RT_HW_CACHE_FLUSH, lwp->text_entry, lwp->text_size);
             rt_hw_cpu_icache_ops(RT_HW_CACHE_INVALIDATE, lwp->text_entry, lwp->text_size);
-        }
 #endif
 
-        if (ptr != RT_NULL) ptr += nbytes;
-
-        /* skip text hole */
-        if ((chunk.total_len - sizeof(struct lwp_chunk) - chunk.data_len))
-        {
-            dbg_log(DBG_LOG, "skip text hole %d!\n", (chunk.total_len - sizeof(struct lwp_chunk) - chunk.data_len));
-            lseek(fd, (chunk.total_len - sizeof(struct lwp_chunk) - chunk.data_len), SEEK_CUR);
+            if (ptr != RT_NULL) ptr += lwp->text_size;
         }
     }
 
     /* load data */
-    nbytes = read(fd, &chunk, sizeof(struct lwp_chunk));
+    nbytes = lwp_loader_read(&loader, &chunk, sizeof(struct lwp_chunk));
     if (nbytes != sizeof(struct lwp_chunk))
     {
         dbg_log(DBG_ERROR, "read data chunk info failed!\n");
@@ -229,33 +520,37 @@ static int lwp_load(const char *filename, struct rt_lwp *lwp, uint8_t *load_addr
         }
 
         dbg_log(DBG_INFO, "load data %d => (0x%08x, 0x%08x)\n", lwp->data_size, (uint32_t)lwp->data, (uint32_t)lwp->data + lwp->data_size);
-        nbytes = read(fd, lwp->data, chunk.data_len);
-        if (nbytes != chunk.data_len)
+        result = lwp_load_chunk(&loader, &chunk, lwp->data, lwp->data_size);
+        if (result != RT_EOK)
         {
             dbg_log(DBG_ERROR, "read data region from file failed!\n");
-            result = -RT_ERROR;
             goto _exit;
         }
     }
 
+    /* the crc32 covers all of bytes after header */
+    if (loader.check)
+    {
+        result = lwp_loader_skip(&loader, 0);
+        if (result == RT_EOK && loader.crc != header.crc32)
+        {
+            dbg_log(DBG_ERROR, "crc32 error: 0x%08x != 0x%08x\n", loader.crc, header.crc32);
+            result = -RT_EINVAL;
+        }
+    }
+
 _exit:
-    if (fd >= 0)
-        close(fd);
+    if (loader.fd >= 0)
+        close(loader.fd);
+    if (loader.block != RT_NULL)
+        rt_free(loader.block);
 
     if (result != RT_EOK)
     {
         if (lwp->lwp_type == LWP_TYPE_DYN_ADDR)
         {
             dbg_log(DBG_ERROR, "lwp dynamic load faild, %d\n", result);
-            if (lwp->text_entry)
-            {
-                dbg_log(DBG_LOG, "lwp text free: %p\n", lwp->text_entry);
-#ifdef RT_USING_CACHE
-                rt_free_align(lwp->text_entry);
-#else
-                rt_free(lwp->text_entry);
-#endif
-            }
+            lwp_text_free(lwp);
             if (lwp->data)
             {
                 dbg_log(DBG_LOG, "lwp data free: %p\n", lwp->data);
@@ -278,15 +573,7 @@ static void lwp_cleanup(struct rt_thread *tid)
     if (lwp->lwp_type == LWP_TYPE_DYN_ADDR)
     {
         dbg_log(DBG_INFO, "dynamic lwp\n");
-        if (lwp->text_entry)
-        {
-            dbg_log(DBG_LOG, "lwp text free: %p\n", lwp->text_entry);
-#ifdef RT_USING_CACHE
-            rt_free_align(lwp->text_entry);
-#else
-            rt_free(lwp->text_entry);
-#endif
-        }
+        lwp_text_free(lwp);
         if (lwp->data)
         {
             dbg_log(DBG_LOG, "lwp data free: %p\n", lwp->data);
@@ -294,6 +581,11 @@ static void lwp_cleanup(struct rt_thread *tid)
         }
     }
 
+#ifdef LWP_USING_SHM
+    /* a killed process has not released them in sys_exit */
+    lwp_shm_detach(lwp);
+#endif
+
     dbg_log(DBG_LOG, "lwp free memory pages\n");
     rt_lwp_mem_deinit(lwp);
 
@@ -334,6 +626,10 @@ int exec(char *filename, int argc, char **argv)
     if (filename == RT_NULL)
         return -RT_ERROR;
 
+#ifdef LWP_USING_SHM
+    lwp_shm_reap();
+#endif
+
     lwp = (struct rt_lwp *)rt_malloc(sizeof(struct rt_lwp));
     if (lwp == RT_NULL)
     {
@@ -364,11 +660,7 @@ int exec(char *filename, int argc, char **argv)
         }
         else
         {
-#ifdef RT_USING_CACHE
-            rt_free_align(lwp->text_entry);
-#else
-            rt_free(lwp->text_entry);
-#endif
+            lwp_text_free(lwp);
             rt_free(lwp->data);
         }
     }
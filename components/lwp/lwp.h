@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2018-06-29     heyuanjie    first version
+ * 2026-10-19     heyuanjie    add compressed image and xip text
  */
 
 #ifndef __LWP_H__
@@ -18,6 +19,25 @@
 
 #define LWP_ARG_MAX         8
 
+#define LWP_FLAG_TEXT_XIP   0x01    /* text runs in place, it is not freed */
+
+/* lwp_header.compress_encrypt_algo, compress in low 4 bits */
+#define LWP_COMPRESS_MASK   0x0F
+#define LWP_COMPRESS_NONE   0x00
+#define LWP_COMPRESS_LZ4    0x01    /* chunk data is a list of lz4 blocks */
+#define LWP_ENCRYPT_MASK    0xF0
+#define LWP_ENCRYPT_NONE    0x00
+
+/*
+ * in a compressed chunk every block has a 32 bits size word ahead, which
+ * is the block format of lz4 frame. The chunk data is the blocks of a frame
+ * made by "lz4 -B4 -BD --no-frame-crc" without the 7 bytes frame header:
+ * blocks of 64KB (larger ones need a larger LWP_LOAD_BLOCK_SIZE), linked
+ * or independent, no block checksum (-BX) and no content checksum. The end
+ * mark, a zero size word, may be kept.
+ */
+#define LWP_BLOCK_STORED    0x80000000  /* block is not compressed */
+
 #include <stdint.h>
 #include <rtthread.h>
 #include <dfs.h>
@@ -30,7 +50,7 @@ struct rt_lwp
     uint8_t lwp_type;
     uint8_t heap_cnt;
     uint8_t argc;
-    uint8_t reserv;
+    uint8_t flags;
 
 #ifdef LWP_USING_RIU
     rt_list_t hlist;                                    /**< headp list */
@@ -51,7 +71,7 @@ struct lwp_header
     uint8_t compress_encrypt_algo;
     uint16_t reserved;
 
-    uint32_t crc32;
+    uint32_t crc32;     /* crc32 of the bytes after header, 0 for not checked */
 };
 
 struct lwp_chunk
@@ -6,10 +6,14 @@
  * Change Logs:
  * Date           Author       Notes
  * 2018-06-10     Bernard      first version
+ * 2026-10-19     heyuanjie    add lwp_user_accessable
  */
 
 #include <rtthread.h>
 #include <lwp.h>
+#ifdef LWP_USING_SHM
+#include <lwp_shm.h>
+#endif
 
 #define DBG_ENABLE
 #define DBG_SECTION_NAME    "LWPMEM"
@@ -119,6 +123,60 @@ void rt_lwp_mem_deinit(struct rt_lwp *lwp)
     }
 }
 
+/* whether [start, end) is in [base, base + size) */
+static rt_bool_t lwp_range_in(rt_uint8_t *start, rt_uint8_t *end, void *base, rt_size_t size)
+{
+    return (start >= (rt_uint8_t *)base) && (end <= (rt_uint8_t *)base + size);
+}
+
+/**
+ * This function will check whether the memory of a system call argument
+ * belongs to the current process: its data, heap pages, stack or shared
+ * memory mappings.
+ *
+ * @param addr the address passed by user
+ * @param size the size of memory
+ *
+ * @return RT_TRUE if user can access it
+ */
+rt_bool_t lwp_user_accessable(void *addr, rt_size_t size)
+{
+    struct rt_lwp *lwp;
+    struct rt_list_node *node;
+    rt_thread_t tid;
+    rt_uint8_t *start, *end;
+
+    tid = rt_thread_self();
+    lwp = (struct rt_lwp *)tid->lwp;
+    start = (rt_uint8_t *)addr;
+    end = start + size;
+    if (lwp == RT_NULL || addr == RT_NULL || end < start)
+        return RT_FALSE;
+
+    if (lwp_range_in(start, end, lwp->data, lwp->data_size))
+        return RT_TRUE;
+
+    /* user runs on the stack of its thread */
+    if (lwp_range_in(start, end, tid->stack_addr, tid->stack_size))
+        return RT_TRUE;
+
+    for (node = lwp->hlist.next; node != &(lwp->hlist); node = node->next)
+    {
+        struct rt_lwp_memheap *lwp_heap;
+
+        lwp_heap = rt_list_entry(node, struct rt_lwp_memheap, mlist);
+        if (lwp_range_in(start, end, lwp_heap->start_addr, lwp_heap->pool_size))
+            return RT_TRUE;
+    }
+
+#ifdef LWP_USING_SHM
+    if (lwp_shm_accessable(lwp, addr, size))
+        return RT_TRUE;
+#endif
+
+    return RT_FALSE;
+}
+
 void *rt_lwp_mem_malloc(rt_uint32_t size)
 {
     struct rt_lwp *lwp;
@@ -18,4 +18,6 @@ extern void *rt_lwp_mem_malloc(rt_uint32_t size);
 extern void rt_lwp_mem_free(void *addr);
 extern void *rt_lwp_mem_realloc(void *rmem, rt_size_t newsize);
 
+extern rt_bool_t lwp_user_accessable(void *addr, rt_size_t size);
+
 #endif
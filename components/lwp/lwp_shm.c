@@ -0,0 +1,529 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ * 2026-10-19     heyuanjie    release the shared memory of a killed process
+ */
+
+#include <rtthread.h>
+#include <rthw.h>
+#include <string.h>
+#include <lwp.h>
+#include <lwp_shm.h>
+
+#ifdef LWP_USING_SHM
+
+#include <posix_name.h>
+
+#define DBG_ENABLE
+#define DBG_SECTION_NAME    "LWPSHM"
+#define DBG_COLOR
+#define DBG_LEVEL           DBG_WARNING
+#include <rtdbg.h>
+
+#ifndef LWP_MEM_PAGE_SIZE
+    #define LWP_MEM_PAGE_SIZE       (4 * 1024)
+#endif
+
+#ifndef LWP_SHM_HANDLE_MAX
+    #define LWP_SHM_HANDLE_MAX      32
+#endif
+
+#ifndef LWP_SHM_MAP_MAX
+    #define LWP_SHM_MAP_MAX         32
+#endif
+
+/* a shared memory object, the pages are shared by all of the mappings */
+struct lwp_shm
+{
+    struct posix_name name;
+
+    void *addr;
+    rt_size_t size;
+    rt_uint32_t nmaps;
+};
+
+/* an opened object, the index is the id returned by lwp_shm_open */
+struct lwp_shm_handle
+{
+    struct lwp_shm *shm;
+    struct rt_lwp *owner;                               /**< RT_NULL for kernel */
+};
+
+/* a mapping, it holds a reference of object until it's unmapped */
+struct lwp_shm_map
+{
+    struct lwp_shm *shm;
+    void *addr;
+    struct rt_lwp *owner;
+};
+
+/* the owner of entries left by a dead process, released by lwp_shm_reap */
+#define LWP_SHM_ORPHAN      ((struct rt_lwp *)-1)
+
+static struct lwp_shm_handle _shm_handle[LWP_SHM_HANDLE_MAX];
+static struct lwp_shm_map _shm_map[LWP_SHM_MAP_MAX];
+static struct rt_semaphore _shm_lock;
+static volatile rt_bool_t _shm_orphans;
+
+static void lwp_shm_destroy(struct posix_name *pn)
+{
+    struct lwp_shm *shm = rt_container_of(pn, struct lwp_shm, name);
+
+    if (shm->addr != RT_NULL)
+        rt_free_align(shm->addr);
+    rt_free(shm);
+}
+
+static struct posix_name *lwp_shm_create(const char *name, void *arg)
+{
+    struct lwp_shm *shm;
+
+    shm = (struct lwp_shm *)rt_malloc(sizeof(struct lwp_shm));
+    if (shm == RT_NULL)
+    {
+        rt_set_errno(ENOMEM);
+
+        return RT_NULL;
+    }
+    memset(shm, 0, sizeof(struct lwp_shm));
+    shm->name.destroy = lwp_shm_destroy;
+
+    return &(shm->name);
+}
+
+/* get the object of an id opened by current process, _shm_lock is taken */
+static struct lwp_shm *lwp_shm_get(int id)
+{
+    if (id < 0 || id >= LWP_SHM_HANDLE_MAX)
+        return RT_NULL;
+    if (_shm_handle[id].owner != rt_lwp_self())
+        return RT_NULL;
+
+    return _shm_handle[id].shm;
+}
+
+/**
+ * This function will open a shared memory object, which is created with
+ * size zero by O_CREAT.
+ *
+ * @param name the object name
+ * @param oflag O_CREAT and O_EXCL are used
+ * @param mode not used
+ *
+ * @return the id of object, or a negative errno on failure
+ */
+int lwp_shm_open(const char *name, int oflag, mode_t mode)
+{
+    struct posix_name *pn;
+    int id;
+
+    lwp_shm_reap();
+
+    pn = posix_name_open(name, POSIX_NAME_SHM, oflag, lwp_shm_create, RT_NULL);
+    if (pn == RT_NULL)
+        return -rt_get_errno();
+
+    rt_sem_take(&_shm_lock, RT_WAITING_FOREVER);
+    for (id = 0; id < LWP_SHM_HANDLE_MAX; id ++)
+    {
+        if (_shm_handle[id].shm == RT_NULL)
+        {
+            _shm_handle[id].shm = rt_container_of(pn, struct lwp_shm, name);
+            _shm_handle[id].owner = rt_lwp_self();
+            break;
+        }
+    }
+    rt_sem_release(&_shm_lock);
+
+    if (id == LWP_SHM_HANDLE_MAX)
+    {
+        dbg_log(DBG_ERROR, "no shared memory handle for %s\n", name);
+        posix_name_close(pn);
+
+        return -EMFILE;
+    }
+
+    return id;
+}
+RTM_EXPORT(lwp_shm_open);
+
+/**
+ * This function will set the size of a shared memory object. The pages are
+ * allocated in kernel and the new part of them is zeroed. There is no MMU
+ * to move the mappings, so the size of a mapped object is not changed.
+ *
+ * @param id the id of object
+ * @param length the new size in bytes
+ *
+ * @return 0 on OK, or a negative errno on failure
+ */
+int lwp_shm_ftruncate(int id, off_t length)
+{
+    struct lwp_shm *shm;
+    rt_size_t size;
+    void *addr = RT_NULL;
+    int result = 0;
+
+    if (length < 0)
+        return -EINVAL;
+
+    size = RT_ALIGN((rt_size_t)length, LWP_MEM_PAGE_SIZE);
+
+    rt_sem_take(&_shm_lock, RT_WAITING_FOREVER);
+    shm = lwp_shm_get(id);
+    if (shm == RT_NULL)
+    {
+        result = -EBADF;
+        goto __exit;
+    }
+    if (size == shm->size)
+        goto __exit;
+    if (shm->nmaps > 0)
+    {
+        result = -EBUSY;
+        goto __exit;
+    }
+
+    if (size > 0)
+    {
+        addr = rt_malloc_align(size, LWP_MEM_PAGE_SIZE);
+        if (addr == RT_NULL)
+        {
+            result = -ENOMEM;
+            goto __exit;
+        }
+
+        if (size > shm->size)
+        {
+            memcpy(addr, shm->addr, shm->size);
+            memset((rt_uint8_t *)addr + shm->size, 0, size - shm->size);
+        }
+        else
+        {
+            memcpy(addr, shm->addr, size);
+        }
+    }
+
+    if (shm->addr != RT_NULL)
+        rt_free_align(shm->addr);
+    shm->addr = addr;
+    shm->size = size;
+
+__exit:
+    rt_sem_release(&_shm_lock);
+
+    return result;
+}
+RTM_EXPORT(lwp_shm_ftruncate);
+
+/**
+ * This function will map a shared memory object. The processes share the
+ * address space, so the address of pages in kernel is returned and it's
+ * the same in every process.
+ *
+ * @param addr not used
+ * @param length the size to be mapped
+ * @param prot not used, the pages are not protected
+ * @param flags MAP_SHARED must be set
+ * @param id the id of object
+ * @param offset the offset in object
+ *
+ * @return the mapped address, or MAP_FAILED on failure
+ */
+void *lwp_shm_mmap(void *addr, size_t length, int prot, int flags, int id, off_t offset)
+{
+    struct lwp_shm *shm;
+    int index;
+
+    if (!(flags & MAP_SHARED) || length == 0 || offset < 0)
+        return MAP_FAILED;
+
+    lwp_shm_reap();
+
+    rt_sem_take(&_shm_lock, RT_WAITING_FOREVER);
+    shm = lwp_shm_get(id);
+    if (shm == RT_NULL || (rt_size_t)offset + length > shm->size)
+        goto __failed;
+
+    for (index = 0; index < LWP_SHM_MAP_MAX; index ++)
+    {
+        if (_shm_map[index].shm == RT_NULL)
+            break;
+    }
+    if (index == LWP_SHM_MAP_MAX)
+    {
+        dbg_log(DBG_ERROR, "no shared memory map for %d\n", id);
+        goto __failed;
+    }
+
+    /* the mapping is kept after the object is closed */
+    posix_name_dup(&(shm->name));
+    shm->nmaps ++;
+
+    _shm_map[index].shm = shm;
+    _shm_map[index].addr = (rt_uint8_t *)shm->addr + offset;
+    _shm_map[index].owner = rt_lwp_self();
+    rt_sem_release(&_shm_lock);
+
+    return _shm_map[index].addr;
+
+__failed:
+    rt_sem_release(&_shm_lock);
+
+    return MAP_FAILED;
+}
+RTM_EXPORT(lwp_shm_mmap);
+
+static void lwp_shm_unmap(struct lwp_shm_map *map)
+{
+    map->shm->nmaps --;
+    map->shm = RT_NULL;
+    map->addr = RT_NULL;
+    map->owner = RT_NULL;
+}
+
+/**
+ * This function will remove a mapping of shared memory object.
+ *
+ * @param addr the address returned by lwp_shm_mmap
+ * @param length not used, the whole mapping is removed
+ *
+ * @return 0 on OK, or a negative errno on failure
+ */
+int lwp_shm_munmap(void *addr, size_t length)
+{
+    struct lwp_shm *shm = RT_NULL;
+    struct rt_lwp *lwp;
+    int index;
+
+    lwp = rt_lwp_self();
+
+    rt_sem_take(&_shm_lock, RT_WAITING_FOREVER);
+    for (index = 0; index < LWP_SHM_MAP_MAX; index ++)
+    {
+        if (_shm_map[index].shm != RT_NULL &&
+            _shm_map[index].addr == addr && _shm_map[index].owner == lwp)
+        {
+            shm = _shm_map[index].shm;
+            lwp_shm_unmap(&_shm_map[index]);
+            break;
+        }
+    }
+    rt_sem_release(&_shm_lock);
+
+    if (shm == RT_NULL)
+        return -EINVAL;
+
+    posix_name_close(&(shm->name));
+
+    return 0;
+}
+RTM_EXPORT(lwp_shm_munmap);
+
+/**
+ * This function will close an opened shared memory object. The mappings
+ * of it are still used.
+ *
+ * @param id the id of object
+ *
+ * @return 0 on OK, or a negative errno on failure
+ */
+int lwp_shm_close(int id)
+{
+    struct lwp_shm *shm;
+
+    rt_sem_take(&_shm_lock, RT_WAITING_FOREVER);
+    shm = lwp_shm_get(id);
+    if (shm != RT_NULL)
+    {
+        _shm_handle[id].shm = RT_NULL;
+        _shm_handle[id].owner = RT_NULL;
+    }
+    rt_sem_release(&_shm_lock);
+
+    if (shm == RT_NULL)
+        return -EBADF;
+
+    posix_name_close(&(shm->name));
+
+    return 0;
+}
+RTM_EXPORT(lwp_shm_close);
+
+/**
+ * This function will remove the name of a shared memory object, the pages
+ * are freed when it's closed and unmapped.
+ *
+ * @param name the object name
+ *
+ * @return 0 on OK, or a negative errno on failure
+ */
+int lwp_shm_unlink(const char *name)
+{
+    if (posix_name_unlink(name, POSIX_NAME_SHM) != 0)
+        return -rt_get_errno();
+
+    return 0;
+}
+RTM_EXPORT(lwp_shm_unlink);
+
+/**
+ * This function will check whether the memory is in a mapping of process.
+ * A mapping reaches the end of its object.
+ *
+ * @param lwp the process
+ * @param addr the start of memory
+ * @param size the size of memory
+ *
+ * @return RT_TRUE if it's in a mapping
+ */
+rt_bool_t lwp_shm_accessable(struct rt_lwp *lwp, void *addr, rt_size_t size)
+{
+    struct lwp_shm *shm;
+    rt_uint8_t *start = (rt_uint8_t *)addr;
+    rt_bool_t result = RT_FALSE;
+    int index;
+
+    rt_sem_take(&_shm_lock, RT_WAITING_FOREVER);
+    for (index = 0; index < LWP_SHM_MAP_MAX; index ++)
+    {
+        shm = _shm_map[index].shm;
+        if (shm == RT_NULL || _shm_map[index].owner != lwp)
+            continue;
+
+        if (start >= (rt_uint8_t *)_shm_map[index].addr &&
+            start + size <= (rt_uint8_t *)shm->addr + shm->size)
+        {
+            result = RT_TRUE;
+            break;
+        }
+    }
+    rt_sem_release(&_shm_lock);
+
+    return result;
+}
+
+/* release the entries of an owner, in thread context for the lock may be blocked */
+static void lwp_shm_release(struct rt_lwp *owner)
+{
+    struct lwp_shm *shm;
+    int index;
+
+    for (index = 0; index < LWP_SHM_HANDLE_MAX; index ++)
+    {
+        rt_sem_take(&_shm_lock, RT_WAITING_FOREVER);
+        shm = RT_NULL;
+        if (_shm_handle[index].shm != RT_NULL && _shm_handle[index].owner == owner)
+        {
+            shm = _shm_handle[index].shm;
+            _shm_handle[index].shm = RT_NULL;
+            _shm_handle[index].owner = RT_NULL;
+        }
+        rt_sem_release(&_shm_lock);
+
+        if (shm != RT_NULL)
+            posix_name_close(&(shm->name));
+    }
+
+    for (index = 0; index < LWP_SHM_MAP_MAX; index ++)
+    {
+        rt_sem_take(&_shm_lock, RT_WAITING_FOREVER);
+        shm = RT_NULL;
+        if (_shm_map[index].shm != RT_NULL && _shm_map[index].owner == owner)
+        {
+            shm = _shm_map[index].shm;
+            lwp_shm_unmap(&_shm_map[index]);
+        }
+        rt_sem_release(&_shm_lock);
+
+        if (shm != RT_NULL)
+            posix_name_close(&(shm->name));
+    }
+}
+
+/**
+ * This function will release the handles and mappings of a process when
+ * it exits. It's called in thread context for the lock may be blocked.
+ *
+ * @param lwp the exiting process
+ */
+void lwp_shm_exit(struct rt_lwp *lwp)
+{
+    RT_ASSERT(lwp != RT_NULL);
+    RT_DEBUG_IN_THREAD_CONTEXT;
+
+    lwp_shm_release(lwp);
+}
+
+/**
+ * This function will give up the handles and mappings of a process which
+ * is deleted. It's called by the cleanup of thread, where nothing may be
+ * blocked, so the entries are only taken from the process: nobody else
+ * uses the entries of a process, the owner is changed without the lock.
+ * The objects are released by lwp_shm_reap later.
+ *
+ * @param lwp the dead process
+ */
+void lwp_shm_detach(struct rt_lwp *lwp)
+{
+    rt_base_t level;
+    int index;
+
+    RT_ASSERT(lwp != RT_NULL);
+
+    level = rt_hw_interrupt_disable();
+    for (index = 0; index < LWP_SHM_HANDLE_MAX; index ++)
+    {
+        if (_shm_handle[index].shm != RT_NULL && _shm_handle[index].owner == lwp)
+        {
+            _shm_handle[index].owner = LWP_SHM_ORPHAN;
+            _shm_orphans = RT_TRUE;
+        }
+    }
+
+    for (index = 0; index < LWP_SHM_MAP_MAX; index ++)
+    {
+        if (_shm_map[index].shm != RT_NULL && _shm_map[index].owner == lwp)
+        {
+            _shm_map[index].owner = LWP_SHM_ORPHAN;
+            _shm_orphans = RT_TRUE;
+        }
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * This function will release the entries left by dead processes. It's
+ * called in thread context before a new object or mapping, and when a
+ * process is started.
+ */
+void lwp_shm_reap(void)
+{
+    rt_base_t level;
+    rt_bool_t orphans;
+
+    RT_DEBUG_IN_THREAD_CONTEXT;
+
+    level = rt_hw_interrupt_disable();
+    orphans = _shm_orphans;
+    _shm_orphans = RT_FALSE;
+    rt_hw_interrupt_enable(level);
+
+    if (orphans)
+        lwp_shm_release(LWP_SHM_ORPHAN);
+}
+
+int lwp_shm_system_init(void)
+{
+    rt_sem_init(&_shm_lock, "lshm", 1, RT_IPC_FLAG_FIFO);
+
+    return 0;
+}
+INIT_COMPONENT_EXPORT(lwp_shm_system_init);
+
+#endif
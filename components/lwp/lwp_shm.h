@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ */
+
+#ifndef __LWP_SHM_H__
+#define __LWP_SHM_H__
+
+#include <rtthread.h>
+#include <sys/types.h>
+
+#ifndef PROT_READ
+#define PROT_NONE       0x00
+#define PROT_READ       0x01
+#define PROT_WRITE      0x02
+#define PROT_EXEC       0x04
+#endif
+
+#ifndef MAP_SHARED
+#define MAP_SHARED      0x01
+#define MAP_PRIVATE     0x02
+#endif
+
+#ifndef MAP_FAILED
+#define MAP_FAILED      ((void *)-1)
+#endif
+
+struct rt_lwp;
+
+/* the following functions return a negative errno on failure */
+int lwp_shm_open(const char *name, int oflag, mode_t mode);
+int lwp_shm_ftruncate(int id, off_t length);
+void *lwp_shm_mmap(void *addr, size_t length, int prot, int flags, int id, off_t offset);
+int lwp_shm_munmap(void *addr, size_t length);
+int lwp_shm_close(int id);
+int lwp_shm_unlink(const char *name);
+
+/* release the handles and mappings of a process */
+void lwp_shm_exit(struct rt_lwp *lwp);
+/* give them up in the cleanup of a deleted process, without blocking */
+void lwp_shm_detach(struct rt_lwp *lwp);
+/* release the ones given up */
+void lwp_shm_reap(void);
+
+/* whether the memory is in a mapping of the process */
+rt_bool_t lwp_shm_accessable(struct rt_lwp *lwp, void *addr, rt_size_t size);
+
+#endif
@@ -6,6 +6,10 @@
  * Change Logs:
  * Date           Author       Notes
  * 2018-06-10     Bernard      first version
+ * 2026-10-19     heyuanjie    nanosleep with high-resolution timer
+ * 2026-10-19     heyuanjie    add futex
+ * 2026-10-19     heyuanjie    add shared memory
+ * 2026-10-19     heyuanjie    check the address and timeout of futex
  */
 
 /* RT-Thread System call */
@@ -24,6 +28,14 @@
 #define SYSCALL_NET(f) ((void*)sys_notimpl)
 #endif
 
+#ifdef LWP_USING_SHM
+#include <lwp_shm.h>
+
+#define SYSCALL_SHM(f) ((void*)(f))
+#else
+#define SYSCALL_SHM(f) ((void*)sys_notimpl)
+#endif
+
 #define DBG_ENABLE
 #define DBG_SECTION_NAME    "LWP_CALL"
 #define DBG_COLOR
@@ -51,6 +63,9 @@ void sys_exit(int value)
     dbg_log(DBG_LOG, "enter sys_exit\n");
     tid = rt_thread_self();
     __exit_files(tid);
+#ifdef LWP_USING_SHM
+    lwp_shm_exit((struct rt_lwp *)tid->lwp);
+#endif
     rt_thread_delete(tid);
 
     rt_schedule();
@@ -97,24 +112,85 @@ int sys_ioctl(int fd, unsigned long cmd, void* data)
 /* syscall: "nanosleep" ret: "int" args: "const struct timespec *" "struct timespec *" */
 int sys_nanosleep(const struct timespec *rqtp, struct timespec *rmtp)
 {
-    rt_tick_t tick;
+    rt_uint64_t ns, expire;
 
     dbg_log(DBG_LOG, "sys_nanosleep\n");
 
-    tick = rqtp->tv_sec * RT_TICK_PER_SECOND + (rqtp->tv_nsec * RT_TICK_PER_SECOND)/ 1000000000;
-    rt_thread_delay(tick);
+    ns = (rt_uint64_t)rqtp->tv_sec * 1000000000ULL + rqtp->tv_nsec;
+    expire = rt_clock_ns() + ns;
+
+#ifdef RT_USING_HRTIMER
+    rt_hrtimer_sleep_until(expire);
+#else
+    /* round up to tick */
+    rt_thread_delay((rt_tick_t)((ns + (1000000000UL / RT_TICK_PER_SECOND) - 1) /
+                                (1000000000UL / RT_TICK_PER_SECOND)));
+#endif
 
     if (rmtp)
     {
-        tick = rt_tick_get() - tick;
-        /* get the passed time */
-        rmtp->tv_sec = tick/RT_TICK_PER_SECOND;
-        rmtp->tv_nsec = (tick%RT_TICK_PER_SECOND) * (1000000000/RT_TICK_PER_SECOND);
+        /* get the remaining time when the sleep is broken */
+        ns = rt_clock_ns();
+        ns = expire > ns ? expire - ns : 0;
+        rmtp->tv_sec = (time_t)(ns / 1000000000ULL);
+        rmtp->tv_nsec = (long)(ns % 1000000000ULL);
     }
 
     return 0;
 }
 
+/* syscall: "futex" ret: "int" args: "rt_atomic_t *" "int" "rt_atomic_t" "const struct timespec *" */
+int sys_futex(rt_atomic_t *uaddr, int op, rt_atomic_t val, const struct timespec *timeout)
+{
+    rt_int32_t tick;
+    rt_int64_t ticks;
+    rt_err_t result;
+
+    dbg_log(DBG_LOG, "sys_futex\n");
+
+    /* the word is waited and woken in kernel, it must be of the process */
+    if (((rt_ubase_t)uaddr & (sizeof(rt_atomic_t) - 1)) ||
+        !lwp_user_accessable(uaddr, sizeof(rt_atomic_t)))
+        return -EFAULT;
+
+    switch (op)
+    {
+    case FUTEX_WAIT:
+        tick = RT_WAITING_FOREVER;
+        if (timeout)
+        {
+            if (!lwp_user_accessable((void *)timeout, sizeof(struct timespec)))
+                return -EFAULT;
+            if (timeout->tv_sec < 0 || timeout->tv_nsec < 0 || timeout->tv_nsec >= 1000000000L)
+                return -EINVAL;
+
+            /* the relative time, round up to tick and limit as rt_timer does */
+            ticks = (rt_int64_t)timeout->tv_sec * RT_TICK_PER_SECOND +
+                    (timeout->tv_nsec * (rt_int64_t)RT_TICK_PER_SECOND + 999999999L) / 1000000000L;
+            if (ticks > RT_TICK_MAX / 2)
+                ticks = RT_TICK_MAX / 2;
+            tick = (rt_int32_t)ticks;
+        }
+
+        result = rt_futex_wait(uaddr, val, tick);
+        if (result == -RT_EBUSY)
+            return -EAGAIN;
+        if (result == -RT_ETIMEOUT)
+            return -ETIMEDOUT;
+        if (result == -RT_EINTR)
+            return -EINTR;
+        return 0;
+
+    case FUTEX_WAKE:
+        return rt_futex_wake(uaddr, (int)val);
+
+    default:
+        break;
+    }
+
+    return -ENOSYS;
+}
+
 /* syscall: "getpriority" ret: "int" args: "int" "id_t" */
 int sys_getpriority(int which, id_t who)
 {
@@ -261,6 +337,15 @@ const static void* func_table[] =
     SYSCALL_NET(socket),     // 0x1f
 
     (void *)select,          // 0x20
+
+    (void *)sys_futex,       // 0x21
+
+    SYSCALL_SHM(lwp_shm_open),      // 0x22
+    SYSCALL_SHM(lwp_shm_ftruncate), // 0x23
+    SYSCALL_SHM(lwp_shm_mmap),      // 0x24
+    SYSCALL_SHM(lwp_shm_munmap),    // 0x25
+    SYSCALL_SHM(lwp_shm_close),     // 0x26
+    SYSCALL_SHM(lwp_shm_unlink),    // 0x27
 };
 
 const void *lwp_get_sys_api(rt_uint32_t number)
@@ -11,6 +11,7 @@
  * 2012-12-29     Bernard      add rt_hw_exception_install declaration
  * 2017-10-17     Hichard      add some micros
  * 2018-12-10     Jesven       fix complie error in iar and keil
+ * 2026-10-19     heyuanjie    add futex
  */
 
 #ifndef __LWP_SYSCALL_H__
@@ -35,6 +36,12 @@ typedef uint32_t id_t;          /* may contain pid, uid or gid */
 #define	PRIO_PGRP	    1
 #define	PRIO_USER	    2
 
+/*
+ * futex operations
+ */
+#define FUTEX_WAIT      0
+#define FUTEX_WAKE      1
+
 #define TIMEVAL_TO_TIMESPEC(tv, ts) {                   \
     (ts)->tv_sec = (tv)->tv_sec;                        \
     (ts)->tv_nsec = (tv)->tv_usec * 1000;               \
@@ -51,6 +58,7 @@ off_t sys_lseek(int fd, off_t offset, int whence);
 int sys_open(const char *name, int mode, ...);
 int sys_close(int fd);
 int sys_nanosleep(const struct timespec *rqtp, struct timespec *rmtp);
+int sys_futex(rt_atomic_t *uaddr, int op, rt_atomic_t val, const struct timespec *timeout);
 int sys_getpriority(int which, id_t who);
 int sys_setpriority(int which, id_t who, int prio);
 int sys_gettimeofday(struct timeval *tp, struct timezone *tzp);
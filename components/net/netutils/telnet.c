@@ -1,7 +1,37 @@
+/*
+ * File      : telnet.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2006 - 2012, RT-Thread Development Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    rewrite as a select() driven multi-session
+ *                             server, coalesce output into full segments
+ * 2026-10-19     heyuanjie    rt_kprintf of shell is queued without blocking
+ */
+
 #include <rtthread.h>
+#include <rthw.h>
 #include <lwip/api.h>
 #include <lwip/sockets.h>
+#include <lwip/tcp.h>
 #include <rtdevice.h>
+#include <dfs_file.h>
+#include <poll.h>
 
 #include <finsh.h>
 #include <shell.h>
@@ -10,6 +40,22 @@
 #define TELNET_BACKLOG      5
 #define RX_BUFFER_SIZE      256
 #define TX_BUFFER_SIZE      4096
+#define CON_BUFFER_SIZE     1024
+
+/* number of concurrent sessions, each one has its own device and shell */
+#ifndef TELNET_MAX_SESSIONS
+#define TELNET_MAX_SESSIONS 4
+#endif
+
+/* size of socket read at one time, shared by all of sessions */
+#define TELNET_RECV_CHUNK   512
+
+/* pending output is pushed out when it fills a segment... */
+#define TELNET_TX_SEGMENT   TCP_MSS
+/* ...or when the oldest byte has been waiting this long (in tick) */
+#ifndef TELNET_FLUSH_DELAY
+#define TELNET_FLUSH_DELAY  (RT_TICK_PER_SECOND / 50 + 1)
+#endif
 
 #define ISO_nl              0x0a
 #define ISO_cr              0x0d
@@ -28,95 +74,202 @@
 #define TELNET_DO           253
 #define TELNET_DONT         254
 
+/* session slot status */
+#define SESSION_FREE        0   /* no client and no shell */
+#define SESSION_ACTIVE      1   /* client is connected */
+#define SESSION_HANGUP      2   /* client is gone, waiting the shell to exit */
+
 struct telnet_session
 {
+    struct rt_device device;
+    struct rt_console console;          /* rt_kprintf of the session shell */
+
     struct rt_ringbuffer rx_ringbuffer;
     struct rt_ringbuffer tx_ringbuffer;
+    /* rt_kprintf of the shell, taken with interrupts disabled */
+    struct rt_ringbuffer con_ringbuffer;
 
-    rt_mutex_t rx_ringbuffer_lock;
-    rt_mutex_t tx_ringbuffer_lock;
+    struct rt_mutex rx_ringbuffer_lock;
+    struct rt_mutex tx_ringbuffer_lock;
+
+    rt_wqueue_t reader_queue;
 
-    struct rt_device device;
-    rt_int32_t server_fd;
     rt_int32_t client_fd;
+    rt_uint8_t status;
 
     /* telnet protocol */
     rt_uint8_t state;
-    rt_uint8_t echo_mode;
 
+    /* tick when the oldest byte in tx ringbuffer was queued */
+    rt_tick_t tx_tick;
 };
 
-static struct telnet_session* telnet;
+struct telnet_server
+{
+    rt_int32_t server_fd;
+
+    struct telnet_session session[TELNET_MAX_SESSIONS];
+    rt_uint8_t recv_buf[TELNET_RECV_CHUNK];
+};
 
-/* process tx data */
-static void send_to_client(struct telnet_session* telnet)
+static struct telnet_server *telnet;
+
+/*
+ * push tx data to client, the tx ringbuffer lock must be held.
+ *
+ * Data goes to the socket straight from the ringbuffer memory. In blocking
+ * mode all of data is sent; otherwise what the socket can not take stays in
+ * ringbuffer for the next try.
+ */
+static void send_to_client(struct telnet_session *session, int flags)
 {
+    rt_uint8_t *ptr;
     rt_size_t length;
-    rt_uint8_t tx_buffer[32];
+    int result;
 
-    while (1)
+    while ((length = rt_ringbuffer_peek(&session->tx_ringbuffer, &ptr)) > 0)
     {
-        rt_memset(tx_buffer, 0, sizeof(tx_buffer));
-        rt_mutex_take(telnet->tx_ringbuffer_lock, RT_WAITING_FOREVER);
-        /* get buffer from ringbuffer */
-        length = rt_ringbuffer_get(&(telnet->tx_ringbuffer), tx_buffer, sizeof(tx_buffer));
-        rt_mutex_release(telnet->tx_ringbuffer_lock);
+        result = send(session->client_fd, ptr, length, flags);
+        if (result <= 0)
+        {
+            /* client is gone, drop the output */
+            if (!(flags & MSG_DONTWAIT))
+                rt_ringbuffer_reset(&session->tx_ringbuffer);
+            break;
+        }
 
-        /* do a tx procedure */
-        if (length > 0)
+        rt_ringbuffer_skip(&session->tx_ringbuffer, result);
+        if (result < length)
+            break;
+    }
+
+    session->tx_tick = rt_tick_get();
+}
+
+/* whether tx data should be pushed out, the tx ringbuffer lock must be held */
+static rt_bool_t flush_is_due(struct telnet_session *session)
+{
+    rt_size_t length;
+
+    length = rt_ringbuffer_data_len(&session->tx_ringbuffer);
+    if (length == 0)
+        return RT_FALSE;
+
+    if (length >= TELNET_TX_SEGMENT)
+        return RT_TRUE;
+
+    return (rt_tick_get() - session->tx_tick) >= TELNET_FLUSH_DELAY;
+}
+
+/* queue tx data, the tx ringbuffer lock must be held */
+static void queue_to_client(struct telnet_session *session, const rt_uint8_t *data, rt_size_t length)
+{
+    if (rt_ringbuffer_data_len(&session->tx_ringbuffer) == 0)
+        session->tx_tick = rt_tick_get();
+
+    rt_ringbuffer_put(&session->tx_ringbuffer, data, length);
+}
+
+/*
+ * queue text with '\n' as "\r\n", the tx ringbuffer lock must be held.
+ * Return the length of text queued, which is short if the socket can not
+ * take the data in non-blocking mode.
+ */
+static rt_size_t queue_text(struct telnet_session *session, const rt_uint8_t *ptr, rt_size_t count, int flags)
+{
+    rt_size_t index;
+
+    if (rt_ringbuffer_data_len(&session->tx_ringbuffer) == 0)
+        session->tx_tick = rt_tick_get();
+
+    for (index = 0; index < count; index ++)
+    {
+        /* make room for '\r' '\n' by pushing out what is queued */
+        if (rt_ringbuffer_space_len(&session->tx_ringbuffer) < 2)
         {
-            send(telnet->client_fd, tx_buffer, length, 0);
+            send_to_client(session, flags);
+            if (rt_ringbuffer_space_len(&session->tx_ringbuffer) < 2)
+                break;
         }
-        else break;
+
+        if (ptr[index] == '\n')
+            rt_ringbuffer_putchar(&session->tx_ringbuffer, '\r');
+        rt_ringbuffer_putchar(&session->tx_ringbuffer, ptr[index]);
     }
+
+    return index;
+}
+
+/* move rt_kprintf of the shell to tx, the tx ringbuffer lock must be held */
+static void drain_console(struct telnet_session *session, int flags)
+{
+    rt_uint8_t *ptr;
+    rt_size_t length, queued;
+    rt_base_t level;
+
+    do
+    {
+        level = rt_hw_interrupt_disable();
+        length = rt_ringbuffer_peek(&session->con_ringbuffer, &ptr);
+        rt_hw_interrupt_enable(level);
+        if (length == 0)
+            break;
+
+        /* the writer only appends, the peeked data stays until skipped */
+        queued = queue_text(session, ptr, length, flags);
+
+        level = rt_hw_interrupt_disable();
+        rt_ringbuffer_skip(&session->con_ringbuffer, queued);
+        rt_hw_interrupt_enable(level);
+    } while (queued == length);
 }
 
 /* send telnet option to remote */
-static void send_option_to_client(struct telnet_session* telnet, rt_uint8_t option, rt_uint8_t value)
+static void send_option_to_client(struct telnet_session *session, rt_uint8_t option, rt_uint8_t value)
 {
-    rt_uint8_t optbuf[4];
+    rt_uint8_t optbuf[3];
 
     optbuf[0] = TELNET_IAC;
     optbuf[1] = option;
     optbuf[2] = value;
-    optbuf[3] = 0;
 
-    rt_mutex_take(telnet->tx_ringbuffer_lock, RT_WAITING_FOREVER);
-    rt_ringbuffer_put(&telnet->tx_ringbuffer, optbuf, 3);
-    rt_mutex_release(telnet->tx_ringbuffer_lock);
+    rt_mutex_take(&session->tx_ringbuffer_lock, RT_WAITING_FOREVER);
+    queue_to_client(session, optbuf, 3);
+    rt_mutex_release(&session->tx_ringbuffer_lock);
+}
 
-    send_to_client(telnet);
+/* put one received character, the rx ringbuffer lock must be held */
+rt_inline void put_to_shell(struct telnet_session *session, rt_uint8_t ch)
+{
+    rt_ringbuffer_putchar(&session->rx_ringbuffer, ch);
 }
 
 /* process rx data */
-static void process_rx(struct telnet_session* telnet, rt_uint8_t *data, rt_size_t length)
+static void process_rx(struct telnet_session *session, rt_uint8_t *data, rt_size_t length)
 {
-    rt_size_t rx_length, index;
+    rt_size_t index;
 
+    rt_mutex_take(&session->rx_ringbuffer_lock, RT_WAITING_FOREVER);
     for (index = 0; index < length; index ++)
     {
-        switch(telnet->state)
+        switch (session->state)
         {
         case STATE_IAC:
             if (*data == TELNET_IAC)
             {
-                rt_mutex_take(telnet->rx_ringbuffer_lock, RT_WAITING_FOREVER);
-                /* put buffer to ringbuffer */
-                rt_ringbuffer_putchar(&(telnet->rx_ringbuffer), *data);
-                rt_mutex_release(telnet->rx_ringbuffer_lock);
-
-                telnet->state = STATE_NORMAL;
+                put_to_shell(session, *data);
+                session->state = STATE_NORMAL;
             }
             else
             {
                 /* set telnet state according to received package */
                 switch (*data)
                 {
-                case TELNET_WILL: telnet->state = STATE_WILL; break;
-                case TELNET_WONT: telnet->state = STATE_WONT; break;
-                case TELNET_DO:   telnet->state = STATE_DO; break;
-                case TELNET_DONT: telnet->state = STATE_DONT; break;
-                default: telnet->state = STATE_NORMAL; break;
+                case TELNET_WILL: session->state = STATE_WILL; break;
+                case TELNET_WONT: session->state = STATE_WONT; break;
+                case TELNET_DO:   session->state = STATE_DO; break;
+                case TELNET_DONT: session->state = STATE_DONT; break;
+                default: session->state = STATE_NORMAL; break;
                 }
             }
             break;
@@ -124,25 +277,22 @@ static void process_rx(struct telnet_session* telnet, rt_uint8_t *data, rt_size_
         /* don't option */
         case STATE_WILL:
         case STATE_WONT:
-            send_option_to_client(telnet, TELNET_DONT, *data);
-            telnet->state = STATE_NORMAL;
+            send_option_to_client(session, TELNET_DONT, *data);
+            session->state = STATE_NORMAL;
             break;
 
         /* won't option */
         case STATE_DO:
         case STATE_DONT:
-            send_option_to_client(telnet, TELNET_WONT, *data);
-            telnet->state = STATE_NORMAL;
+            send_option_to_client(session, TELNET_WONT, *data);
+            session->state = STATE_NORMAL;
             break;
 
         case STATE_NORMAL:
-            if (*data == TELNET_IAC) telnet->state = STATE_IAC;
+            if (*data == TELNET_IAC) session->state = STATE_IAC;
             else if (*data != '\r') /* ignore '\r' */
             {
-                rt_mutex_take(telnet->rx_ringbuffer_lock, RT_WAITING_FOREVER);
-                /* put buffer to ringbuffer */
-                rt_ringbuffer_putchar(&(telnet->rx_ringbuffer), *data);
-                rt_mutex_release(telnet->rx_ringbuffer_lock);
+                put_to_shell(session, *data);
             }
             break;
         }
@@ -150,102 +300,273 @@ static void process_rx(struct telnet_session* telnet, rt_uint8_t *data, rt_size_
         data ++;
     }
 
-    rt_mutex_take(telnet->rx_ringbuffer_lock, RT_WAITING_FOREVER);
-    /* get total size */
-    rx_length = rt_ringbuffer_data_len(&telnet->rx_ringbuffer);
-    rt_mutex_release(telnet->rx_ringbuffer_lock);
+    length = rt_ringbuffer_data_len(&session->rx_ringbuffer);
+    rt_mutex_release(&session->rx_ringbuffer_lock);
 
     /* indicate there are reception data */
-    if ((rx_length > 0) && (telnet->device.rx_indicate != RT_NULL))
-        telnet->device.rx_indicate(&telnet->device, rx_length);
+    if (length > 0)
+        rt_wqueue_wakeup(&session->reader_queue, (void*)POLLIN);
+}
+
+/* client close, the shell exits when it reads end-of-file */
+static void client_close(struct telnet_session *session)
+{
+    rt_mutex_take(&session->tx_ringbuffer_lock, RT_WAITING_FOREVER);
+    closesocket(session->client_fd);
+    session->client_fd = -1;
+    rt_ringbuffer_reset(&session->tx_ringbuffer);
+    rt_mutex_release(&session->tx_ringbuffer_lock);
+
+    session->status = SESSION_HANGUP;
+    rt_wqueue_wakeup(&session->reader_queue, (void*)(POLLIN | POLLHUP));
 
-    return;
+    rt_kprintf("telnet: %s client disconnected\n", session->device.parent.name);
 }
 
-/* client close */
-static void client_close(struct telnet_session* telnet)
+/* session device file operations */
+static int telnet_fops_open(struct dfs_fd *fd)
 {
-    /* set console */
-    rt_console_set_device(RT_CONSOLE_DEVICE_NAME);
-    /* set finsh device */
-    finsh_set_device(RT_CONSOLE_DEVICE_NAME);
+    struct telnet_session *session;
 
-    /* close connection */
-    closesocket(telnet->client_fd);
+    session = (struct telnet_session *)fd->dev;
+    if (session->status != SESSION_ACTIVE)
+        return -EIO;
 
-    /* restore shell option */
-    finsh_set_echo(telnet->echo_mode);
+    session->device.ref_count ++;
 
-    rt_kprintf("resume console to %s\n", RT_CONSOLE_DEVICE_NAME);
+    return 0;
 }
 
-/* RT-Thread Device Driver Interface */
-static rt_err_t telnet_init(rt_device_t dev)
+static int telnet_fops_close(struct dfs_fd *fd)
 {
-    return RT_EOK;
+    struct telnet_session *session;
+
+    session = (struct telnet_session *)fd->dev;
+    if (session->device.ref_count > 0)
+    {
+        session->device.ref_count --;
+
+        /* the last user is gone, the slot is free for next client */
+        if (session->device.ref_count == 0 && session->status == SESSION_HANGUP)
+            session->status = SESSION_FREE;
+    }
+
+    return 0;
 }
 
-static rt_err_t telnet_open(rt_device_t dev, rt_uint16_t oflag)
+static int telnet_fops_read(struct dfs_fd *fd, void *buf, size_t count)
 {
-    return RT_EOK;
+    struct telnet_session *session;
+    int length;
+
+    session = (struct telnet_session *)fd->dev;
+
+    while (1)
+    {
+        rt_mutex_take(&session->rx_ringbuffer_lock, RT_WAITING_FOREVER);
+        length = rt_ringbuffer_get(&session->rx_ringbuffer, buf, count);
+        rt_mutex_release(&session->rx_ringbuffer_lock);
+
+        if (length > 0)
+            break;
+
+        /* client has hung up, return end-of-file */
+        if (session->status != SESSION_ACTIVE)
+            break;
+
+        if (fd->flags & O_NONBLOCK)
+        {
+            length = -EAGAIN;
+            break;
+        }
+
+        rt_wqueue_uwait(&session->reader_queue, -1);
+    }
+
+    return length;
 }
 
-static rt_err_t telnet_close(rt_device_t dev)
+static int telnet_fops_write(struct dfs_fd *fd, const void *buf, size_t count)
 {
-    return RT_EOK;
+    struct telnet_session *session;
+    rt_size_t length;
+
+    session = (struct telnet_session *)fd->dev;
+
+    rt_mutex_take(&session->tx_ringbuffer_lock, RT_WAITING_FOREVER);
+    if (session->client_fd < 0)
+    {
+        rt_mutex_release(&session->tx_ringbuffer_lock);
+        return -EPIPE;
+    }
+
+    /* rt_kprintf of the command goes before the output after it */
+    drain_console(session, 0);
+    length = queue_text(session, (const rt_uint8_t *)buf, count, 0);
+
+    /* a full segment is sent at once, the tail waits for the flush timer */
+    if (rt_ringbuffer_data_len(&session->tx_ringbuffer) >= TELNET_TX_SEGMENT)
+        send_to_client(session, 0);
+    rt_mutex_release(&session->tx_ringbuffer_lock);
+
+    return length;
 }
 
-static rt_size_t telnet_read(rt_device_t dev, rt_off_t pos, void* buffer, rt_size_t size)
+/*
+ * rt_kprintf of the session shell, which may be called in a critical section
+ * or with interrupts disabled, so it must not block: the text is queued and
+ * the server thread sends it. The text over the buffer is dropped.
+ */
+static void telnet_console_write(struct rt_console *con, const char *str, rt_size_t length)
 {
-    rt_size_t result;
+    struct telnet_session *session = (struct telnet_session *)con->user_data;
+    rt_base_t level;
 
-    /* read from rx ring buffer */
-    rt_mutex_take(telnet->rx_ringbuffer_lock, RT_WAITING_FOREVER);
-    result = rt_ringbuffer_get(&(telnet->rx_ringbuffer), buffer, size);
-    rt_mutex_release(telnet->rx_ringbuffer_lock);
+    /* the client has hung up, don't lose the output of the shell commands */
+    if (session->client_fd < 0)
+    {
+        rt_hw_console_output(str);
+        return;
+    }
 
-    return result;
+    level = rt_hw_interrupt_disable();
+    rt_ringbuffer_put(&session->con_ringbuffer, (const rt_uint8_t *)str, length);
+    rt_hw_interrupt_enable(level);
 }
 
-static rt_size_t telnet_write (rt_device_t dev, rt_off_t pos, const void* buffer, rt_size_t size)
+static int telnet_fops_poll(struct dfs_fd *fd, rt_pollreq_t *req)
 {
-    const rt_uint8_t *ptr;
+    struct telnet_session *session;
+    int mask = POLLOUT;
 
-    ptr = (rt_uint8_t*) buffer;
+    session = (struct telnet_session *)fd->dev;
 
-    rt_mutex_take(telnet->tx_ringbuffer_lock, RT_WAITING_FOREVER);
-    while (size)
-    {
-        if (*ptr == '\n')
-            rt_ringbuffer_putchar(&telnet->tx_ringbuffer, '\r');
+    rt_poll_add(&session->reader_queue, req);
 
-        if (rt_ringbuffer_putchar(&telnet->tx_ringbuffer, *ptr) == 0) /* overflow */
-            break;
-        ptr++;
-        size--;
-    }
-    rt_mutex_release(telnet->tx_ringbuffer_lock);
-
-    /* send data to telnet client */
-    send_to_client(telnet);
+    if (rt_ringbuffer_data_len(&session->rx_ringbuffer) != 0)
+        mask |= POLLIN;
+    if (session->status != SESSION_ACTIVE)
+        mask |= POLLHUP;
 
-    return (rt_uint32_t) ptr - (rt_uint32_t) buffer;
+    return mask;
 }
 
-static rt_err_t telnet_control(rt_device_t dev, int cmd, void *args)
+static const struct dfs_file_ops telnet_fops =
+{
+    telnet_fops_open,
+    telnet_fops_close,
+    RT_NULL,
+    telnet_fops_read,
+    telnet_fops_write,
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    telnet_fops_poll,
+};
+
+static int telnet_session_init(struct telnet_session *session, int index)
 {
+    char name[RT_NAME_MAX];
+    rt_uint8_t *ptr;
+
+    rt_snprintf(name, sizeof(name), "telnet%d", index);
+
+    ptr = rt_malloc(RX_BUFFER_SIZE + TX_BUFFER_SIZE + CON_BUFFER_SIZE);
+    if (ptr == RT_NULL)
+        return -RT_ENOMEM;
+
+    rt_ringbuffer_init(&session->rx_ringbuffer, ptr, RX_BUFFER_SIZE);
+    rt_ringbuffer_init(&session->tx_ringbuffer, ptr + RX_BUFFER_SIZE, TX_BUFFER_SIZE);
+    rt_ringbuffer_init(&session->con_ringbuffer, ptr + RX_BUFFER_SIZE + TX_BUFFER_SIZE, CON_BUFFER_SIZE);
+    rt_mutex_init(&session->rx_ringbuffer_lock, name, RT_IPC_FLAG_FIFO);
+    rt_mutex_init(&session->tx_ringbuffer_lock, name, RT_IPC_FLAG_FIFO);
+    rt_wqueue_init(&session->reader_queue);
+
+    session->client_fd = -1;
+    session->status = SESSION_FREE;
+
+    session->device.type = RT_Device_Class_Char;
+    session->device.user_data = RT_NULL;
+    rt_device_register(&session->device, name, RT_DEVICE_FLAG_RDWR);
+    session->device.fops = &telnet_fops;
+
+    session->console.init = RT_NULL;
+    session->console.write = telnet_console_write;
+    session->console.user_data = session;
+#ifdef RT_USING_DEVICE
+    session->console.device = &session->device;
+#endif
+
     return RT_EOK;
 }
 
+/* bind a new connection to a free session slot and start its shell */
+static void telnet_accept(void)
+{
+    struct sockaddr_in addr;
+    socklen_t addr_size;
+    struct telnet_session *session = RT_NULL;
+    char path[RT_NAME_MAX + 5];
+    int client_fd, index, option = 1;
+    rt_base_t level;
+
+    addr_size = sizeof(addr);
+    client_fd = accept(telnet->server_fd, (struct sockaddr *)&addr, &addr_size);
+    if (client_fd < 0)
+        return;
+
+    for (index = 0; index < TELNET_MAX_SESSIONS; index ++)
+    {
+        if (telnet->session[index].status == SESSION_FREE)
+        {
+            session = &telnet->session[index];
+            break;
+        }
+    }
+
+    if (session == RT_NULL)
+    {
+        const char *busy = "too many telnet sessions\r\n";
+
+        send(client_fd, busy, rt_strlen(busy), 0);
+        closesocket(client_fd);
+        return;
+    }
+
+    /* output is coalesced here, don't let Nagle delay it once more */
+    setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, (void *)&option, sizeof(option));
+
+    session->client_fd = client_fd;
+    session->state = STATE_NORMAL;
+    rt_ringbuffer_reset(&session->rx_ringbuffer);
+    rt_ringbuffer_reset(&session->tx_ringbuffer);
+    level = rt_hw_interrupt_disable();
+    rt_ringbuffer_reset(&session->con_ringbuffer);
+    rt_hw_interrupt_enable(level);
+    session->status = SESSION_ACTIVE;
+
+    rt_kprintf("telnet: new client(%s:%d) on %s\n", inet_ntoa(addr.sin_addr),
+               ntohs(addr.sin_port), session->device.parent.name);
+
+    /* the client echoes by itself, the output of commands goes to the client */
+    rt_snprintf(path, sizeof(path), "/dev/%s", session->device.parent.name);
+    if (finsh_shell_create(session->device.parent.name, path, RT_FALSE, &session->console) == RT_NULL)
+    {
+        rt_kprintf("telnet: create shell failed\n");
+        client_close(session);
+        session->status = SESSION_FREE;
+    }
+}
+
 /* telnet server thread entry */
 static void telnet_thread(void* parameter)
 {
-#define RECV_BUF_LEN 64
-
     struct sockaddr_in addr;
-    socklen_t addr_size;
-    rt_uint8_t recv_buf[RECV_BUF_LEN];
-    rt_int32_t recv_len = 0;
+    struct timeval timeout;
+    struct telnet_session *session;
+    fd_set readset;
+    int index, maxfd, active;
+    rt_int32_t recv_len;
 
     if ((telnet->server_fd = socket(AF_INET, SOCK_STREAM, 0)) == -1)
     {
@@ -269,64 +590,63 @@ static void telnet_thread(void* parameter)
         return;
     }
 
-    /* register telnet device */
-    telnet->device.type     = RT_Device_Class_Char;
-    telnet->device.init     = telnet_init;
-    telnet->device.open     = telnet_open;
-    telnet->device.close    = telnet_close;
-    telnet->device.read     = telnet_read;
-    telnet->device.write    = telnet_write;
-    telnet->device.control  = telnet_control;
-
-    /* no private */
-    telnet->device.user_data = RT_NULL;
-
-    /* register telnet device */
-    rt_device_register(&telnet->device, "telnet",
-                       RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_STREAM);
+    rt_kprintf("telnet server waiting for connection\n");
 
     while (1)
     {
-        rt_kprintf("telnet server waiting for connection\n");
+        FD_ZERO(&readset);
+        FD_SET(telnet->server_fd, &readset);
+        maxfd = telnet->server_fd;
+        active = 0;
 
-        /* grab new connection */
-        if ((telnet->client_fd = accept(telnet->server_fd, (struct sockaddr * )&addr, &addr_size)) == -1)
+        for (index = 0; index < TELNET_MAX_SESSIONS; index ++)
         {
-            continue;
+            session = &telnet->session[index];
+            if (session->status != SESSION_ACTIVE)
+                continue;
+
+            FD_SET(session->client_fd, &readset);
+            if (session->client_fd > maxfd)
+                maxfd = session->client_fd;
+            active ++;
         }
 
-        rt_kprintf("new telnet client(%s:%d) connection, switch console to telnet...\n", inet_ntoa(addr.sin_addr), addr.sin_port);
-
-        /* process the new connection */
-        /* set console */
-        rt_console_set_device("telnet");
-        /* set finsh device */
-        finsh_set_device("telnet");
-
-        /* set init state */
-        telnet->state = STATE_NORMAL;
-
-        telnet->echo_mode = finsh_get_echo();
-        /* disable echo mode */
-        finsh_set_echo(0);
+        /* with a client connected, wake up in time to flush the short tail */
+        timeout.tv_sec = 0;
+        timeout.tv_usec = TELNET_FLUSH_DELAY * (1000000 / RT_TICK_PER_SECOND);
+        if (select(maxfd + 1, &readset, RT_NULL, RT_NULL, active ? &timeout : RT_NULL) < 0)
+        {
+            rt_thread_delay(TELNET_FLUSH_DELAY);
+            continue;
+        }
 
-        while (1)
+        for (index = 0; index < TELNET_MAX_SESSIONS; index ++)
         {
-            /* try to send all data in tx ringbuffer */
-            send_to_client(telnet);
+            session = &telnet->session[index];
+            if (session->status != SESSION_ACTIVE)
+                continue;
 
-            /* do a rx procedure */
-            if ((recv_len = recv(telnet->client_fd, recv_buf, RECV_BUF_LEN, 0)) > 0)
+            if (FD_ISSET(session->client_fd, &readset))
             {
-                process_rx(telnet, recv_buf, recv_len);
-            }
-            else
-            {
-                /* close connection */
-                client_close(telnet);
-                break;
+                recv_len = recv(session->client_fd, telnet->recv_buf, TELNET_RECV_CHUNK, 0);
+                if (recv_len <= 0)
+                {
+                    client_close(session);
+                    continue;
+                }
+
+                process_rx(session, telnet->recv_buf, recv_len);
             }
+
+            rt_mutex_take(&session->tx_ringbuffer_lock, RT_WAITING_FOREVER);
+            drain_console(session, MSG_DONTWAIT);
+            if (flush_is_due(session))
+                send_to_client(session, MSG_DONTWAIT);
+            rt_mutex_release(&session->tx_ringbuffer_lock);
         }
+
+        if (FD_ISSET(telnet->server_fd, &readset))
+            telnet_accept();
     }
 }
 
@@ -334,42 +654,26 @@ static void telnet_thread(void* parameter)
 void telnet_srv(void)
 {
     rt_thread_t tid;
+    int index;
 
     if (telnet == RT_NULL)
     {
-        rt_uint8_t *ptr;
-
-        telnet = rt_malloc(sizeof(struct telnet_session));
+        telnet = rt_malloc(sizeof(struct telnet_server));
         if (telnet == RT_NULL)
         {
             rt_kprintf("telnet: no memory\n");
             return;
         }
-        /* init ringbuffer */
-        ptr = rt_malloc(RX_BUFFER_SIZE);
-        if (ptr)
-        {
-            rt_ringbuffer_init(&telnet->rx_ringbuffer, ptr, RX_BUFFER_SIZE);
-        }
-        else
-        {
-            rt_kprintf("telnet: no memory\n");
-            return;
-        }
-        ptr = rt_malloc(TX_BUFFER_SIZE);
-        if (ptr)
-        {
-            rt_ringbuffer_init(&telnet->tx_ringbuffer, ptr, TX_BUFFER_SIZE);
-        }
-        else
+        rt_memset(telnet, 0, sizeof(struct telnet_server));
+
+        for (index = 0; index < TELNET_MAX_SESSIONS; index ++)
         {
-            rt_kprintf("telnet: no memory\n");
-            return;
+            if (telnet_session_init(&telnet->session[index], index) != RT_EOK)
+            {
+                rt_kprintf("telnet: no memory\n");
+                return;
+            }
         }
-        /* create tx ringbuffer lock */
-        telnet->tx_ringbuffer_lock = rt_mutex_create("telnet_tx", RT_IPC_FLAG_FIFO);
-        /* create rx ringbuffer lock */
-        telnet->rx_ringbuffer_lock = rt_mutex_create("telnet_rx", RT_IPC_FLAG_FIFO);
 
         tid = rt_thread_create("telnet", telnet_thread, RT_NULL, 2048, 25, 5);
         if (tid != RT_NULL)
@@ -379,7 +683,6 @@ void telnet_srv(void)
     {
         rt_kprintf("telnet: already running\n");
     }
-
 }
 
 #ifdef RT_USING_FINSH
@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ */
+
+/*
+ * File system benchmark.
+ *
+ * The device is formatted, then the mount time, the throughput of
+ * sequential and random access, the longest write (the stall by garbage
+ * collection) and the write amplification are measured. On a simulator
+ * of the posix port, the busy time of device is added to the time of cpu,
+ * and the bytes programmed on device are got for the write amplification.
+ * With RT_USING_POSIX_AIO, the file is written and read by aio too, and the
+ * longest write is the longest submission.
+ */
+
+#include <rtthread.h>
+#include <dfs_posix.h>
+#include <dfs_fs.h>
+#include <finsh.h>
+#include <stdlib.h>
+
+#ifdef RT_USING_FLASH_SIM
+#include <flash_sim.h>
+#endif
+
+#ifdef RT_USING_POSIX_AIO
+#include <aio.h>
+#endif
+
+#define BENCH_FILE          "bench.dat"
+#define BENCH_IO_SIZE       4096
+#define BENCH_AIO_SIZE      1024    /* merged by the workers of aio */
+#define BENCH_AIO_DEPTH     (BENCH_IO_SIZE / BENCH_AIO_SIZE)
+
+struct fs_bench
+{
+    rt_device_t dev;
+    char file[64];
+    uint8_t *buf;
+    uint32_t size;
+    uint32_t seed;
+
+    uint64_t start;
+    uint32_t max_us;                /* the longest one of writes */
+};
+
+/* the time in us, with the busy time of simulated device */
+static uint64_t bench_now(struct fs_bench *b)
+{
+    uint64_t us = (uint64_t)rt_tick_get() * 1000000 / RT_TICK_PER_SECOND;
+
+#ifdef RT_USING_FLASH_SIM
+    {
+        struct flash_sim *sim = flash_sim_find(b->dev);
+
+        /* the busy time is spent already for realtime */
+        if (sim != RT_NULL && !sim->cfg.realtime)
+            us += sim->stat.time_ns / 1000;
+    }
+#endif
+
+    return us;
+}
+
+static uint32_t bench_rand(struct fs_bench *b)
+{
+    b->seed = b->seed * 1103515245 + 12345;
+
+    return b->seed >> 8;
+}
+
+static uint32_t bench_rate(uint32_t bytes, uint64_t us)
+{
+    /* KB/s */
+    return us ? (uint32_t)((uint64_t)bytes * 1000000 / 1024 / us) : 0;
+}
+
+static void bench_begin(struct fs_bench *b)
+{
+    b->max_us = 0;
+    b->start = bench_now(b);
+}
+
+static uint32_t bench_end(struct fs_bench *b)
+{
+    return (uint32_t)(bench_now(b) - b->start);
+}
+
+/* read or write the file by BENCH_IO_SIZE, at random offsets if random_io */
+static int bench_io(struct fs_bench *b, int writing, int random_io)
+{
+    uint32_t count = b->size / BENCH_IO_SIZE;
+    uint32_t i, us;
+    uint64_t t;
+    int fd, ret;
+
+    fd = open(b->file, writing ? (O_WRONLY | O_CREAT) : O_RDONLY, 0);
+    if (fd < 0)
+        return -1;
+
+    for (i = 0; i < count; i ++)
+    {
+        t = bench_now(b);
+        if (random_io)
+            lseek(fd, (bench_rand(b) % count) * BENCH_IO_SIZE, SEEK_SET);
+
+        if (writing)
+        {
+            rt_memset(b->buf, (uint8_t)i, BENCH_IO_SIZE);
+            ret = write(fd, b->buf, BENCH_IO_SIZE);
+        }
+        else
+        {
+            ret = read(fd, b->buf, BENCH_IO_SIZE);
+        }
+        if (ret != BENCH_IO_SIZE)
+            break;
+
+        us = (uint32_t)(bench_now(b) - t);
+        if (us > b->max_us)
+            b->max_us = us;
+    }
+
+    if (writing)
+        fsync(fd);
+    close(fd);
+
+    return (i == count) ? 0 : -1;
+}
+
+#ifdef RT_USING_POSIX_AIO
+static int bench_aio_wait(struct aiocb *cb)
+{
+    const struct aiocb *list[1];
+
+    list[0] = cb;
+    while (aio_error(cb) == EINPROGRESS)
+        aio_suspend(list, 1, RT_NULL);
+
+    return (aio_return(cb) == BENCH_AIO_SIZE) ? 0 : -1;
+}
+
+/*
+ * read or write the file by BENCH_AIO_SIZE with BENCH_AIO_DEPTH requests in
+ * flight, the longest is of the submission, what the caller is blocked for.
+ */
+static int bench_aio(struct fs_bench *b, int writing, int random_io)
+{
+    struct aiocb cb[BENCH_AIO_DEPTH];
+    uint32_t count = b->size / BENCH_AIO_SIZE;
+    uint32_t i, slot, us;
+    uint64_t t;
+    int fd, ret = 0;
+
+    fd = open(b->file, writing ? (O_WRONLY | O_CREAT) : O_RDONLY, 0);
+    if (fd < 0)
+        return -1;
+
+    rt_memset(cb, 0, sizeof(cb));
+    for (i = 0; i < count; i ++)
+    {
+        slot = i % BENCH_AIO_DEPTH;
+        if (i >= BENCH_AIO_DEPTH && bench_aio_wait(&cb[slot]) != 0)
+        {
+            ret = -1;
+            break;
+        }
+
+        cb[slot].aio_fildes = fd;
+        cb[slot].aio_offset = (random_io ? bench_rand(b) % count : i) * BENCH_AIO_SIZE;
+        cb[slot].aio_buf = b->buf + slot * BENCH_AIO_SIZE;
+        cb[slot].aio_nbytes = BENCH_AIO_SIZE;
+        cb[slot].aio_sigevent.sigev_notify = SIGEV_NONE;
+        if (writing)
+            rt_memset(b->buf + slot * BENCH_AIO_SIZE, (uint8_t)i, BENCH_AIO_SIZE);
+
+        t = bench_now(b);
+        if ((writing ? aio_write(&cb[slot]) : aio_read(&cb[slot])) != 0)
+        {
+            ret = -1;
+            break;
+        }
+        us = (uint32_t)(bench_now(b) - t);
+        if (us > b->max_us)
+            b->max_us = us;
+    }
+
+    /* the buffers are used until the requests in flight are done */
+    for (slot = 0; slot < BENCH_AIO_DEPTH && slot < i; slot ++)
+    {
+        if (bench_aio_wait(&cb[slot]) != 0)
+            ret = -1;
+    }
+
+    if (writing)
+        fsync(fd);
+    close(fd);
+
+    return ret;
+}
+#endif
+
+static void bench_report(struct fs_bench *b, const char *name, int writing, int random_io,
+                         int (*io)(struct fs_bench *b, int writing, int random_io))
+{
+    uint32_t us;
+#ifdef RT_USING_FLASH_SIM
+    struct flash_sim_stat stat;
+
+    flash_sim_stat(b->dev, RT_NULL, 1);
+#endif
+
+    bench_begin(b);
+    if (io(b, writing, random_io) != 0)
+    {
+        rt_kprintf("%-10s failed\n", name);
+        return;
+    }
+    us = bench_end(b);
+
+    rt_kprintf("%-10s %8u us %6u KB/s", name, us, bench_rate(b->size, us));
+    if (writing)
+        rt_kprintf(", longest %u us", b->max_us);
+#ifdef RT_USING_FLASH_SIM
+    if (writing && flash_sim_stat(b->dev, &stat, 0) == 0)
+    {
+        /* the bytes programmed for every 100 bytes written */
+        rt_kprintf(", amplification %u.%02u", (uint32_t)(stat.prog_bytes / b->size),
+                   (uint32_t)(stat.prog_bytes * 100 / b->size % 100));
+    }
+#endif
+    rt_kprintf("\n");
+}
+
+static int bench_mount(struct fs_bench *b, const char *device, const char *path, const char *fstype)
+{
+    uint32_t us;
+
+    bench_begin(b);
+    if (dfs_mount(device, path, fstype, 0, 0) != 0)
+    {
+        rt_kprintf("mount %s on %s failed\n", device, path);
+        return -1;
+    }
+    us = bench_end(b);
+    rt_kprintf("%-10s %8u us\n", "mount", us);
+
+    return 0;
+}
+
+static int fs_bench(int argc, char **argv)
+{
+    struct fs_bench bench;
+    const char *fstype, *device, *path;
+
+    if (argc < 4)
+    {
+        rt_kprintf("fs_bench <fstype> <device> <path> [size_kb], the device is formatted\n");
+        return -1;
+    }
+    fstype = argv[1];
+    device = argv[2];
+    path = argv[3];
+
+    rt_memset(&bench, 0, sizeof(bench));
+    bench.dev = rt_device_find(device);
+    bench.size = RT_ALIGN_DOWN((argc > 4) ? atoi(argv[4]) * 1024 : 256 * 1024, BENCH_IO_SIZE);
+    bench.seed = 0x12345678;
+    if (bench.dev == RT_NULL || bench.size == 0)
+    {
+        rt_kprintf("no device %s, or size is too small\n", device);
+        return -1;
+    }
+    rt_snprintf(bench.file, sizeof(bench.file), "%s/%s", path, BENCH_FILE);
+
+    bench.buf = rt_malloc(BENCH_IO_SIZE);
+    if (bench.buf == RT_NULL)
+        return -1;
+
+    if (dfs_mkfs(fstype, device) != 0)
+        rt_kprintf("mkfs failed, use the old one\n");
+
+    mkdir(path, 0);
+    if (bench_mount(&bench, device, path, fstype) != 0)
+        goto __exit;
+
+    bench_report(&bench, "seq write", 1, 0, bench_io);
+    bench_report(&bench, "seq read", 0, 0, bench_io);
+    bench_report(&bench, "rand write", 1, 1, bench_io);
+    bench_report(&bench, "rand read", 0, 1, bench_io);
+#ifdef RT_USING_POSIX_AIO
+    bench_report(&bench, "aio write", 1, 0, bench_aio);
+    bench_report(&bench, "aio read", 0, 0, bench_aio);
+#endif
+
+    /* mount the file system with data */
+    dfs_unmount(path);
+    if (bench_mount(&bench, device, path, fstype) != 0)
+        goto __exit;
+
+    unlink(bench.file);
+    dfs_unmount(path);
+
+__exit:
+    rt_free(bench.buf);
+
+    return 0;
+}
+MSH_CMD_EXPORT(fs_bench, benchmark a file system on a device);
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    the first version
+ * 2026-10-19     heyuanjie    builtins only with native compare-and-swap
+ * 2026-10-19     heyuanjie    add back MCS lock, measured by lock_bench
+ */
+
+#ifndef __RT_ATOMIC_H__
+#define __RT_ATOMIC_H__
+
+#include <rtdef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * atomic operations on a word, which is also wide enough to hold a pointer.
+ * The operations are sequentially consistent, so a lock built on them
+ * needs no more memory barrier.
+ */
+typedef rt_base_t rt_atomic_t;
+
+/*
+ * the builtins are used only when the word compare-and-swap is native, on
+ * the others (e.g. armv6-m, armv5) they are calls to libatomic.
+ */
+#if (defined(__GNUC__) || defined(__clang__)) &&                                    \
+    ((__SIZEOF_LONG__ == 4 && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)) ||       \
+     (__SIZEOF_LONG__ == 8 && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8)))
+
+rt_inline rt_atomic_t rt_atomic_load(volatile rt_atomic_t *ptr)
+{
+    return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+}
+
+rt_inline void rt_atomic_store(volatile rt_atomic_t *ptr, rt_atomic_t val)
+{
+    __atomic_store_n(ptr, val, __ATOMIC_SEQ_CST);
+}
+
+/* the following operations return the old value */
+rt_inline rt_atomic_t rt_atomic_add(volatile rt_atomic_t *ptr, rt_atomic_t val)
+{
+    return __atomic_fetch_add(ptr, val, __ATOMIC_SEQ_CST);
+}
+
+rt_inline rt_atomic_t rt_atomic_sub(volatile rt_atomic_t *ptr, rt_atomic_t val)
+{
+    return __atomic_fetch_sub(ptr, val, __ATOMIC_SEQ_CST);
+}
+
+rt_inline rt_atomic_t rt_atomic_or(volatile rt_atomic_t *ptr, rt_atomic_t val)
+{
+    return __atomic_fetch_or(ptr, val, __ATOMIC_SEQ_CST);
+}
+
+rt_inline rt_atomic_t rt_atomic_and(volatile rt_atomic_t *ptr, rt_atomic_t val)
+{
+    return __atomic_fetch_and(ptr, val, __ATOMIC_SEQ_CST);
+}
+
+rt_inline rt_atomic_t rt_atomic_exchange(volatile rt_atomic_t *ptr, rt_atomic_t val)
+{
+    return __atomic_exchange_n(ptr, val, __ATOMIC_SEQ_CST);
+}
+
+/* set *ptr to val if it is *old, otherwise get it to *old */
+rt_inline rt_bool_t rt_atomic_compare_exchange(volatile rt_atomic_t *ptr, rt_atomic_t *old, rt_atomic_t val)
+{
+    return __atomic_compare_exchange_n(ptr, old, val, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST) ? RT_TRUE : RT_FALSE;
+}
+
+#ifndef rt_hw_cpu_relax
+#if defined(__i386__) || defined(__x86_64__)
+#define rt_hw_cpu_relax()   __asm__ volatile("pause" ::: "memory")
+#elif defined(__aarch64__) || (defined(__ARM_ARCH) && __ARM_ARCH >= 7)
+#define rt_hw_cpu_relax()   __asm__ volatile("yield" ::: "memory")
+#else
+#define rt_hw_cpu_relax()   __asm__ volatile("" ::: "memory")
+#endif
+#endif
+
+#elif !defined(RT_USING_SMP)
+
+/* a single core, interrupt disabling makes the operations atomic */
+rt_base_t rt_hw_interrupt_disable(void);
+void rt_hw_interrupt_enable(rt_base_t level);
+
+rt_inline rt_atomic_t rt_atomic_load(volatile rt_atomic_t *ptr)
+{
+    return *ptr;
+}
+
+rt_inline void rt_atomic_store(volatile rt_atomic_t *ptr, rt_atomic_t val)
+{
+    *ptr = val;
+}
+
+#define RT_ATOMIC_FETCH_OP(name, op)                                        \
+rt_inline rt_atomic_t rt_atomic_##name(volatile rt_atomic_t *ptr, rt_atomic_t val) \
+{                                                                           \
+    rt_base_t level;                                                        \
+    rt_atomic_t old;                                                        \
+                                                                            \
+    level = rt_hw_interrupt_disable();                                      \
+    old = *ptr;                                                             \
+    *ptr = op;                                                              \
+    rt_hw_interrupt_enable(level);                                          \
+                                                                            \
+    return old;                                                             \
+}
+
+RT_ATOMIC_FETCH_OP(add, old + val)
+RT_ATOMIC_FETCH_OP(sub, old - val)
+RT_ATOMIC_FETCH_OP(or, old | val)
+RT_ATOMIC_FETCH_OP(and, old & val)
+RT_ATOMIC_FETCH_OP(exchange, val)
+
+rt_inline rt_bool_t rt_atomic_compare_exchange(volatile rt_atomic_t *ptr, rt_atomic_t *old, rt_atomic_t val)
+{
+    rt_base_t level;
+    rt_bool_t result = RT_FALSE;
+
+    level = rt_hw_interrupt_disable();
+    if (*ptr == *old)
+    {
+        *ptr = val;
+        result = RT_TRUE;
+    }
+    else
+    {
+        *old = *ptr;
+    }
+    rt_hw_interrupt_enable(level);
+
+    return result;
+}
+
+#ifndef rt_hw_cpu_relax
+#define rt_hw_cpu_relax()
+#endif
+
+#else
+#error "the cpu has no atomic operations for SMP"
+#endif
+
+/*
+ * ticket lock, the lockers get the lock in the order they come.
+ */
+struct rt_ticket_lock
+{
+    rt_atomic_t next;                                   /**< the next ticket to take */
+    rt_atomic_t owner;                                  /**< the ticket holding the lock */
+};
+
+#define RT_TICKET_LOCK_INIT     {0, 0}
+
+rt_inline void rt_ticket_lock_init(struct rt_ticket_lock *lock)
+{
+    rt_atomic_store(&lock->next, 0);
+    rt_atomic_store(&lock->owner, 0);
+}
+
+rt_inline void rt_ticket_lock(struct rt_ticket_lock *lock)
+{
+    rt_atomic_t ticket;
+
+    ticket = rt_atomic_add(&lock->next, 1);
+    while (rt_atomic_load(&lock->owner) != ticket)
+        rt_hw_cpu_relax();
+}
+
+rt_inline rt_bool_t rt_ticket_trylock(struct rt_ticket_lock *lock)
+{
+    rt_atomic_t ticket;
+
+    /* it is free when no ticket is taken after the owner */
+    ticket = rt_atomic_load(&lock->owner);
+
+    return rt_atomic_compare_exchange(&lock->next, &ticket, ticket + 1);
+}
+
+rt_inline void rt_ticket_unlock(struct rt_ticket_lock *lock)
+{
+    rt_atomic_add(&lock->owner, 1);
+}
+
+rt_inline rt_bool_t rt_ticket_is_locked(struct rt_ticket_lock *lock)
+{
+    return rt_atomic_load(&lock->next) != rt_atomic_load(&lock->owner);
+}
+
+/*
+ * MCS queue lock, every locker spins on its own node, so the cache line
+ * of lock is not bounced between cpus under contention. The node must
+ * stay valid until the lock is released.
+ */
+struct rt_mcs_node
+{
+    rt_atomic_t next;                                   /**< the next waiting node */
+    rt_atomic_t locked;                                 /**< waiting for the lock */
+};
+
+struct rt_mcs_lock
+{
+    rt_atomic_t tail;                                   /**< the last node in queue */
+};
+
+#define RT_MCS_LOCK_INIT        {0}
+
+rt_inline void rt_mcs_lock_init(struct rt_mcs_lock *lock)
+{
+    rt_atomic_store(&lock->tail, 0);
+}
+
+rt_inline void rt_mcs_lock(struct rt_mcs_lock *lock, struct rt_mcs_node *node)
+{
+    struct rt_mcs_node *prev;
+
+    rt_atomic_store(&node->next, 0);
+    rt_atomic_store(&node->locked, 1);
+
+    prev = (struct rt_mcs_node *)rt_atomic_exchange(&lock->tail, (rt_atomic_t)node);
+    if (prev != RT_NULL)
+    {
+        rt_atomic_store(&prev->next, (rt_atomic_t)node);
+        while (rt_atomic_load(&node->locked))
+            rt_hw_cpu_relax();
+    }
+}
+
+rt_inline rt_bool_t rt_mcs_trylock(struct rt_mcs_lock *lock, struct rt_mcs_node *node)
+{
+    rt_atomic_t tail = 0;
+
+    rt_atomic_store(&node->next, 0);
+    rt_atomic_store(&node->locked, 0);
+
+    return rt_atomic_compare_exchange(&lock->tail, &tail, (rt_atomic_t)node);
+}
+
+rt_inline void rt_mcs_unlock(struct rt_mcs_lock *lock, struct rt_mcs_node *node)
+{
+    struct rt_mcs_node *next;
+    rt_atomic_t tail;
+
+    next = (struct rt_mcs_node *)rt_atomic_load(&node->next);
+    if (next == RT_NULL)
+    {
+        /* no one is waiting */
+        tail = (rt_atomic_t)node;
+        if (rt_atomic_compare_exchange(&lock->tail, &tail, 0))
+            return;
+
+        /* a locker is coming, wait it to link itself */
+        while ((next = (struct rt_mcs_node *)rt_atomic_load(&node->next)) == RT_NULL)
+            rt_hw_cpu_relax();
+    }
+
+    rt_atomic_store(&next->locked, 0);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
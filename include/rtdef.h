@@ -29,6 +29,8 @@
  * 2018-11-22     Jesven       add smp member to struct rt_thread
  *                             add struct rt_cpu
  *                             add smp relevant macros
+ * 2026-10-19     heyuanjie    add message priority of message queue
+ * 2026-10-19     heyuanjie    add console of thread
  */
 
 #ifndef __RT_DEF_H__
@@ -452,6 +454,54 @@ struct rt_timer
 };
 typedef struct rt_timer *rt_timer_t;
 
+/**
+ * clock source structure, a free-running counter registered by port
+ */
+struct rt_clocksource
+{
+    const char  *name;                                  /**< name of clock source */
+    rt_uint64_t (*read)(void);                          /**< read the counter */
+    rt_uint64_t  mask;                                  /**< valid bits of counter */
+    rt_uint32_t  freq;                                  /**< counting frequency, Hz */
+
+    rt_uint32_t  mult;                                  /**< ns = (cycles * mult) >> shift */
+    rt_uint32_t  shift;
+};
+
+#ifdef RT_USING_HRTIMER
+/**
+ * clock event structure, a one-shot comparator registered by port. Its
+ * interrupt shall invoke rt_hrtimer_interrupt.
+ */
+struct rt_clockevent
+{
+    const char  *name;                                  /**< name of clock event */
+    rt_err_t   (*set_next)(rt_uint64_t ns);             /**< interrupt after ns */
+    rt_uint64_t  min_ns;                                /**< the shortest programmable time */
+    rt_uint64_t  max_ns;                                /**< the longest programmable time */
+};
+
+#define RT_HRTIMER_FLAG_DEACTIVATED     0x0             /**< high-resolution timer is deactive */
+#define RT_HRTIMER_FLAG_ACTIVATED       0x1             /**< high-resolution timer is active */
+
+/**
+ * high-resolution timer structure, its time is rt_clock_ns in nanosecond
+ */
+struct rt_hrtimer
+{
+    rt_list_t    list;                                  /**< node of the sorted timer list */
+
+    void (*timeout_func)(void *parameter);              /**< timeout function */
+    void        *parameter;                             /**< timeout function's parameter */
+
+    rt_uint64_t  expire;                                /**< absolute expire time */
+    rt_uint64_t  period;                                /**< period, 0 for one shot */
+    rt_uint32_t  overrun;                               /**< periods missed at last expiration */
+    rt_uint8_t   flag;
+};
+typedef struct rt_hrtimer *rt_hrtimer_t;
+#endif
+
 /*@}*/
 
 /**
@@ -539,6 +589,8 @@ struct rt_cpu
 /**
  * Thread structure
  */
+struct rt_console;
+
 struct rt_thread
 {
     /* rt object */
@@ -604,6 +656,15 @@ struct rt_thread
 
     void (*cleanup)(struct rt_thread *tid);             /**< cleanup function when thread exit */
 
+#ifdef RT_USING_CONSOLE
+    struct rt_console *console;                         /**< rt_kprintf output, RT_NULL for system console */
+#endif
+
+#ifdef RT_USING_CPUTIME
+    rt_uint64_t cpu_time;                               /**< consumed cpu time, ns */
+    rt_uint64_t cpu_stamp;                              /**< when the thread got cpu, ns */
+#endif
+
     /* light weight process if present */
 #ifdef RT_USING_LWP
     void        *lwp;
@@ -716,6 +777,15 @@ typedef struct rt_mailbox *rt_mailbox_t;
 #endif
 
 #ifdef RT_USING_MESSAGEQUEUE
+/* the priority levels of message, 0 is the highest one */
+#ifndef RT_MQ_PRIO_MAX
+#define RT_MQ_PRIO_MAX                  8
+#endif
+
+#if RT_MQ_PRIO_MAX < 1 || RT_MQ_PRIO_MAX > 32
+#error "RT_MQ_PRIO_MAX should be 1 - 32"
+#endif
+
 /**
  * message queue structure
  */
@@ -733,6 +803,9 @@ struct rt_messagequeue
     void                *msg_queue_head;                /**< list head */
     void                *msg_queue_tail;                /**< list tail */
     void                *msg_queue_free;                /**< pointer indicated the free node of queue */
+
+    void                *msg_prio_tail[RT_MQ_PRIO_MAX]; /**< the last message of each priority */
+    rt_uint32_t          msg_prio_ready;                /**< the priorities have messages */
 };
 typedef struct rt_messagequeue *rt_mq_t;
 #endif
@@ -811,10 +884,14 @@ struct rt_mempool
 typedef struct rt_mempool *rt_mp_t;
 #endif
 
+/**
+ * console of a thread, which takes the rt_kprintf output of the thread.
+ * The write must not block, it may be called with interrupts disabled.
+ */
 struct rt_console
 {
 	void (*init)(struct rt_console *con);
-	void (*write)(struct rt_console *con, char ch);
+	void (*write)(struct rt_console *con, const char *str, rt_size_t length);
 	void *user_data;
 #ifdef RT_USING_DEVICE
     const void* device;
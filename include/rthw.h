@@ -12,6 +12,7 @@
  * 2017-10-17     Hichard      add some micros
  * 2018-11-17     Jesven       add rt_hw_spinlock_t
  *                             add smp support
+ * 2026-10-19     heyuanjie    rt_hw_spinlock_t is a ticket lock of rtatomic.h
  */
 
 #ifndef __RT_HW_H__
@@ -134,14 +135,21 @@ void rt_hw_exception_install(rt_err_t (*exception_handle)(void *context));
  */
 void rt_hw_us_delay(rt_uint32_t us);
 
+/*
+ * clock source interfaces
+ */
+int rt_hw_cycle_clocksource_init(rt_uint32_t freq);
+
+/*
+ * clock event interfaces
+ */
+int rt_hw_systick_clockevent_init(rt_uint32_t freq);
+
 #ifdef RT_USING_SMP
-typedef union {
-    unsigned long slock;
-    struct __arch_tickets {
-        unsigned short owner;
-        unsigned short next;
-    } tickets;
-} rt_hw_spinlock_t;
+#include <rtatomic.h>
+
+/* a ticket lock, the port may implement rt_hw_spin_lock/unlock on its own */
+typedef struct rt_ticket_lock rt_hw_spinlock_t;
 
 void rt_hw_spin_lock(rt_hw_spinlock_t *lock);
 void rt_hw_spin_unlock(rt_hw_spinlock_t *lock);
@@ -14,6 +14,7 @@
  * 2013-06-24     Bernard      add rt_kprintf re-define when not use RT_USING_CONSOLE.
  * 2016-08-09     ArdaFu       add new thread and interrupt hook.
  * 2018-11-22     Jesven       add all cpu's lock and ipi handler
+ * 2026-10-19     heyuanjie    add futex interface
  */
 
 #ifndef __RT_THREAD_H__
@@ -24,6 +25,9 @@
 #include <rtdef.h>
 #include <rtservice.h>
 #include <rtm.h>
+#ifdef RT_USING_FUTEX
+#include <rtatomic.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -48,6 +52,9 @@ void rt_object_detach(rt_object_t object);
 rt_object_t rt_object_allocate(enum rt_object_class_type type,
                                const char               *name);
 void rt_object_delete(rt_object_t object);
+void rt_object_reuse(rt_object_t               object,
+                     enum rt_object_class_type type,
+                     const char               *name);
 rt_bool_t rt_object_is_systemobject(rt_object_t object);
 rt_uint8_t rt_object_get_type(rt_object_t object);
 rt_object_t rt_object_find(const char *name, rt_uint8_t type);
@@ -77,6 +84,10 @@ void rt_tick_set(rt_tick_t tick);
 void rt_tick_increase(void);
 int  rt_tick_from_millisecond(rt_int32_t ms);
 
+rt_err_t rt_clocksource_register(struct rt_clocksource *cs);
+rt_uint64_t rt_clock_ns(void);
+rt_uint32_t rt_clock_resolution_ns(void);
+
 void rt_system_timer_init(void);
 void rt_system_timer_thread_init(void);
 
@@ -105,6 +116,21 @@ void rt_timer_enter_sethook(void (*hook)(struct rt_timer *timer));
 void rt_timer_exit_sethook(void (*hook)(struct rt_timer *timer));
 #endif
 
+#ifdef RT_USING_HRTIMER
+rt_err_t rt_clockevent_register(struct rt_clockevent *ce);
+
+void rt_hrtimer_init(rt_hrtimer_t timer,
+                     void (*timeout)(void *parameter),
+                     void       *parameter);
+rt_err_t rt_hrtimer_start(rt_hrtimer_t timer, rt_uint64_t expire, rt_uint64_t period);
+rt_err_t rt_hrtimer_stop(rt_hrtimer_t timer);
+rt_err_t rt_hrtimer_sleep(rt_uint64_t ns);
+rt_err_t rt_hrtimer_sleep_until(rt_uint64_t expire);
+
+void rt_hrtimer_interrupt(void);
+void rt_hrtimer_tick(void);
+#endif
+
 /**@}*/
 
 /**
@@ -131,10 +157,16 @@ rt_thread_t rt_thread_create(const char *name,
                              rt_uint32_t stack_size,
                              rt_uint8_t  priority,
                              rt_uint32_t tick);
+rt_thread_t rt_thread_alloc(rt_uint32_t stack_size);
+void rt_thread_free(rt_thread_t thread);
+#ifdef RT_USING_THREAD_CACHE
+void rt_thread_cache_fill(void);
+#endif
 rt_thread_t rt_thread_self(void);
 rt_thread_t rt_thread_find(char *name);
 rt_err_t rt_thread_startup(rt_thread_t thread);
 rt_err_t rt_thread_delete(rt_thread_t thread);
+void rt_thread_exit(void);
 
 rt_err_t rt_thread_yield(void);
 rt_err_t rt_thread_delay(rt_tick_t tick);
@@ -143,11 +175,15 @@ rt_err_t rt_thread_control(rt_thread_t thread, int cmd, void *arg);
 rt_err_t rt_thread_suspend(rt_thread_t thread);
 rt_err_t rt_thread_resume(rt_thread_t thread);
 void rt_thread_timeout(void *parameter);
+#ifdef RT_USING_CPUTIME
+rt_uint64_t rt_thread_cputime(rt_thread_t thread);
+#endif
 
 #ifdef RT_USING_SIGNALS
 void rt_thread_alloc_sig(rt_thread_t tid);
 void rt_thread_free_sig(rt_thread_t tid);
 int  rt_thread_kill(rt_thread_t tid, int sig);
+int  rt_thread_sigqueue(rt_thread_t tid, const rt_siginfo_t *info);
 #endif
 
 #ifdef RT_USING_HOOK
@@ -166,6 +202,9 @@ rt_err_t rt_thread_idle_delhook(void (*hook)(void));
 #endif
 void rt_thread_idle_excute(void);
 rt_thread_t rt_thread_idle_gethandler(void);
+#ifdef RT_USING_CPUTIME
+rt_uint64_t rt_thread_idle_cputime(void);
+#endif
 
 /*
  * schedule service
@@ -358,12 +397,24 @@ rt_err_t rt_mb_send_wait(rt_mailbox_t mb,
                          rt_ubase_t  value,
                          rt_int32_t   timeout);
 rt_err_t rt_mb_recv(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeout);
+rt_err_t rt_mb_send_batch(rt_mailbox_t      mb,
+                          const rt_ubase_t *values,
+                          rt_size_t        *count,
+                          rt_int32_t        timeout);
+rt_err_t rt_mb_recv_batch(rt_mailbox_t mb,
+                          rt_ubase_t  *values,
+                          rt_size_t   *count,
+                          rt_int32_t   timeout);
 rt_err_t rt_mb_control(rt_mailbox_t mb, int cmd, void *arg);
 #endif
 
 #ifdef RT_USING_MESSAGEQUEUE
 /*
  * message queue interface
+ *
+ * Each message takes msg_size and a header in the pool. The header has the
+ * priority and size of message besides the list pointer, which is 8 bytes
+ * on 32-bit cpu, 4 bytes more than the one without priority.
  */
 rt_err_t rt_mq_init(rt_mq_t     mq,
                     const char *name,
@@ -379,14 +430,38 @@ rt_mq_t rt_mq_create(const char *name,
 rt_err_t rt_mq_delete(rt_mq_t mq);
 
 rt_err_t rt_mq_send(rt_mq_t mq, void *buffer, rt_size_t size);
+rt_err_t rt_mq_send_prio(rt_mq_t mq, void *buffer, rt_size_t size, int prio);
 rt_err_t rt_mq_urgent(rt_mq_t mq, void *buffer, rt_size_t size);
 rt_err_t rt_mq_recv(rt_mq_t    mq,
                     void      *buffer,
                     rt_size_t  size,
                     rt_int32_t timeout);
+rt_err_t rt_mq_recv_prio(rt_mq_t     mq,
+                         void       *buffer,
+                         rt_size_t   size,
+                         int        *prio,
+                         rt_size_t  *length,
+                         rt_int32_t  timeout);
+
+/* the message buffer is loaned without copy */
+void *rt_mq_alloc_msg(rt_mq_t mq);
+rt_err_t rt_mq_send_msg(rt_mq_t mq, void *buffer, rt_size_t size, int prio);
+rt_err_t rt_mq_recv_msg(rt_mq_t     mq,
+                        void      **buffer,
+                        rt_size_t  *size,
+                        rt_int32_t  timeout);
+void rt_mq_release_msg(rt_mq_t mq, void *buffer);
 rt_err_t rt_mq_control(rt_mq_t mq, int cmd, void *arg);
 #endif
 
+#ifdef RT_USING_FUTEX
+/*
+ * futex interface
+ */
+rt_err_t rt_futex_wait(volatile rt_atomic_t *addr, rt_atomic_t value, rt_int32_t timeout);
+int rt_futex_wake(volatile rt_atomic_t *addr, int count);
+#endif
+
 
 /*
  * interrupt service
@@ -15,6 +15,7 @@
  * 2012-12-23   aozima      stack addr align to 8byte.
  * 2012-12-29   Bernard     Add exception hook.
  * 2013-07-09   aozima      enhancement hard fault exception handler.
+ * 2026-10-19   heyuanjie   add DWT cycle counter clock source.
  */
 
 #include <rtthread.h>
@@ -352,6 +353,39 @@ void rt_hw_cpu_shutdown(void)
     RT_ASSERT(0);
 }
 
+#define DWT_DEMCR       (*(volatile unsigned *)0xE000EDFC) /* Debug Exception and Monitor Control Register */
+#define DWT_CTRL        (*(volatile unsigned *)0xE0001000) /* DWT Control Register */
+#define DWT_CYCCNT      (*(volatile unsigned *)0xE0001004) /* Cycle Count Register */
+
+static rt_uint64_t rt_hw_cycle_read(void)
+{
+    return DWT_CYCCNT;
+}
+
+static struct rt_clocksource rt_hw_cycle_clocksource =
+{
+    "cyccnt",
+    rt_hw_cycle_read,
+    0xFFFFFFFF,
+};
+
+/**
+ * register DWT cycle counter as clock source of kernel
+ *
+ * @param freq the frequency of core clock
+ */
+int rt_hw_cycle_clocksource_init(rt_uint32_t freq)
+{
+    /* enable trace and cycle counter */
+    DWT_DEMCR |= (1UL << 24);
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= (1UL << 0);
+
+    rt_hw_cycle_clocksource.freq = freq;
+
+    return rt_clocksource_register(&rt_hw_cycle_clocksource);
+}
+
 #ifdef RT_USING_CPU_FFS
 /**
  * This function finds the first bit set (beginning with the least significant bit)
@@ -17,6 +17,8 @@
  * 2012-12-23     aozima       stack addr align to 8byte.
  * 2012-12-29     Bernard      Add exception hook.
  * 2013-06-23     aozima       support lazy stack optimized.
+ * 2026-10-19     heyuanjie    add DWT cycle counter clock source.
+ * 2026-10-19     heyuanjie    add SysTick clock event.
  */
 
 #include <rtthread.h>
@@ -223,6 +225,105 @@ void rt_hw_cpu_shutdown(void)
     RT_ASSERT(0);
 }
 
+#define DWT_DEMCR       (*(volatile unsigned *)0xE000EDFC) /* Debug Exception and Monitor Control Register */
+#define DWT_CTRL        (*(volatile unsigned *)0xE0001000) /* DWT Control Register */
+#define DWT_CYCCNT      (*(volatile unsigned *)0xE0001004) /* Cycle Count Register */
+
+static rt_uint64_t rt_hw_cycle_read(void)
+{
+    return DWT_CYCCNT;
+}
+
+static struct rt_clocksource rt_hw_cycle_clocksource =
+{
+    "cyccnt",
+    rt_hw_cycle_read,
+    0xFFFFFFFF,
+};
+
+/**
+ * register DWT cycle counter as clock source of kernel
+ *
+ * @param freq the frequency of core clock
+ */
+int rt_hw_cycle_clocksource_init(rt_uint32_t freq)
+{
+    /* enable trace and cycle counter */
+    DWT_DEMCR |= (1UL << 24);
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= (1UL << 0);
+
+    rt_hw_cycle_clocksource.freq = freq;
+
+    return rt_clocksource_register(&rt_hw_cycle_clocksource);
+}
+
+#ifdef RT_USING_HRTIMER
+#define SYSTICK_CTRL    (*(volatile unsigned *)0xE000E010) /* SysTick Control and Status Register */
+#define SYSTICK_LOAD    (*(volatile unsigned *)0xE000E014) /* SysTick Reload Value Register */
+#define SYSTICK_VAL     (*(volatile unsigned *)0xE000E018) /* SysTick Current Value Register */
+
+#define SYSTICK_MIN_CYCLES      256         /* to leave the interrupt before the next one */
+
+static rt_uint32_t rt_hw_systick_freq;
+static struct rt_hrtimer rt_hw_tick_timer;
+
+static rt_err_t rt_hw_systick_set_next(rt_uint64_t ns)
+{
+    rt_uint32_t cycles;
+
+    cycles = (rt_uint32_t)(ns * rt_hw_systick_freq / 1000000000ULL);
+    if (cycles < SYSTICK_MIN_CYCLES)
+        cycles = SYSTICK_MIN_CYCLES;
+
+    /* restart counting down from the new value on core clock */
+    SYSTICK_CTRL = 0;
+    SYSTICK_LOAD = cycles - 1;
+    SYSTICK_VAL  = 0;
+    SYSTICK_CTRL = 0x07;
+
+    return RT_EOK;
+}
+
+static struct rt_clockevent rt_hw_systick_clockevent =
+{
+    "systick",
+    rt_hw_systick_set_next,
+};
+
+static void rt_hw_tick_timeout(void *parameter)
+{
+    rt_tick_increase();
+}
+
+/**
+ * use SysTick as clock event of high-resolution timer, so its timers expire
+ * between the ticks. The system tick becomes a periodic high-resolution
+ * timer on DWT cycle counter, which is registered as clock source as well.
+ *
+ * BSP shall call it instead of setting up SysTick periodic, and the
+ * SysTick_Handler invokes rt_hrtimer_interrupt instead of rt_tick_increase.
+ *
+ * @param freq the frequency of core clock
+ */
+int rt_hw_systick_clockevent_init(rt_uint32_t freq)
+{
+    rt_uint64_t period = 1000000000ULL / RT_TICK_PER_SECOND;
+
+    rt_hw_cycle_clocksource_init(freq);
+
+    rt_hw_systick_freq = freq;
+    rt_hw_systick_clockevent.min_ns = SYSTICK_MIN_CYCLES * 1000000000ULL / freq;
+    /* the 24 bits reload value */
+    rt_hw_systick_clockevent.max_ns = 0xFFFFFFULL * 1000000000ULL / freq;
+
+    rt_hrtimer_init(&rt_hw_tick_timer, rt_hw_tick_timeout, RT_NULL);
+    rt_hrtimer_start(&rt_hw_tick_timer, rt_clock_ns() + period, period);
+
+    return rt_clockevent_register(&rt_hw_systick_clockevent);
+}
+#endif
+
 #ifdef RT_USING_CPU_FFS
 /**
  * This function finds the first bit set (beginning with the least significant bit)
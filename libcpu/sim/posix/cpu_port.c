@@ -33,6 +33,7 @@ typedef struct _thread
 #define MSG_SUSPEND  SIGUSR1    /* 10 */
 #define MSG_RESUME   SIGUSR2
 #define MSG_TICK     SIGALRM    /* 14 */
+#define MSG_HRTIMER  SIGRTMIN   /* clock event of high-resolution timer */
 #define TIMER_TYPE   ITIMER_REAL
 #define MAX_INTERRUPT_NUM ((unsigned int)sizeof(unsigned int) * 8)
 
@@ -62,6 +63,52 @@ static pthread_t mainthread_pid;
 
 /* function definition */
 static void start_sys_timer(void);
+
+static rt_uint64_t sim_clock_read(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (rt_uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static struct rt_clocksource sim_clocksource =
+{
+    "monotonic",
+    sim_clock_read,
+    0xFFFFFFFFFFFFFFFFULL,
+    1000000000UL,
+};
+
+#ifdef RT_USING_HRTIMER
+static timer_t sim_hrtimer;
+
+static rt_err_t sim_clockevent_set_next(rt_uint64_t ns)
+{
+    struct itimerspec its;
+
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = ns / 1000000000ULL;
+    its.it_value.tv_nsec = ns % 1000000000ULL;
+    if (timer_settime(sim_hrtimer, 0, &its, NULL) != 0)
+        return -RT_ERROR;
+
+    return RT_EOK;
+}
+
+/* one-shot host timer, its signal is the interrupt of clock event */
+static struct rt_clockevent sim_clockevent =
+{
+    "monotonic",
+    sim_clockevent_set_next,
+    10000ULL,                   /* shorter is not kept by host */
+    0,
+};
+
+static void start_hrtimer(void);
+static int hrtimer_interrupt_isr(void);
+#endif
 static int tick_interrupt_isr(void);
 static void mthread_signal_tick(int sig);
 static int mainthread_scheduler(void);
@@ -84,6 +131,9 @@ int signal_mask(void)
     /* set signal mask */
     sigemptyset(&sigmask);
     sigaddset(&sigmask, SIGALRM);
+#ifdef RT_USING_HRTIMER
+    sigaddset(&sigmask, MSG_HRTIMER);
+#endif
     pthread_sigmask(SIG_BLOCK, &sigmask, &oldmask);
 }
 static void thread_suspend_signal_handler(int sig)
@@ -443,6 +493,10 @@ static int mainthread_scheduler(void)
 
     sigemptyset(&sigmask);
     sigaddset(&sigmask, SIGALRM);
+#ifdef RT_USING_HRTIMER
+    sigaddset(&sigmask, MSG_HRTIMER);
+    pthread_sigmask(SIG_BLOCK, &sigmask, &oldmask);
+#endif
 
     /* install signal handler of system tick */
     signal_install(SIGALRM, mthread_signal_tick);
@@ -456,8 +510,14 @@ static int mainthread_scheduler(void)
     pthread_mutexattr_settype(&mutexattr, PTHREAD_MUTEX_RECURSIVE_NP);
     pthread_mutex_init(ptr_int_mutex, &mutexattr);
 
+    /* nanosecond clock of kernel */
+    rt_clocksource_register(&sim_clocksource);
+
     /* start timer */
     start_sys_timer();
+#ifdef RT_USING_HRTIMER
+    start_hrtimer();
+#endif
 
     thread_to = (thread_t *) rt_interrupt_to_thread;
     thread_resume(thread_to);
@@ -478,6 +538,11 @@ static int mainthread_scheduler(void)
         // if (systick_signal_flag != 0)
         if (pthread_mutex_trylock(ptr_int_mutex) == 0)
         {
+#ifdef RT_USING_HRTIMER
+            if (sig == MSG_HRTIMER)
+                hrtimer_interrupt_isr();
+            else
+#endif
             tick_interrupt_isr();
             // systick_signal_flag = 0;
             pthread_mutex_unlock(ptr_int_mutex);
@@ -485,6 +550,11 @@ static int mainthread_scheduler(void)
         else
         {
             TRACE("try lock failed.\n");
+#ifdef RT_USING_HRTIMER
+            /* the one-shot timer is not lost, fire it again soon */
+            if (sig == MSG_HRTIMER)
+                sim_clockevent_set_next(sim_clockevent.min_ns);
+#endif
         }
 
         /* 开启SIGALRM信号 */
@@ -530,6 +600,41 @@ static void start_sys_timer(void)
     }
 }
 
+#ifdef RT_USING_HRTIMER
+/*
+ * Setup the one-shot host timer as clock event of high-resolution timer, so
+ * its timers expire between system ticks.
+ */
+static void start_hrtimer(void)
+{
+    struct sigevent sev;
+
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = MSG_HRTIMER;
+    if (timer_create(CLOCK_MONOTONIC, &sev, &sim_hrtimer) != 0)
+    {
+        TRACE("create hrtimer failed.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    rt_clockevent_register(&sim_clockevent);
+}
+
+static int hrtimer_interrupt_isr(void)
+{
+    /* enter interrupt */
+    rt_interrupt_enter();
+
+    rt_hrtimer_interrupt();
+
+    /* leave interrupt */
+    rt_interrupt_leave();
+
+    return 0;
+}
+#endif
+
 static void mthread_signal_tick(int sig)
 {
     int res;
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ */
+
+/*
+ * File backed block device, such as a sd card or emmc with its own ftl.
+ * A request is busy for the access time and the bytes on bus.
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+
+#ifdef RT_USING_FLASH_SIM
+
+#include <flash_sim.h>
+
+#ifndef DISK_SIM_READ_US
+#define DISK_SIM_READ_US        100
+#endif
+#ifndef DISK_SIM_PROG_US
+#define DISK_SIM_PROG_US        500
+#endif
+#ifndef DISK_SIM_BUS_NS
+#define DISK_SIM_BUS_NS         40      /* 4 bits sdio at 50MHz */
+#endif
+
+struct disk_sim
+{
+    struct rt_device parent;
+    struct flash_sim sim;
+
+    uint32_t sectors;
+    uint32_t sector_size;
+};
+
+#define US(t)       ((uint64_t)(t) * 1000)
+#define NOW(ds)     ((ds)->sim.stat.time_ns)
+
+static rt_size_t disk_sim_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    struct disk_sim *ds = (struct disk_sim *)dev;
+    uint32_t len;
+
+    if ((uint32_t)pos >= ds->sectors)
+        return 0;
+    if (size > ds->sectors - pos)
+        size = ds->sectors - pos;
+
+    len = size * ds->sector_size;
+    flash_sim_load(&ds->sim, pos * ds->sector_size, buffer, len);
+    flash_sim_wait(&ds->sim, NOW(ds) + US(ds->sim.cfg.read_us) + (uint64_t)len * ds->sim.cfg.bus_ns);
+
+    ds->sim.stat.reads ++;
+    ds->sim.stat.read_bytes += len;
+
+    return size;
+}
+
+static rt_size_t disk_sim_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    struct disk_sim *ds = (struct disk_sim *)dev;
+    uint32_t len;
+
+    if ((uint32_t)pos >= ds->sectors)
+        return 0;
+    if (size > ds->sectors - pos)
+        size = ds->sectors - pos;
+
+    len = size * ds->sector_size;
+    flash_sim_store(&ds->sim, pos * ds->sector_size, buffer, len);
+    flash_sim_wait(&ds->sim, NOW(ds) + US(ds->sim.cfg.prog_us) + (uint64_t)len * ds->sim.cfg.bus_ns);
+
+    ds->sim.stat.progs ++;
+    ds->sim.stat.prog_bytes += len;
+
+    return size;
+}
+
+static rt_err_t disk_sim_control(rt_device_t dev, int cmd, void *args)
+{
+    struct disk_sim *ds = (struct disk_sim *)dev;
+
+    switch (cmd)
+    {
+    case RT_DEVICE_CTRL_BLK_GETGEOME:
+    {
+        struct rt_device_blk_geometry *geometry = (struct rt_device_blk_geometry *)args;
+
+        if (geometry == RT_NULL)
+            return -RT_ERROR;
+
+        geometry->sector_count = ds->sectors;
+        geometry->bytes_per_sector = ds->sector_size;
+        geometry->block_size = ds->sector_size;
+    }break;
+
+    case RT_DEVICE_CTRL_BLK_SYNC:
+        fflush(ds->sim.fp);
+        break;
+
+    default:
+        break;
+    }
+
+    return RT_EOK;
+}
+
+static const struct rt_device_ops _disk_sim_ops =
+{
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    disk_sim_read,
+    disk_sim_write,
+    disk_sim_control,
+};
+
+/**
+ * This function will create a block device backed by host file, the file
+ * is created with zero if it doesn't exist.
+ *
+ * @param name the device name
+ * @param path the host file
+ * @param sectors the number of sectors
+ * @param sector_size the sector size
+ *
+ * @return 0 on OK, or a negative errno on failure
+ */
+int disk_sim_init(const char *name, const char *path, uint32_t sectors, uint32_t sector_size)
+{
+    struct disk_sim *ds;
+    int ret;
+
+    if (sectors == 0 || sector_size == 0 || sector_size % 512)
+        return -EINVAL;
+
+    ds = rt_malloc(sizeof(struct disk_sim));
+    if (ds == RT_NULL)
+        return -ENOMEM;
+    rt_memset(ds, 0, sizeof(struct disk_sim));
+
+    ret = flash_sim_open(&ds->sim, path, sectors * sector_size, 0);
+    if (ret)
+    {
+        rt_free(ds);
+        return ret;
+    }
+    ds->sim.cfg.read_us = DISK_SIM_READ_US;
+    ds->sim.cfg.prog_us = DISK_SIM_PROG_US;
+    ds->sim.cfg.bus_ns = DISK_SIM_BUS_NS;
+
+    ds->sectors = sectors;
+    ds->sector_size = sector_size;
+    ds->parent.type = RT_Device_Class_Block;
+    ds->parent.dops = &_disk_sim_ops;
+
+    if (rt_device_register(&ds->parent, name, RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_REMOVABLE) != RT_EOK)
+    {
+        flash_sim_close(&ds->sim);
+        rt_free(ds);
+        return -EIO;
+    }
+    flash_sim_register(&ds->sim, &ds->parent);
+
+    return 0;
+}
+RTM_EXPORT(disk_sim_init);
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+#include <stdlib.h>
+
+static int disk_sim(int argc, char **argv)
+{
+    uint32_t sectors;
+    int ret;
+
+    if (argc < 3)
+    {
+        rt_kprintf("disk_sim <name> <file> [size_kb]\n");
+        return -1;
+    }
+    sectors = (argc > 3) ? atoi(argv[3]) * 2 : 16 * 1024 * 2;
+
+    ret = disk_sim_init(argv[1], argv[2], sectors, 512);
+    if (ret)
+        rt_kprintf("create disk simulator failed: %d\n", ret);
+
+    return ret;
+}
+MSH_CMD_EXPORT(disk_sim, create file backed block device);
+#endif
+
+#endif
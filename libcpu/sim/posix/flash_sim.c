@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ */
+
+/*
+ * The common part of the flash and disk simulators backed by host file.
+ *
+ * The busy time of device is counted by a clock in ns. It's only counted
+ * by default, so the result doesn't depend on the host; with realtime the
+ * thread also sleeps on host for it, which makes the file systems on top
+ * see the latency.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+#include <rtdevice.h>
+
+#ifdef RT_USING_FLASH_SIM
+
+#include <time.h>
+#include <flash_sim.h>
+
+static rt_list_t _sim_list = RT_LIST_OBJECT_INIT(_sim_list);
+
+struct flash_sim *flash_sim_find(rt_device_t dev)
+{
+    struct flash_sim *sim = RT_NULL;
+    rt_list_t *node;
+    rt_base_t level;
+
+#if defined(RT_USING_MTD_NAND) || defined(RT_USING_MTD_NOR)
+    /* the partitions of mtd share the master */
+    if (dev != RT_NULL && dev->type == RT_Device_Class_MTD)
+        dev = &(((rt_mtd_t *)dev)->master->parent);
+#endif
+
+    level = rt_hw_interrupt_disable();
+    for (node = _sim_list.next; node != &_sim_list; node = node->next)
+    {
+        if (rt_list_entry(node, struct flash_sim, list)->dev == dev)
+        {
+            sim = rt_list_entry(node, struct flash_sim, list);
+            break;
+        }
+    }
+    rt_hw_interrupt_enable(level);
+
+    return sim;
+}
+
+/**
+ * This function will set the timing and fault model of a simulator.
+ *
+ * @param dev the device of simulator, or a partition of it
+ * @param cfg the new config
+ *
+ * @return 0 on OK, -ENODEV if it's not a simulator
+ */
+int flash_sim_config(rt_device_t dev, const struct flash_sim_config *cfg)
+{
+    struct flash_sim *sim = flash_sim_find(dev);
+
+    if (sim == RT_NULL)
+        return -ENODEV;
+
+    sim->cfg = *cfg;
+
+    return 0;
+}
+
+/**
+ * This function will get the statistics of a simulator, which are used to
+ * get the busy time and the write amplification.
+ *
+ * @param dev the device of simulator, or a partition of it
+ * @param stat the statistics got
+ * @param reset reset the counters except the clock
+ *
+ * @return 0 on OK, -ENODEV if it's not a simulator
+ */
+int flash_sim_stat(rt_device_t dev, struct flash_sim_stat *stat, int reset)
+{
+    struct flash_sim *sim = flash_sim_find(dev);
+    uint64_t time_ns;
+
+    if (sim == RT_NULL)
+        return -ENODEV;
+
+    if (stat != RT_NULL)
+        *stat = sim->stat;
+    if (reset)
+    {
+        time_ns = sim->stat.time_ns;
+        rt_memset(&sim->stat, 0, sizeof(sim->stat));
+        sim->stat.time_ns = time_ns;
+    }
+
+    return 0;
+}
+
+/* open the file, and extend it with the byte of erased device */
+int flash_sim_open(struct flash_sim *sim, const char *path, uint32_t size, uint8_t fill)
+{
+    uint8_t buf[512];
+    long end;
+
+    sim->fp = fopen(path, "r+b");
+    if (sim->fp == RT_NULL)
+        sim->fp = fopen(path, "w+b");
+    if (sim->fp == RT_NULL)
+        return -ENOENT;
+
+    fseek(sim->fp, 0, SEEK_END);
+    end = ftell(sim->fp);
+    if (end < 0)
+    {
+        flash_sim_close(sim);
+        return -EIO;
+    }
+
+    rt_memset(buf, fill, sizeof(buf));
+    while ((uint32_t)end < size)
+    {
+        uint32_t len = size - end > sizeof(buf) ? sizeof(buf) : size - end;
+
+        if (fwrite(buf, 1, len, sim->fp) != len)
+        {
+            flash_sim_close(sim);
+            return -EIO;
+        }
+        end += len;
+    }
+    fflush(sim->fp);
+
+    sim->size = size;
+    sim->seed = 0x12345678;
+
+    return 0;
+}
+
+void flash_sim_close(struct flash_sim *sim)
+{
+    if (sim->dev != RT_NULL)
+    {
+        rt_base_t level = rt_hw_interrupt_disable();
+        rt_list_remove(&sim->list);
+        rt_hw_interrupt_enable(level);
+        sim->dev = RT_NULL;
+    }
+
+    if (sim->fp != RT_NULL)
+    {
+        fclose(sim->fp);
+        sim->fp = RT_NULL;
+    }
+}
+
+void flash_sim_register(struct flash_sim *sim, rt_device_t dev)
+{
+    rt_base_t level;
+
+    sim->dev = dev;
+
+    level = rt_hw_interrupt_disable();
+    rt_list_insert_before(&_sim_list, &sim->list);
+    rt_hw_interrupt_enable(level);
+}
+
+/* the clock goes to the time, the busy time is spent on host for realtime */
+void flash_sim_wait(struct flash_sim *sim, uint64_t time_ns)
+{
+    if (sim->stat.time_ns >= time_ns)
+        return;
+
+    if (sim->cfg.realtime)
+    {
+        struct timespec ts;
+
+        ts.tv_sec = (time_t)((time_ns - sim->stat.time_ns) / 1000000000);
+        ts.tv_nsec = (long)((time_ns - sim->stat.time_ns) % 1000000000);
+        nanosleep(&ts, RT_NULL);
+    }
+    sim->stat.time_ns = time_ns;
+}
+
+void flash_sim_load(struct flash_sim *sim, uint32_t offset, uint8_t *buf, uint32_t len)
+{
+    if (offset >= sim->size)
+        return;
+    if (len > sim->size - offset)
+        len = sim->size - offset;
+
+    fseek(sim->fp, offset, SEEK_SET);
+    fread(buf, 1, len, sim->fp);
+}
+
+void flash_sim_store(struct flash_sim *sim, uint32_t offset, const uint8_t *buf, uint32_t len)
+{
+    if (offset >= sim->size)
+        return;
+    if (len > sim->size - offset)
+        len = sim->size - offset;
+
+    fseek(sim->fp, offset, SEEK_SET);
+    fwrite(buf, 1, len, sim->fp);
+}
+
+/* the bits can only be cleared by program */
+void flash_sim_program(struct flash_sim *sim, uint32_t offset, const uint8_t *buf, uint32_t len)
+{
+    uint8_t tmp[256];
+    uint32_t bytes, i;
+
+    for (; len > 0; offset += bytes, buf += bytes, len -= bytes)
+    {
+        bytes = len > sizeof(tmp) ? sizeof(tmp) : len;
+
+        rt_memset(tmp, 0xff, bytes);
+        flash_sim_load(sim, offset, tmp, bytes);
+        for (i = 0; i < bytes; i ++)
+            tmp[i] &= buf[i];
+        flash_sim_store(sim, offset, tmp, bytes);
+    }
+}
+
+static uint32_t flash_sim_rand(struct flash_sim *sim)
+{
+    sim->seed = sim->seed * 1103515245 + 12345;
+
+    return sim->seed >> 8;
+}
+
+/* flip some bits of a page read, they are not kept in the file */
+void flash_sim_flip(struct flash_sim *sim, uint8_t *buf, uint32_t len)
+{
+    int i;
+
+    if (sim->cfg.flip_rate == 0 || len == 0)
+        return;
+    if (flash_sim_rand(sim) % sim->cfg.flip_rate != 0)
+        return;
+
+    for (i = 0; i < sim->cfg.flip_bits; i ++)
+    {
+        uint32_t bit = flash_sim_rand(sim) % (len * 8);
+
+        buf[bit / 8] ^= 1 << (bit % 8);
+    }
+    sim->stat.flips += sim->cfg.flip_bits;
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+#include <stdlib.h>
+
+/* show the statistics, or set the config */
+static int flash_sim(int argc, char **argv)
+{
+    struct flash_sim *sim;
+    struct flash_sim_config cfg;
+
+    sim = (argc > 1) ? flash_sim_find(rt_device_find(argv[1])) : RT_NULL;
+    if (sim == RT_NULL)
+    {
+        rt_kprintf("flash_sim <device> [read_us prog_us erase_us bus_ns flip_rate flip_bits realtime]\n");
+        return -1;
+    }
+
+    if (argc > 2)
+    {
+        cfg = sim->cfg;
+        cfg.read_us = atoi(argv[2]);
+        if (argc > 3) cfg.prog_us = atoi(argv[3]);
+        if (argc > 4) cfg.erase_us = atoi(argv[4]);
+        if (argc > 5) cfg.bus_ns = atoi(argv[5]);
+        if (argc > 6) cfg.flip_rate = atoi(argv[6]);
+        if (argc > 7) cfg.flip_bits = atoi(argv[7]);
+        if (argc > 8) cfg.realtime = atoi(argv[8]);
+        sim->cfg = cfg;
+    }
+
+    rt_kprintf("read %u us, prog %u us, erase %u us, bus %u ns, flip 1/%u x %u bits%s\n",
+               sim->cfg.read_us, sim->cfg.prog_us, sim->cfg.erase_us, sim->cfg.bus_ns,
+               sim->cfg.flip_rate, sim->cfg.flip_bits, sim->cfg.realtime ? ", realtime" : "");
+    rt_kprintf("busy %u ms, read %u KB in %u, prog %u KB in %u, erase %u, flips %u\n",
+               (uint32_t)(sim->stat.time_ns / 1000000),
+               (uint32_t)(sim->stat.read_bytes >> 10), sim->stat.reads,
+               (uint32_t)(sim->stat.prog_bytes >> 10), sim->stat.progs,
+               sim->stat.erases, sim->stat.flips);
+
+    return 0;
+}
+MSH_CMD_EXPORT(flash_sim, show or set the flash simulator);
+#endif
+
+#endif
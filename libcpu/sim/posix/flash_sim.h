@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ */
+
+#ifndef __FLASH_SIM_H__
+#define __FLASH_SIM_H__
+
+#include <rtthread.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* the timing and fault model of a simulator */
+struct flash_sim_config
+{
+    uint32_t read_us;               /* nand tR, or nor access */
+    uint32_t prog_us;               /* nand tPROG, or nor program of 256 bytes */
+    uint32_t erase_us;              /* block erase */
+    uint32_t bus_ns;                /* a byte on bus */
+
+    uint32_t flip_rate;             /* one of flip_rate page reads has bit flips, 0 for none */
+    uint8_t flip_bits;              /* the bits flipped in a page */
+    uint8_t realtime;               /* sleep on host for the busy time */
+};
+
+struct flash_sim_stat
+{
+    uint64_t time_ns;               /* the busy time of device */
+    uint64_t read_bytes;
+    uint64_t prog_bytes;
+    uint32_t reads;
+    uint32_t progs;
+    uint32_t erases;
+    uint32_t flips;
+};
+
+/* the common part of simulators, kept in a list to be found by device */
+struct flash_sim
+{
+    rt_list_t list;
+    rt_device_t dev;
+
+    FILE *fp;
+    uint32_t size;
+    uint32_t seed;
+
+    struct flash_sim_config cfg;
+    struct flash_sim_stat stat;
+};
+
+struct flash_sim *flash_sim_find(rt_device_t dev);
+int flash_sim_config(rt_device_t dev, const struct flash_sim_config *cfg);
+int flash_sim_stat(rt_device_t dev, struct flash_sim_stat *stat, int reset);
+
+/* used by the simulators */
+int flash_sim_open(struct flash_sim *sim, const char *path, uint32_t size, uint8_t fill);
+void flash_sim_close(struct flash_sim *sim);
+void flash_sim_register(struct flash_sim *sim, rt_device_t dev);
+void flash_sim_wait(struct flash_sim *sim, uint64_t time_ns);
+void flash_sim_load(struct flash_sim *sim, uint32_t offset, uint8_t *buf, uint32_t len);
+void flash_sim_store(struct flash_sim *sim, uint32_t offset, const uint8_t *buf, uint32_t len);
+void flash_sim_program(struct flash_sim *sim, uint32_t offset, const uint8_t *buf, uint32_t len);
+void flash_sim_flip(struct flash_sim *sim, uint8_t *buf, uint32_t len);
+
+/* the simulated devices, 0 or a negative errno is returned */
+int nand_sim_init(const char *name, const char *path, int page_size,
+                  int oobsize, int pages_pb, int blocks);
+int nor_sim_init(const char *name, const char *path, uint32_t size, uint32_t erasesize);
+int disk_sim_init(const char *name, const char *path, uint32_t sectors, uint32_t sector_size);
+
+#endif
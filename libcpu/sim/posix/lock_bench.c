@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ */
+
+/*
+ * Spin lock benchmark with host threads.
+ *
+ * The simulator runs one thread of RT-Thread at a time, so the lockers are
+ * host threads out of the scheduler, which run on the cpus of host in
+ * parallel. Each locker takes the lock for loops times and updates a few
+ * shared words in it; the time per lock and the spread of the lockers
+ * (how many locks the others get while the first one is done) are shown
+ * for a test-and-set lock, the ticket lock, the MCS lock and the mutex of
+ * host. The lockers should be no more than the cpus of host: a waiter of
+ * ticket or MCS lock preempted by host stalls all of the ones behind it.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#ifdef RT_USING_LOCK_BENCH
+
+#include <rtatomic.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LOCK_BENCH_THREADS_MAX  32
+#define LOCK_BENCH_DATA_WORDS   16      /* shared data written in lock */
+
+enum lock_bench_type
+{
+    LOCK_BENCH_TAS = 0,
+    LOCK_BENCH_TICKET,
+    LOCK_BENCH_MCS,
+    LOCK_BENCH_MUTEX,
+    LOCK_BENCH_TYPES
+};
+
+static const char *_type_name[LOCK_BENCH_TYPES] = {"tas", "ticket", "mcs", "mutex"};
+
+struct lock_bench
+{
+    enum lock_bench_type type;
+    rt_uint32_t loops;
+    rt_atomic_t start;                  /* the lockers go all together */
+    rt_atomic_t done;                   /* the first locker has finished */
+
+    rt_atomic_t tas;
+    struct rt_ticket_lock ticket;
+    struct rt_mcs_lock mcs;
+    pthread_mutex_t mutex;
+
+    rt_uint32_t count;                  /* checked after all lockers */
+    rt_uint32_t data[LOCK_BENCH_DATA_WORDS];
+};
+
+struct lock_bench_locker
+{
+    pthread_t thread;
+    struct lock_bench *bench;
+    rt_uint32_t got;                    /* locks taken when the first one is done */
+};
+
+static rt_uint64_t lock_bench_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (rt_uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void *lock_bench_entry(void *parameter)
+{
+    struct lock_bench_locker *locker = (struct lock_bench_locker *)parameter;
+    struct lock_bench *b = locker->bench;
+    struct rt_mcs_node node;
+    rt_atomic_t unlocked;
+    rt_uint32_t index, word;
+
+    while (rt_atomic_load(&b->start) == 0)
+        rt_hw_cpu_relax();
+
+    for (index = 0; index < b->loops; index ++)
+    {
+        switch (b->type)
+        {
+        case LOCK_BENCH_TAS:
+            unlocked = 0;
+            while (!rt_atomic_compare_exchange(&b->tas, &unlocked, 1))
+            {
+                /* spin on reading, no store until it looks free */
+                while (rt_atomic_load(&b->tas))
+                    rt_hw_cpu_relax();
+                unlocked = 0;
+            }
+            break;
+        case LOCK_BENCH_TICKET:
+            rt_ticket_lock(&b->ticket);
+            break;
+        case LOCK_BENCH_MCS:
+            rt_mcs_lock(&b->mcs, &node);
+            break;
+        default:
+            pthread_mutex_lock(&b->mutex);
+            break;
+        }
+
+        b->count ++;
+        for (word = 0; word < LOCK_BENCH_DATA_WORDS; word ++)
+            b->data[word] += index;
+
+        switch (b->type)
+        {
+        case LOCK_BENCH_TAS:
+            rt_atomic_store(&b->tas, 0);
+            break;
+        case LOCK_BENCH_TICKET:
+            rt_ticket_unlock(&b->ticket);
+            break;
+        case LOCK_BENCH_MCS:
+            rt_mcs_unlock(&b->mcs, &node);
+            break;
+        default:
+            pthread_mutex_unlock(&b->mutex);
+            break;
+        }
+
+        if (locker->got == 0 && rt_atomic_load(&b->done))
+            locker->got = index + 1;
+    }
+
+    rt_atomic_store(&b->done, 1);
+    if (locker->got == 0)
+        locker->got = b->loops;
+
+    return RT_NULL;
+}
+
+static int lock_bench_run(struct lock_bench *b, struct lock_bench_locker *lockers, int threads)
+{
+    sigset_t set, old;
+    rt_uint64_t ns;
+    rt_uint32_t min = b->loops;
+    int index;
+
+    b->count = 0;
+    rt_memset(b->data, 0, sizeof(b->data));
+    rt_atomic_store(&b->start, 0);
+    rt_atomic_store(&b->done, 0);
+    rt_atomic_store(&b->tas, 0);
+    rt_ticket_lock_init(&b->ticket);
+    rt_mcs_lock_init(&b->mcs);
+
+    /* the signals of simulator go to the threads of RT-Thread only */
+    sigfillset(&set);
+    pthread_sigmask(SIG_BLOCK, &set, &old);
+    for (index = 0; index < threads; index ++)
+    {
+        lockers[index].bench = b;
+        lockers[index].got = 0;
+        if (pthread_create(&lockers[index].thread, RT_NULL, lock_bench_entry, &lockers[index]) != 0)
+            break;
+    }
+    pthread_sigmask(SIG_SETMASK, &old, RT_NULL);
+
+    if (index < threads)
+    {
+        rt_kprintf("create host thread failed\n");
+        threads = index;
+    }
+
+    ns = lock_bench_ns();
+    rt_atomic_store(&b->start, 1);
+    for (index = 0; index < threads; index ++)
+    {
+        pthread_join(lockers[index].thread, RT_NULL);
+        if (lockers[index].got < min)
+            min = lockers[index].got;
+    }
+    ns = lock_bench_ns() - ns;
+
+    if (b->count != b->loops * threads)
+    {
+        rt_kprintf("%-8s broken, count %u of %u\n", _type_name[b->type],
+                   b->count, b->loops * threads);
+        return -RT_ERROR;
+    }
+
+    /* a fair lock lets every locker get near loops before the first one ends */
+    rt_kprintf("%-8s %8u ms %8u ns/lock %5u%% least share\n", _type_name[b->type],
+               (rt_uint32_t)(ns / 1000000), (rt_uint32_t)(ns / b->count),
+               (rt_uint32_t)((rt_uint64_t)min * 100 / b->loops));
+
+    return RT_EOK;
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+#include <stdlib.h>
+
+static int lock_bench(int argc, char **argv)
+{
+    struct lock_bench *b;
+    struct lock_bench_locker *lockers;
+    int threads, cpus, type;
+
+    cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1)
+        cpus = 1;
+
+    threads = (argc > 1) ? atoi(argv[1]) : cpus;
+    if (threads < 1 || threads > LOCK_BENCH_THREADS_MAX)
+    {
+        rt_kprintf("lock_bench [threads(1-%d) loops]\n", LOCK_BENCH_THREADS_MAX);
+        return -1;
+    }
+    if (threads > cpus)
+        rt_kprintf("%d host threads on %d cpus, the fair locks stall on preemption\n",
+                   threads, cpus);
+
+    b = (struct lock_bench *)rt_calloc(1, sizeof(struct lock_bench));
+    lockers = (struct lock_bench_locker *)rt_calloc(threads, sizeof(struct lock_bench_locker));
+    if (b == RT_NULL || lockers == RT_NULL)
+    {
+        rt_free(b);
+        rt_free(lockers);
+        return -RT_ENOMEM;
+    }
+
+    b->loops = (argc > 2) ? atoi(argv[2]) : 100000;
+    if (b->loops == 0)
+        b->loops = 1;
+    pthread_mutex_init(&b->mutex, RT_NULL);
+
+    rt_kprintf("%d host threads, %u locks each\n", threads, b->loops);
+    for (type = 0; type < LOCK_BENCH_TYPES; type ++)
+    {
+        b->type = (enum lock_bench_type)type;
+        if (lock_bench_run(b, lockers, threads) != RT_EOK)
+            break;
+    }
+
+    pthread_mutex_destroy(&b->mutex);
+    rt_free(lockers);
+    rt_free(b);
+
+    return 0;
+}
+MSH_CMD_EXPORT(lock_bench, spin lock benchmark with host threads);
+#endif
+
+#endif
@@ -0,0 +1,450 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ * 2026-10-19     heyuanjie    use flash_sim
+ */
+
+/*
+ * File backed nand simulator.
+ *
+ * The pages with oob are kept in a host file. The array is busy for tR,
+ * tPROG and tBERS, and the bus takes bus_ns for a byte, which are counted
+ * by the clock of flash_sim. Cache read and cache program overlap the array
+ * with the bus, so the gain of them is measured by the clock no matter how
+ * fast the host is.
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+
+#if defined(RT_USING_FLASH_SIM) && defined(RT_USING_MTD_NAND)
+
+#include <flash_sim.h>
+
+#ifndef NAND_SIM_TR_US
+#define NAND_SIM_TR_US          25      /* array to cache register */
+#endif
+#ifndef NAND_SIM_TPROG_US
+#define NAND_SIM_TPROG_US       200
+#endif
+#ifndef NAND_SIM_TBERS_US
+#define NAND_SIM_TBERS_US       2000
+#endif
+#ifndef NAND_SIM_TCBSY_US
+#define NAND_SIM_TCBSY_US       3       /* cache register to data register */
+#endif
+#ifndef NAND_SIM_BUS_NS
+#define NAND_SIM_BUS_NS         25      /* a byte on bus, 40MB/s */
+#endif
+#ifndef NAND_SIM_PLANES
+#define NAND_SIM_PLANES         2
+#endif
+
+struct nand_sim
+{
+    rt_nand_t chip;
+    struct flash_sim sim;
+
+    uint32_t pages;
+    uint16_t psize;                 /* page size with oob */
+
+    uint8_t *data_reg;              /* used by read_buf and write_buf */
+    uint8_t *cache_reg;             /* loaded by array in cache read */
+    int column;
+    int page;                       /* the page of NAND_PAGE_WR0 */
+    int cache_page;                 /* the page in cache register, -1 for none */
+
+    uint64_t array_ready;
+    uint64_t data_ready;
+};
+
+#define US(t)       ((uint64_t)(t) * 1000)
+#define NOW(ns)     ((ns)->sim.stat.time_ns)
+
+static void sim_load(struct nand_sim *ns, int page, uint8_t *reg)
+{
+    rt_memset(reg, 0xff, ns->psize);
+    if ((uint32_t)page >= ns->pages)
+        return;
+
+    flash_sim_load(&ns->sim, (uint32_t)page * ns->psize, reg, ns->psize);
+    flash_sim_flip(&ns->sim, reg, ns->psize);
+    ns->sim.stat.reads ++;
+}
+
+static void sim_program(struct nand_sim *ns, int page, const uint8_t *reg)
+{
+    if ((uint32_t)page >= ns->pages)
+        return;
+
+    flash_sim_program(&ns->sim, (uint32_t)page * ns->psize, reg, ns->psize);
+    ns->sim.stat.progs ++;
+    ns->sim.stat.prog_bytes += ns->psize;
+}
+
+static void sim_erase(struct nand_sim *ns, int page)
+{
+    int i;
+
+    page -= page % ns->chip.pages_pb;
+    if ((uint32_t)page >= ns->pages)
+        return;
+
+    rt_memset(ns->cache_reg, 0xff, ns->psize);
+    for (i = 0; i < ns->chip.pages_pb; i ++)
+        flash_sim_store(&ns->sim, (uint32_t)(page + i) * ns->psize, ns->cache_reg, ns->psize);
+    ns->sim.stat.erases ++;
+}
+
+static int sim_cmdfunc(rt_nand_t *nand, int cmd, int page, int offset)
+{
+    struct nand_sim *ns = (struct nand_sim *)nand;
+
+    switch (cmd)
+    {
+    case NAND_PAGE_RD:
+        flash_sim_wait(&ns->sim, ns->array_ready);
+        sim_load(ns, page, ns->data_reg);
+        ns->array_ready = NOW(ns) + US(ns->sim.cfg.read_us);
+        ns->data_ready = ns->array_ready;
+        ns->column = offset;
+        ns->cache_page = -1;
+        break;
+
+    case NAND_PAGE_WR0:
+        /* the data register may be in use by cache program */
+        flash_sim_wait(&ns->sim, ns->data_ready);
+        rt_memset(ns->data_reg, 0xff, ns->psize);
+        ns->page = page;
+        ns->column = offset;
+        ns->cache_page = -1;
+        break;
+
+    case NAND_PAGE_WR1:
+        flash_sim_wait(&ns->sim, ns->array_ready);
+        sim_program(ns, ns->page, ns->data_reg);
+        ns->array_ready = NOW(ns) + US(ns->sim.cfg.prog_us);
+        flash_sim_wait(&ns->sim, ns->array_ready);
+        break;
+
+    case NAND_BLK_ERASE_MP:
+        /* erased with the last block */
+        flash_sim_wait(&ns->sim, ns->array_ready);
+        sim_erase(ns, page);
+        ns->cache_page = -1;
+        break;
+
+    case NAND_BLK_ERASE:
+        flash_sim_wait(&ns->sim, ns->array_ready);
+        sim_erase(ns, page);
+        ns->array_ready = NOW(ns) + US(ns->sim.cfg.erase_us);
+        flash_sim_wait(&ns->sim, ns->array_ready);
+        ns->cache_page = -1;
+        break;
+
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+static int sim_read_buf(rt_nand_t *nand, uint8_t *buf, int len)
+{
+    struct nand_sim *ns = (struct nand_sim *)nand;
+
+    flash_sim_wait(&ns->sim, ns->data_ready);
+    if (ns->column + len > ns->psize)
+        len = ns->psize - ns->column;
+    if (len <= 0)
+        return 0;
+
+    rt_memcpy(buf, ns->data_reg + ns->column, len);
+    ns->column += len;
+    ns->sim.stat.read_bytes += len;
+    flash_sim_wait(&ns->sim, NOW(ns) + (uint64_t)len * ns->sim.cfg.bus_ns);
+
+    return len;
+}
+
+static int sim_write_buf(rt_nand_t *nand, const uint8_t *buf, int len)
+{
+    struct nand_sim *ns = (struct nand_sim *)nand;
+
+    if (ns->column + len > ns->psize)
+        len = ns->psize - ns->column;
+    if (len <= 0)
+        return 0;
+
+    rt_memcpy(ns->data_reg + ns->column, buf, len);
+    ns->column += len;
+    flash_sim_wait(&ns->sim, NOW(ns) + (uint64_t)len * ns->sim.cfg.bus_ns);
+
+    return len;
+}
+
+static int sim_read_page_cached(rt_nand_t *nand, int page, int next)
+{
+    struct nand_sim *ns = (struct nand_sim *)nand;
+    uint8_t *reg;
+
+    if (ns->cache_page != page)
+    {
+        flash_sim_wait(&ns->sim, ns->array_ready);
+        sim_load(ns, page, ns->cache_reg);
+        ns->array_ready = NOW(ns) + US(ns->sim.cfg.read_us);
+    }
+
+    /* move the page to data register, and load the next one */
+    flash_sim_wait(&ns->sim, ns->array_ready);
+    reg = ns->data_reg;
+    ns->data_reg = ns->cache_reg;
+    ns->cache_reg = reg;
+    ns->data_ready = NOW(ns) + US(NAND_SIM_TCBSY_US);
+    ns->column = 0;
+    ns->cache_page = -1;
+
+    if (next >= 0)
+    {
+        sim_load(ns, next, ns->cache_reg);
+        ns->array_ready = ns->data_ready + US(ns->sim.cfg.read_us);
+        ns->cache_page = next;
+    }
+
+    return 0;
+}
+
+static int sim_write_page_cached(rt_nand_t *nand, int page, int last)
+{
+    struct nand_sim *ns = (struct nand_sim *)nand;
+
+    /* the previous page is programmed */
+    flash_sim_wait(&ns->sim, ns->array_ready);
+    sim_program(ns, ns->page, ns->data_reg);
+    ns->array_ready = NOW(ns) + US(ns->sim.cfg.prog_us);
+
+    if (last)
+        flash_sim_wait(&ns->sim, ns->array_ready);
+    else
+        flash_sim_wait(&ns->sim, NOW(ns) + US(NAND_SIM_TCBSY_US));
+    ns->data_ready = NOW(ns);
+
+    return 0;
+}
+
+static const struct nand_ops _sim_ops =
+{
+    sim_cmdfunc,
+    sim_read_buf,
+    sim_write_buf,
+    RT_NULL,
+    RT_NULL,
+};
+
+static const struct nand_ops _sim_ops_cached =
+{
+    sim_cmdfunc,
+    sim_read_buf,
+    sim_write_buf,
+    sim_read_page_cached,
+    sim_write_page_cached,
+};
+
+/**
+ * This function will create a nand simulator and register it as a mtd
+ * device. The file is created with erased pages if it doesn't exist.
+ *
+ * @param name the device name
+ * @param path the host file
+ * @param page_size the page size, must be power of 2
+ * @param oobsize the oob size
+ * @param pages_pb the pages per block
+ * @param blocks the number of blocks
+ *
+ * @return 0 on OK, or a negative errno on failure
+ */
+int nand_sim_init(const char *name, const char *path, int page_size,
+                  int oobsize, int pages_pb, int blocks)
+{
+    struct nand_sim *ns;
+    rt_mtdpart_t part;
+    int ret;
+
+    if (page_size <= 0 || (page_size & (page_size - 1)) || oobsize <= 0 ||
+        pages_pb <= 0 || blocks <= 0)
+        return -EINVAL;
+
+    ns = rt_malloc(sizeof(struct nand_sim));
+    if (ns == RT_NULL)
+        return -ENOMEM;
+    rt_memset(ns, 0, sizeof(struct nand_sim));
+
+    ns->psize = page_size + oobsize;
+    ns->pages = (uint32_t)pages_pb * blocks;
+    ns->cache_page = -1;
+    ns->data_reg = rt_malloc(ns->psize * 2);
+    if (ns->data_reg == RT_NULL)
+    {
+        ret = -ENOMEM;
+        goto __free;
+    }
+    ns->cache_reg = ns->data_reg + ns->psize;
+
+    ret = flash_sim_open(&ns->sim, path, ns->pages * ns->psize, 0xff);
+    if (ret)
+        goto __free;
+    ns->sim.cfg.read_us = NAND_SIM_TR_US;
+    ns->sim.cfg.prog_us = NAND_SIM_TPROG_US;
+    ns->sim.cfg.erase_us = NAND_SIM_TBERS_US;
+    ns->sim.cfg.bus_ns = NAND_SIM_BUS_NS;
+
+    ns->chip.ops = &_sim_ops_cached;
+    ns->chip.page_size = page_size;
+    ns->chip.oobsize = oobsize;
+    ns->chip.pages_pb = pages_pb;
+    ns->chip.planes = NAND_SIM_PLANES;
+    ns->chip.ecc.mode = NAND_ECC_SOFT_BCH;
+
+    ret = rt_mtd_nand_init(&ns->chip, blocks, 1);
+    if (ret)
+        goto __free;
+
+    part.name = name;
+    part.offset = 0;
+    part.length = ns->chip.mtd.size;
+    ret = mtd_part_add(&ns->chip.mtd, &part, 1);
+    if (ret)
+    {
+        /* the chip is initialized, it's not freed */
+        return -EIO;
+    }
+    flash_sim_register(&ns->sim, &ns->chip.mtd.parent);
+
+    return 0;
+
+__free:
+    flash_sim_close(&ns->sim);
+    rt_free(ns->data_reg);
+    rt_free(ns);
+
+    return ret;
+}
+RTM_EXPORT(nand_sim_init);
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+#include <stdlib.h>
+
+static int nand_sim(int argc, char **argv)
+{
+    int blocks, ret;
+
+    if (argc < 3)
+    {
+        rt_kprintf("nand_sim <name> <file> [blocks]\n");
+        return -1;
+    }
+    blocks = (argc > 3) ? atoi(argv[3]) : 256;
+
+    /* 2K page with 64 bytes oob, 64 pages a block */
+    ret = nand_sim_init(argv[1], argv[2], 2048, 64, 64, blocks);
+    if (ret)
+        rt_kprintf("create nand simulator failed: %d\n", ret);
+
+    return ret;
+}
+MSH_CMD_EXPORT(nand_sim, create file backed nand simulator);
+
+static uint32_t sim_rate(uint32_t bytes, uint64_t ns)
+{
+    /* KB/s */
+    return ns ? (uint32_t)((uint64_t)bytes * 1000000000 / 1024 / ns) : 0;
+}
+
+/* write and read the first blocks with and without the pipeline, data is lost */
+static int nand_sim_bench(int argc, char **argv)
+{
+    static const char *mode[2] = {"page", "pipelined"};
+    struct nand_sim *ns;
+    struct erase_info instr;
+    rt_mtd_t *mtd;
+    uint8_t *buf, *ref;
+    uint32_t len, blksize, seed = 0x12345678, i;
+    uint64_t t[4];
+    size_t retlen;
+    int pages, m;
+
+    mtd = (argc > 1) ? mtd_device_get(argv[1]) : RT_NULL;
+    if (mtd == RT_NULL)
+    {
+        rt_kprintf("nand_sim_bench <name> [pages]\n");
+        return -1;
+    }
+    ns = (struct nand_sim *)mtd->master->priv;
+    if (mtd->type != MTD_NANDFLASH ||
+        (ns->chip.ops != &_sim_ops && ns->chip.ops != &_sim_ops_cached))
+    {
+        rt_kprintf("%s is not a nand simulator\n", argv[1]);
+        return -1;
+    }
+
+    pages = (argc > 2) ? atoi(argv[2]) : 128;
+    blksize = ns->chip.page_size * ns->chip.pages_pb;
+    len = (uint32_t)pages * ns->chip.page_size;
+    if (pages <= 0 || RT_ALIGN(len, blksize) + NAND_BBT_BLOCKS * blksize > mtd->size)
+    {
+        rt_kprintf("too many pages\n");
+        return -1;
+    }
+
+    buf = rt_malloc(len * 2);
+    if (buf == RT_NULL)
+    {
+        rt_kprintf("no memory\n");
+        return -1;
+    }
+    ref = buf + len;
+    for (i = 0; i < len; i ++)
+    {
+        seed = seed * 1103515245 + 12345;
+        ref[i] = seed >> 16;
+    }
+
+    for (m = 0; m < 2; m ++)
+    {
+        ns->chip.ops = m ? &_sim_ops_cached : &_sim_ops;
+        ns->chip.planes = m ? NAND_SIM_PLANES : 1;
+
+        instr.addr = 0;
+        instr.len = RT_ALIGN(len, blksize);
+        t[0] = NOW(ns);
+        mtd_erase(mtd, &instr);
+        t[1] = NOW(ns);
+        mtd_write(mtd, 0, len, &retlen, ref);
+        t[2] = NOW(ns);
+        rt_memset(buf, 0, len);
+        mtd_read(mtd, 0, len, &retlen, buf);
+        t[3] = NOW(ns);
+
+        rt_kprintf("%-9s erase %6u us, write %6u us %5u KB/s, read %6u us %5u KB/s%s\n",
+                   mode[m], (uint32_t)((t[1] - t[0]) / 1000),
+                   (uint32_t)((t[2] - t[1]) / 1000), sim_rate(len, t[2] - t[1]),
+                   (uint32_t)((t[3] - t[2]) / 1000), sim_rate(len, t[3] - t[2]),
+                   rt_memcmp(buf, ref, len) ? ", data error" : "");
+    }
+
+    ns->chip.ops = &_sim_ops_cached;
+    ns->chip.planes = NAND_SIM_PLANES;
+    rt_free(buf);
+
+    return 0;
+}
+MSH_CMD_EXPORT(nand_sim_bench, nand simulator throughput with and without cache ops);
+#endif
+
+#endif
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ */
+
+/*
+ * File backed nor simulator. The device is read and programmed by byte,
+ * the bits can only be cleared by program and set by block erase.
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+
+#if defined(RT_USING_FLASH_SIM) && defined(RT_USING_MTD_NOR)
+
+#include <flash_sim.h>
+
+#ifndef NOR_SIM_READ_US
+#define NOR_SIM_READ_US         1       /* command and address */
+#endif
+#ifndef NOR_SIM_PROG_US
+#define NOR_SIM_PROG_US         600     /* a page of 256 bytes */
+#endif
+#ifndef NOR_SIM_ERASE_US
+#define NOR_SIM_ERASE_US        45000
+#endif
+#ifndef NOR_SIM_BUS_NS
+#define NOR_SIM_BUS_NS          20      /* quad spi at 100MHz */
+#endif
+
+#define NOR_SIM_PAGE            256
+
+struct nor_sim
+{
+    rt_mtd_t mtd;
+    struct flash_sim sim;
+};
+
+#define US(t)       ((uint64_t)(t) * 1000)
+#define NOW(ns)     ((ns)->sim.stat.time_ns)
+
+static int nor_sim_erase(rt_mtd_t *mtd, struct erase_info *instr)
+{
+    struct nor_sim *ns = (struct nor_sim *)mtd->priv;
+    uint8_t buf[NOR_SIM_PAGE];
+    uint32_t addr, end, i;
+
+    if ((instr->addr % mtd->erasesize) || (instr->len % mtd->erasesize))
+        return -EINVAL;
+
+    rt_memset(buf, 0xff, sizeof(buf));
+    end = instr->addr + instr->len;
+    for (addr = instr->addr; addr < end; addr += mtd->erasesize)
+    {
+        for (i = 0; i < mtd->erasesize; i += sizeof(buf))
+            flash_sim_store(&ns->sim, addr + i, buf, sizeof(buf));
+
+        flash_sim_wait(&ns->sim, NOW(ns) + US(ns->sim.cfg.erase_us));
+        ns->sim.stat.erases ++;
+    }
+
+    return 0;
+}
+
+static int nor_sim_read(rt_mtd_t *mtd, loff_t from, size_t len, size_t *retlen, uint8_t *buf)
+{
+    struct nor_sim *ns = (struct nor_sim *)mtd->priv;
+
+    flash_sim_load(&ns->sim, (uint32_t)from, buf, len);
+    flash_sim_flip(&ns->sim, buf, len);
+    flash_sim_wait(&ns->sim, NOW(ns) + US(ns->sim.cfg.read_us) + (uint64_t)len * ns->sim.cfg.bus_ns);
+
+    ns->sim.stat.reads ++;
+    ns->sim.stat.read_bytes += len;
+    *retlen = len;
+
+    return 0;
+}
+
+/* it's programmed by page, which doesn't go across the page boundary */
+static int nor_sim_write(rt_mtd_t *mtd, loff_t to, size_t len, size_t *retlen, const uint8_t *buf)
+{
+    struct nor_sim *ns = (struct nor_sim *)mtd->priv;
+    uint32_t addr = (uint32_t)to;
+    size_t bytes;
+
+    *retlen = 0;
+    for (; len > 0; addr += bytes, buf += bytes, len -= bytes)
+    {
+        bytes = NOR_SIM_PAGE - addr % NOR_SIM_PAGE;
+        if (bytes > len)
+            bytes = len;
+
+        flash_sim_program(&ns->sim, addr, buf, bytes);
+        flash_sim_wait(&ns->sim, NOW(ns) + (uint64_t)bytes * ns->sim.cfg.bus_ns +
+                       US(ns->sim.cfg.prog_us) * bytes / NOR_SIM_PAGE);
+
+        ns->sim.stat.progs ++;
+        ns->sim.stat.prog_bytes += bytes;
+        *retlen += bytes;
+    }
+
+    return 0;
+}
+
+static const struct mtd_ops _nor_sim_ops =
+{
+    nor_sim_erase,
+    nor_sim_read,
+    nor_sim_write,
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+};
+
+/**
+ * This function will create a nor simulator and register it as a mtd
+ * device. The file is created erased if it doesn't exist.
+ *
+ * @param name the device name
+ * @param path the host file
+ * @param size the size in bytes
+ * @param erasesize the size of erase block
+ *
+ * @return 0 on OK, or a negative errno on failure
+ */
+int nor_sim_init(const char *name, const char *path, uint32_t size, uint32_t erasesize)
+{
+    struct nor_sim *ns;
+    rt_mtdpart_t part;
+    int ret;
+
+    if (erasesize == 0 || erasesize % NOR_SIM_PAGE || size == 0 || size % erasesize)
+        return -EINVAL;
+
+    ns = rt_malloc(sizeof(struct nor_sim));
+    if (ns == RT_NULL)
+        return -ENOMEM;
+    rt_memset(ns, 0, sizeof(struct nor_sim));
+
+    ret = flash_sim_open(&ns->sim, path, size, 0xff);
+    if (ret)
+    {
+        rt_free(ns);
+        return ret;
+    }
+    ns->sim.cfg.read_us = NOR_SIM_READ_US;
+    ns->sim.cfg.prog_us = NOR_SIM_PROG_US;
+    ns->sim.cfg.erase_us = NOR_SIM_ERASE_US;
+    ns->sim.cfg.bus_ns = NOR_SIM_BUS_NS;
+
+    ns->mtd.parent.type = RT_Device_Class_MTD;
+    ns->mtd.type = MTD_NORFLASH;
+    ns->mtd.size = size;
+    ns->mtd.erasesize = erasesize;
+    ns->mtd.writesize = 1;
+    ns->mtd.ops = &_nor_sim_ops;
+    ns->mtd.priv = ns;
+
+    part.name = name;
+    part.offset = 0;
+    part.length = size;
+    ret = mtd_part_add(&ns->mtd, &part, 1);
+    if (ret)
+    {
+        flash_sim_close(&ns->sim);
+        rt_free(ns);
+        return -EIO;
+    }
+    flash_sim_register(&ns->sim, &ns->mtd.parent);
+
+    return 0;
+}
+RTM_EXPORT(nor_sim_init);
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+#include <stdlib.h>
+
+static int nor_sim(int argc, char **argv)
+{
+    uint32_t size;
+    int ret;
+
+    if (argc < 3)
+    {
+        rt_kprintf("nor_sim <name> <file> [size_kb]\n");
+        return -1;
+    }
+    size = (argc > 3) ? atoi(argv[3]) * 1024 : 4 * 1024 * 1024;
+
+    /* 64KB block */
+    ret = nor_sim_init(argv[1], argv[2], size, 64 * 1024);
+    if (ret)
+        rt_kprintf("create nor simulator failed: %d\n", ret);
+
+    return ret;
+}
+MSH_CMD_EXPORT(nor_sim, create file backed nor simulator);
+#endif
+
+#endif
@@ -13,6 +13,8 @@
  * 2010-07-13     Bernard      fix rt_tick_from_millisecond issue found by kuronca
  * 2011-06-26     Bernard      add rt_tick_set function.
  * 2018-11-22     Jesven       add per cpu tick
+ * 2026-10-19     heyuanjie    add clock source and nanosecond clock
+ * 2026-10-19     heyuanjie    expire high-resolution timers on tick
  */
 
 #include <rthw.h>
@@ -26,6 +28,15 @@ static rt_tick_t rt_tick = 0;
 
 extern void rt_timer_check(void);
 
+#define NANOSECOND_PER_TICK     (1000000000UL / RT_TICK_PER_SECOND)
+/* the longest time the counter may go unread, e.g. with interrupt disabled */
+#define CLOCKSOURCE_MAX_SECOND  60
+
+/* clock source, and the counter and the clock when it was read last */
+static struct rt_clocksource *_clocksource = RT_NULL;
+static rt_uint64_t _clock_cycle_last = 0;
+static rt_uint64_t _clock_ns_last = 0;
+
 /**
  * This function will init system tick and set it to zero.
  * @ingroup SystemInit
@@ -67,6 +78,131 @@ void rt_tick_set(rt_tick_t tick)
     rt_hw_interrupt_enable(level);
 }
 
+/* the nanoseconds passed since the counter was read last */
+rt_inline rt_uint64_t _clock_delta_ns(struct rt_clocksource *cs, rt_uint64_t *cycle)
+{
+    *cycle = cs->read();
+
+    return (((*cycle - _clock_cycle_last) & cs->mask) * cs->mult) >> cs->shift;
+}
+
+/*
+ * advance the clock on every tick, so the counter is read before it
+ * wraps and the clock keeps going without a clock source.
+ */
+static void _clock_update(void)
+{
+    rt_uint64_t cycle;
+    rt_base_t level;
+
+#ifdef RT_USING_SMP
+    if (rt_hw_cpu_id() != 0)
+        return;
+#endif
+
+    level = rt_hw_interrupt_disable();
+    if (_clocksource != RT_NULL)
+    {
+        _clock_ns_last += _clock_delta_ns(_clocksource, &cycle);
+        _clock_cycle_last = cycle;
+    }
+    else
+    {
+        _clock_ns_last += NANOSECOND_PER_TICK;
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * This function will register a clock source, which is a free-running
+ * counter of port, such as cycle counter or hardware timer. The clock
+ * goes on from its current value with the new clock source.
+ *
+ * @param cs the clock source, read, mask and freq shall be set
+ *
+ * @return RT_EOK on success, -RT_EINVAL on a bad clock source
+ */
+rt_err_t rt_clocksource_register(struct rt_clocksource *cs)
+{
+    rt_uint64_t mult, limit;
+    rt_base_t level;
+
+    if (cs == RT_NULL || cs->read == RT_NULL || cs->freq == 0 || cs->mask == 0)
+        return -RT_EINVAL;
+
+    /*
+     * get the most precise mult which fits in 32 bits, and with which the
+     * cycles of CLOCKSOURCE_MAX_SECOND do not overflow on conversion.
+     */
+    limit = 0xFFFFFFFFFFFFFFFFULL / ((rt_uint64_t)cs->freq * CLOCKSOURCE_MAX_SECOND);
+    if (limit > 0xFFFFFFFFULL)
+        limit = 0xFFFFFFFFULL;
+
+    cs->shift = 32;
+    do
+    {
+        cs->shift --;
+        mult = (1000000000ULL << cs->shift) / cs->freq;
+    } while (mult > limit && cs->shift > 0);
+    if (mult > limit || mult == 0)
+        return -RT_EINVAL;
+    cs->mult = (rt_uint32_t)mult;
+
+    level = rt_hw_interrupt_disable();
+    if (_clocksource != RT_NULL)
+    {
+        rt_uint64_t cycle;
+
+        _clock_ns_last += _clock_delta_ns(_clocksource, &cycle);
+    }
+    _clocksource = cs;
+    _clock_cycle_last = cs->read();
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_clocksource_register);
+
+/**
+ * This function will return the monotonic time since system startup in
+ * nanosecond. Its resolution is the one of clock source, or one tick when
+ * no clock source is registered.
+ *
+ * @return current clock in nanosecond
+ */
+rt_uint64_t rt_clock_ns(void)
+{
+    rt_uint64_t cycle, ns;
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    ns = _clock_ns_last;
+    if (_clocksource != RT_NULL)
+        ns += _clock_delta_ns(_clocksource, &cycle);
+    rt_hw_interrupt_enable(level);
+
+    return ns;
+}
+RTM_EXPORT(rt_clock_ns);
+
+/**
+ * This function will return the resolution of rt_clock_ns.
+ *
+ * @return resolution in nanosecond
+ */
+rt_uint32_t rt_clock_resolution_ns(void)
+{
+    rt_uint32_t ns;
+
+    if (_clocksource == RT_NULL)
+        return NANOSECOND_PER_TICK;
+
+    ns = 1000000000UL / _clocksource->freq;
+
+    return ns ? ns : 1;
+}
+RTM_EXPORT(rt_clock_resolution_ns);
+
 /**
  * This function will notify kernel there is one tick passed. Normally,
  * this function is invoked by clock ISR.
@@ -82,6 +218,8 @@ void rt_tick_increase(void)
     ++ rt_tick;
 #endif
 
+    _clock_update();
+
     /* check time slice */
     thread = rt_thread_self();
 
@@ -97,6 +235,10 @@ void rt_tick_increase(void)
 
     /* check timer */
     rt_timer_check();
+
+#ifdef RT_USING_HRTIMER
+    rt_hrtimer_tick();
+#endif
 }
 
 /**
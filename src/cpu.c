@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2018-10-30     Bernard      The first version
+ * 2026-10-19     heyuanjie    add generic ticket spinlock
  */
 
 #include <rtthread.h>
@@ -16,6 +17,23 @@
 static struct rt_cpu rt_cpus[RT_CPUS_NR];
 rt_hw_spinlock_t _cpus_lock;
 
+/**
+ * This function will lock a spinlock, the cpus get it in the order they
+ * come. A port may implement it on its own.
+ */
+RT_WEAK void rt_hw_spin_lock(rt_hw_spinlock_t *lock)
+{
+    rt_ticket_lock(lock);
+}
+
+/**
+ * This function will unlock a spinlock.
+ */
+RT_WEAK void rt_hw_spin_unlock(rt_hw_spinlock_t *lock)
+{
+    rt_ticket_unlock(lock);
+}
+
 /**
  * This fucntion will return current cpu.
  */
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#ifdef RT_USING_FUTEX
+
+#ifndef RT_FUTEX_HASH_SIZE
+#define RT_FUTEX_HASH_SIZE      16
+#endif
+
+/* a thread waiting on an address, which is on the stack of the thread */
+struct rt_futex_waiter
+{
+    rt_list_t list;
+    volatile rt_atomic_t *addr;
+    rt_thread_t thread;
+};
+
+/* the waiters hashed by address */
+static rt_list_t _futex_hash[RT_FUTEX_HASH_SIZE];
+
+/* get the waiter list of an address, interrupt is disabled */
+static rt_list_t *_futex_bucket(volatile rt_atomic_t *addr)
+{
+    rt_list_t *bucket;
+
+    bucket = &_futex_hash[((rt_ubase_t)addr / sizeof(rt_atomic_t)) % RT_FUTEX_HASH_SIZE];
+    if (bucket->next == RT_NULL)
+        rt_list_init(bucket);
+
+    return bucket;
+}
+
+/**
+ * @addtogroup IPC
+ */
+
+/**@{*/
+
+/**
+ * This function will suspend current thread on an address when the value
+ * on it is the expected one. The value is checked and the thread is
+ * suspended atomically, so a wake after the value is changed is never lost.
+ *
+ * @param addr the address of value
+ * @param value the expected value
+ * @param timeout the waiting time in tick, RT_WAITING_FOREVER to wait forever
+ *
+ * @return RT_EOK when woken up by rt_futex_wake, -RT_EBUSY when the value is
+ *         not the expected one, -RT_ETIMEOUT on timeout, -RT_EINTR when
+ *         woken up by others.
+ */
+rt_err_t rt_futex_wait(volatile rt_atomic_t *addr, rt_atomic_t value, rt_int32_t timeout)
+{
+    struct rt_futex_waiter waiter;
+    struct rt_thread *thread;
+    register rt_base_t level;
+    rt_err_t result;
+
+    RT_ASSERT(addr != RT_NULL);
+    RT_DEBUG_IN_THREAD_CONTEXT;
+
+    thread = rt_thread_self();
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    if (rt_atomic_load(addr) != value)
+    {
+        rt_hw_interrupt_enable(level);
+
+        return -RT_EBUSY;
+    }
+
+    if (timeout == 0)
+    {
+        rt_hw_interrupt_enable(level);
+
+        return -RT_ETIMEOUT;
+    }
+
+    waiter.addr   = addr;
+    waiter.thread = thread;
+    rt_list_insert_before(_futex_bucket(addr), &(waiter.list));
+
+    thread->error = RT_EOK;
+    rt_thread_suspend(thread);
+
+    /* has waiting time, start thread timer */
+    if (timeout > 0)
+    {
+        rt_timer_control(&(thread->thread_timer),
+                         RT_TIMER_CTRL_SET_TIME,
+                         &timeout);
+        rt_timer_start(&(thread->thread_timer));
+    }
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+
+    rt_schedule();
+
+    level = rt_hw_interrupt_disable();
+    if (rt_list_isempty(&(waiter.list)))
+    {
+        /* removed by rt_futex_wake */
+        result = RT_EOK;
+    }
+    else
+    {
+        rt_list_remove(&(waiter.list));
+        result = (thread->error == -RT_ETIMEOUT) ? -RT_ETIMEOUT : -RT_EINTR;
+    }
+    thread->error = RT_EOK;
+    rt_hw_interrupt_enable(level);
+
+    return result;
+}
+RTM_EXPORT(rt_futex_wait);
+
+/**
+ * This function will wake up the threads waiting on an address.
+ *
+ * @param addr the address of value
+ * @param count the max number of threads to be woken up, a negative
+ *        number to wake up all of them
+ *
+ * @return the number of threads woken up
+ */
+int rt_futex_wake(volatile rt_atomic_t *addr, int count)
+{
+    struct rt_futex_waiter *waiter;
+    rt_list_t *bucket, *node;
+    register rt_base_t level;
+    int woken = 0;
+
+    RT_ASSERT(addr != RT_NULL);
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    bucket = _futex_bucket(addr);
+    node = bucket->next;
+    while (node != bucket && woken != count)
+    {
+        waiter = rt_list_entry(node, struct rt_futex_waiter, list);
+        node = node->next;
+
+        if (waiter->addr != addr)
+            continue;
+
+        /* an empty list tells the waiter it's woken up here */
+        rt_list_remove(&(waiter->list));
+        rt_thread_resume(waiter->thread);
+        woken ++;
+    }
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+
+    if (woken > 0)
+        rt_schedule();
+
+    return woken;
+}
+RTM_EXPORT(rt_futex_wake);
+
+/**@}*/
+
+#endif
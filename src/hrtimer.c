@@ -0,0 +1,332 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     heyuanjie    first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#ifdef RT_USING_HRTIMER
+
+/* the timers sorted by expire time, the earliest first */
+static rt_list_t _hrtimer_list = RT_LIST_OBJECT_INIT(_hrtimer_list);
+static struct rt_clockevent *_clockevent = RT_NULL;
+
+static void _hrtimer_insert(rt_hrtimer_t timer)
+{
+    struct rt_list_node *node;
+
+    /* insert after the timers expire at the same time */
+    for (node = _hrtimer_list.next; node != &_hrtimer_list; node = node->next)
+    {
+        if (rt_list_entry(node, struct rt_hrtimer, list)->expire > timer->expire)
+            break;
+    }
+    rt_list_insert_before(node, &(timer->list));
+}
+
+/* program the clock event for the earliest timer, interrupt is disabled */
+static void _hrtimer_program(rt_uint64_t now)
+{
+    rt_hrtimer_t timer;
+    rt_uint64_t ns;
+
+    if (_clockevent == RT_NULL || rt_list_isempty(&_hrtimer_list))
+        return;
+
+    timer = rt_list_first_entry(&_hrtimer_list, struct rt_hrtimer, list);
+
+    ns = timer->expire > now ? timer->expire - now : 0;
+    if (ns < _clockevent->min_ns)
+        ns = _clockevent->min_ns;
+    /* a longer time is reached by several interrupts */
+    if (_clockevent->max_ns != 0 && ns > _clockevent->max_ns)
+        ns = _clockevent->max_ns;
+
+    _clockevent->set_next(ns);
+}
+
+/* invoke the timeout function of expired timers */
+static void _hrtimer_run(void)
+{
+    rt_hrtimer_t timer;
+    rt_uint64_t now;
+    register rt_base_t level;
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    now = rt_clock_ns();
+    while (!rt_list_isempty(&_hrtimer_list))
+    {
+        timer = rt_list_first_entry(&_hrtimer_list, struct rt_hrtimer, list);
+        if (timer->expire > now)
+            break;
+
+        rt_list_remove(&(timer->list));
+        if (timer->period != 0)
+        {
+            /* keep the phase of periodic timer, and skip the missed periods */
+            timer->overrun = (rt_uint32_t)((now - timer->expire) / timer->period);
+            timer->expire += (timer->overrun + 1ULL) * timer->period;
+            _hrtimer_insert(timer);
+        }
+        else
+        {
+            timer->flag &= ~RT_HRTIMER_FLAG_ACTIVATED;
+        }
+
+        /* call timeout function, it may stop or restart the timer */
+        timer->timeout_func(timer->parameter);
+
+        /* re-get time */
+        now = rt_clock_ns();
+    }
+
+    _hrtimer_program(now);
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * @addtogroup Clock
+ */
+
+/**@{*/
+
+/**
+ * This function will register a clock event, which is a one-shot hardware
+ * comparator used to expire high-resolution timers. Without clock event,
+ * high-resolution timers are expired on system tick.
+ *
+ * @param ce the clock event, set_next shall be set
+ *
+ * @return RT_EOK on success, -RT_EINVAL on a bad clock event
+ */
+rt_err_t rt_clockevent_register(struct rt_clockevent *ce)
+{
+    register rt_base_t level;
+
+    if (ce == RT_NULL || ce->set_next == RT_NULL)
+        return -RT_EINVAL;
+
+    level = rt_hw_interrupt_disable();
+    _clockevent = ce;
+    _hrtimer_program(rt_clock_ns());
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_clockevent_register);
+
+/**
+ * This function will initialize a high-resolution timer. The timeout
+ * function is invoked in interrupt context, it must be simple and never
+ * be blocked.
+ *
+ * @param timer the timer to be initialized
+ * @param timeout the timeout function
+ * @param parameter the parameter of timeout function
+ */
+void rt_hrtimer_init(rt_hrtimer_t timer,
+                     void (*timeout)(void *parameter),
+                     void       *parameter)
+{
+    /* timer check */
+    RT_ASSERT(timer != RT_NULL);
+    RT_ASSERT(timeout != RT_NULL);
+
+    rt_list_init(&(timer->list));
+    timer->timeout_func = timeout;
+    timer->parameter    = parameter;
+    timer->expire       = 0;
+    timer->period       = 0;
+    timer->overrun      = 0;
+    timer->flag         = RT_HRTIMER_FLAG_DEACTIVATED;
+}
+RTM_EXPORT(rt_hrtimer_init);
+
+/**
+ * This function will start a high-resolution timer, or restart it with
+ * new time when it is active.
+ *
+ * @param timer the timer to be started
+ * @param expire the absolute expire time of rt_clock_ns in nanosecond,
+ *        the timer expires at once when the time is passed
+ * @param period the period in nanosecond, 0 for one shot timer
+ *
+ * @return the operation status, RT_EOK on OK
+ */
+rt_err_t rt_hrtimer_start(rt_hrtimer_t timer, rt_uint64_t expire, rt_uint64_t period)
+{
+    register rt_base_t level;
+
+    /* timer check */
+    RT_ASSERT(timer != RT_NULL);
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    rt_list_remove(&(timer->list));
+    timer->expire  = expire;
+    timer->period  = period;
+    timer->overrun = 0;
+    timer->flag   |= RT_HRTIMER_FLAG_ACTIVATED;
+    _hrtimer_insert(timer);
+
+    /* the earliest timer is changed */
+    if (_hrtimer_list.next == &(timer->list))
+        _hrtimer_program(rt_clock_ns());
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_hrtimer_start);
+
+/**
+ * This function will stop a high-resolution timer.
+ *
+ * @param timer the timer to be stopped
+ *
+ * @return the operation status, RT_EOK on OK, -RT_ERROR on error
+ */
+rt_err_t rt_hrtimer_stop(rt_hrtimer_t timer)
+{
+    register rt_base_t level;
+
+    /* timer check */
+    RT_ASSERT(timer != RT_NULL);
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    if (!(timer->flag & RT_HRTIMER_FLAG_ACTIVATED))
+    {
+        rt_hw_interrupt_enable(level);
+
+        return -RT_ERROR;
+    }
+
+    /* the clock event of a removed timer just expires nothing */
+    rt_list_remove(&(timer->list));
+    timer->flag &= ~RT_HRTIMER_FLAG_ACTIVATED;
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_hrtimer_stop);
+
+static void _hrtimer_thread_timeout(void *parameter)
+{
+    struct rt_thread *thread;
+
+    thread = (struct rt_thread *)parameter;
+
+    /* the thread may be woken up already */
+    if ((thread->stat & RT_THREAD_STAT_MASK) != RT_THREAD_SUSPEND)
+        return;
+
+    thread->error = -RT_ETIMEOUT;
+    rt_thread_resume(thread);
+
+    rt_schedule();
+}
+
+/**
+ * This function will let current thread sleep until the time of
+ * rt_clock_ns reaches expire. A periodic thread gets no drift by
+ * sleeping until its last wakeup time plus period.
+ *
+ * @param expire the absolute wakeup time in nanosecond
+ *
+ * @return RT_EOK on timeout, -RT_EINTR when woken up before
+ */
+rt_err_t rt_hrtimer_sleep_until(rt_uint64_t expire)
+{
+    struct rt_hrtimer timer;
+    struct rt_thread *thread;
+    register rt_base_t level;
+
+    /* set to current thread */
+    thread = rt_thread_self();
+    RT_ASSERT(thread != RT_NULL);
+
+    rt_hrtimer_init(&timer, _hrtimer_thread_timeout, thread);
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    if (expire <= rt_clock_ns())
+    {
+        rt_hw_interrupt_enable(level);
+
+        return RT_EOK;
+    }
+
+    thread->error = RT_EOK;
+    rt_thread_suspend(thread);
+    rt_hrtimer_start(&timer, expire, 0);
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+
+    rt_schedule();
+
+    /* the timer is still active when the thread is woken up by others */
+    rt_hrtimer_stop(&timer);
+
+    if (thread->error != -RT_ETIMEOUT)
+        return -RT_EINTR;
+
+    /* clear error number of this thread to RT_EOK */
+    thread->error = RT_EOK;
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_hrtimer_sleep_until);
+
+/**
+ * This function will let current thread sleep for some nanoseconds.
+ *
+ * @param ns the sleep time in nanosecond
+ *
+ * @return RT_EOK on timeout, -RT_EINTR when woken up before
+ */
+rt_err_t rt_hrtimer_sleep(rt_uint64_t ns)
+{
+    return rt_hrtimer_sleep_until(rt_clock_ns() + ns);
+}
+RTM_EXPORT(rt_hrtimer_sleep);
+
+/**
+ * This function will expire high-resolution timers. It shall be invoked by
+ * the interrupt of clock event.
+ */
+void rt_hrtimer_interrupt(void)
+{
+    _hrtimer_run();
+}
+
+/**
+ * This function will expire high-resolution timers on system tick when
+ * there is no clock event.
+ */
+void rt_hrtimer_tick(void)
+{
+    if (_clockevent == RT_NULL)
+        _hrtimer_run();
+}
+
+/**@}*/
+
+#endif
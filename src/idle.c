@@ -15,6 +15,9 @@
  * 2018-07-14     armink       add idle hook list
  * 2018-11-22     Jesven       add per cpu idle task
  *                             combine the code of primary and secondary cpu
+ * 2026-10-19     heyuanjie    add rt_thread_idle_cputime
+ * 2026-10-19     heyuanjie    release thread to thread cache, fill cached
+ *                             stacks in idle.
  */
 
 #include <rthw.h>
@@ -154,6 +157,7 @@ void rt_thread_idle_excute(void)
     {
         rt_base_t lock;
         rt_thread_t thread;
+        rt_bool_t dynamic;
 #ifdef RT_USING_MODULE
         struct rt_dlmodule *module = RT_NULL;
 #endif
@@ -182,16 +186,22 @@ void rt_thread_idle_excute(void)
             /* lock scheduler to prevent scheduling in cleanup function. */
             rt_enter_critical();
 
-            /* invoke thread cleanup */
-            if (thread->cleanup != RT_NULL)
-                thread->cleanup(thread);
+            /*
+             * only the thread of rt_thread_create is deleted here, check it
+             * before cleanup, which may release a static thread object.
+             */
+            dynamic = (thread->type == RT_Object_Class_Thread);
 
 #ifdef RT_USING_SIGNALS
             rt_thread_free_sig(thread);
 #endif
 
+            /* invoke thread cleanup */
+            if (thread->cleanup != RT_NULL)
+                thread->cleanup(thread);
+
             /* if it's a system object, not delete it */
-            if (rt_object_is_systemobject((rt_object_t)thread) == RT_TRUE)
+            if (dynamic == RT_FALSE)
             {
                 /* unlock scheduler */
                 rt_exit_critical();
@@ -218,10 +228,9 @@ void rt_thread_idle_excute(void)
         rt_hw_interrupt_enable(lock);
 
 #ifdef RT_USING_HEAP
-        /* release thread's stack */
-        RT_KERNEL_FREE(thread->stack_addr);
-        /* delete thread object */
-        rt_object_delete((rt_object_t)thread);
+        /* delete thread object, and release it with its stack */
+        rt_object_detach((rt_object_t)thread);
+        rt_thread_free(thread);
 #endif
     }
 }
@@ -253,6 +262,10 @@ static void rt_thread_idle_entry(void *parameter)
 #endif
 
         rt_thread_idle_excute();
+
+#ifdef RT_USING_THREAD_CACHE
+        rt_thread_cache_fill();
+#endif
     }
 }
 
@@ -303,3 +316,25 @@ rt_thread_t rt_thread_idle_gethandler(void)
 
     return (rt_thread_t)(&idle[id]);
 }
+
+#ifdef RT_USING_CPUTIME
+/**
+ * @ingroup Thread
+ *
+ * This function will get the cpu time of idle threads of all cpus.
+ *
+ * @return idle cpu time in nanosecond
+ */
+rt_uint64_t rt_thread_idle_cputime(void)
+{
+    rt_uint64_t ns = 0;
+    int i;
+
+    for (i = 0; i < _CPUS_NR; i++)
+    {
+        ns += rt_thread_cputime(&idle[i]);
+    }
+
+    return ns;
+}
+#endif
@@ -33,6 +33,10 @@
  * 2011-12-18     Bernard      add more parameter checking in message queue
  * 2013-09-14     Grissiom     add an option check in rt_event_recv
  * 2018-10-02     Bernard      add 64bit support for mailbox
+ * 2026-10-19     heyuanjie    add message priority and loaned message buffer
+ * 2026-10-19     heyuanjie    add batched send and receive of mailbox
+ * 2026-10-19     heyuanjie    get the priority of received message, limit
+ *                             the size of message to 16 bits
  */
 
 #include <rtthread.h>
@@ -1426,48 +1430,33 @@ rt_err_t rt_mb_delete(rt_mailbox_t mb)
 RTM_EXPORT(rt_mb_delete);
 #endif
 
-/**
- * This function will send a mail to mailbox object. If the mailbox is full,
- * current thread will be suspended until timeout.
- *
- * @param mb the mailbox object
- * @param value the mail
- * @param timeout the waiting time
- *
- * @return the error code
+/*
+ * wait for a free slot to send or a mail to receive. It returns RT_EOK with
+ * interrupt disabled, otherwise the error code with interrupt enabled.
  */
-rt_err_t rt_mb_send_wait(rt_mailbox_t mb,
-                         rt_ubase_t   value,
-                         rt_int32_t   timeout)
+static rt_err_t _rt_mb_wait(rt_mailbox_t  mb,
+                            rt_bool_t     send,
+                            rt_int32_t    timeout,
+                            rt_ubase_t   *level)
 {
     struct rt_thread *thread;
     register rt_ubase_t temp;
     rt_uint32_t tick_delta;
-
-    /* parameter check */
-    RT_ASSERT(mb != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
+    rt_err_t error;
 
     /* initialize delta tick */
     tick_delta = 0;
     /* get current thread */
     thread = rt_thread_self();
 
-    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mb->parent.parent)));
+    /* the error of non-blocking call */
+    error = send ? -RT_EFULL : -RT_ETIMEOUT;
 
     /* disable interrupt */
     temp = rt_hw_interrupt_disable();
 
-    /* for non-blocking call */
-    if (mb->entry == mb->size && timeout == 0)
-    {
-        rt_hw_interrupt_enable(temp);
-
-        return -RT_EFULL;
-    }
-
-    /* mailbox is full */
-    while (mb->entry == mb->size)
+    /* mailbox is full for sender, or is empty for receiver */
+    while (send ? (mb->entry == mb->size) : (mb->entry == 0))
     {
         /* reset error number in thread */
         thread->error = RT_EOK;
@@ -1478,12 +1467,15 @@ rt_err_t rt_mb_send_wait(rt_mailbox_t mb,
             /* enable interrupt */
             rt_hw_interrupt_enable(temp);
 
-            return -RT_EFULL;
+            if (!send)
+                thread->error = -RT_ETIMEOUT;
+
+            return error;
         }
 
         RT_DEBUG_IN_THREAD_CONTEXT;
         /* suspend current thread */
-        rt_ipc_list_suspend(&(mb->suspend_sender_thread),
+        rt_ipc_list_suspend(send ? &(mb->suspend_sender_thread) : &(mb->parent.suspend_thread),
                             thread,
                             mb->parent.parent.flag);
 
@@ -1493,7 +1485,7 @@ rt_err_t rt_mb_send_wait(rt_mailbox_t mb,
             /* get the start tick of timer */
             tick_delta = rt_tick_get();
 
-            RT_DEBUG_LOG(RT_DEBUG_IPC, ("mb_send_wait: start timer of thread:%s\n",
+            RT_DEBUG_LOG(RT_DEBUG_IPC, ("mb_wait: start timer of thread:%s\n",
                                         thread->name));
 
             /* reset the timeout of thread timer and start it */
@@ -1529,32 +1521,50 @@ rt_err_t rt_mb_send_wait(rt_mailbox_t mb,
         }
     }
 
-    /* set ptr */
-    mb->msg_pool[mb->in_offset] = value;
-    /* increase input offset */
-    ++ mb->in_offset;
-    if (mb->in_offset >= mb->size)
-        mb->in_offset = 0;
-    /* increase message entry */
-    mb->entry ++;
-
-    /* resume suspended thread */
-    if (!rt_list_isempty(&mb->parent.suspend_thread))
-    {
-        rt_ipc_list_resume(&(mb->parent.suspend_thread));
+    *level = temp;
 
-        /* enable interrupt */
-        rt_hw_interrupt_enable(temp);
+    return RT_EOK;
+}
 
-        rt_schedule();
+/*
+ * resume the threads waiting on a list for the mails moved, and enable
+ * interrupt. It schedules once for all of them.
+ */
+static void _rt_mb_wakeup(rt_list_t *list, rt_size_t count, rt_ubase_t level)
+{
+    rt_bool_t resumed = RT_FALSE;
 
-        return RT_EOK;
+    while (count > 0 && !rt_list_isempty(list))
+    {
+        rt_ipc_list_resume(list);
+        resumed = RT_TRUE;
+        count --;
     }
 
     /* enable interrupt */
-    rt_hw_interrupt_enable(temp);
+    rt_hw_interrupt_enable(level);
 
-    return RT_EOK;
+    if (resumed)
+        rt_schedule();
+}
+
+/**
+ * This function will send a mail to mailbox object. If the mailbox is full,
+ * current thread will be suspended until timeout.
+ *
+ * @param mb the mailbox object
+ * @param value the mail
+ * @param timeout the waiting time
+ *
+ * @return the error code
+ */
+rt_err_t rt_mb_send_wait(rt_mailbox_t mb,
+                         rt_ubase_t   value,
+                         rt_int32_t   timeout)
+{
+    rt_size_t count = 1;
+
+    return rt_mb_send_batch(mb, &value, &count, timeout);
 }
 RTM_EXPORT(rt_mb_send_wait);
 
@@ -1575,141 +1585,149 @@ rt_err_t rt_mb_send(rt_mailbox_t mb, rt_ubase_t value)
 RTM_EXPORT(rt_mb_send);
 
 /**
- * This function will receive a mail from mailbox object, if there is no mail
- * in mailbox object, the thread shall wait for a specified time.
+ * This function will send mails to mailbox object. If the mailbox is full,
+ * current thread will be suspended until there is a free slot or timeout,
+ * and then the mails are sent as many as the free slots, with interrupt
+ * disabled once. The receivers are waked up and scheduled once.
  *
  * @param mb the mailbox object
- * @param value the received mail will be saved in
+ * @param values the mails
+ * @param count the number of mails, and the number of mails sent on return
  * @param timeout the waiting time
  *
  * @return the error code
  */
-rt_err_t rt_mb_recv(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeout)
+rt_err_t rt_mb_send_batch(rt_mailbox_t      mb,
+                          const rt_ubase_t *values,
+                          rt_size_t        *count,
+                          rt_int32_t        timeout)
 {
-    struct rt_thread *thread;
-    register rt_ubase_t temp;
-    rt_uint32_t tick_delta;
+    rt_ubase_t temp;
+    rt_size_t index, number;
+    rt_err_t result;
 
     /* parameter check */
     RT_ASSERT(mb != RT_NULL);
     RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
+    RT_ASSERT(values != RT_NULL);
+    RT_ASSERT(count != RT_NULL && *count != 0);
 
-    /* initialize delta tick */
-    tick_delta = 0;
-    /* get current thread */
-    thread = rt_thread_self();
-
-    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mb->parent.parent)));
-
-    /* disable interrupt */
-    temp = rt_hw_interrupt_disable();
+    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mb->parent.parent)));
 
-    /* for non-blocking call */
-    if (mb->entry == 0 && timeout == 0)
+    result = _rt_mb_wait(mb, RT_TRUE, timeout, &temp);
+    if (result != RT_EOK)
     {
-        rt_hw_interrupt_enable(temp);
+        *count = 0;
 
-        return -RT_ETIMEOUT;
+        return result;
     }
 
-    /* mailbox is empty */
-    while (mb->entry == 0)
-    {
-        /* reset error number in thread */
-        thread->error = RT_EOK;
-
-        /* no waiting, return timeout */
-        if (timeout == 0)
-        {
-            /* enable interrupt */
-            rt_hw_interrupt_enable(temp);
-
-            thread->error = -RT_ETIMEOUT;
+    number = mb->size - mb->entry;
+    if (number > *count)
+        number = *count;
 
-            return -RT_ETIMEOUT;
-        }
+    for (index = 0; index < number; index ++)
+    {
+        /* set ptr */
+        mb->msg_pool[mb->in_offset] = values[index];
+        /* increase input offset */
+        ++ mb->in_offset;
+        if (mb->in_offset >= mb->size)
+            mb->in_offset = 0;
+    }
+    /* increase message entry */
+    mb->entry += number;
+    *count = number;
 
-        RT_DEBUG_IN_THREAD_CONTEXT;
-        /* suspend current thread */
-        rt_ipc_list_suspend(&(mb->parent.suspend_thread),
-                            thread,
-                            mb->parent.parent.flag);
+    /* resume suspended thread */
+    _rt_mb_wakeup(&(mb->parent.suspend_thread), number, temp);
 
-        /* has waiting time, start thread timer */
-        if (timeout > 0)
-        {
-            /* get the start tick of timer */
-            tick_delta = rt_tick_get();
+    return RT_EOK;
+}
+RTM_EXPORT(rt_mb_send_batch);
 
-            RT_DEBUG_LOG(RT_DEBUG_IPC, ("mb_recv: start timer of thread:%s\n",
-                                        thread->name));
+/**
+ * This function will receive a mail from mailbox object, if there is no mail
+ * in mailbox object, the thread shall wait for a specified time.
+ *
+ * @param mb the mailbox object
+ * @param value the received mail will be saved in
+ * @param timeout the waiting time
+ *
+ * @return the error code
+ */
+rt_err_t rt_mb_recv(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeout)
+{
+    rt_size_t count = 1;
 
-            /* reset the timeout of thread timer and start it */
-            rt_timer_control(&(thread->thread_timer),
-                             RT_TIMER_CTRL_SET_TIME,
-                             &timeout);
-            rt_timer_start(&(thread->thread_timer));
-        }
+    return rt_mb_recv_batch(mb, value, &count, timeout);
+}
+RTM_EXPORT(rt_mb_recv);
 
-        /* enable interrupt */
-        rt_hw_interrupt_enable(temp);
+/**
+ * This function will receive mails from mailbox object, if there is no mail
+ * in mailbox object, the thread shall wait for a specified time. The mails
+ * in mailbox are received up to count, with interrupt disabled once. The
+ * senders are waked up and scheduled once.
+ *
+ * @param mb the mailbox object
+ * @param values the received mails will be saved in
+ * @param count the max number of mails, and the number of mails received
+ *        on return
+ * @param timeout the waiting time
+ *
+ * @return the error code
+ */
+rt_err_t rt_mb_recv_batch(rt_mailbox_t mb,
+                          rt_ubase_t  *values,
+                          rt_size_t   *count,
+                          rt_int32_t   timeout)
+{
+    rt_ubase_t temp;
+    rt_size_t index, number;
+    rt_err_t result;
 
-        /* re-schedule */
-        rt_schedule();
+    /* parameter check */
+    RT_ASSERT(mb != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
+    RT_ASSERT(values != RT_NULL);
+    RT_ASSERT(count != RT_NULL && *count != 0);
 
-        /* resume from suspend state */
-        if (thread->error != RT_EOK)
-        {
-            /* return error */
-            return thread->error;
-        }
+    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mb->parent.parent)));
 
-        /* disable interrupt */
-        temp = rt_hw_interrupt_disable();
+    result = _rt_mb_wait(mb, RT_FALSE, timeout, &temp);
+    if (result != RT_EOK)
+    {
+        *count = 0;
 
-        /* if it's not waiting forever and then re-calculate timeout tick */
-        if (timeout > 0)
-        {
-            tick_delta = rt_tick_get() - tick_delta;
-            timeout -= tick_delta;
-            if (timeout < 0)
-                timeout = 0;
-        }
+        return result;
     }
 
-    /* fill ptr */
-    *value = mb->msg_pool[mb->out_offset];
+    number = mb->entry;
+    if (number > *count)
+        number = *count;
 
-    /* increase output offset */
-    ++ mb->out_offset;
-    if (mb->out_offset >= mb->size)
-        mb->out_offset = 0;
-    /* decrease message entry */
-    mb->entry --;
-
-    /* resume suspended thread */
-    if (!rt_list_isempty(&(mb->suspend_sender_thread)))
+    for (index = 0; index < number; index ++)
     {
-        rt_ipc_list_resume(&(mb->suspend_sender_thread));
-
-        /* enable interrupt */
-        rt_hw_interrupt_enable(temp);
-
-        RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mb->parent.parent)));
-
-        rt_schedule();
-
-        return RT_EOK;
+        /* fill ptr */
+        values[index] = mb->msg_pool[mb->out_offset];
+        /* increase output offset */
+        ++ mb->out_offset;
+        if (mb->out_offset >= mb->size)
+            mb->out_offset = 0;
     }
-
-    /* enable interrupt */
-    rt_hw_interrupt_enable(temp);
+    /* decrease message entry */
+    mb->entry -= number;
+    *count = number;
 
     RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mb->parent.parent)));
 
+    /* resume suspended thread */
+    _rt_mb_wakeup(&(mb->suspend_sender_thread), number, temp);
+
     return RT_EOK;
 }
-RTM_EXPORT(rt_mb_recv);
+RTM_EXPORT(rt_mb_recv_batch);
 
 /**
  * This function can get or set some extra attributions of a mailbox object.
@@ -1760,53 +1778,27 @@ RTM_EXPORT(rt_mb_control);
 struct rt_mq_message
 {
     struct rt_mq_message *next;
+
+    rt_uint16_t prio;                                   /* priority of message */
+    rt_uint16_t size;                                   /* size of message */
 };
 
-/**
- * This function will initialize a message queue and put it under control of
- * resource management.
- *
- * @param mq the message object
- * @param name the name of message queue
- * @param msgpool the beginning address of buffer to save messages
- * @param msg_size the maximum size of message
- * @param pool_size the size of buffer to save messages
- * @param flag the flag of message queue
- *
- * @return the operation status, RT_EOK on successful
- */
-rt_err_t rt_mq_init(rt_mq_t     mq,
-                    const char *name,
-                    void       *msgpool,
-                    rt_size_t   msg_size,
-                    rt_size_t   pool_size,
-                    rt_uint8_t  flag)
+/* the lowest bit in msg_prio_ready is for the lowest priority */
+#define RT_MQ_PRIO_BIT(prio)    (1UL << (RT_MQ_PRIO_MAX - 1 - (prio)))
+
+/* get the message of a loaned buffer */
+#define RT_MQ_MSG(buffer)       ((struct rt_mq_message *)(buffer) - 1)
+
+static void _rt_mq_pool_init(rt_mq_t mq)
 {
     struct rt_mq_message *head;
     register rt_base_t temp;
 
-    /* parameter check */
-    RT_ASSERT(mq != RT_NULL);
-
-    /* init object */
-    rt_object_init(&(mq->parent.parent), RT_Object_Class_MessageQueue, name);
-
-    /* set parent flag */
-    mq->parent.parent.flag = flag;
-
-    /* init ipc object */
-    rt_ipc_object_init(&(mq->parent));
-
-    /* set messasge pool */
-    mq->msg_pool = msgpool;
-
-    /* get correct message size */
-    mq->msg_size = RT_ALIGN(msg_size, RT_ALIGN_SIZE);
-    mq->max_msgs = pool_size / (mq->msg_size + sizeof(struct rt_mq_message));
-
     /* init message list */
     mq->msg_queue_head = RT_NULL;
     mq->msg_queue_tail = RT_NULL;
+    rt_memset(mq->msg_prio_tail, 0, sizeof(mq->msg_prio_tail));
+    mq->msg_prio_ready = 0;
 
     /* init message empty list */
     mq->msg_queue_free = RT_NULL;
@@ -1820,199 +1812,83 @@ rt_err_t rt_mq_init(rt_mq_t     mq,
 
     /* the initial entry is zero */
     mq->entry = 0;
-
-    return RT_EOK;
 }
-RTM_EXPORT(rt_mq_init);
 
-/**
- * This function will detach a message queue object from resource management
- *
- * @param mq the message queue object
- *
- * @return the operation status, RT_EOK on successful
- */
-rt_err_t rt_mq_detach(rt_mq_t mq)
+/* get a message from free list, RT_NULL when the queue is full */
+static struct rt_mq_message *_rt_mq_msg_alloc(rt_mq_t mq)
 {
-    /* parameter check */
-    RT_ASSERT(mq != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
-    RT_ASSERT(rt_object_is_systemobject(&mq->parent.parent));
+    register rt_ubase_t temp;
+    struct rt_mq_message *msg;
 
-    /* resume all suspended thread */
-    rt_ipc_list_resume_all(&mq->parent.suspend_thread);
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
 
-    /* detach message queue object */
-    rt_object_detach(&(mq->parent.parent));
+    msg = (struct rt_mq_message *)mq->msg_queue_free;
+    /* move free list pointer */
+    if (msg != RT_NULL)
+        mq->msg_queue_free = msg->next;
 
-    return RT_EOK;
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+
+    return msg;
 }
-RTM_EXPORT(rt_mq_detach);
 
-#ifdef RT_USING_HEAP
-/**
- * This function will create a message queue object from system resource
- *
- * @param name the name of message queue
- * @param msg_size the size of message
- * @param max_msgs the maximum number of message in queue
- * @param flag the flag of message queue
- *
- * @return the created message queue, RT_NULL on error happen
- */
-rt_mq_t rt_mq_create(const char *name,
-                     rt_size_t   msg_size,
-                     rt_size_t   max_msgs,
-                     rt_uint8_t  flag)
-{
-    struct rt_messagequeue *mq;
-    struct rt_mq_message *head;
-    register rt_base_t temp;
-
-    RT_DEBUG_NOT_IN_INTERRUPT;
-
-    /* allocate object */
-    mq = (rt_mq_t)rt_object_allocate(RT_Object_Class_MessageQueue, name);
-    if (mq == RT_NULL)
-        return mq;
-
-    /* set parent */
-    mq->parent.parent.flag = flag;
-
-    /* init ipc object */
-    rt_ipc_object_init(&(mq->parent));
-
-    /* init message queue */
-
-    /* get correct message size */
-    mq->msg_size = RT_ALIGN(msg_size, RT_ALIGN_SIZE);
-    mq->max_msgs = max_msgs;
-
-    /* allocate message pool */
-    mq->msg_pool = RT_KERNEL_MALLOC((mq->msg_size + sizeof(struct rt_mq_message)) * mq->max_msgs);
-    if (mq->msg_pool == RT_NULL)
-    {
-        rt_mq_delete(mq);
-
-        return RT_NULL;
-    }
-
-    /* init message list */
-    mq->msg_queue_head = RT_NULL;
-    mq->msg_queue_tail = RT_NULL;
-
-    /* init message empty list */
-    mq->msg_queue_free = RT_NULL;
-    for (temp = 0; temp < mq->max_msgs; temp ++)
-    {
-        head = (struct rt_mq_message *)((rt_uint8_t *)mq->msg_pool +
-                                        temp * (mq->msg_size + sizeof(struct rt_mq_message)));
-        head->next = mq->msg_queue_free;
-        mq->msg_queue_free = head;
-    }
-
-    /* the initial entry is zero */
-    mq->entry = 0;
-
-    return mq;
-}
-RTM_EXPORT(rt_mq_create);
-
-/**
- * This function will delete a message queue object and release the memory
- *
- * @param mq the message queue object
- *
- * @return the error code
- */
-rt_err_t rt_mq_delete(rt_mq_t mq)
+/* put a message to free list */
+static void _rt_mq_msg_free(rt_mq_t mq, struct rt_mq_message *msg)
 {
-    RT_DEBUG_NOT_IN_INTERRUPT;
-
-    /* parameter check */
-    RT_ASSERT(mq != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
-    RT_ASSERT(rt_object_is_systemobject(&mq->parent.parent) == RT_FALSE);
-
-    /* resume all suspended thread */
-    rt_ipc_list_resume_all(&(mq->parent.suspend_thread));
-
-    /* free message queue pool */
-    RT_KERNEL_FREE(mq->msg_pool);
-
-    /* delete message queue object */
-    rt_object_delete(&(mq->parent.parent));
+    register rt_ubase_t temp;
 
-    return RT_EOK;
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+    msg->next = (struct rt_mq_message *)mq->msg_queue_free;
+    mq->msg_queue_free = msg;
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
 }
-RTM_EXPORT(rt_mq_delete);
-#endif
 
-/**
- * This function will send a message to message queue object, if there are
- * threads suspended on message queue object, it will be waked up.
- *
- * @param mq the message queue object
- * @param buffer the message
- * @param size the size of buffer
- *
- * @return the error code
+/*
+ * link a message after the messages of the same or higher priority, or to
+ * the beginning of queue for an urgent one. The message to link after is
+ * the tail of the nearest ready priority, which is found by bitmap.
  */
-rt_err_t rt_mq_send(rt_mq_t mq, void *buffer, rt_size_t size)
+static rt_err_t _rt_mq_msg_link(rt_mq_t mq, struct rt_mq_message *msg, rt_bool_t urgent)
 {
     register rt_ubase_t temp;
-    struct rt_mq_message *msg;
-
-    /* parameter check */
-    RT_ASSERT(mq != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
-    RT_ASSERT(buffer != RT_NULL);
-    RT_ASSERT(size != 0);
-
-    /* greater than one message size */
-    if (size > mq->msg_size)
-        return -RT_ERROR;
-
-    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mq->parent.parent)));
+    struct rt_mq_message *prev = RT_NULL;
+    rt_uint32_t ready;
 
     /* disable interrupt */
     temp = rt_hw_interrupt_disable();
 
-    /* get a free list, there must be an empty item */
-    msg = (struct rt_mq_message *)mq->msg_queue_free;
-    /* message queue is full */
-    if (msg == RT_NULL)
+    if (urgent == RT_FALSE)
     {
-        /* enable interrupt */
-        rt_hw_interrupt_enable(temp);
-
-        return -RT_EFULL;
+        /* the ready priorities not lower than the message */
+        ready = mq->msg_prio_ready & ~(RT_MQ_PRIO_BIT(msg->prio) - 1);
+        if (ready != 0)
+            prev = (struct rt_mq_message *)mq->msg_prio_tail[RT_MQ_PRIO_MAX - __rt_ffs(ready)];
     }
-    /* move free list pointer */
-    mq->msg_queue_free = msg->next;
-
-    /* enable interrupt */
-    rt_hw_interrupt_enable(temp);
 
-    /* the msg is the new tailer of list, the next shall be NULL */
-    msg->next = RT_NULL;
-    /* copy buffer */
-    rt_memcpy(msg + 1, buffer, size);
-
-    /* disable interrupt */
-    temp = rt_hw_interrupt_disable();
-    /* link msg to message queue */
-    if (mq->msg_queue_tail != RT_NULL)
+    if (prev == RT_NULL)
+    {
+        /* link msg to the beginning of message queue */
+        msg->next = (struct rt_mq_message *)mq->msg_queue_head;
+        mq->msg_queue_head = msg;
+    }
+    else
     {
-        /* if the tail exists, */
-        ((struct rt_mq_message *)mq->msg_queue_tail)->next = msg;
+        msg->next = prev->next;
+        prev->next = msg;
     }
 
     /* set new tail */
-    mq->msg_queue_tail = msg;
-    /* if the head is empty, set head */
-    if (mq->msg_queue_head == RT_NULL)
-        mq->msg_queue_head = msg;
+    if (msg->next == RT_NULL)
+        mq->msg_queue_tail = msg;
+
+    /* an urgent message is not the last one of its priority */
+    if (urgent == RT_FALSE || mq->msg_prio_tail[msg->prio] == RT_NULL)
+        mq->msg_prio_tail[msg->prio] = msg;
+    mq->msg_prio_ready |= RT_MQ_PRIO_BIT(msg->prio);
 
     /* increase message entry */
     mq->entry ++;
@@ -2035,125 +1911,47 @@ rt_err_t rt_mq_send(rt_mq_t mq, void *buffer, rt_size_t size)
 
     return RT_EOK;
 }
-RTM_EXPORT(rt_mq_send);
 
-/**
- * This function will send an urgent message to message queue object, which
- * means the message will be inserted to the head of message queue. If there
- * are threads suspended on message queue object, it will be waked up.
- *
- * @param mq the message queue object
- * @param buffer the message
- * @param size the size of buffer
- *
- * @return the error code
- */
-rt_err_t rt_mq_urgent(rt_mq_t mq, void *buffer, rt_size_t size)
+/* get the first message of queue, interrupt is disabled */
+static struct rt_mq_message *_rt_mq_msg_unlink(rt_mq_t mq)
 {
-    register rt_ubase_t temp;
     struct rt_mq_message *msg;
 
-    /* parameter check */
-    RT_ASSERT(mq != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
-    RT_ASSERT(buffer != RT_NULL);
-    RT_ASSERT(size != 0);
-
-    /* greater than one message size */
-    if (size > mq->msg_size)
-        return -RT_ERROR;
-
-    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mq->parent.parent)));
-
-    /* disable interrupt */
-    temp = rt_hw_interrupt_disable();
-
-    /* get a free list, there must be an empty item */
-    msg = (struct rt_mq_message *)mq->msg_queue_free;
-    /* message queue is full */
-    if (msg == RT_NULL)
-    {
-        /* enable interrupt */
-        rt_hw_interrupt_enable(temp);
-
-        return -RT_EFULL;
-    }
-    /* move free list pointer */
-    mq->msg_queue_free = msg->next;
-
-    /* enable interrupt */
-    rt_hw_interrupt_enable(temp);
-
-    /* copy buffer */
-    rt_memcpy(msg + 1, buffer, size);
-
-    /* disable interrupt */
-    temp = rt_hw_interrupt_disable();
-
-    /* link msg to the beginning of message queue */
-    msg->next = mq->msg_queue_head;
-    mq->msg_queue_head = msg;
-
-    /* if there is no tail */
-    if (mq->msg_queue_tail == RT_NULL)
-        mq->msg_queue_tail = msg;
+    /* get message from queue */
+    msg = (struct rt_mq_message *)mq->msg_queue_head;
 
-    /* increase message entry */
-    mq->entry ++;
+    /* move message queue head */
+    mq->msg_queue_head = msg->next;
+    /* reach queue tail, set to NULL */
+    if (mq->msg_queue_tail == msg)
+        mq->msg_queue_tail = RT_NULL;
 
-    /* resume suspended thread */
-    if (!rt_list_isempty(&mq->parent.suspend_thread))
+    /* it's the only message of its priority */
+    if (mq->msg_prio_tail[msg->prio] == msg)
     {
-        rt_ipc_list_resume(&(mq->parent.suspend_thread));
-
-        /* enable interrupt */
-        rt_hw_interrupt_enable(temp);
-
-        rt_schedule();
-
-        return RT_EOK;
+        mq->msg_prio_tail[msg->prio] = RT_NULL;
+        mq->msg_prio_ready &= ~RT_MQ_PRIO_BIT(msg->prio);
     }
 
-    /* enable interrupt */
-    rt_hw_interrupt_enable(temp);
+    /* decrease message entry */
+    mq->entry --;
 
-    return RT_EOK;
+    return msg;
 }
-RTM_EXPORT(rt_mq_urgent);
 
-/**
- * This function will receive a message from message queue object, if there is
- * no message in message queue object, the thread shall wait for a specified
- * time.
- *
- * @param mq the message queue object
- * @param buffer the received message will be saved in
- * @param size the size of buffer
- * @param timeout the waiting time
- *
- * @return the error code
- */
-rt_err_t rt_mq_recv(rt_mq_t    mq,
-                    void      *buffer,
-                    rt_size_t  size,
-                    rt_int32_t timeout)
+/* wait for a message and take it out of queue */
+static rt_err_t _rt_mq_msg_wait(rt_mq_t                mq,
+                                struct rt_mq_message **msg,
+                                rt_int32_t             timeout)
 {
     struct rt_thread *thread;
     register rt_ubase_t temp;
-    struct rt_mq_message *msg;
     rt_uint32_t tick_delta;
 
-    /* parameter check */
-    RT_ASSERT(mq != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
-    RT_ASSERT(buffer != RT_NULL);
-    RT_ASSERT(size != 0);
-
     /* initialize delta tick */
     tick_delta = 0;
     /* get current thread */
     thread = rt_thread_self();
-    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mq->parent.parent)));
 
     /* disable interrupt */
     temp = rt_hw_interrupt_disable();
@@ -2232,37 +2030,469 @@ rt_err_t rt_mq_recv(rt_mq_t    mq,
         }
     }
 
-    /* get message from queue */
-    msg = (struct rt_mq_message *)mq->msg_queue_head;
-
-    /* move message queue head */
-    mq->msg_queue_head = msg->next;
-    /* reach queue tail, set to NULL */
-    if (mq->msg_queue_tail == msg)
-        mq->msg_queue_tail = RT_NULL;
-
-    /* decrease message entry */
-    mq->entry --;
+    *msg = _rt_mq_msg_unlink(mq);
 
     /* enable interrupt */
     rt_hw_interrupt_enable(temp);
 
+    return RT_EOK;
+}
+
+/**
+ * This function will initialize a message queue and put it under control of
+ * resource management.
+ *
+ * @param mq the message object
+ * @param name the name of message queue
+ * @param msgpool the beginning address of buffer to save messages
+ * @param msg_size the maximum size of message
+ * @param pool_size the size of buffer to save messages
+ * @param flag the flag of message queue
+ *
+ * @return the operation status, RT_EOK on successful
+ */
+rt_err_t rt_mq_init(rt_mq_t     mq,
+                    const char *name,
+                    void       *msgpool,
+                    rt_size_t   msg_size,
+                    rt_size_t   pool_size,
+                    rt_uint8_t  flag)
+{
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+
+    /* the size of message is kept in 16 bits */
+    if (RT_ALIGN(msg_size, RT_ALIGN_SIZE) > RT_UINT16_MAX)
+        return -RT_ERROR;
+
+    /* init object */
+    rt_object_init(&(mq->parent.parent), RT_Object_Class_MessageQueue, name);
+
+    /* set parent flag */
+    mq->parent.parent.flag = flag;
+
+    /* init ipc object */
+    rt_ipc_object_init(&(mq->parent));
+
+    /* set messasge pool */
+    mq->msg_pool = msgpool;
+
+    /* get correct message size */
+    mq->msg_size = RT_ALIGN(msg_size, RT_ALIGN_SIZE);
+    mq->max_msgs = pool_size / (mq->msg_size + sizeof(struct rt_mq_message));
+
+    /* init message list and empty list */
+    _rt_mq_pool_init(mq);
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_mq_init);
+
+/**
+ * This function will detach a message queue object from resource management
+ *
+ * @param mq the message queue object
+ *
+ * @return the operation status, RT_EOK on successful
+ */
+rt_err_t rt_mq_detach(rt_mq_t mq)
+{
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(rt_object_is_systemobject(&mq->parent.parent));
+
+    /* resume all suspended thread */
+    rt_ipc_list_resume_all(&mq->parent.suspend_thread);
+
+    /* detach message queue object */
+    rt_object_detach(&(mq->parent.parent));
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_mq_detach);
+
+#ifdef RT_USING_HEAP
+/**
+ * This function will create a message queue object from system resource
+ *
+ * @param name the name of message queue
+ * @param msg_size the size of message
+ * @param max_msgs the maximum number of message in queue
+ * @param flag the flag of message queue
+ *
+ * @return the created message queue, RT_NULL on error happen
+ */
+rt_mq_t rt_mq_create(const char *name,
+                     rt_size_t   msg_size,
+                     rt_size_t   max_msgs,
+                     rt_uint8_t  flag)
+{
+    struct rt_messagequeue *mq;
+
+    RT_DEBUG_NOT_IN_INTERRUPT;
+
+    /* the size of message and the number of messages are kept in 16 bits */
+    if (RT_ALIGN(msg_size, RT_ALIGN_SIZE) > RT_UINT16_MAX || max_msgs > RT_UINT16_MAX)
+        return RT_NULL;
+
+    /* allocate object */
+    mq = (rt_mq_t)rt_object_allocate(RT_Object_Class_MessageQueue, name);
+    if (mq == RT_NULL)
+        return mq;
+
+    /* set parent */
+    mq->parent.parent.flag = flag;
+
+    /* init ipc object */
+    rt_ipc_object_init(&(mq->parent));
+
+    /* init message queue */
+
+    /* get correct message size */
+    mq->msg_size = RT_ALIGN(msg_size, RT_ALIGN_SIZE);
+    mq->max_msgs = max_msgs;
+
+    /* allocate message pool */
+    mq->msg_pool = RT_KERNEL_MALLOC((mq->msg_size + sizeof(struct rt_mq_message)) * mq->max_msgs);
+    if (mq->msg_pool == RT_NULL)
+    {
+        rt_mq_delete(mq);
+
+        return RT_NULL;
+    }
+
+    /* init message list and empty list */
+    _rt_mq_pool_init(mq);
+
+    return mq;
+}
+RTM_EXPORT(rt_mq_create);
+
+/**
+ * This function will delete a message queue object and release the memory
+ *
+ * @param mq the message queue object
+ *
+ * @return the error code
+ */
+rt_err_t rt_mq_delete(rt_mq_t mq)
+{
+    RT_DEBUG_NOT_IN_INTERRUPT;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(rt_object_is_systemobject(&mq->parent.parent) == RT_FALSE);
+
+    /* resume all suspended thread */
+    rt_ipc_list_resume_all(&(mq->parent.suspend_thread));
+
+    /* free message queue pool */
+    RT_KERNEL_FREE(mq->msg_pool);
+
+    /* delete message queue object */
+    rt_object_delete(&(mq->parent.parent));
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_mq_delete);
+#endif
+
+/**
+ * This function will send a message to message queue object, if there are
+ * threads suspended on message queue object, it will be waked up.
+ *
+ * @param mq the message queue object
+ * @param buffer the message
+ * @param size the size of buffer
+ *
+ * @return the error code
+ */
+rt_err_t rt_mq_send(rt_mq_t mq, void *buffer, rt_size_t size)
+{
+    /* a normal message has the lowest priority */
+    return rt_mq_send_prio(mq, buffer, size, RT_MQ_PRIO_MAX - 1);
+}
+RTM_EXPORT(rt_mq_send);
+
+/**
+ * This function will send a message with priority to message queue object.
+ * The message is received after the messages of higher priority, and after
+ * the ones of the same priority which are sent before it.
+ *
+ * @param mq the message queue object
+ * @param buffer the message
+ * @param size the size of buffer
+ * @param prio the priority of message, 0 is the highest one
+ *
+ * @return the error code
+ */
+rt_err_t rt_mq_send_prio(rt_mq_t mq, void *buffer, rt_size_t size, int prio)
+{
+    struct rt_mq_message *msg;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+    RT_ASSERT(size != 0);
+
+    /* greater than one message size */
+    if (size > mq->msg_size || prio < 0 || prio >= RT_MQ_PRIO_MAX)
+        return -RT_ERROR;
+
+    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mq->parent.parent)));
+
+    /* get a free list, there must be an empty item */
+    msg = _rt_mq_msg_alloc(mq);
+    /* message queue is full */
+    if (msg == RT_NULL)
+        return -RT_EFULL;
+
+    /* copy buffer */
+    rt_memcpy(msg + 1, buffer, size);
+    msg->prio = prio;
+    msg->size = size;
+
+    return _rt_mq_msg_link(mq, msg, RT_FALSE);
+}
+RTM_EXPORT(rt_mq_send_prio);
+
+/**
+ * This function will send an urgent message to message queue object, which
+ * means the message will be inserted to the head of message queue. If there
+ * are threads suspended on message queue object, it will be waked up.
+ *
+ * @param mq the message queue object
+ * @param buffer the message
+ * @param size the size of buffer
+ *
+ * @return the error code
+ */
+rt_err_t rt_mq_urgent(rt_mq_t mq, void *buffer, rt_size_t size)
+{
+    struct rt_mq_message *msg;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+    RT_ASSERT(size != 0);
+
+    /* greater than one message size */
+    if (size > mq->msg_size)
+        return -RT_ERROR;
+
+    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mq->parent.parent)));
+
+    /* get a free list, there must be an empty item */
+    msg = _rt_mq_msg_alloc(mq);
+    /* message queue is full */
+    if (msg == RT_NULL)
+        return -RT_EFULL;
+
+    /* copy buffer */
+    rt_memcpy(msg + 1, buffer, size);
+    msg->prio = 0;
+    msg->size = size;
+
+    return _rt_mq_msg_link(mq, msg, RT_TRUE);
+}
+RTM_EXPORT(rt_mq_urgent);
+
+/**
+ * This function will receive a message from message queue object, if there is
+ * no message in message queue object, the thread shall wait for a specified
+ * time.
+ *
+ * @param mq the message queue object
+ * @param buffer the received message will be saved in
+ * @param size the size of buffer
+ * @param timeout the waiting time
+ *
+ * @return the error code
+ */
+rt_err_t rt_mq_recv(rt_mq_t    mq,
+                    void      *buffer,
+                    rt_size_t  size,
+                    rt_int32_t timeout)
+{
+    return rt_mq_recv_prio(mq, buffer, size, RT_NULL, RT_NULL, timeout);
+}
+RTM_EXPORT(rt_mq_recv);
+
+/**
+ * This function will receive a message from message queue object as
+ * rt_mq_recv, and get the priority and size of the message.
+ *
+ * @param mq the message queue object
+ * @param buffer the received message will be saved in
+ * @param size the size of buffer
+ * @param prio the priority of message received, it could be RT_NULL
+ * @param length the size of message copied to buffer, it could be RT_NULL
+ * @param timeout the waiting time
+ *
+ * @return the error code
+ */
+rt_err_t rt_mq_recv_prio(rt_mq_t     mq,
+                         void       *buffer,
+                         rt_size_t   size,
+                         int        *prio,
+                         rt_size_t  *length,
+                         rt_int32_t  timeout)
+{
+    struct rt_mq_message *msg;
+    rt_err_t result;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+    RT_ASSERT(size != 0);
+
+    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mq->parent.parent)));
+
+    result = _rt_mq_msg_wait(mq, &msg, timeout);
+    if (result != RT_EOK)
+        return result;
+
     /* copy message */
-    rt_memcpy(buffer, msg + 1, size > mq->msg_size ? mq->msg_size : size);
+    if (size > msg->size)
+        size = msg->size;
+    rt_memcpy(buffer, msg + 1, size);
+    if (prio != RT_NULL)
+        *prio = msg->prio;
+    if (length != RT_NULL)
+        *length = size;
 
-    /* disable interrupt */
-    temp = rt_hw_interrupt_disable();
     /* put message to free list */
-    msg->next = (struct rt_mq_message *)mq->msg_queue_free;
-    mq->msg_queue_free = msg;
-    /* enable interrupt */
-    rt_hw_interrupt_enable(temp);
+    _rt_mq_msg_free(mq, msg);
 
     RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mq->parent.parent)));
 
     return RT_EOK;
 }
-RTM_EXPORT(rt_mq_recv);
+RTM_EXPORT(rt_mq_recv_prio);
+
+/**
+ * This function will allocate a message buffer in message queue object,
+ * which is loaned to the caller until it's sent by rt_mq_send_msg or
+ * released by rt_mq_release_msg. The message is not copied when it's sent.
+ *
+ * @param mq the message queue object
+ *
+ * @return the message buffer of msg_size, RT_NULL when the queue is full
+ */
+void *rt_mq_alloc_msg(rt_mq_t mq)
+{
+    struct rt_mq_message *msg;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+
+    msg = _rt_mq_msg_alloc(mq);
+    if (msg == RT_NULL)
+        return RT_NULL;
+
+    return msg + 1;
+}
+RTM_EXPORT(rt_mq_alloc_msg);
+
+/**
+ * This function will send a message buffer allocated by rt_mq_alloc_msg,
+ * and the buffer is owned by message queue object then.
+ *
+ * @param mq the message queue object
+ * @param buffer the message buffer
+ * @param size the size of message
+ * @param prio the priority of message, 0 is the highest one
+ *
+ * @return the error code
+ */
+rt_err_t rt_mq_send_msg(rt_mq_t mq, void *buffer, rt_size_t size, int prio)
+{
+    struct rt_mq_message *msg;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+    RT_ASSERT(size != 0);
+
+    /* greater than one message size */
+    if (size > mq->msg_size || prio < 0 || prio >= RT_MQ_PRIO_MAX)
+        return -RT_ERROR;
+
+    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mq->parent.parent)));
+
+    msg = RT_MQ_MSG(buffer);
+    msg->prio = prio;
+    msg->size = size;
+
+    return _rt_mq_msg_link(mq, msg, RT_FALSE);
+}
+RTM_EXPORT(rt_mq_send_msg);
+
+/**
+ * This function will receive a message from message queue object without
+ * copy. The message buffer is loaned to the caller until it's released by
+ * rt_mq_release_msg.
+ *
+ * @param mq the message queue object
+ * @param buffer the message buffer received
+ * @param size the size of message received, it could be RT_NULL
+ * @param timeout the waiting time
+ *
+ * @return the error code
+ */
+rt_err_t rt_mq_recv_msg(rt_mq_t     mq,
+                        void      **buffer,
+                        rt_size_t  *size,
+                        rt_int32_t  timeout)
+{
+    struct rt_mq_message *msg;
+    rt_err_t result;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+
+    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mq->parent.parent)));
+
+    result = _rt_mq_msg_wait(mq, &msg, timeout);
+    if (result != RT_EOK)
+        return result;
+
+    *buffer = msg + 1;
+    if (size != RT_NULL)
+        *size = msg->size;
+
+    RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mq->parent.parent)));
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_mq_recv_msg);
+
+/**
+ * This function will release a message buffer loaned by rt_mq_alloc_msg or
+ * rt_mq_recv_msg.
+ *
+ * @param mq the message queue object
+ * @param buffer the message buffer
+ */
+void rt_mq_release_msg(rt_mq_t mq, void *buffer)
+{
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+
+    _rt_mq_msg_free(mq, RT_MQ_MSG(buffer));
+}
+RTM_EXPORT(rt_mq_release_msg);
 
 /**
  * This function can get or set some extra attributions of a message queue
@@ -2310,6 +2540,8 @@ rt_err_t rt_mq_control(rt_mq_t mq, int cmd, void *arg)
 
         /* clean entry */
         mq->entry = 0;
+        rt_memset(mq->msg_prio_tail, 0, sizeof(mq->msg_prio_tail));
+        mq->msg_prio_ready = 0;
 
         /* enable interrupt */
         rt_hw_interrupt_enable(level);
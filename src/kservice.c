@@ -17,6 +17,7 @@
  * 2013-06-24     Bernard      remove rt_kprintf if RT_USING_CONSOLE is not defined.
  * 2013-09-24     aozima       make sure the device is in STREAM mode when used by rt_kprintf.
  * 2015-07-06     Bernard      Add rt_assert_handler routine.
+ * 2026-10-19     heyuanjie    output to the console of thread if it has one
  */
 
 #include <rtthread.h>
@@ -1059,6 +1060,27 @@ RT_WEAK void rt_hw_console_output(const char *str)
 }
 RTM_EXPORT(rt_hw_console_output);
 
+/*
+ * a thread with its own console, e.g. a telnet shell, prints there. The
+ * write of console is called in critical sections or with interrupts
+ * disabled too, it must not block.
+ */
+static void _console_output(const char *str, rt_size_t length)
+{
+#ifdef RT_USING_CONSOLE
+    rt_thread_t thread;
+
+    thread = rt_thread_self();
+    if (rt_interrupt_get_nest() == 0 && thread != RT_NULL && thread->console != RT_NULL)
+    {
+        thread->console->write(thread->console, str, length);
+        return;
+    }
+#endif
+
+    rt_hw_console_output(str);
+}
+
 /**
  * This function will put string to the console.
  *
@@ -1068,7 +1090,7 @@ void rt_kputs(const char *str)
 {
     if (!str) return;
 
-    rt_hw_console_output(str);
+    _console_output(str, rt_strlen(str));
 }
 
 #ifdef RT_USING_CONSOLE
@@ -1093,7 +1115,7 @@ void rt_kprintf(const char *fmt, ...)
     if (length > RT_CONSOLEBUF_SIZE - 1)
         length = RT_CONSOLEBUF_SIZE - 1;
 
-    rt_hw_console_output(rt_log_buf);
+    _console_output(rt_log_buf, length);
 
     va_end(args);
 }
@@ -28,6 +28,10 @@
  * 2012-11-28     Bernard      remove rt_current_module and user
  *                             can use rt_module_unload to remove a module.
  * 2017-08-20     parai        support intel 386 machine
+ * 2026-10-19     heyuanjie    hash kernel symbol table, sort module symbol
+ *                             table and cache resolved symbols on loading
+ * 2026-10-19     heyuanjie    share a library between rt_module_open calls
+ * 2026-10-19     heyuanjie    lazy binding of PLT entries on arm
  */
 
 #include <rthw.h>
@@ -65,6 +69,17 @@
 #define RT_USING_MODULE_PRIO (RT_THREAD_PRIORITY_MAX - 2)
 #endif
 
+/*
+ * With RT_MODULE_USING_LAZY_BIND, the functions of kernel called by a module
+ * through its PLT are resolved on their first call instead of on loading.
+ * The PLT of the arm (and thumb-2) toolchain enters the resolver with the
+ * GOT entry in ip, so it's supported by GCC on these targets only.
+ */
+#if defined(RT_MODULE_USING_LAZY_BIND) && defined(__GNUC__) && defined(__arm__) && \
+    (defined(__ARM_ARCH_ISA_ARM) || defined(__thumb2__))
+#define MODULE_LAZY_BIND
+#endif
+
 #ifdef RT_USING_SLAB
 #define PAGE_COUNT_MAX    256
 
@@ -89,13 +104,71 @@ static void rt_module_free_page(rt_module_t module,
 static struct rt_semaphore mod_sem;
 #endif
 
+rt_module_t rt_module_find(const char *name);
+
 static struct rt_module_symtab *_rt_module_symtab_begin = RT_NULL;
 static struct rt_module_symtab *_rt_module_symtab_end   = RT_NULL;
 
+/*
+ * hash index of kernel symbol table, which is built on initialization.
+ * bucket and chain hold symbol index + 1, 0 is the end of a chain.
+ */
+static rt_uint32_t  _rt_module_symhash_nbucket = 0;
+static rt_uint32_t *_rt_module_symhash  = RT_NULL;
+static rt_uint16_t *_rt_module_symbucket = RT_NULL;
+static rt_uint16_t *_rt_module_symchain  = RT_NULL;
+
 #if defined(__IAR_SYSTEMS_ICC__) /* for IAR compiler */
     #pragma section="RTMSymTab"
 #endif
 
+/* the hash function of GNU hash section */
+static rt_uint32_t _rt_module_symbol_hash(const char *name)
+{
+    rt_uint32_t hash = 5381;
+
+    while (*name)
+        hash = (hash << 5) + hash + (rt_uint8_t)*name ++;
+
+    return hash;
+}
+
+static void _rt_module_symhash_init(void)
+{
+    rt_uint32_t nsym, index, bucket;
+    rt_uint8_t *ptr;
+
+    nsym = _rt_module_symtab_end - _rt_module_symtab_begin;
+    if (nsym == 0 || nsym >= 0xFFFF)
+        return;
+
+    /* about two symbols in a bucket */
+    _rt_module_symhash_nbucket = nsym / 2 + 1;
+    ptr = (rt_uint8_t *)rt_malloc(nsym * sizeof(rt_uint32_t) +
+                                  RT_ALIGN((_rt_module_symhash_nbucket + nsym) * sizeof(rt_uint16_t), 4));
+    if (ptr == RT_NULL)
+    {
+        /* fall back to linear search */
+        _rt_module_symhash_nbucket = 0;
+        return;
+    }
+
+    _rt_module_symhash   = (rt_uint32_t *)ptr;
+    _rt_module_symbucket = (rt_uint16_t *)(ptr + nsym * sizeof(rt_uint32_t));
+    _rt_module_symchain  = _rt_module_symbucket + _rt_module_symhash_nbucket;
+    rt_memset(_rt_module_symbucket, 0, _rt_module_symhash_nbucket * sizeof(rt_uint16_t));
+
+    /* insert from the end, so the chains keep the order of table */
+    for (index = nsym; index > 0; index --)
+    {
+        _rt_module_symhash[index - 1] = _rt_module_symbol_hash(_rt_module_symtab_begin[index - 1].name);
+        bucket = _rt_module_symhash[index - 1] % _rt_module_symhash_nbucket;
+
+        _rt_module_symchain[index - 1] = _rt_module_symbucket[bucket];
+        _rt_module_symbucket[bucket] = index;
+    }
+}
+
 /**
  * @ingroup SystemInit
  *
@@ -120,6 +193,8 @@ int rt_system_module_init(void)
     _rt_module_symtab_end   = __section_end("RTMSymTab");
 #endif
 
+    _rt_module_symhash_init();
+
 #ifdef RT_USING_SLAB
     /* initialize heap semaphore */
     rt_sem_init(&mod_sem, "module", 1, RT_IPC_FLAG_FIFO);
@@ -152,6 +227,24 @@ static rt_uint32_t rt_module_symbol_find(const char *sym_str)
     /* find in kernel symbol table */
     struct rt_module_symtab *index;
 
+    if (_rt_module_symhash_nbucket != 0)
+    {
+        rt_uint32_t hash;
+        rt_uint16_t sym;
+
+        hash = _rt_module_symbol_hash(sym_str);
+        for (sym = _rt_module_symbucket[hash % _rt_module_symhash_nbucket];
+             sym != 0;
+             sym = _rt_module_symchain[sym - 1])
+        {
+            if (_rt_module_symhash[sym - 1] == hash &&
+                rt_strcmp(_rt_module_symtab_begin[sym - 1].name, sym_str) == 0)
+                return (rt_uint32_t)_rt_module_symtab_begin[sym - 1].addr;
+        }
+
+        return 0;
+    }
+
     for (index = _rt_module_symtab_begin;
          index != _rt_module_symtab_end;
          index ++)
@@ -401,6 +494,204 @@ void rt_module_unload_sethook(void (*hook)(rt_module_t module))
 /**@}*/
 #endif
 
+/*
+ * resolve a symbol in kernel symbol table for relocation. Many relocations
+ * refer to the same symbol, so the address is cached by symbol index and
+ * every symbol is searched only once while loading.
+ */
+static Elf32_Addr _rt_module_symbol_resolve(Elf32_Addr  *cache,
+                                            rt_uint32_t  index,
+                                            const char  *name)
+{
+    if (cache == RT_NULL)
+        return rt_module_symbol_find(name);
+
+    if (cache[index] == 0)
+        cache[index] = rt_module_symbol_find(name);
+
+    return cache[index];
+}
+
+/* shell sort, the symbol table of a module is searched in binary by dlsym */
+static void _rt_module_symtab_sort(struct rt_module_symtab *symtab, int nsym)
+{
+    struct rt_module_symtab tmp;
+    int gap, i, j;
+
+    for (gap = nsym / 2; gap > 0; gap /= 2)
+    {
+        for (i = gap; i < nsym; i ++)
+        {
+            tmp = symtab[i];
+            for (j = i; j >= gap && rt_strcmp(symtab[j - gap].name, tmp.name) > 0; j -= gap)
+                symtab[j] = symtab[j - gap];
+            symtab[j] = tmp;
+        }
+    }
+}
+
+/* get the symbol cache for the symbol table of a relocation section */
+static Elf32_Addr *_rt_module_symbol_cache(void        *module_ptr,
+                                           Elf32_Addr  *cache,
+                                           rt_uint32_t *link,
+                                           rt_uint32_t  index)
+{
+    if (cache != RT_NULL && *link == shdr[index].sh_link)
+        return cache;
+
+    if (cache != RT_NULL)
+        rt_free(cache);
+
+    /* no cache is not an error, only slower */
+    *link = shdr[index].sh_link;
+    return (Elf32_Addr *)rt_calloc(shdr[*link].sh_size / sizeof(Elf32_Sym),
+                                   sizeof(Elf32_Addr));
+}
+
+#ifdef MODULE_LAZY_BIND
+/* lazy binding state, placed after the image in the module space */
+struct rt_module_lazy
+{
+    rt_uint8_t  *base;                  /* module space - vstart_addr */
+    Elf32_Addr  *pltgot;
+    Elf32_Rel   *jmprel;
+    rt_uint32_t  nr_jmprel;
+    Elf32_Sym   *symtab;
+    const char  *strtab;
+};
+
+/*
+ * resolve the function of a PLT entry on its first call and fill its GOT
+ * entry, so that the later calls go to the function directly
+ */
+__attribute__((used))
+static Elf32_Addr _rt_module_lazy_resolve(struct rt_module_lazy *lazy,
+                                          Elf32_Addr            *got)
+{
+    Elf32_Rel *rel;
+    Elf32_Sym *sym;
+    Elf32_Addr addr;
+    rt_uint32_t index;
+
+    /* the GOT entries of PLT follow the 3 reserved ones in the order of JMPREL */
+    index = got - lazy->pltgot - 3;
+    if (index >= lazy->nr_jmprel ||
+        (Elf32_Addr *)(lazy->base + lazy->jmprel[index].r_offset) != got)
+    {
+        for (index = 0; index < lazy->nr_jmprel; index ++)
+        {
+            if ((Elf32_Addr *)(lazy->base + lazy->jmprel[index].r_offset) == got)
+                break;
+        }
+        RT_ASSERT(index < lazy->nr_jmprel);
+    }
+
+    rel  = &lazy->jmprel[index];
+    sym  = &lazy->symtab[ELF32_R_SYM(rel->r_info)];
+    addr = rt_module_symbol_find(lazy->strtab + sym->st_name);
+    if (addr == 0)
+    {
+        rt_kprintf("Module: can't find %s in kernel symbol table\n",
+                   lazy->strtab + sym->st_name);
+        RT_ASSERT(0);
+    }
+
+    *got = addr;
+
+    return addr;
+}
+
+/*
+ * entered from PLT0 with the return address of the caller pushed, ip the
+ * GOT entry and lr &GOT[2]. GOT[1] is the lazy binding state. r4 is saved
+ * only to keep the stack 8 bytes aligned.
+ */
+__attribute__((naked))
+static void _rt_module_lazy_entry(void)
+{
+    __asm__ volatile(
+        "push  {r0-r4}                  \n"
+        "ldr   r0, [lr, #-4]            \n"
+        "mov   r1, ip                   \n"
+        "bl    _rt_module_lazy_resolve  \n"
+        "mov   ip, r0                   \n"
+        "pop   {r0-r4}                  \n"
+        "pop   {lr}                     \n"
+        "bx    ip                       \n");
+}
+
+/* the address in module space of a vaddr of the image, RT_NULL if out of it */
+static void *_rt_module_lazy_addr(Elf32_Addr vaddr, Elf32_Addr vstart_addr,
+                                  rt_uint32_t module_size, rt_uint8_t *base)
+{
+    if (vaddr < vstart_addr || vaddr >= vstart_addr + module_size)
+        return RT_NULL;
+
+    return base + vaddr;
+}
+
+static struct rt_module_lazy *_rt_module_lazy_init(void        *module_ptr,
+                                                   rt_uint8_t  *module_space,
+                                                   Elf32_Addr   vstart_addr,
+                                                   rt_uint32_t  module_size)
+{
+    struct rt_module_lazy *lazy;
+    Elf32_Dyn *dyn = RT_NULL;
+    rt_uint32_t index, nr_dyn = 0;
+
+    for (index = 0; index < elf_module->e_shnum; index ++)
+    {
+        if (shdr[index].sh_type == SHT_DYNAMIC)
+        {
+            dyn = (Elf32_Dyn *)((rt_uint8_t *)module_ptr + shdr[index].sh_offset);
+            nr_dyn = shdr[index].sh_size / sizeof(Elf32_Dyn);
+            break;
+        }
+    }
+    if (dyn == RT_NULL)
+        return RT_NULL;
+
+    /* placed after the image, which is rounded up to word */
+    lazy = (struct rt_module_lazy *)(module_space + RT_ALIGN(module_size, 4));
+    rt_memset(lazy, 0, sizeof(struct rt_module_lazy));
+    lazy->base = module_space - vstart_addr;
+
+    for (index = 0; index < nr_dyn && dyn[index].d_tag != DT_NULL; index ++)
+    {
+        void *addr = _rt_module_lazy_addr(dyn[index].d_un.d_ptr, vstart_addr,
+                                          module_size, lazy->base);
+
+        switch (dyn[index].d_tag)
+        {
+        case DT_PLTGOT:
+            lazy->pltgot = (Elf32_Addr *)addr;
+            break;
+        case DT_JMPREL:
+            lazy->jmprel = (Elf32_Rel *)addr;
+            break;
+        case DT_PLTRELSZ:
+            lazy->nr_jmprel = dyn[index].d_un.d_val / sizeof(Elf32_Rel);
+            break;
+        case DT_SYMTAB:
+            lazy->symtab = (Elf32_Sym *)addr;
+            break;
+        case DT_STRTAB:
+            lazy->strtab = (const char *)addr;
+            break;
+        }
+    }
+
+    if (lazy->pltgot == RT_NULL || lazy->jmprel == RT_NULL ||
+        lazy->nr_jmprel == 0 || lazy->symtab == RT_NULL || lazy->strtab == RT_NULL)
+        return RT_NULL;
+
+    lazy->pltgot[1] = (Elf32_Addr)lazy;
+    lazy->pltgot[2] = (Elf32_Addr)_rt_module_lazy_entry;
+
+    return lazy;
+}
+#endif
+
 static struct rt_module *_load_shared_object(const char *name,
                                              void       *module_ptr)
 {
@@ -409,6 +700,11 @@ static struct rt_module *_load_shared_object(const char *name,
     rt_uint32_t index, module_size = 0;
     Elf32_Addr vstart_addr, vend_addr;
     rt_bool_t has_vstart;
+    Elf32_Addr *symcache = RT_NULL;
+    rt_uint32_t symlink = 0;
+#ifdef MODULE_LAZY_BIND
+    struct rt_module_lazy *lazy = RT_NULL;
+#endif
 
     RT_ASSERT(module_ptr != RT_NULL);
 
@@ -493,7 +789,11 @@ static struct rt_module *_load_shared_object(const char *name,
     module->nref = 0;
 
     /* allocate module space */
+#ifdef MODULE_LAZY_BIND
+    module->module_space = rt_malloc(RT_ALIGN(module_size, 4) + sizeof(struct rt_module_lazy));
+#else
     module->module_space = rt_malloc(module_size);
+#endif
     if (module->module_space == RT_NULL)
     {
         rt_kprintf("Module: allocate space failed.\n");
@@ -519,6 +819,12 @@ static struct rt_module *_load_shared_object(const char *name,
     module->module_entry = module->module_space
                            + elf_module->e_entry - vstart_addr;
 
+#ifdef MODULE_LAZY_BIND
+    if (!linked)
+        lazy = _rt_module_lazy_init(module_ptr, module->module_space,
+                                    vstart_addr, module_size);
+#endif
+
     /* handle relocation section */
     for (index = 0; index < elf_module->e_shnum; index ++)
     {
@@ -531,6 +837,8 @@ static struct rt_module *_load_shared_object(const char *name,
         if (!IS_REL(shdr[index]))
             continue;
 
+        symcache = _rt_module_symbol_cache(module_ptr, symcache, &symlink, index);
+
         /* get relocate item */
         rel = (Elf32_Rel *)((rt_uint8_t *)module_ptr + shdr[index].sh_offset);
 
@@ -562,6 +870,13 @@ static struct rt_module *_load_shared_object(const char *name,
                                                     + sym->st_value
                                                     - vstart_addr));
             }
+#ifdef MODULE_LAZY_BIND
+            else if (lazy != RT_NULL && ELF32_R_TYPE(rel->r_info) == R_ARM_JUMP_SLOT)
+            {
+                /* points to PLT0 until the first call resolves it */
+                *(Elf32_Addr *)(lazy->base + rel->r_offset) += (Elf32_Addr)lazy->base;
+            }
+#endif
             else if (!linked)
             {
                 Elf32_Addr addr;
@@ -570,7 +885,8 @@ static struct rt_module *_load_shared_object(const char *name,
                                                strtab + sym->st_name));
 
                 /* need to resolve symbol in kernel symbol table */
-                addr = rt_module_symbol_find((const char *)(strtab + sym->st_name));
+                addr = _rt_module_symbol_resolve(symcache, ELF32_R_SYM(rel->r_info),
+                                                 (const char *)(strtab + sym->st_name));
                 if (addr == 0)
                 {
                     rt_kprintf("Module: can't find %s in kernel symbol table\n",
@@ -585,12 +901,17 @@ static struct rt_module *_load_shared_object(const char *name,
 
         if (unsolved)
         {
+            if (symcache != RT_NULL)
+                rt_free(symcache);
             rt_object_delete(&(module->parent));
 
             return RT_NULL;
         }
     }
 
+    if (symcache != RT_NULL)
+        rt_free(symcache);
+
     /* construct module symbol table */
     for (index = 0; index < elf_module->e_shnum; index ++)
     {
@@ -641,6 +962,9 @@ static struct rt_module *_load_shared_object(const char *name,
                       length);
             count ++;
         }
+
+        /* sort symbol table by name for dlsym */
+        _rt_module_symtab_sort(module->symtab, module->nsym);
     }
 
     return module;
@@ -653,6 +977,8 @@ static struct rt_module* _load_relocated_object(const char *name,
     rt_uint32_t module_addr = 0, module_size = 0;
     struct rt_module *module = RT_NULL;
     rt_uint8_t *ptr, *strtab, *shstrab;
+    Elf32_Addr *symcache = RT_NULL;
+    rt_uint32_t symlink = 0;
 
     /* get the ELF image size */
     for (index = 0; index < elf_module->e_shnum; index ++)
@@ -770,6 +1096,8 @@ static struct rt_module* _load_relocated_object(const char *name,
         if (!IS_REL(shdr[index]))
             continue;
 
+        symcache = _rt_module_symbol_cache(module_ptr, symcache, &symlink, index);
+
         /* get relocate item */
         rel = (Elf32_Rel *)((rt_uint8_t *)module_ptr + shdr[index].sh_offset);
 
@@ -840,7 +1168,8 @@ static struct rt_module* _load_relocated_object(const char *name,
                                                    strtab + sym->st_name));
 
                     /* need to resolve symbol in kernel symbol table */
-                    addr = rt_module_symbol_find((const char *)(strtab + sym->st_name));
+                    addr = _rt_module_symbol_resolve(symcache, ELF32_R_SYM(rel->r_info),
+                                                     (const char *)(strtab + sym->st_name));
                     if (addr != (Elf32_Addr)RT_NULL)
                     {
                         rt_module_arm_relocate(module, rel, addr);
@@ -864,6 +1193,9 @@ static struct rt_module* _load_relocated_object(const char *name,
         }
     }
 
+    if (symcache != RT_NULL)
+        rt_free(symcache);
+
     return module;
 }
 
@@ -1117,7 +1449,9 @@ static char *_module_name(const char *path)
 }
 
 /**
- * This function will load a module from a file
+ * This function will load a module from a file. A module without entry,
+ * i.e. a library, is loaded only once: opening it again shares the loaded
+ * module and increases its reference count.
  *
  * @param path the full path of application module
  *
@@ -1136,9 +1470,25 @@ rt_module_t rt_module_open(const char *path)
     /* check parameters */
     RT_ASSERT(path != RT_NULL);
 
+    name = _module_name(path);
+
+    /* share the library loaded already */
+    rt_enter_critical();
+    module = rt_module_find(name);
+    if (module != RT_NULL && (module->parent.flag & RT_MODULE_FLAG_WITHOUTENTRY))
+    {
+        module->nref ++;
+        rt_exit_critical();
+        rt_free(name);
+
+        return module;
+    }
+    rt_exit_critical();
+
     if (stat(path, &s) != 0)
     {
         rt_kprintf("Module: access %s failed\n", path);
+        rt_free(name);
 
         return RT_NULL;
     }
@@ -1146,6 +1496,7 @@ rt_module_t rt_module_open(const char *path)
     if (buffer == RT_NULL)
     {
         rt_kprintf("Module: out of memory\n");
+        rt_free(name);
 
         return RT_NULL;
     }
@@ -1156,6 +1507,7 @@ rt_module_t rt_module_open(const char *path)
     {
         rt_kprintf("Module: open %s failed\n", path);
         rt_free(buffer);
+        rt_free(name);
 
         return RT_NULL;
     }
@@ -1176,11 +1528,11 @@ rt_module_t rt_module_open(const char *path)
     {
         rt_kprintf("Module: read file failed\n");
         rt_free(buffer);
+        rt_free(name);
 
         return RT_NULL;
     }
 
-    name   = _module_name(path);
     module = rt_module_load(name, (void *)buffer);
     rt_free(buffer);
     rt_free(name);
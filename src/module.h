@@ -215,6 +215,25 @@ typedef struct
 #define R_386_JUMP_SLOT         7
 #define R_386_RELATIVE          8
 
+/* Dynamic section entry */
+typedef struct
+{
+    Elf32_Sword d_tag;                         /* entry tag value */
+    union
+    {
+        Elf32_Word d_val;
+        Elf32_Addr d_ptr;
+    } d_un;
+} Elf32_Dyn;
+
+/* d_tag */
+#define DT_NULL                 0              /* end of _DYNAMIC array */
+#define DT_PLTRELSZ             2              /* size of relocation entries of PLT */
+#define DT_PLTGOT               3              /* address of PLT/GOT */
+#define DT_STRTAB               5              /* address of string table */
+#define DT_SYMTAB               6              /* address of symbol table */
+#define DT_JMPREL               23             /* address of relocation entries of PLT */
+
 /* Program Header */
 typedef struct
 {
@@ -13,6 +13,7 @@
  * 2010-10-26     yi.qiu       add module support in rt_object_allocate and rt_object_free
  * 2017-12-10     Bernard      Add object_info enum.
  * 2018-01-25     Bernard      Fix the object find issue when enable MODULE.
+ * 2026-10-19     heyuanjie    add rt_object_reuse
  */
 
 #include <rtthread.h>
@@ -309,35 +310,26 @@ void rt_object_detach(rt_object_t object)
 
 #ifdef RT_USING_HEAP
 /**
- * This function will allocate an object from object system
+ * This function will put a released object memory into object system
+ * again, as rt_object_allocate does, but without memory allocation.
+ * It's used by the object cache, such as thread cache.
  *
+ * @param object the object memory, which was released by rt_object_detach
  * @param type the type of object
  * @param name the object name. In system, the object's name must be unique.
- *
- * @return object
  */
-rt_object_t rt_object_allocate(enum rt_object_class_type type, const char *name)
+void rt_object_reuse(rt_object_t object, enum rt_object_class_type type, const char *name)
 {
-    struct rt_object *object;
     register rt_base_t temp;
     struct rt_object_information *information;
 #ifdef RT_USING_MODULE
     struct rt_dlmodule *module = dlmodule_self();
 #endif
 
-    RT_DEBUG_NOT_IN_INTERRUPT;
-
     /* get object information */
     information = rt_object_get_information(type);
     RT_ASSERT(information != RT_NULL);
 
-    object = (struct rt_object *)RT_KERNEL_MALLOC(information->object_size);
-    if (object == RT_NULL)
-    {
-        /* no memory can be allocated */
-        return RT_NULL;
-    }
-
     /* clean memory data of object */
     rt_memset(object, 0x0, information->object_size);
 
@@ -372,6 +364,35 @@ rt_object_t rt_object_allocate(enum rt_object_class_type type, const char *name)
 
     /* unlock interrupt */
     rt_hw_interrupt_enable(temp);
+}
+
+/**
+ * This function will allocate an object from object system
+ *
+ * @param type the type of object
+ * @param name the object name. In system, the object's name must be unique.
+ *
+ * @return object
+ */
+rt_object_t rt_object_allocate(enum rt_object_class_type type, const char *name)
+{
+    struct rt_object *object;
+    struct rt_object_information *information;
+
+    RT_DEBUG_NOT_IN_INTERRUPT;
+
+    /* get object information */
+    information = rt_object_get_information(type);
+    RT_ASSERT(information != RT_NULL);
+
+    object = (struct rt_object *)RT_KERNEL_MALLOC(information->object_size);
+    if (object == RT_NULL)
+    {
+        /* no memory can be allocated */
+        return RT_NULL;
+    }
+
+    rt_object_reuse(object, type, name);
 
     /* return object */
     return object;
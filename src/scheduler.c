@@ -27,6 +27,7 @@
  *                             rt_schedule_insert_thread won't insert current task to ready queue
  *                             in smp version, rt_hw_context_switch_interrupt maybe switch to
  *                               new task directly
+ * 2026-10-19     heyuanjie    add cpu time accounting of thread
  *
  */
 
@@ -234,6 +235,21 @@ void rt_system_scheduler_init(void)
     rt_list_init(&rt_thread_defunct);
 }
 
+#ifdef RT_USING_CPUTIME
+/* charge the time since last switch to the thread leaving cpu */
+rt_inline void _rt_scheduler_cputime(struct rt_thread *from, struct rt_thread *to)
+{
+    rt_uint64_t now;
+
+    now = rt_clock_ns();
+    if (from != RT_NULL)
+        from->cpu_time += now - from->cpu_stamp;
+    to->cpu_stamp = now;
+}
+#else
+#define _rt_scheduler_cputime(from, to)
+#endif
+
 /**
  * @ingroup SystemInit
  * This function will startup scheduler. It will select one thread
@@ -253,6 +269,7 @@ void rt_system_scheduler_start(void)
 #endif /*RT_USING_SMP*/
 
     rt_schedule_remove_thread(to_thread);
+    _rt_scheduler_cputime(RT_NULL, to_thread);
 
     /* switch to new thread */
 #ifdef RT_USING_SMP
@@ -336,6 +353,7 @@ void rt_schedule(void)
                 pcpu->current_priority = (rt_uint8_t)highest_ready_priority;
 
                 RT_OBJECT_HOOK_CALL(rt_scheduler_hook, (current_thread, to_thread));
+                _rt_scheduler_cputime(current_thread, to_thread);
 
                 rt_schedule_remove_thread(to_thread);
 
@@ -422,6 +440,7 @@ void rt_schedule(void)
                 rt_current_thread   = to_thread;
 
                 RT_OBJECT_HOOK_CALL(rt_scheduler_hook, (from_thread, to_thread));
+                _rt_scheduler_cputime(from_thread, to_thread);
 
                 if (need_insert_from_thread)
                 {
@@ -538,6 +557,7 @@ void rt_scheduler_do_irq_switch(void *context)
                 pcpu->current_priority = (rt_uint8_t)highest_ready_priority;
 
                 RT_OBJECT_HOOK_CALL(rt_scheduler_hook, (current_thread, to_thread));
+                _rt_scheduler_cputime(current_thread, to_thread);
 
                 rt_schedule_remove_thread(to_thread);
 
@@ -8,6 +8,7 @@
  * 2017/10/5      Bernard      the first version
  * 2018/09/17     Jesven       fix: in _signal_deliver RT_THREAD_STAT_MASK to RT_THREAD_STAT_SIGNAL_MASK
  * 2018/11/22     Jesven       in smp version rt_hw_context_switch_to add a param
+ * 2026/10/19     heyuanjie    add rt_thread_sigqueue
  */
 
 #include <stdint.h>
@@ -404,16 +405,33 @@ void rt_thread_free_sig(rt_thread_t tid)
 int rt_thread_kill(rt_thread_t tid, int sig)
 {
     siginfo_t si;
+
+    si.si_signo = sig;
+    si.si_code  = SI_USER;
+    si.si_value.sival_ptr = RT_NULL;
+
+    return rt_thread_sigqueue(tid, &si);
+}
+
+/*
+ * send a signal with its information, such as the code and value of a
+ * timer expiration.
+ */
+int rt_thread_sigqueue(rt_thread_t tid, const rt_siginfo_t *info)
+{
+    siginfo_t si;
+    int sig;
     rt_base_t level;
     struct siginfo_node *si_node;
 
     RT_ASSERT(tid != RT_NULL);
+    RT_ASSERT(info != RT_NULL);
+
+    sig = info->si_signo;
     if (!sig_valid(sig)) return -RT_EINVAL;
 
     LOG_I("send signal: %d", sig);
-    si.si_signo = sig;
-    si.si_code  = SI_USER;
-    si.si_value.sival_ptr = RT_NULL;
+    memcpy(&si, info, sizeof(siginfo_t));
 
     level = rt_hw_interrupt_disable();
     if (tid->sig_pending & sig_mask(sig))
@@ -26,6 +26,9 @@
  *                             bug when thread has not startup.
  * 2018-11-22     Jesven       yield is same to rt_schedule
  *                             add support for tasks bound to cpu
+ * 2026-10-19     heyuanjie    add rt_thread_cputime
+ * 2026-10-19     heyuanjie    add thread cache for rt_thread_create
+ * 2026-10-19     heyuanjie    add console of thread
  */
 
 #include <rthw.h>
@@ -133,8 +136,7 @@ static rt_err_t _rt_thread_init(struct rt_thread *thread,
     thread->stack_addr = stack_start;
     thread->stack_size = stack_size;
 
-    /* init thread stack */
-    rt_memset(thread->stack_addr, '#', thread->stack_size);
+    /* init thread stack, the stack is filled with '#' by caller */
 #ifdef ARCH_CPU_STACK_GROWS_UPWARD
     thread->sp = (void *)rt_hw_stack_init(thread->entry, thread->parameter,
                                           (void *)((char *)thread->stack_addr),
@@ -178,6 +180,15 @@ static rt_err_t _rt_thread_init(struct rt_thread *thread,
     thread->cleanup   = 0;
     thread->user_data = 0;
 
+#ifdef RT_USING_CONSOLE
+    thread->console   = RT_NULL;
+#endif
+
+#ifdef RT_USING_CPUTIME
+    thread->cpu_time  = 0;
+    thread->cpu_stamp = 0;
+#endif
+
     /* init thread timer */
     rt_timer_init(&(thread->thread_timer),
                   thread->name,
@@ -242,6 +253,9 @@ rt_err_t rt_thread_init(struct rt_thread *thread,
     /* init thread object */
     rt_object_init((rt_object_t)thread, RT_Object_Class_Thread, name);
 
+    /* fill stack for stack usage checking */
+    rt_memset(stack_start, '#', stack_size);
+
     return _rt_thread_init(thread,
                            name,
                            entry,
@@ -276,6 +290,41 @@ rt_thread_t rt_thread_self(void)
 }
 RTM_EXPORT(rt_thread_self);
 
+#ifdef RT_USING_CPUTIME
+/**
+ * This function will return the cpu time consumed by a thread
+ *
+ * @param thread the thread
+ *
+ * @return cpu time in nanosecond
+ */
+rt_uint64_t rt_thread_cputime(rt_thread_t thread)
+{
+    rt_uint64_t ns;
+    rt_base_t level;
+
+    RT_ASSERT(thread != RT_NULL);
+
+    level = rt_hw_interrupt_disable();
+    ns = thread->cpu_time;
+
+    /* add the time of the running slice */
+#ifdef RT_USING_SMP
+    if (thread->oncpu != RT_CPU_DETACHED &&
+        rt_cpu_index(thread->oncpu)->current_thread == thread)
+#else
+    if (thread == rt_thread_self())
+#endif
+    {
+        ns += rt_clock_ns() - thread->cpu_stamp;
+    }
+    rt_hw_interrupt_enable(level);
+
+    return ns;
+}
+RTM_EXPORT(rt_thread_cputime);
+#endif
+
 /**
  * This function will start a thread and put it to system ready queue
  *
@@ -368,6 +417,220 @@ RTM_EXPORT(rt_thread_detach);
 
 
 #ifdef RT_USING_HEAP
+#ifdef RT_USING_THREAD_CACHE
+#ifndef RT_THREAD_CACHE_SIZES
+#define RT_THREAD_CACHE_SIZES   4
+#endif
+#ifndef RT_THREAD_CACHE_DEPTH
+#define RT_THREAD_CACHE_DEPTH   4
+#endif
+
+/* the released threads of a stack size, which are linked by tlist */
+struct rt_thread_cache
+{
+    rt_uint32_t stack_size;
+    rt_uint32_t count;
+
+    rt_list_t   clean;                                  /**< the stacks filled with '#' */
+    rt_list_t   dirty;                                  /**< the stacks to be filled in idle */
+};
+
+static struct rt_thread_cache _thread_cache[RT_THREAD_CACHE_SIZES];
+
+static rt_thread_t _rt_thread_cache_get(rt_uint32_t stack_size, rt_bool_t *filled)
+{
+    struct rt_thread_cache *cache;
+    rt_thread_t thread = RT_NULL;
+    register rt_base_t level;
+    int index;
+
+    level = rt_hw_interrupt_disable();
+    for (index = 0; index < RT_THREAD_CACHE_SIZES; index ++)
+    {
+        cache = &_thread_cache[index];
+        if (cache->count == 0 || cache->stack_size != stack_size)
+            continue;
+
+        /* a filled stack is preferred */
+        *filled = !rt_list_isempty(&(cache->clean));
+        if (*filled)
+            thread = rt_list_entry(cache->clean.next, struct rt_thread, tlist);
+        else
+            thread = rt_list_entry(cache->dirty.next, struct rt_thread, tlist);
+
+        rt_list_remove(&(thread->tlist));
+        cache->count --;
+        break;
+    }
+    rt_hw_interrupt_enable(level);
+
+    return thread;
+}
+
+static rt_err_t _rt_thread_cache_put(rt_thread_t thread, rt_bool_t filled)
+{
+    struct rt_thread_cache *cache, *empty = RT_NULL;
+    register rt_base_t level;
+    int index;
+
+    level = rt_hw_interrupt_disable();
+    for (index = 0; index < RT_THREAD_CACHE_SIZES; index ++)
+    {
+        cache = &_thread_cache[index];
+        if (cache->count == 0)
+        {
+            if (empty == RT_NULL)
+                empty = cache;
+        }
+        else if (cache->stack_size == thread->stack_size)
+        {
+            break;
+        }
+    }
+
+    if (index == RT_THREAD_CACHE_SIZES)
+    {
+        /* take a free cache for this stack size */
+        cache = empty;
+        if (cache != RT_NULL)
+        {
+            cache->stack_size = thread->stack_size;
+            rt_list_init(&(cache->clean));
+            rt_list_init(&(cache->dirty));
+        }
+    }
+
+    if (cache == RT_NULL || cache->count >= RT_THREAD_CACHE_DEPTH)
+    {
+        rt_hw_interrupt_enable(level);
+
+        return -RT_EFULL;
+    }
+
+    if (filled)
+        rt_list_insert_before(&(cache->clean), &(thread->tlist));
+    else
+        rt_list_insert_before(&(cache->dirty), &(thread->tlist));
+    cache->count ++;
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+
+/**
+ * This function will fill a stack of the released threads with '#', so
+ * a thread created later gets its stack without filling. It's invoked in
+ * idle thread.
+ */
+void rt_thread_cache_fill(void)
+{
+    struct rt_thread_cache *cache;
+    rt_thread_t thread = RT_NULL;
+    register rt_base_t level;
+    int index;
+
+    level = rt_hw_interrupt_disable();
+    for (index = 0; index < RT_THREAD_CACHE_SIZES; index ++)
+    {
+        cache = &_thread_cache[index];
+        if (cache->count != 0 && !rt_list_isempty(&(cache->dirty)))
+        {
+            thread = rt_list_entry(cache->dirty.next, struct rt_thread, tlist);
+            rt_list_remove(&(thread->tlist));
+            cache->count --;
+            break;
+        }
+    }
+    rt_hw_interrupt_enable(level);
+
+    if (thread == RT_NULL)
+        return;
+
+    /* fill it with interrupt enabled */
+    rt_memset(thread->stack_addr, '#', thread->stack_size);
+
+    if (_rt_thread_cache_put(thread, RT_TRUE) != RT_EOK)
+    {
+        RT_KERNEL_FREE(thread->stack_addr);
+        RT_KERNEL_FREE(thread);
+    }
+}
+#endif
+
+static rt_thread_t _rt_thread_alloc(rt_uint32_t stack_size, rt_bool_t *filled)
+{
+    struct rt_thread *thread;
+    void *stack_start;
+
+    RT_DEBUG_NOT_IN_INTERRUPT;
+
+    *filled = RT_FALSE;
+
+#ifdef RT_USING_THREAD_CACHE
+    thread = _rt_thread_cache_get(stack_size, filled);
+    if (thread != RT_NULL)
+        return thread;
+#endif
+
+    thread = (struct rt_thread *)RT_KERNEL_MALLOC(sizeof(struct rt_thread));
+    if (thread == RT_NULL)
+        return RT_NULL;
+
+    stack_start = (void *)RT_KERNEL_MALLOC(stack_size);
+    if (stack_start == RT_NULL)
+    {
+        /* allocate stack failure */
+        RT_KERNEL_FREE(thread);
+
+        return RT_NULL;
+    }
+
+    thread->stack_addr = stack_start;
+    thread->stack_size = stack_size;
+
+    return thread;
+}
+
+/**
+ * This function will allocate the memory of a thread object and its stack,
+ * from thread cache when it's enabled. The memory is used by
+ * rt_thread_init, such as a pthread, and released by rt_thread_free.
+ *
+ * @param stack_size the size of thread stack
+ *
+ * @return the thread memory, whose stack_addr and stack_size are set,
+ *         RT_NULL on failure
+ */
+rt_thread_t rt_thread_alloc(rt_uint32_t stack_size)
+{
+    rt_bool_t filled;
+
+    return _rt_thread_alloc(stack_size, &filled);
+}
+RTM_EXPORT(rt_thread_alloc);
+
+/**
+ * This function will release the memory of a thread object and its stack,
+ * which is detached from object system. It's kept in thread cache for the
+ * next thread with the same stack size when it's enabled.
+ *
+ * @param thread the thread memory
+ */
+void rt_thread_free(rt_thread_t thread)
+{
+    RT_ASSERT(thread != RT_NULL);
+
+#ifdef RT_USING_THREAD_CACHE
+    if (_rt_thread_cache_put(thread, RT_FALSE) == RT_EOK)
+        return;
+#endif
+
+    /* release thread's stack */
+    RT_KERNEL_FREE(thread->stack_addr);
+    RT_KERNEL_FREE(thread);
+}
+RTM_EXPORT(rt_thread_free);
+
 /**
  * This function will create a thread object and allocate thread object memory
  * and stack.
@@ -390,20 +653,20 @@ rt_thread_t rt_thread_create(const char *name,
 {
     struct rt_thread *thread;
     void *stack_start;
+    rt_bool_t filled;
 
-    thread = (struct rt_thread *)rt_object_allocate(RT_Object_Class_Thread,
-                                                    name);
+    thread = _rt_thread_alloc(stack_size, &filled);
     if (thread == RT_NULL)
         return RT_NULL;
 
-    stack_start = (void *)RT_KERNEL_MALLOC(stack_size);
-    if (stack_start == RT_NULL)
-    {
-        /* allocate stack failure */
-        rt_object_delete((rt_object_t)thread);
+    stack_start = thread->stack_addr;
 
-        return RT_NULL;
-    }
+    /* init thread object */
+    rt_object_reuse((rt_object_t)thread, RT_Object_Class_Thread, name);
+
+    /* fill stack for stack usage checking */
+    if (!filled)
+        rt_memset(stack_start, '#', stack_size);
 
     _rt_thread_init(thread,
                     name,